@@ -0,0 +1,135 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include <libaegisub/ass/field_scanner.h>
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AGI_FIELD_SCANNER_SSE2
+#endif
+
+#if defined(AGI_FIELD_SCANNER_SSE2) && defined(__GNUC__)
+#include <immintrin.h>
+#define AGI_FIELD_SCANNER_AVX2
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+#ifdef AGI_FIELD_SCANNER_SSE2
+inline unsigned first_bit(uint32_t mask) {
+#ifdef _MSC_VER
+	unsigned long idx;
+	_BitScanForward(&idx, mask);
+	return idx;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+const char *find_char_sse2(const char *begin, const char *end, char c) {
+	const __m128i needle = _mm_set1_epi8(c);
+	for (; end - begin >= 16; begin += 16) {
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+		uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+		if (mask)
+			return begin + first_bit(mask);
+	}
+	auto found = static_cast<const char *>(memchr(begin, c, end - begin));
+	return found ? found : end;
+}
+#endif
+
+#ifdef AGI_FIELD_SCANNER_AVX2
+__attribute__((target("avx2")))
+const char *find_char_avx2(const char *begin, const char *end, char c) {
+	const __m256i needle = _mm256_set1_epi8(c);
+	for (; end - begin >= 32; begin += 32) {
+		__m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+		uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle));
+		if (mask)
+			return begin + first_bit(mask);
+	}
+	return find_char_sse2(begin, end, c);
+}
+#endif
+
+#ifndef AGI_FIELD_SCANNER_SSE2
+const char *find_char_scalar(const char *begin, const char *end, char c) {
+	auto found = static_cast<const char *>(memchr(begin, c, end - begin));
+	return found ? found : end;
+}
+#endif
+
+using find_char_fn = const char *(*)(const char *, const char *, char);
+
+find_char_fn select_find_char() {
+#ifdef AGI_FIELD_SCANNER_AVX2
+	if (__builtin_cpu_supports("avx2"))
+		return find_char_avx2;
+#endif
+#ifdef AGI_FIELD_SCANNER_SSE2
+	return find_char_sse2;
+#else
+	return find_char_scalar;
+#endif
+}
+
+inline bool is_space(char c) {
+	return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+}
+
+namespace agi { namespace ass {
+const char *FindChar(const char *begin, const char *end, char c) {
+	static const find_char_fn impl = select_find_char();
+	return impl(begin, end, c);
+}
+
+CharRange Trim(CharRange range) {
+	const char *begin = range.begin(), *end = range.end();
+	while (begin != end && is_space(*begin)) ++begin;
+	while (begin != end && is_space(end[-1])) --end;
+	return CharRange(begin, end);
+}
+
+bool ParseInt(CharRange range, int &out) {
+	const char *begin = range.begin(), *end = range.end();
+	bool negative = false;
+	if (begin != end && (*begin == '-' || *begin == '+')) {
+		negative = *begin == '-';
+		++begin;
+	}
+
+	// Nine digits always fit in an int; anything longer is rare enough to
+	// leave to the slow path
+	if (begin == end || end - begin > 9) return false;
+
+	int value = 0;
+	for (; begin != end; ++begin) {
+		if (*begin < '0' || *begin > '9') return false;
+		value = value * 10 + (*begin - '0');
+	}
+
+	out = negative ? -value : value;
+	return true;
+}
+} }
@@ -39,10 +39,13 @@ static void decompose_time(int ms_time, int& h, int& m, int& s, int& ms) {
 namespace agi {
 Time::Time(int time) : time(util::mid(0, time, MAX_TIME)) { }
 
-Time::Time(std::string const& text) {
+Time::Time(std::string const& text) : Time(text.data(), text.data() + text.size()) { }
+
+Time::Time(const char *begin, const char *end) {
 	int after_decimal = -1;
 	int current = 0;
-	for (char c : text) {
+	for (; begin != end; ++begin) {
+		char c = *begin;
 		if (c == ':') {
 			time = time * 60 + current;
 			current = 0;
@@ -84,6 +87,24 @@ std::string Time::GetAssFormatted(bool msPrecision) const {
 		return format("%d:%02d:%02d.%03d", h, m, s, ms);
 }
 
+void Time::AppendAssFormatted(std::string &out) const {
+	int h, m, s, ms;
+	decompose_time(int(*this), h, m, s, ms);
+
+	char buf[16];
+	char *end = buf + sizeof buf;
+	char *p = end;
+	auto put2 = [&](int v) { *--p = '0' + v % 10; *--p = '0' + v / 10; };
+	put2(ms / 10);
+	*--p = '.';
+	put2(s);
+	*--p = ':';
+	put2(m);
+	*--p = ':';
+	do { *--p = '0' + h % 10; } while (h /= 10);
+	out.append(p, end);
+}
+
 std::string Time::GetSrtFormatted() const {
 	int h, m, s, ms;
 	decompose_time(time, h, m, s, ms);
@@ -0,0 +1,116 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include "cache_provider.h"
+
+#include <libaegisub/log.h>
+
+namespace agi {
+bool IsDisplayFormat(AudioProvider const& provider) {
+	return provider.GetChannels() == 1 && provider.GetBytesPerSample() == sizeof(int16_t) && !provider.AreSamplesFloat();
+}
+
+std::unique_ptr<AudioProvider> CreatePlaybackProvider(AudioProvider const& src) {
+	if (IsDisplayFormat(src)) return nullptr;
+
+	auto playback = src.Clone();
+	if (!playback) {
+		LOG_D("audio_provider/cache") << "source can't be cloned, so caching all " << src.GetChannels() << " channels";
+		return nullptr;
+	}
+	return CreateLockAudioProvider(std::move(playback));
+}
+
+CacheAudioProvider::CacheAudioProvider(AudioProvider const& format, bool compact)
+: compact(compact)
+{
+	channels = format.GetChannels();
+	num_samples = format.GetNumSamples();
+	sample_rate = format.GetSampleRate();
+	bytes_per_sample = format.GetBytesPerSample();
+	float_samples = format.AreSamplesFloat();
+	track = format.GetTrack();
+}
+
+void CacheAudioProvider::Decode(AudioProvider const& src, void *buf, int64_t start, int64_t count) const {
+	if (compact)
+		src.GetInt16MonoAudio(static_cast<int16_t *>(buf), start, count);
+	else
+		src.GetAudio(buf, start, count);
+}
+
+void CacheAudioProvider::ReadStream(void *buf, int64_t start, int64_t count) const {
+	if (!decoder) {
+		ReadCache(buf, start, count);
+		return;
+	}
+
+	const int64_t frame_size = CacheFrameSize();
+	auto charbuf = static_cast<char *>(buf);
+	decoder->ForEachRun(start, count, [&](int64_t run_start, int64_t run_count, bool decoded) {
+		if (decoded)
+			ReadCache(charbuf, run_start, run_count);
+		else
+			memset(charbuf, 0, run_count * frame_size);
+		charbuf += run_count * frame_size;
+	});
+}
+
+void CacheAudioProvider::FillBuffer(void *buf, int64_t start, int64_t count) const {
+	if (!compact)
+		ReadStream(buf, start, count);
+	else if (playback)
+		playback->GetAudio(buf, start, count);
+	else
+		source->GetAudio(buf, start, count);
+}
+
+void CacheAudioProvider::FillBufferInt16Mono(int16_t *buf, int64_t start, int64_t count) const {
+	if (compact)
+		ReadStream(buf, start, count);
+	else
+		AudioProvider::FillBufferInt16Mono(buf, start, count);
+}
+
+bool CacheAudioProvider::IsRangeDecoded(int64_t start, int64_t count) const {
+	return !decoder || decoder->IsRangeDecoded(start, count);
+}
+
+void CacheAudioProvider::Prioritize(int64_t start, int64_t count) {
+	if (decoder)
+		decoder->Prioritize(start, count);
+}
+
+void CacheAudioProvider::SetDecodedListener(DecodedFunc listener) {
+	std::lock_guard<std::mutex> lock(listener_mutex);
+	decoded_listener = std::move(listener);
+}
+
+void CacheAudioProvider::AnnounceSegment(size_t segment) {
+	const int64_t start = int64_t(segment) << SegmentedDecoder::SegmentBits;
+	const int64_t count = std::min(SegmentedDecoder::SegmentSize, num_samples - start);
+	std::lock_guard<std::mutex> lock(listener_mutex);
+	if (decoded_listener)
+		decoded_listener(start, count);
+}
+
+AudioCacheUsage CacheAudioProvider::GetCacheUsage() const {
+	AudioCacheUsage usage;
+	(compact ? usage.display : usage.playback) = num_samples * CacheFrameSize();
+	usage.in_memory = InMemory();
+	return usage;
+}
+}
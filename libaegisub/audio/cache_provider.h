@@ -0,0 +1,91 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#pragma once
+
+#include "libaegisub/audio/provider.h"
+#include "segmented_decoder.h"
+
+#include <mutex>
+
+namespace agi {
+/// @class CacheAudioProvider
+/// @brief Base class for the providers which decode their source into a cache
+///
+/// The waveform and spectrum only ever read 16-bit mono audio, so when the
+/// source is in some wider format the cache holds just that display stream,
+/// and audio in the source's own format for playback is decoded on demand
+/// from a second instance of the source. If the source can't be cloned the
+/// cache holds the source's format and the display stream is converted from
+/// it as it's read.
+class CacheAudioProvider : public AudioProvider {
+	void FillBuffer(void *buf, int64_t start, int64_t count) const final;
+	void FillBufferInt16Mono(int16_t *buf, int64_t start, int64_t count) const final;
+
+	/// Read from the cache, with silence for whatever isn't decoded yet
+	void ReadStream(void *buf, int64_t start, int64_t count) const;
+
+	/// Protects decoded_listener
+	std::mutex listener_mutex;
+	DecodedFunc decoded_listener;
+
+protected:
+	/// Provider the cache is filled from, while it's still needed
+	std::unique_ptr<AudioProvider> source;
+	/// Provider for the playback stream if the cache only holds the display
+	/// stream, or nullptr to use source
+	std::unique_ptr<AudioProvider> playback;
+	/// Does the cache hold only the 16-bit mono display stream?
+	const bool compact;
+	/// Background decoder filling the cache, which subclasses have to stop
+	/// before destroying the storage it writes to
+	std::unique_ptr<SegmentedDecoder> decoder;
+
+	/// @param format  Provider to take the format of the audio from
+	/// @param compact Should the cache hold only the display stream?
+	CacheAudioProvider(AudioProvider const& format, bool compact);
+
+	/// Size in bytes of each sample frame in the cache
+	int64_t CacheFrameSize() const { return compact ? sizeof(int16_t) : bytes_per_sample * channels; }
+
+	/// Decode from src in the cache's format
+	void Decode(AudioProvider const& src, void *buf, int64_t start, int64_t count) const;
+
+	/// Copy a range which has been decoded from the cache
+	virtual void ReadCache(void *buf, int64_t start, int64_t count) const = 0;
+
+	/// Tell the listener that a segment has been decoded; subclasses call
+	/// this from their decoder's done function
+	void AnnounceSegment(size_t segment);
+
+public:
+	bool IsRangeDecoded(int64_t start, int64_t count) const override;
+	void Prioritize(int64_t start, int64_t count) override;
+	void SetDecodedListener(DecodedFunc listener) override;
+	AudioCacheUsage GetCacheUsage() const override;
+
+	/// Is the cache in memory rather than on disk?
+	virtual bool InMemory() const = 0;
+};
+
+/// Open a second instance of src to decode the playback stream from, if
+/// it's worth caching only the display stream for it
+/// @return Provider for playback, or nullptr if the cache should hold src's own format
+std::unique_ptr<AudioProvider> CreatePlaybackProvider(AudioProvider const& src);
+
+/// Is this audio already in the display stream's format?
+bool IsDisplayFormat(AudioProvider const& provider);
+}
@@ -0,0 +1,142 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include "libaegisub/audio/decode_ahead.h"
+
+#include "libaegisub/audio/playback_stats.h"
+#include "libaegisub/audio/provider.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+int64_t round_up_pow2(int64_t n) {
+	int64_t pow2 = 1;
+	while (pow2 < n) pow2 *= 2;
+	return pow2;
+}
+
+/// How long the decoder waits for room in the ring before checking again;
+/// the reader never blocks, so it doesn't wake the decoder
+const auto poll_interval = std::chrono::milliseconds(5);
+}
+
+namespace agi {
+DecodeAheadBuffer::DecodeAheadBuffer(AudioProvider *provider, bool mono16, int lead_ms, PlaybackStats *player_stats)
+: provider(provider)
+, mono16(mono16)
+, frame_size(mono16 ? sizeof(int16_t) : provider->GetBytesPerSample() * provider->GetChannels())
+, lead(std::max<int64_t>(int64_t(provider->GetSampleRate()) * lead_ms / 1000, 256))
+, capacity(round_up_pow2(lead))
+, chunk(std::max<int64_t>(lead / 4, 64))
+, ring(new char[capacity * frame_size])
+, player_stats(player_stats)
+, thread([this] { Work(); })
+{
+}
+
+DecodeAheadBuffer::~DecodeAheadBuffer() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closing = true;
+	}
+	cond.notify_all();
+	thread.join();
+}
+
+int64_t DecodeAheadBuffer::DecodeChunk(int64_t count) {
+	const int64_t write_pos = written.load(std::memory_order_relaxed);
+	const int64_t buffered = write_pos - read.load(std::memory_order_acquire);
+	const int64_t position = start_position + write_pos;
+
+	// Don't wrap within a single decode
+	const int64_t offset = write_pos & (capacity - 1);
+	count = std::min({count, lead - buffered, end_position - position, capacity - offset});
+	if (count <= 0) return 0;
+
+	char *dst = ring.get() + offset * frame_size;
+	const auto read_start = std::chrono::steady_clock::now();
+	if (mono16)
+		provider->GetInt16MonoAudioWithVolume(reinterpret_cast<int16_t *>(dst), position, count, volume);
+	else
+		provider->GetAudioWithVolume(dst, position, count, volume);
+	if (player_stats)
+		player_stats->RecordProviderRead(std::chrono::steady_clock::now() - read_start);
+
+	written.store(write_pos + count, std::memory_order_release);
+	return count;
+}
+
+void DecodeAheadBuffer::Work() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!closing) {
+		if (!active || DecodeChunk(chunk) == 0) {
+			cond.wait_for(lock, poll_interval);
+			continue;
+		}
+
+		// Give Start() and Stop() a chance to get in between chunks
+		lock.unlock();
+		std::this_thread::yield();
+		lock.lock();
+	}
+}
+
+void DecodeAheadBuffer::Start(int64_t start, int64_t end, int64_t prefill) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		start_position = start;
+		end_position = end;
+		written = 0;
+		read = 0;
+		active = true;
+
+		prefill = std::min(prefill, lead);
+		while (written < prefill && DecodeChunk(prefill - written) > 0) ;
+	}
+	cond.notify_all();
+}
+
+void DecodeAheadBuffer::Stop() {
+	std::lock_guard<std::mutex> lock(mutex);
+	active = false;
+	written = 0;
+	read = 0;
+}
+
+int64_t DecodeAheadBuffer::Read(void *buf, int64_t frames) {
+	const int64_t read_pos = read.load(std::memory_order_relaxed);
+	const int64_t position = start_position + read_pos;
+	// The end may have been moved back since the audio was decoded
+	const int64_t available = std::min(written.load(std::memory_order_acquire) - read_pos, end_position - position);
+	const int64_t count = std::max<int64_t>(std::min(frames, available), 0);
+
+	// Copy in up to two pieces if the range wraps around the end of the ring
+	const int64_t offset = read_pos & (capacity - 1);
+	const int64_t first = std::min(count, capacity - offset);
+	memcpy(buf, ring.get() + offset * frame_size, first * frame_size);
+	if (count > first)
+		memcpy(static_cast<char *>(buf) + first * frame_size, ring.get(), (count - first) * frame_size);
+	read.store(read_pos + count, std::memory_order_release);
+
+	// Running out at the end of the range isn't an underrun
+	if (player_stats) {
+		const int64_t fill = std::max<int64_t>(available - count, 0);
+		player_stats->RecordRead(fill, count < frames && position + count < end_position);
+	}
+	return count;
+}
+}
@@ -0,0 +1,184 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include "libaegisub/audio/peak_pyramid.h"
+
+#include "libaegisub/audio/provider.h"
+
+#include <algorithm>
+
+namespace {
+/// Offset of the first bucket of a level within a chunk's pyramid
+size_t level_offset(int level) {
+	const size_t level0 = size_t(1) << (agi::AudioPeakPyramid::ChunkBits - agi::AudioPeakPyramid::BucketBits);
+	return 2 * level0 - (2 * level0 >> level);
+}
+
+agi::AudioPeak combine(agi::AudioPeak const& a, agi::AudioPeak const& b) {
+	agi::AudioPeak ret;
+	ret.min = std::min(a.min, b.min);
+	ret.max = std::max(a.max, b.max);
+	ret.avg_min = (a.avg_min + b.avg_min) / 2;
+	ret.avg_max = (a.avg_max + b.avg_max) / 2;
+	return ret;
+}
+}
+
+namespace agi {
+AudioPeakPyramid::AudioPeakPyramid(AudioProvider *provider)
+: provider(provider)
+, chunks((provider->GetNumSamples() + (int64_t(1) << ChunkBits) - 1) >> ChunkBits)
+{
+	provider->SetDecodedListener([this](int64_t start, int64_t count) { OnDecoded(start, count); });
+}
+
+AudioPeakPyramid::~AudioPeakPyramid() {
+	provider->SetDecodedListener(nullptr);
+}
+
+void AudioPeakPyramid::OnDecoded(int64_t start, int64_t count) {
+	const int64_t num_samples = provider->GetNumSamples();
+	const int64_t end = start + count;
+	std::vector<int16_t> buffer;
+
+	// Only whole chunks, or the partial chunk at the end of the stream, can
+	// be built from this range alone; a chunk straddling the edge of the
+	// range is built when it's queried
+	for (int64_t chunk = (start + (int64_t(1) << ChunkBits) - 1) >> ChunkBits; ; ++chunk) {
+		const int64_t chunk_end = std::min((chunk + 1) << ChunkBits, num_samples);
+		if (chunk_end > end || chunk_end <= chunk << ChunkBits) break;
+
+		{
+			std::lock_guard<std::mutex> lock(chunks_mutex);
+			if (chunks[chunk]) continue;
+		}
+
+		std::unique_ptr<AudioPeak[]> pyramid(new AudioPeak[ChunkSize]);
+		BuildChunk(chunk, pyramid.get(), buffer);
+		StoreChunk(chunk, std::move(pyramid));
+	}
+}
+
+AudioPeak const* AudioPeakPyramid::StoreChunk(int64_t chunk, std::unique_ptr<AudioPeak[]> pyramid) {
+	std::lock_guard<std::mutex> lock(chunks_mutex);
+	if (!chunks[chunk])
+		chunks[chunk] = std::move(pyramid);
+	return chunks[chunk].get();
+}
+
+void AudioPeakPyramid::BuildChunk(int64_t chunk, AudioPeak *out, std::vector<int16_t>& buffer) const {
+	buffer.resize(size_t(1) << ChunkBits);
+	provider->GetInt16MonoAudio(buffer.data(), chunk << ChunkBits, buffer.size());
+
+	const int bucket_size = 1 << BucketBits;
+	const size_t level0 = size_t(1) << (ChunkBits - BucketBits);
+	auto aud = buffer.data();
+	for (size_t i = 0; i < level0; ++i) {
+		int16_t peak_min = 0, peak_max = 0;
+		int sum_min = 0, sum_max = 0;
+		for (int j = 0; j < bucket_size; ++j, ++aud) {
+			if (*aud > 0) {
+				peak_max = std::max(peak_max, *aud);
+				sum_max += *aud;
+			}
+			else {
+				peak_min = std::min(peak_min, *aud);
+				sum_min += *aud;
+			}
+		}
+		out[i].min = peak_min;
+		out[i].max = peak_max;
+		out[i].avg_min = sum_min / bucket_size;
+		out[i].avg_max = sum_max / bucket_size;
+	}
+
+	for (int level = 1; level < Levels; ++level) {
+		AudioPeak const* src = out + level_offset(level - 1);
+		AudioPeak *dst = out + level_offset(level);
+		for (size_t i = 0, count = level0 >> level; i < count; ++i)
+			dst[i] = combine(src[i * 2], src[i * 2 + 1]);
+	}
+}
+
+AudioPeak const* AudioPeakPyramid::GetChunk(int64_t chunk) {
+	{
+		std::lock_guard<std::mutex> lock(chunks_mutex);
+		if (chunks[chunk])
+			return chunks[chunk].get();
+	}
+
+	const int64_t chunk_start = chunk << ChunkBits;
+	const int64_t chunk_end = std::min((chunk + 1) << ChunkBits, provider->GetNumSamples());
+	const int64_t decoded = provider->GetDecodedSamples();
+	if (provider->IsRangeDecoded(chunk_start, chunk_end - chunk_start)) {
+		std::unique_ptr<AudioPeak[]> pyramid(new AudioPeak[ChunkSize]);
+		BuildChunk(chunk, pyramid.get(), samples);
+		return StoreChunk(chunk, std::move(pyramid));
+	}
+
+	// Not fully decoded yet, so the result can't be kept, but a render will
+	// usually ask for many ranges in the same chunk so hang onto it until
+	// more audio comes in
+	if (!scratch)
+		scratch.reset(new AudioPeak[ChunkSize]);
+	if (scratch_chunk != chunk || scratch_decoded != decoded) {
+		BuildChunk(chunk, scratch.get(), samples);
+		scratch_chunk = chunk;
+		scratch_decoded = decoded;
+	}
+	return scratch.get();
+}
+
+AudioPeak AudioPeakPyramid::Get(int64_t start, int64_t count) {
+	if (start < 0) {
+		count += start;
+		start = 0;
+	}
+	if (count <= 0 || chunks.empty()) return AudioPeak();
+
+	int level = 0;
+	while (level + 1 < Levels && (int64_t(1) << (BucketBits + level + 1)) <= count)
+		++level;
+
+	const int shift = BucketBits + level;
+	const int chunk_shift = ChunkBits - shift;
+	const int64_t total_buckets = int64_t(chunks.size()) << chunk_shift;
+	const int64_t first = start >> shift;
+	const int64_t last = std::min(std::max(first + 1, (start + count) >> shift), total_buckets);
+	if (first >= last) return AudioPeak();
+
+	AudioPeak ret;
+	int64_t sum_min = 0, sum_max = 0;
+	AudioPeak const* chunk = nullptr;
+	int64_t chunk_index = -1;
+	for (int64_t i = first; i < last; ++i) {
+		if (i >> chunk_shift != chunk_index) {
+			chunk_index = i >> chunk_shift;
+			chunk = GetChunk(chunk_index) + level_offset(level);
+		}
+
+		AudioPeak const& bucket = chunk[i & ((int64_t(1) << chunk_shift) - 1)];
+		ret.min = std::min(ret.min, bucket.min);
+		ret.max = std::max(ret.max, bucket.max);
+		sum_min += bucket.avg_min;
+		sum_max += bucket.avg_max;
+	}
+
+	ret.avg_min = sum_min / (last - first);
+	ret.avg_max = sum_max / (last - first);
+	return ret;
+}
+}
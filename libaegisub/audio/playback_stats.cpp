@@ -0,0 +1,144 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include "libaegisub/audio/playback_stats.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+template<typename T>
+void update_max(std::atomic<T>& value, T candidate) {
+	T current = value.load(std::memory_order_relaxed);
+	while (candidate > current && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed)) ;
+}
+
+template<typename T>
+void update_min(std::atomic<T>& value, T candidate) {
+	T current = value.load(std::memory_order_relaxed);
+	while (candidate < current && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed)) ;
+}
+}
+
+namespace agi {
+PlaybackStats::PlaybackStats(int sample_rate)
+: sample_rate(sample_rate)
+{
+	for (auto& bucket : read_time)
+		bucket = 0;
+}
+
+void PlaybackStats::Reset() {
+	reads = 0;
+	underruns = 0;
+	device_underruns = 0;
+	min_fill = INT64_MAX;
+	total_fill = 0;
+	provider_reads = 0;
+	for (auto& bucket : read_time)
+		bucket = 0;
+	max_read_us = 0;
+	latency = -1;
+	max_latency = -1;
+	drift_samples = 0;
+	drift_ms = 0;
+	max_drift_ms = 0;
+}
+
+void PlaybackStats::RecordRead(int64_t fill, bool underrun) {
+	if (underrun)
+		underruns.fetch_add(1, std::memory_order_relaxed);
+	update_min(min_fill, fill);
+	total_fill.fetch_add(fill, std::memory_order_relaxed);
+	reads.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PlaybackStats::RecordProviderRead(std::chrono::steady_clock::duration time) {
+	const int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+	int bucket = 0;
+	while (bucket < ReadTimeBuckets - 1 && us >= ReadTimeLimit(bucket))
+		++bucket;
+	read_time[bucket].fetch_add(1, std::memory_order_relaxed);
+	update_max(max_read_us, us);
+	provider_reads.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PlaybackStats::RecordDeviceUnderrun() {
+	device_underruns.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PlaybackStats::RecordLatency(int64_t frames) {
+	latency.store(frames, std::memory_order_relaxed);
+	update_max(max_latency, frames);
+}
+
+void PlaybackStats::RecordDrift(int64_t ms) {
+	drift_ms.store(ms, std::memory_order_relaxed);
+	update_max(max_drift_ms, std::abs(ms));
+	drift_samples.fetch_add(1, std::memory_order_relaxed);
+}
+
+PlaybackStats::Snapshot PlaybackStats::Get() const {
+	const int64_t rate = std::max(sample_rate.load(std::memory_order_relaxed), 1);
+	auto to_ms = [=](int64_t frames) { return frames < 0 ? frames : frames * 1000 / rate; };
+
+	Snapshot s;
+	s.reads = reads.load(std::memory_order_relaxed);
+	s.underruns = underruns.load(std::memory_order_relaxed);
+	s.device_underruns = device_underruns.load(std::memory_order_relaxed);
+	if (s.reads) {
+		s.min_fill_ms = to_ms(min_fill.load(std::memory_order_relaxed));
+		s.avg_fill_ms = to_ms(total_fill.load(std::memory_order_relaxed) / int64_t(s.reads));
+	}
+	s.provider_reads = provider_reads.load(std::memory_order_relaxed);
+	for (int i = 0; i < ReadTimeBuckets; ++i)
+		s.read_time[i] = read_time[i].load(std::memory_order_relaxed);
+	s.max_read_us = max_read_us.load(std::memory_order_relaxed);
+	s.latency_ms = to_ms(latency.load(std::memory_order_relaxed));
+	s.max_latency_ms = to_ms(max_latency.load(std::memory_order_relaxed));
+	s.drift_samples = drift_samples.load(std::memory_order_relaxed);
+	s.drift_ms = drift_ms.load(std::memory_order_relaxed);
+	s.max_drift_ms = max_drift_ms.load(std::memory_order_relaxed);
+	return s;
+}
+
+std::string PlaybackStats::Format(Snapshot const& s) {
+	std::ostringstream out;
+	out << "reads=" << s.reads
+	    << " underruns=" << s.underruns
+	    << " device_underruns=" << s.device_underruns
+	    << " fill_min_ms=" << s.min_fill_ms
+	    << " fill_avg_ms=" << s.avg_fill_ms
+	    << " latency_ms=" << s.latency_ms
+	    << " latency_max_ms=" << s.max_latency_ms
+	    << " drift_ms=" << s.drift_ms
+	    << " drift_max_ms=" << s.max_drift_ms
+	    << " drift_samples=" << s.drift_samples
+	    << " provider_reads=" << s.provider_reads
+	    << " read_max_us=" << s.max_read_us
+	    << " read_hist_us=";
+	for (int i = 0; i < ReadTimeBuckets; ++i) {
+		if (i) out << ',';
+		if (i < ReadTimeBuckets - 1)
+			out << '<' << ReadTimeLimit(i);
+		else
+			out << ReadTimeLimit(i - 1) << '+';
+		out << ':' << s.read_time[i];
+	}
+	return out.str();
+}
+}
@@ -16,59 +16,53 @@
 
 #include "libaegisub/audio/provider.h"
 
+#include "libaegisub/audio/sample_convert.h"
 #include "libaegisub/fs.h"
 #include "libaegisub/io.h"
 #include "libaegisub/log.h"
 #include "libaegisub/util.h"
 
 namespace {
+/// Size of the blocks of raw audio fetched by FillBufferInt16Mono, which is
+/// small enough for the block and its converted samples to stay in cache
+const size_t conversion_block_bytes = 128 * 1024;
 
-template<typename Source>
-class ConvertFloatToInt16 {
-	Source* src;
-public:
-	ConvertFloatToInt16(Source* src) :src(src) {}
-	int16_t operator[](size_t idx) const {
-		Source expanded = src[idx] * 32768;
-		return expanded < -32768 ? -32768 :
-			expanded > 32767 ? 32767 :
-			static_cast<int16_t>(expanded);
-	}
+struct Scratch {
+	std::unique_ptr<char[]> data;
+	size_t size = 0;
 };
 
-// 8 bits per sample is assumed to be unsigned with a bias of 128,
-// while everything else is assumed to be signed with zero bias
-class ConvertIntToInt16 {
-	void* src;
-	int bytes_per_sample;
-public:
-	ConvertIntToInt16(void* src, int bytes_per_sample) :src(src), bytes_per_sample(bytes_per_sample) {}
-	const int16_t& operator[](size_t idx) const {
-		return *reinterpret_cast<int16_t*>(reinterpret_cast<char*>(src) + (idx + 1) * bytes_per_sample - sizeof(int16_t));
-	}
-};
-class ConvertUInt8ToInt16 {
-	uint8_t* src;
+/// Buffers not currently in use by this thread
+thread_local std::vector<Scratch> scratch_pool;
+
+/// @class ScratchLease
+/// @brief A conversion buffer borrowed from the calling thread's pool
+///
+/// FillBuffer can call back into FillBufferInt16Mono on another provider, so
+/// each call takes its own buffer out of the pool rather than sharing one.
+class ScratchLease {
+	Scratch scratch;
 public:
-	ConvertUInt8ToInt16(uint8_t* src) :src(src) {}
-	int16_t operator[](size_t idx) const {
-		return int16_t(src[idx]-128) << 8;
+	ScratchLease(size_t size) {
+		if (!scratch_pool.empty()) {
+			scratch = std::move(scratch_pool.back());
+			scratch_pool.pop_back();
+		}
+		if (scratch.size < size) {
+			scratch.data.reset(new char[size]);
+			scratch.size = size;
+		}
 	}
-};
 
-template<typename Source>
-class DownmixToMono {
-	Source src;
-	int channels;
-public:
-	DownmixToMono(Source src, int channels) :src(src), channels(channels) {}
-	int16_t operator[](size_t idx) const {
-		int ret = 0;
-		// Just average the channels together
-		for (int i = 0; i < channels; ++i)
-			ret += src[idx * channels + i];
-		return ret / channels;
+	~ScratchLease() {
+		scratch_pool.push_back(std::move(scratch));
 	}
+
+	ScratchLease(ScratchLease const&) = delete;
+	ScratchLease& operator=(ScratchLease const&) = delete;
+
+	template<typename T = char>
+	T *get() const { return reinterpret_cast<T *>(scratch.data.get()); }
 };
 }
 
@@ -78,45 +72,30 @@ void AudioProvider::FillBufferInt16Mono(int16_t* buf, int64_t start, int64_t cou
 		FillBuffer(buf, start, count);
 		return;
 	}
-	void* buff = malloc(bytes_per_sample * count * channels);
-	FillBuffer(buff, start, count);
-	if (channels == 1) {
-		if (float_samples) {
-			if (bytes_per_sample == sizeof(float))
-				for (int64_t i = 0; i < count; ++i)
-					buf[i] = ConvertFloatToInt16<float>(reinterpret_cast<float*>(buff))[i];
-			else if (bytes_per_sample == sizeof(double))
-				for (int64_t i = 0; i < count; ++i)
-					buf[i] = ConvertFloatToInt16<double>(reinterpret_cast<double*>(buff))[i];
-		}
-		else {
-			if (bytes_per_sample == sizeof(uint8_t))
-				for (int64_t i = 0; i < count; ++i)
-					buf[i] = ConvertUInt8ToInt16(reinterpret_cast<uint8_t*>(buff))[i];
-			else
-				for (int64_t i = 0; i < count; ++i)
-					buf[i] = ConvertIntToInt16(buff, bytes_per_sample)[i];
-		}
-	}
-	else {
-		if (float_samples) {
-			if (bytes_per_sample == sizeof(float))
-				for (int64_t i = 0; i < count; ++i)
-					buf[i] = DownmixToMono<ConvertFloatToInt16<float> >(ConvertFloatToInt16<float>(reinterpret_cast<float*>(buff)), channels)[i];
-			else if (bytes_per_sample == sizeof(double))
-				for (int64_t i = 0; i < count; ++i)
-					buf[i] = DownmixToMono<ConvertFloatToInt16<double> >(ConvertFloatToInt16<double>(reinterpret_cast<double*>(buff)), channels)[i];
-		}
+
+	const size_t frame_size = bytes_per_sample * channels;
+	const int64_t block = std::max<int64_t>(1, conversion_block_bytes / frame_size);
+	const int64_t block_frames = std::min(block, count);
+	ScratchLease raw(frame_size * block_frames);
+
+	// 16-bit audio can be downmixed directly, while everything else is
+	// converted into a second buffer first
+	const bool needs_conversion = float_samples || bytes_per_sample != 2;
+	const bool needs_downmix = channels > 1;
+	ScratchLease converted(needs_conversion && needs_downmix ? sizeof(int16_t) * channels * block_frames : 0);
+
+	for (int64_t i = 0; i < count; i += block) {
+		const int64_t frames = std::min(block, count - i);
+		FillBuffer(raw.get(), start + i, frames);
+		if (!needs_downmix)
+			ConvertSamplesToInt16(raw.get(), buf + i, frames, bytes_per_sample, float_samples);
+		else if (!needs_conversion)
+			DownmixInt16(raw.get<int16_t>(), buf + i, frames, channels);
 		else {
-			if (bytes_per_sample == sizeof(uint8_t))
-				for (int64_t i = 0; i < count; ++i)
-					buf[i] = DownmixToMono<ConvertUInt8ToInt16>(ConvertUInt8ToInt16(reinterpret_cast<uint8_t*>(buff)), channels)[i];
-			else
-				for (int64_t i = 0; i < count; ++i)
-					buf[i] = DownmixToMono<ConvertIntToInt16>(ConvertIntToInt16(buff, bytes_per_sample), channels)[i];
+			ConvertSamplesToInt16(raw.get(), converted.get<int16_t>(), frames * channels, bytes_per_sample, float_samples);
+			DownmixInt16(converted.get<int16_t>(), buf + i, frames, channels);
 		}
 	}
-	free(buff);
 }
 
 // This entire file has turned into a mess. For now I'm just following the pattern of the wangqr code, but
@@ -145,9 +124,7 @@ void AudioProvider::GetAudioWithVolume(void *buf, int64_t start, int64_t count,
 			for (int64_t i = 0; i < n; ++i)
 				buff[i] = util::mid(0, static_cast<int>(((int) buff[i] - 128) * volume + 128), 0xFF);
 		} else if (bytes_per_sample == sizeof(int16_t)) {
-			int16_t *buff = reinterpret_cast<int16_t *>(buf);
-			for (int64_t i = 0; i < n; ++i)
-				buff[i] = util::mid(-0x8000, static_cast<int>(buff[i] * volume), 0x7FFF);
+			ScaleInt16(reinterpret_cast<int16_t *>(buf), n, volume, false);
 		} else if (bytes_per_sample == sizeof(int32_t)) {
 			int32_t *buff = reinterpret_cast<int32_t *>(buf);
 			for (int64_t i = 0; i < n; ++i)
@@ -164,9 +141,7 @@ void AudioProvider::GetInt16MonoAudioWithVolume(int16_t *buf, int64_t start, int
 	GetInt16MonoAudio(buf, start, count);
 	if (volume == 1.0) return;
 
-	auto buffer = static_cast<int16_t *>(buf);
-	for (size_t i = 0; i < (size_t)count; ++i)
-		buffer[i] = util::mid(-0x8000, static_cast<int>(buffer[i] * volume + 0.5), 0x7FFF);
+	ScaleInt16(buf, count, volume, true);
 }
 
 void AudioProvider::ZeroFill(void *buf, int64_t count) const {
@@ -177,6 +152,10 @@ void AudioProvider::ZeroFill(void *buf, int64_t count) const {
 		memset(buf, 0, count * bytes_per_sample * channels);
 }
 
+bool AudioProvider::IsRangeDecoded(int64_t start, int64_t count) const {
+	return std::min(start + count, num_samples) <= decoded_samples;
+}
+
 void AudioProvider::GetAudio(void *buf, int64_t start, int64_t count) const {
 	if (start < 0) {
 		ZeroFill(buf, std::min(-start, count));
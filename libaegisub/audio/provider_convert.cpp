@@ -34,6 +34,12 @@ public:
 	void FillBuffer(void *buf, int64_t start, int64_t count) const override {
 		source->GetInt16MonoAudio(reinterpret_cast<int16_t*>(buf), start, count);
 	}
+
+	std::unique_ptr<AudioProvider> Clone() const override {
+		auto src = source->Clone();
+		if (!src) return nullptr;
+		return agi::make_unique<ConvertAudioProvider>(std::move(src));
+	}
 };
 /// Sample doubler with linear interpolation for the samples provider
 /// Requires 16-bit mono input
@@ -45,6 +51,12 @@ public:
 		decoded_samples = decoded_samples * 2;
 	}
 
+	std::unique_ptr<AudioProvider> Clone() const override {
+		auto src = source->Clone();
+		if (!src) return nullptr;
+		return agi::make_unique<SampleDoublingAudioProvider>(std::move(src));
+	}
+
 	void FillBuffer(void *buf, int64_t start, int64_t count) const override {
 		int16_t *src, *dst = static_cast<int16_t *>(buf);
 
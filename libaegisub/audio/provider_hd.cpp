@@ -14,7 +14,7 @@
 //
 // Aegisub Project http://www.aegisub.org/
 
-#include "libaegisub/audio/provider.h"
+#include "cache_provider.h"
 
 #include <libaegisub/file_mapping.h>
 #include <libaegisub/format.h>
@@ -25,33 +25,23 @@
 #include <boost/filesystem/path.hpp>
 #include <boost/interprocess/detail/os_thread_functions.hpp>
 #include <ctime>
-#include <thread>
+#include <mutex>
 
 namespace {
 using namespace agi;
 
-class HDAudioProvider final : public AudioProviderWrapper {
+class HDAudioProvider final : public CacheAudioProvider {
 	mutable temp_file_mapping file;
-	std::atomic<bool> cancelled = {false};
-	std::thread decoder;
+	/// The decoders share the file's write window
+	std::mutex write_mutex;
 
-	void FillBuffer(void *buf, int64_t start, int64_t count) const override {
-		auto missing = std::min(count, start + count - decoded_samples);
-		if (missing > 0) {
-			memset(static_cast<int16_t*>(buf) + count - missing, 0, missing * bytes_per_sample * channels);
-			count -= missing;
-		}
-
-		if (count > 0) {
-			start *= bytes_per_sample * channels;
-			count *= bytes_per_sample * channels;
-			memcpy(buf, file.read(start, count), count);
-		}
+	void ReadCache(void *buf, int64_t start, int64_t count) const override {
+		memcpy(buf, file.read(start * CacheFrameSize(), count * CacheFrameSize()), count * CacheFrameSize());
 	}
 
 	fs::path CacheFilename(fs::path const& dir) {
 		// Check free space
-		if ((uint64_t)num_samples * bytes_per_sample * channels > fs::FreeSpace(dir))
+		if ((uint64_t)num_samples * CacheFrameSize() > fs::FreeSpace(dir))
 			throw AudioProviderError("Not enough free disk space in " + dir.string() + " to cache the audio");
 
 		return format("audio-%lld-%lld", time(nullptr),
@@ -59,31 +49,43 @@ class HDAudioProvider final : public AudioProviderWrapper {
 	}
 
 public:
-	HDAudioProvider(std::unique_ptr<AudioProvider> src, agi::fs::path const& dir)
-	: AudioProviderWrapper(std::move(src))
-	, file(dir / CacheFilename(dir), num_samples * bytes_per_sample * channels)
+	HDAudioProvider(std::unique_ptr<AudioProvider> src, std::unique_ptr<AudioProvider> playback_src, agi::fs::path const& dir)
+	: CacheAudioProvider(*src, !!playback_src)
+	, file(dir / CacheFilename(dir), num_samples * CacheFrameSize())
 	{
-		decoded_samples = 0;
-		decoder = std::thread([&] {
-			int64_t block = 65536;
-			for (int64_t i = 0; i < num_samples; i += block) {
-				if (cancelled) break;
-				block = std::min(block, num_samples - i);
-				source->GetAudio(file.write(i * bytes_per_sample * channels, block * bytes_per_sample * channels), i, block);
-				decoded_samples += block;
-			}
-		});
+		source = std::move(src);
+		playback = std::move(playback_src);
+
+		// Map the file before the decoder starts so that concurrent reads on
+		// 64-bit builds never need to change the mapping
+		if (num_samples)
+			file.read(0, CacheFrameSize());
+
+		decoder = agi::make_unique<SegmentedDecoder>(*source, decoded_samples,
+			[this](AudioProvider const& src, int64_t start, int64_t count) {
+				const int64_t frame_size = CacheFrameSize();
+				std::vector<char> buf(std::min<int64_t>(count, 65536) * frame_size);
+				for (int64_t block = 65536; count > 0; start += block, count -= block) {
+					block = std::min(block, count);
+					Decode(src, buf.data(), start, block);
+					std::lock_guard<std::mutex> lock(write_mutex);
+					memcpy(file.write(start * frame_size, block * frame_size), buf.data(), block * frame_size);
+				}
+			},
+			[this](size_t segment) { AnnounceSegment(segment); });
 	}
 
 	~HDAudioProvider() {
-		cancelled = true;
-		decoder.join();
+		decoder.reset();
 	}
+
+	bool InMemory() const override { return false; }
 };
 }
 
 namespace agi {
 std::unique_ptr<AudioProvider> CreateHDAudioProvider(std::unique_ptr<AudioProvider> src, agi::fs::path const& dir) {
-	return agi::make_unique<HDAudioProvider>(std::move(src), dir);
+	auto playback = CreatePlaybackProvider(*src);
+	return agi::make_unique<HDAudioProvider>(std::move(src), std::move(playback), dir);
 }
 }
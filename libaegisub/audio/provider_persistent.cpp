@@ -0,0 +1,279 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include "cache_provider.h"
+
+#include <libaegisub/file_mapping.h>
+#include <libaegisub/fs.h>
+#include <libaegisub/log.h>
+#include <libaegisub/make_unique.h>
+
+#include <boost/filesystem/path.hpp>
+#include <mutex>
+
+namespace {
+using namespace agi;
+
+/// Start of a cache file, which is followed by the interleaved samples and
+/// then a bitmap of which segments of them have been written
+struct CacheHeader {
+	char magic[8];
+	/// Format of the samples in the file, which is either the source's
+	/// format or the 16-bit mono display stream
+	int32_t channels;
+	int32_t sample_rate;
+	int32_t bytes_per_sample;
+	int32_t float_samples;
+	int64_t num_samples;
+	/// Number of samples per channel which have been written
+	int64_t decoded_samples;
+	/// log2 of the number of samples per segment in the bitmap
+	int32_t segment_bits;
+};
+
+const char cache_magic[8] = {'A', 'G', 'I', 'P', 'C', 'M', '0', '2'};
+
+/// Offset of the samples in the file, leaving room for the header to grow
+const int64_t header_size = 64;
+static_assert(sizeof(CacheHeader) <= header_size, "Cache header is too large");
+
+/// Format of the samples stored in a cache file for a provider
+struct StoredFormat {
+	int channels;
+	int bytes_per_sample;
+	bool float_samples;
+	int sample_rate;
+	int64_t num_samples;
+
+	StoredFormat(AudioProvider const& provider, bool compact)
+	: channels(compact ? 1 : provider.GetChannels())
+	, bytes_per_sample(compact ? sizeof(int16_t) : provider.GetBytesPerSample())
+	, float_samples(compact ? false : provider.AreSamplesFloat())
+	, sample_rate(provider.GetSampleRate())
+	, num_samples(provider.GetNumSamples())
+	{
+	}
+
+	int64_t SamplesSize() const {
+		return num_samples * bytes_per_sample * channels;
+	}
+
+	int64_t BitmapSize() const {
+		const int64_t segments = (num_samples + SegmentedDecoder::SegmentSize - 1) >> SegmentedDecoder::SegmentBits;
+		return (segments + 7) / 8;
+	}
+
+	int64_t FileSize() const {
+		return header_size + SamplesSize() + BitmapSize();
+	}
+
+	bool Matches(CacheHeader const& header) const {
+		return memcmp(header.magic, cache_magic, sizeof(cache_magic)) == 0
+			&& header.channels == channels
+			&& header.sample_rate == sample_rate
+			&& header.bytes_per_sample == bytes_per_sample
+			&& header.float_samples == float_samples
+			&& header.num_samples == num_samples
+			&& header.decoded_samples >= 0
+			&& header.decoded_samples <= header.num_samples
+			&& header.segment_bits == SegmentedDecoder::SegmentBits;
+	}
+};
+
+/// Read which segments are already in the cache file for this audio
+/// @param[out] segments Bitmap of the segments which have been written
+/// @return Number of samples already in the file, or -1 if the file doesn't
+///         exist or holds something else
+int64_t cached_samples(fs::path const& cache_file, StoredFormat const& format, std::vector<bool>& segments) {
+	try {
+		read_file_mapping file(cache_file);
+		if ((int64_t)file.size() != format.FileSize())
+			return -1;
+		CacheHeader header;
+		memcpy(&header, file.read(0, sizeof(header)), sizeof(header));
+		if (!format.Matches(header))
+			return -1;
+
+		const auto bitmap = reinterpret_cast<const uint8_t *>(file.read(header_size + format.SamplesSize(), format.BitmapSize()));
+		segments.resize(size_t(format.BitmapSize() * 8));
+		for (size_t i = 0; i < segments.size(); ++i)
+			segments[i] = (bitmap[i / 8] >> (i % 8)) & 1;
+		return header.decoded_samples;
+	}
+	catch (fs::FileNotFound const&) {
+		return -1;
+	}
+}
+
+/// Audio provider for a cache file which has been completely decoded, which
+/// only needs the source provider if it has to decode the playback stream
+class CompleteCacheAudioProvider final : public CacheAudioProvider {
+	mutable read_file_mapping file;
+
+	void ReadCache(void *buf, int64_t start, int64_t count) const override {
+		memcpy(buf, file.read(header_size + start * CacheFrameSize(), count * CacheFrameSize()), count * CacheFrameSize());
+	}
+
+public:
+	/// @param src     Source of the audio, which is kept for playback if compact
+	/// @param compact Does the file hold only the display stream?
+	CompleteCacheAudioProvider(std::unique_ptr<AudioProvider> src, bool compact, fs::path const& cache_file)
+	: CacheAudioProvider(*src, compact)
+	, file(cache_file)
+	{
+		decoded_samples = num_samples;
+		if (compact)
+			source = CreateLockAudioProvider(std::move(src));
+
+		// Map the file now so that concurrent reads on 64-bit builds never
+		// need to change the mapping
+		file.read(0, header_size);
+	}
+
+	bool InMemory() const override { return false; }
+};
+
+/// Audio provider which decodes into a cache file, resuming from whatever
+/// an earlier session already wrote to it
+class PersistentAudioProvider final : public CacheAudioProvider {
+	std::unique_ptr<write_file_mapping> file;
+	const StoredFormat format;
+	/// The decoders share the file's write window
+	std::mutex write_mutex;
+
+	void ReadCache(void *buf, int64_t start, int64_t count) const override {
+		memcpy(buf, file->read(header_size + start * CacheFrameSize(), count * CacheFrameSize()), count * CacheFrameSize());
+	}
+
+	CacheHeader *Header() {
+		return reinterpret_cast<CacheHeader *>(file->write(0, header_size));
+	}
+
+	/// Record a finished segment in the file so that it's kept if decoding
+	/// is interrupted
+	///
+	/// Each step is on the disk before the next one refers to it: the samples
+	/// before the segment's bit, and the bitmap before the header's count, so
+	/// that a crash never leaves a marked segment without its samples.
+	void SegmentDone(size_t segment) {
+		const int64_t frame_size = CacheFrameSize();
+		const int64_t start = int64_t(segment) << SegmentedDecoder::SegmentBits;
+		const int64_t count = std::min(SegmentedDecoder::SegmentSize, format.num_samples - start);
+		const int64_t bitmap_offset = header_size + format.SamplesSize() + segment / 8;
+
+		std::lock_guard<std::mutex> lock(write_mutex);
+		try {
+			file->flush(header_size + start * frame_size, count * frame_size);
+			*reinterpret_cast<uint8_t *>(file->write(bitmap_offset, 1)) |= uint8_t(1 << (segment % 8));
+			file->flush(bitmap_offset, 1);
+			Header()->decoded_samples = decoded_samples;
+			file->flush(0, header_size);
+		}
+		catch (fs::FileSystemError const& e) {
+			// The segment is still usable this session, but it'll be decoded
+			// again next time
+			LOG_W("audio_provider/persistent") << "Could not save segment " << segment << ": " << e.GetMessage();
+		}
+	}
+
+public:
+	PersistentAudioProvider(std::unique_ptr<AudioProvider> src, std::unique_ptr<AudioProvider> playback_src,
+	                        std::unique_ptr<write_file_mapping> cache, std::vector<bool> const& segments)
+	: CacheAudioProvider(*src, !!playback_src)
+	, file(std::move(cache))
+	, format(*src, compact)
+	{
+		source = std::move(src);
+		playback = std::move(playback_src);
+		file->read(0, header_size);
+
+		if (segments.empty()) {
+			CacheHeader *header = Header();
+			memcpy(header->magic, cache_magic, sizeof(cache_magic));
+			header->channels = format.channels;
+			header->sample_rate = format.sample_rate;
+			header->bytes_per_sample = format.bytes_per_sample;
+			header->float_samples = format.float_samples;
+			header->num_samples = format.num_samples;
+			header->decoded_samples = 0;
+			header->segment_bits = SegmentedDecoder::SegmentBits;
+			memset(file->write(header_size + format.SamplesSize(), format.BitmapSize()), 0, format.BitmapSize());
+		}
+
+		decoder = agi::make_unique<SegmentedDecoder>(*source, decoded_samples,
+			[this](AudioProvider const& src, int64_t start, int64_t count) {
+				const int64_t frame_size = CacheFrameSize();
+				std::vector<char> buf(std::min<int64_t>(count, 65536) * frame_size);
+				for (int64_t block = 65536; count > 0; start += block, count -= block) {
+					block = std::min(block, count);
+					Decode(src, buf.data(), start, block);
+					std::lock_guard<std::mutex> lock(write_mutex);
+					memcpy(file->write(header_size + start * frame_size, block * frame_size), buf.data(), block * frame_size);
+				}
+			},
+			[this](size_t segment) {
+				SegmentDone(segment);
+				AnnounceSegment(segment);
+			},
+			segments);
+	}
+
+	~PersistentAudioProvider() {
+		decoder.reset();
+	}
+
+	bool InMemory() const override { return false; }
+};
+}
+
+namespace agi {
+std::unique_ptr<AudioProvider> CreatePersistentAudioProvider(std::unique_ptr<AudioProvider>& src, fs::path const& cache_file) {
+	// Everything which can fail is done before taking src, so that the caller
+	// can still fall back to another kind of cache
+	std::vector<bool> segments;
+
+	// A complete cache of either stream can be used without decoding anything
+	// into it, and playback can use the source itself
+	for (bool compact : {!IsDisplayFormat(*src), false}) {
+		if (cached_samples(cache_file, StoredFormat(*src, compact), segments) != src->GetNumSamples())
+			continue;
+		LOG_D("audio_provider/persistent") << "using complete cache " << cache_file;
+		auto provider = agi::make_unique<CompleteCacheAudioProvider>(std::move(src), compact, cache_file);
+		// Keep it from being the first thing cleaned up
+		fs::Touch(cache_file);
+		return provider;
+	}
+
+	auto playback = CreatePlaybackProvider(*src);
+	const StoredFormat format(*src, !!playback);
+	const int64_t cached = cached_samples(cache_file, format, segments);
+	if (cached < 0)
+		segments.clear();
+
+	const uint64_t needed = (format.num_samples - std::max<int64_t>(cached, 0)) * format.bytes_per_sample * format.channels;
+	if (needed > fs::FreeSpace(cache_file.parent_path()))
+		throw AudioProviderError("Not enough free disk space in " + cache_file.parent_path().string() + " to cache the audio");
+
+	auto file = agi::make_unique<write_file_mapping>(cache_file, format.FileSize());
+	if (cached > 0)
+		LOG_D("audio_provider/persistent") << "resuming " << cache_file << " with " << cached << " samples already decoded";
+	// Writes through the mapping don't reliably update the modification time,
+	// so a resumed cache could otherwise be the oldest file when the caller
+	// cleans up the cache directory and be deleted while in use
+	fs::Touch(cache_file);
+	return agi::make_unique<PersistentAudioProvider>(std::move(src), std::move(playback), std::move(file), segments);
+}
+}
@@ -14,13 +14,12 @@
 //
 // Aegisub Project http://www.aegisub.org/
 
-#include "libaegisub/audio/provider.h"
+#include "cache_provider.h"
 
 #include "libaegisub/make_unique.h"
 
 #include <array>
 #include <boost/container/stable_vector.hpp>
-#include <thread>
 
 namespace {
 using namespace agi;
@@ -28,71 +27,72 @@ using namespace agi;
 #define CacheBits 22
 #define CacheBlockSize (1 << CacheBits)
 
-class RAMAudioProvider final : public AudioProviderWrapper {
+class RAMAudioProvider final : public CacheAudioProvider {
 #ifdef _MSC_VER
 	boost::container::stable_vector<char[CacheBlockSize]> blockcache;
 #else
 	boost::container::stable_vector<std::array<char, CacheBlockSize>> blockcache;
 #endif
-	std::atomic<bool> cancelled = {false};
-	std::thread decoder;
 
-	void FillBuffer(void *buf, int64_t start, int64_t count) const override;
+	int64_t SamplesPerBlock() const {
+		return CacheBlockSize / CacheFrameSize();
+	}
+
+	/// Call func(block, byte offset, samples) for the part of the range in each cache block
+	template<typename Func>
+	void ForEachBlock(int64_t start, int64_t count, Func&& func) const {
+		const int64_t samples_per_block = SamplesPerBlock();
+		for (const int64_t end = start + count; start < end; ) {
+			const int64_t offset = start % samples_per_block;
+			const int64_t samples = std::min(end - start, samples_per_block - offset);
+			func(size_t(start / samples_per_block), offset * CacheFrameSize(), samples);
+			start += samples;
+		}
+	}
+
+	void ReadCache(void *buf, int64_t start, int64_t count) const override {
+		auto charbuf = static_cast<char *>(buf);
+		ForEachBlock(start, count, [&](size_t block, int64_t offset, int64_t samples) {
+			memcpy(charbuf, &blockcache[block][offset], samples * CacheFrameSize());
+			charbuf += samples * CacheFrameSize();
+		});
+	}
 
 public:
-	RAMAudioProvider(std::unique_ptr<AudioProvider> src)
-	: AudioProviderWrapper(std::move(src))
+	RAMAudioProvider(std::unique_ptr<AudioProvider> src, std::unique_ptr<AudioProvider> playback_src)
+	: CacheAudioProvider(*src, !!playback_src)
 	{
-		decoded_samples = 0;
+		source = std::move(src);
+		playback = std::move(playback_src);
 
 		try {
-			blockcache.resize((num_samples * bytes_per_sample * channels + CacheBlockSize - 1) >> CacheBits);
+			blockcache.resize((num_samples + SamplesPerBlock() - 1) / SamplesPerBlock());
 		}
 		catch (std::bad_alloc const&) {
 			throw AudioProviderError("Not enough memory available to cache in RAM");
 		}
 
-		decoder = std::thread([&] {
-			int64_t readsize = CacheBlockSize / bytes_per_sample / channels;
-			for (size_t i = 0; i < blockcache.size(); i++) {
-				if (cancelled) break;
-				auto actual_read = std::min<int64_t>(readsize, num_samples - i * readsize);
-				source->GetAudio(&blockcache[i][0], i * readsize, actual_read);
-				decoded_samples += actual_read;
-			}
-		});
+		decoder = agi::make_unique<SegmentedDecoder>(*source, decoded_samples,
+			[this](AudioProvider const& src, int64_t start, int64_t count) {
+				ForEachBlock(start, count, [&](size_t block, int64_t offset, int64_t samples) {
+					Decode(src, &blockcache[block][offset], start, samples);
+					start += samples;
+				});
+			},
+			[this](size_t segment) { AnnounceSegment(segment); });
 	}
 
 	~RAMAudioProvider() {
-		cancelled = true;
-		decoder.join();
+		decoder.reset();
 	}
-};
 
-void RAMAudioProvider::FillBuffer(void *buf, int64_t start, int64_t count) const {
-	auto charbuf = static_cast<char *>(buf);
-	for (int64_t bytes_remaining = count * bytes_per_sample * channels; bytes_remaining; ) {
-		if (start >= decoded_samples) {
-			memset(charbuf, 0, bytes_remaining);
-			break;
-		}
-
-		const int64_t samples_per_block = CacheBlockSize / bytes_per_sample / channels;
-
-		const size_t i = start / samples_per_block;
-		const int start_offset = (start % samples_per_block) * bytes_per_sample * channels;
-		const int read_size = std::min<int>(bytes_remaining, samples_per_block * bytes_per_sample * channels - start_offset);
-
-		memcpy(charbuf, &blockcache[i][start_offset], read_size);
-		charbuf += read_size;
-		bytes_remaining -= read_size;
-		start += read_size / bytes_per_sample / channels;
-	}
-}
+	bool InMemory() const override { return true; }
+};
 }
 
 namespace agi {
 std::unique_ptr<AudioProvider> CreateRAMAudioProvider(std::unique_ptr<AudioProvider> src) {
-	return agi::make_unique<RAMAudioProvider>(std::move(src));
+	auto playback = CreatePlaybackProvider(*src);
+	return agi::make_unique<RAMAudioProvider>(std::move(src), std::move(playback));
+}
 }
-}
\ No newline at end of file
@@ -0,0 +1,385 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include "libaegisub/audio/sample_convert.h"
+
+#include <cstring>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AGI_SAMPLE_CONVERT_SSE2
+#endif
+
+#if defined(AGI_SAMPLE_CONVERT_SSE2) && defined(__GNUC__)
+#include <immintrin.h>
+#define AGI_SAMPLE_CONVERT_AVX2
+#endif
+
+namespace {
+// The scalar versions define the exact results; the vector versions must
+// match them bit for bit, and are also used for the tails of the buffers.
+
+template<typename Source>
+void float_to_int16_scalar(const Source *src, int16_t *dst, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		Source expanded = src[i] * 32768;
+		dst[i] = expanded < -32768 ? -32768 :
+			expanded > 32767 ? 32767 :
+			static_cast<int16_t>(expanded);
+	}
+}
+
+void uint8_to_int16_scalar(const uint8_t *src, int16_t *dst, size_t count) {
+	for (size_t i = 0; i < count; ++i)
+		dst[i] = int16_t(src[i] - 128) << 8;
+}
+
+/// Keep the most significant 16 bits of little-endian samples of any size
+void int_to_int16_scalar(const char *src, int16_t *dst, size_t count, int bytes_per_sample) {
+	src += bytes_per_sample - sizeof(int16_t);
+	for (size_t i = 0; i < count; ++i, src += bytes_per_sample)
+		memcpy(&dst[i], src, sizeof(int16_t));
+}
+
+template<int... Channel>
+int sum_frame(const int16_t *src, std::integer_sequence<int, Channel...>) {
+	return (0 + ... + src[Channel]);
+}
+
+template<int Channels>
+void downmix_fixed(const int16_t *src, int16_t *dst, size_t frames) {
+	// With the channel count known, the sum is unrolled and the division is
+	// a multiply and shift
+	for (size_t i = 0; i < frames; ++i, src += Channels)
+		dst[i] = sum_frame(src, std::make_integer_sequence<int, Channels>()) / Channels;
+}
+
+void downmix_generic(const int16_t *src, int16_t *dst, size_t frames, int channels) {
+	for (size_t i = 0; i < frames; ++i, src += channels) {
+		int sum = 0;
+		for (int c = 0; c < channels; ++c)
+			sum += src[c];
+		dst[i] = sum / channels;
+	}
+}
+
+void scale_scalar(int16_t *buf, size_t count, double volume, double offset) {
+	for (size_t i = 0; i < count; ++i) {
+		int scaled = static_cast<int>(buf[i] * volume + offset);
+		buf[i] = scaled < -0x8000 ? -0x8000 : scaled > 0x7FFF ? 0x7FFF : scaled;
+	}
+}
+
+#ifdef AGI_SAMPLE_CONVERT_SSE2
+void float_to_int16_sse2(const float *src, int16_t *dst, size_t count) {
+	const __m128 scale = _mm_set1_ps(32768.f);
+	const __m128 lo = _mm_set1_ps(-32768.f);
+	const __m128 hi = _mm_set1_ps(32767.f);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m128 a = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+		__m128 b = _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale);
+		a = _mm_max_ps(_mm_min_ps(a, hi), lo);
+		b = _mm_max_ps(_mm_min_ps(b, hi), lo);
+		__m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), packed);
+	}
+	float_to_int16_scalar(src + i, dst + i, count - i);
+}
+
+void double_to_int16_sse2(const double *src, int16_t *dst, size_t count) {
+	const __m128d scale = _mm_set1_pd(32768.);
+	const __m128d lo = _mm_set1_pd(-32768.);
+	const __m128d hi = _mm_set1_pd(32767.);
+	auto convert = [&](const double *p) {
+		__m128d v = _mm_mul_pd(_mm_loadu_pd(p), scale);
+		return _mm_cvttpd_epi32(_mm_max_pd(_mm_min_pd(v, hi), lo));
+	};
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m128i a = _mm_unpacklo_epi64(convert(src + i), convert(src + i + 2));
+		__m128i b = _mm_unpacklo_epi64(convert(src + i + 4), convert(src + i + 6));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packs_epi32(a, b));
+	}
+	float_to_int16_scalar(src + i, dst + i, count - i);
+}
+
+void uint8_to_int16_sse2(const uint8_t *src, int16_t *dst, size_t count) {
+	// Flipping the top bit turns the biased sample into a signed one, which
+	// then just needs to end up in the high byte
+	const __m128i bias = _mm_set1_epi8(-128);
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)), bias);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_unpacklo_epi8(zero, v));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 8), _mm_unpackhi_epi8(zero, v));
+	}
+	uint8_to_int16_scalar(src + i, dst + i, count - i);
+}
+
+void int32_to_int16_sse2(const int32_t *src, int16_t *dst, size_t count) {
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m128i a = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)), 16);
+		__m128i b = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 4)), 16);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packs_epi32(a, b));
+	}
+	int_to_int16_scalar(reinterpret_cast<const char *>(src + i), dst + i, count - i, sizeof(int32_t));
+}
+
+/// Divide 32-bit sums by 2^Shift, rounding toward zero like integer division
+template<int Shift>
+inline __m128i divide_sse2(__m128i sum) {
+	__m128i bias = _mm_srli_epi32(_mm_srai_epi32(sum, 31), 32 - Shift);
+	return _mm_srai_epi32(_mm_add_epi32(sum, bias), Shift);
+}
+
+/// Sum adjacent pairs of 16-bit samples into 32 bits
+inline __m128i sum_pairs_sse2(const int16_t *src) {
+	return _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src)), _mm_set1_epi16(1));
+}
+
+void downmix_stereo_sse2(const int16_t *src, int16_t *dst, size_t frames) {
+	size_t i = 0;
+	for (; i + 8 <= frames; i += 8) {
+		__m128i a = divide_sse2<1>(sum_pairs_sse2(src + i * 2));
+		__m128i b = divide_sse2<1>(sum_pairs_sse2(src + i * 2 + 8));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packs_epi32(a, b));
+	}
+	downmix_fixed<2>(src + i * 2, dst + i, frames - i);
+}
+
+/// Sum four frames of four channels, one per 32-bit lane
+inline __m128i sum_quad_frames_sse2(const int16_t *src) {
+	// Each vector holds two frames as [f0 f0 f1 f1]; reorder to [f0 f1 f0 f1]
+	__m128i a = _mm_shuffle_epi32(sum_pairs_sse2(src), _MM_SHUFFLE(3, 1, 2, 0));
+	__m128i b = _mm_shuffle_epi32(sum_pairs_sse2(src + 8), _MM_SHUFFLE(3, 1, 2, 0));
+	return _mm_add_epi32(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b));
+}
+
+void downmix_quad_sse2(const int16_t *src, int16_t *dst, size_t frames) {
+	size_t i = 0;
+	for (; i + 8 <= frames; i += 8) {
+		__m128i a = divide_sse2<2>(sum_quad_frames_sse2(src + i * 4));
+		__m128i b = divide_sse2<2>(sum_quad_frames_sse2(src + i * 4 + 16));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packs_epi32(a, b));
+	}
+	downmix_fixed<4>(src + i * 4, dst + i, frames - i);
+}
+
+/// Sum four frames of six channels, one per 32-bit lane
+inline __m128 sum_six_frames_sse2(const int16_t *src) {
+	// The twelve pair sums are three per frame, spread over three vectors:
+	// [a0 b0 c0 a1] [b1 c1 a2 b2] [c2 a3 b3 c3]
+	__m128 p0 = _mm_castsi128_ps(sum_pairs_sse2(src));
+	__m128 p1 = _mm_castsi128_ps(sum_pairs_sse2(src + 8));
+	__m128 p2 = _mm_castsi128_ps(sum_pairs_sse2(src + 16));
+	__m128 m1 = _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(2, 1, 3, 2)); // a2 b2 a3 b3
+	__m128 m2 = _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(3, 0, 1, 0)); // b1 c1 c2 c3
+	__m128 m0 = _mm_shuffle_ps(p0, m2, _MM_SHUFFLE(1, 0, 2, 1)); // b0 c0 b1 c1
+	__m128i a = _mm_castps_si128(_mm_shuffle_ps(p0, m1, _MM_SHUFFLE(2, 0, 3, 0)));
+	__m128i b = _mm_castps_si128(_mm_shuffle_ps(m0, m1, _MM_SHUFFLE(3, 1, 2, 0)));
+	__m128i c = _mm_castps_si128(_mm_shuffle_ps(m0, m2, _MM_SHUFFLE(3, 2, 3, 1)));
+	// The sums fit in a float's mantissa, and 1/6 is rounded up far less
+	// than would be needed to move the product past an integer, so
+	// truncating the product matches integer division exactly
+	__m128 sum = _mm_cvtepi32_ps(_mm_add_epi32(_mm_add_epi32(a, b), c));
+	return _mm_mul_ps(sum, _mm_set1_ps(1.f / 6));
+}
+
+void downmix_six_sse2(const int16_t *src, int16_t *dst, size_t frames) {
+	size_t i = 0;
+	for (; i + 8 <= frames; i += 8) {
+		__m128i a = _mm_cvttps_epi32(sum_six_frames_sse2(src + i * 6));
+		__m128i b = _mm_cvttps_epi32(sum_six_frames_sse2(src + i * 6 + 24));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packs_epi32(a, b));
+	}
+	downmix_fixed<6>(src + i * 6, dst + i, frames - i);
+}
+
+/// Sum four frames of eight channels, one per 32-bit lane
+inline __m128i sum_octo_frames_sse2(const int16_t *src) {
+	// Each vector is one frame's four pair sums, so transpose and add
+	__m128i f0 = sum_pairs_sse2(src), f1 = sum_pairs_sse2(src + 8);
+	__m128i f2 = sum_pairs_sse2(src + 16), f3 = sum_pairs_sse2(src + 24);
+	__m128i a = _mm_add_epi32(_mm_unpacklo_epi32(f0, f1), _mm_unpackhi_epi32(f0, f1));
+	__m128i b = _mm_add_epi32(_mm_unpacklo_epi32(f2, f3), _mm_unpackhi_epi32(f2, f3));
+	return _mm_add_epi32(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b));
+}
+
+void downmix_octo_sse2(const int16_t *src, int16_t *dst, size_t frames) {
+	size_t i = 0;
+	for (; i + 8 <= frames; i += 8) {
+		__m128i a = divide_sse2<3>(sum_octo_frames_sse2(src + i * 8));
+		__m128i b = divide_sse2<3>(sum_octo_frames_sse2(src + i * 8 + 32));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packs_epi32(a, b));
+	}
+	downmix_fixed<8>(src + i * 8, dst + i, frames - i);
+}
+
+void scale_sse2(int16_t *buf, size_t count, double volume, double offset) {
+	const __m128d vol = _mm_set1_pd(volume);
+	const __m128d off = _mm_set1_pd(offset);
+	auto scale = [&](__m128i v) {
+		__m128i lo = _mm_cvttpd_epi32(_mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(v), vol), off));
+		__m128i hi = _mm_cvttpd_epi32(_mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(v, 8)), vol), off));
+		return _mm_unpacklo_epi64(lo, hi);
+	};
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + i));
+		// Sign-extend to 32 bits by putting each sample in the high half
+		__m128i a = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+		__m128i b = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(buf + i), _mm_packs_epi32(scale(a), scale(b)));
+	}
+	scale_scalar(buf + i, count - i, volume, offset);
+}
+#endif
+
+#ifdef AGI_SAMPLE_CONVERT_AVX2
+__attribute__((target("avx2")))
+void float_to_int16_avx2(const float *src, int16_t *dst, size_t count) {
+	const __m256 scale = _mm256_set1_ps(32768.f);
+	const __m256 lo = _mm256_set1_ps(-32768.f);
+	const __m256 hi = _mm256_set1_ps(32767.f);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m256 a = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale);
+		__m256 b = _mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale);
+		a = _mm256_max_ps(_mm256_min_ps(a, hi), lo);
+		b = _mm256_max_ps(_mm256_min_ps(b, hi), lo);
+		// packs works within each 128-bit lane, so put the quarters back in order
+		__m256i packed = _mm256_packs_epi32(_mm256_cvttps_epi32(a), _mm256_cvttps_epi32(b));
+		packed = _mm256_permute4x64_epi64(packed, 0xD8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), packed);
+	}
+	float_to_int16_sse2(src + i, dst + i, count - i);
+}
+
+__attribute__((target("avx2")))
+inline __m256i average_pairs_avx2(__m256i v) {
+	__m256i sum = _mm256_madd_epi16(v, _mm256_set1_epi16(1));
+	return _mm256_srai_epi32(_mm256_add_epi32(sum, _mm256_srli_epi32(sum, 31)), 1);
+}
+
+__attribute__((target("avx2")))
+void downmix_stereo_avx2(const int16_t *src, int16_t *dst, size_t frames) {
+	size_t i = 0;
+	for (; i + 16 <= frames; i += 16) {
+		__m256i a = average_pairs_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 2)));
+		__m256i b = average_pairs_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 2 + 16)));
+		__m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), packed);
+	}
+	downmix_stereo_sse2(src + i * 2, dst + i, frames - i);
+}
+
+__attribute__((target("avx2")))
+void scale_avx2(int16_t *buf, size_t count, double volume, double offset) {
+	const __m256d vol = _mm256_set1_pd(volume);
+	const __m256d off = _mm256_set1_pd(offset);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + i)));
+		__m256d lo = _mm256_cvtepi32_pd(_mm256_castsi256_si128(v));
+		__m256d hi = _mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1));
+		__m128i a = _mm256_cvttpd_epi32(_mm256_add_pd(_mm256_mul_pd(lo, vol), off));
+		__m128i b = _mm256_cvttpd_epi32(_mm256_add_pd(_mm256_mul_pd(hi, vol), off));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(buf + i), _mm_packs_epi32(a, b));
+	}
+	scale_scalar(buf + i, count - i, volume, offset);
+}
+#endif
+
+/// The implementations picked for the running CPU
+struct Kernels {
+	void (*float_to_int16)(const float *, int16_t *, size_t);
+	void (*double_to_int16)(const double *, int16_t *, size_t);
+	void (*uint8_to_int16)(const uint8_t *, int16_t *, size_t);
+	void (*downmix_stereo)(const int16_t *, int16_t *, size_t);
+	void (*scale)(int16_t *, size_t, double, double);
+};
+
+Kernels select_kernels() {
+#ifdef AGI_SAMPLE_CONVERT_AVX2
+	if (__builtin_cpu_supports("avx2"))
+		return {float_to_int16_avx2, double_to_int16_sse2, uint8_to_int16_sse2, downmix_stereo_avx2, scale_avx2};
+#endif
+#ifdef AGI_SAMPLE_CONVERT_SSE2
+	return {float_to_int16_sse2, double_to_int16_sse2, uint8_to_int16_sse2, downmix_stereo_sse2, scale_sse2};
+#else
+	return {float_to_int16_scalar<float>, float_to_int16_scalar<double>, uint8_to_int16_scalar, downmix_fixed<2>, scale_scalar};
+#endif
+}
+
+Kernels const& kernels() {
+	static const Kernels impl = select_kernels();
+	return impl;
+}
+}
+
+namespace agi {
+void ConvertSamplesToInt16(const void *src, int16_t *dst, size_t count, int bytes_per_sample, bool is_float) {
+	if (is_float) {
+		if (bytes_per_sample == sizeof(float))
+			kernels().float_to_int16(static_cast<const float *>(src), dst, count);
+		else if (bytes_per_sample == sizeof(double))
+			kernels().double_to_int16(static_cast<const double *>(src), dst, count);
+	}
+	else if (bytes_per_sample == sizeof(uint8_t))
+		kernels().uint8_to_int16(static_cast<const uint8_t *>(src), dst, count);
+	else if (bytes_per_sample == sizeof(int16_t)) {
+		if (src != dst)
+			memcpy(dst, src, count * sizeof(int16_t));
+	}
+#ifdef AGI_SAMPLE_CONVERT_SSE2
+	else if (bytes_per_sample == sizeof(int32_t))
+		int32_to_int16_sse2(static_cast<const int32_t *>(src), dst, count);
+#endif
+	else
+		int_to_int16_scalar(static_cast<const char *>(src), dst, count, bytes_per_sample);
+}
+
+void DownmixInt16(const int16_t *src, int16_t *dst, size_t frames, int channels) {
+	switch (channels) {
+		case 1: if (src != dst) memcpy(dst, src, frames * sizeof(int16_t)); break;
+		case 2: kernels().downmix_stereo(src, dst, frames); break;
+		case 3: downmix_fixed<3>(src, dst, frames); break;
+#ifdef AGI_SAMPLE_CONVERT_SSE2
+		case 4: downmix_quad_sse2(src, dst, frames); break;
+#else
+		case 4: downmix_fixed<4>(src, dst, frames); break;
+#endif
+		case 5: downmix_fixed<5>(src, dst, frames); break;
+		case 7: downmix_fixed<7>(src, dst, frames); break;
+#ifdef AGI_SAMPLE_CONVERT_SSE2
+		case 6: downmix_six_sse2(src, dst, frames); break;
+		case 8: downmix_octo_sse2(src, dst, frames); break;
+#else
+		case 6: downmix_fixed<6>(src, dst, frames); break;
+		case 8: downmix_fixed<8>(src, dst, frames); break;
+#endif
+		default: downmix_generic(src, dst, frames, channels); break;
+	}
+}
+
+void ScaleInt16(int16_t *buf, size_t count, double volume, bool round) {
+	kernels().scale(buf, count, volume, round ? 0.5 : 0.0);
+}
+}
@@ -0,0 +1,180 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include "segmented_decoder.h"
+
+#include "libaegisub/audio/provider.h"
+
+namespace {
+/// Most decoders which will be run at once
+const unsigned max_decoders = 4;
+
+/// Most prioritized segments remembered; older requests are dropped first
+const size_t max_urgent = 1024;
+
+const size_t no_segment = size_t(-1);
+}
+
+namespace agi {
+SegmentedDecoder::SegmentedDecoder(AudioProvider const& source, std::atomic<int64_t>& decoded_samples,
+                                   DecodeFunc decode, DoneFunc done,
+                                   std::vector<bool> const& already_decoded)
+: source(source)
+, num_samples(source.GetNumSamples())
+, segment_count(size_t((num_samples + SegmentSize - 1) >> SegmentBits))
+, decoded_samples(decoded_samples)
+, decode(std::move(decode))
+, done(std::move(done))
+, done_bits(new std::atomic<uint64_t>[segment_count / 64 + 1])
+, state(segment_count, Pending)
+{
+	for (size_t i = 0; i < segment_count / 64 + 1; ++i)
+		done_bits[i] = 0;
+
+	size_t pending = segment_count;
+	int64_t decoded = 0;
+	for (size_t i = 0; i < std::min(segment_count, already_decoded.size()); ++i) {
+		if (!already_decoded[i]) continue;
+		state[i] = Done;
+		done_bits[i / 64] |= uint64_t(1) << (i % 64);
+		decoded += std::min(SegmentSize, num_samples - (int64_t(i) << SegmentBits));
+		--pending;
+	}
+	decoded_samples = decoded;
+
+	const size_t threads = std::min<size_t>(pending, std::max(1u, std::min(max_decoders, std::thread::hardware_concurrency())));
+	for (size_t i = 0; i < threads; ++i)
+		workers.emplace_back([=] { Work(i); });
+}
+
+SegmentedDecoder::~SegmentedDecoder() {
+	cancelled = true;
+	for (auto& worker : workers)
+		worker.join();
+}
+
+bool SegmentedDecoder::IsRangeDecoded(int64_t start, int64_t count) const {
+	start = std::max<int64_t>(start, 0);
+	const int64_t end = std::min(start + count, num_samples);
+	if (end <= start) return true;
+
+	for (size_t i = size_t(start >> SegmentBits), last = size_t((end - 1) >> SegmentBits); i <= last; ++i) {
+		if (!IsSegmentDecoded(i))
+			return false;
+	}
+	return true;
+}
+
+void SegmentedDecoder::Prioritize(int64_t start, int64_t count) {
+	start = std::max<int64_t>(start, 0);
+	const int64_t end = std::min(start + count, num_samples);
+	if (IsRangeDecoded(start, end - start)) return;
+
+	const size_t first = size_t(start >> SegmentBits);
+	std::lock_guard<std::mutex> lock(mutex);
+	for (size_t i = size_t((end - 1) >> SegmentBits) + 1; i-- > first; ) {
+		if (state[i] == Pending)
+			urgent.push_front(i);
+	}
+	if (urgent.size() > max_urgent)
+		urgent.resize(max_urgent);
+}
+
+size_t SegmentedDecoder::Claim(size_t previous) {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto claim = [&](size_t segment) {
+		state[segment] = Claimed;
+		return segment;
+	};
+
+	const size_t next = previous + 1;
+	const bool can_continue = previous != no_segment && next < segment_count && state[next] == Pending;
+
+	// Prioritized segments come first, but if the one right after what this
+	// thread just did is among them take that to avoid a seek
+	while (!urgent.empty()) {
+		if (can_continue && std::find(urgent.begin(), urgent.end(), next) != urgent.end())
+			return claim(next);
+		const size_t segment = urgent.front();
+		urgent.pop_front();
+		if (state[segment] == Pending)
+			return claim(segment);
+	}
+
+	if (can_continue)
+		return claim(next);
+
+	// Otherwise pick the longest run of segments which nobody has started on.
+	// If another thread is working its way into the run from the left, leave
+	// it the first half.
+	size_t best_start = 0, best_length = 0;
+	for (size_t i = 0; i < segment_count; ) {
+		if (state[i] != Pending) {
+			++i;
+			continue;
+		}
+		size_t j = i;
+		while (j < segment_count && state[j] == Pending) ++j;
+		if (j - i > best_length) {
+			best_start = i;
+			best_length = j - i;
+		}
+		i = j;
+	}
+
+	if (best_length == 0)
+		return no_segment;
+	if (best_start > 0 && state[best_start - 1] == Claimed)
+		return claim(best_start + best_length / 2);
+	return claim(best_start);
+}
+
+void SegmentedDecoder::Work(size_t index) {
+	// The first thread uses the source itself and the rest need their own
+	std::unique_ptr<AudioProvider> clone;
+	if (index > 0) {
+		std::lock_guard<std::mutex> lock(clone_mutex);
+		if (!cancelled)
+			clone = source.Clone();
+		if (!clone
+			|| clone->GetNumSamples() != source.GetNumSamples()
+			|| clone->GetChannels() != source.GetChannels()
+			|| clone->GetBytesPerSample() != source.GetBytesPerSample()
+			|| clone->AreSamplesFloat() != source.AreSamplesFloat())
+			return;
+	}
+	AudioProvider const& decoder = clone ? *clone : source;
+
+	size_t previous = no_segment;
+	while (!cancelled) {
+		const size_t segment = Claim(previous);
+		if (segment == no_segment) break;
+
+		const int64_t start = int64_t(segment) << SegmentBits;
+		const int64_t count = std::min(SegmentSize, num_samples - start);
+		decode(decoder, start, count);
+
+		done_bits[segment / 64].fetch_or(uint64_t(1) << (segment % 64), std::memory_order_release);
+		decoded_samples += count;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			state[segment] = Done;
+		}
+		if (done) done(segment);
+		previous = segment;
+	}
+}
+}
@@ -0,0 +1,117 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace agi {
+class AudioProvider;
+
+/// @class SegmentedDecoder
+/// @brief Background decoding for the cache providers
+///
+/// The audio is split into fixed-size segments which are decoded in whatever
+/// order is most useful: segments which have been asked for with Prioritize()
+/// first, and then the rest in long runs so that each decoder rarely has to
+/// seek. Several threads decode at once when the source can be cloned.
+class SegmentedDecoder {
+public:
+	/// Decode [start, start + count) from decoder into the cache
+	/// Called on the decoding threads, possibly several at once
+	using DecodeFunc = std::function<void (AudioProvider const& decoder, int64_t start, int64_t count)>;
+	/// Called on the decoding threads after a segment has been marked decoded
+	using DoneFunc = std::function<void (size_t segment)>;
+
+	/// log2 of the number of samples per channel in each segment
+	static const int SegmentBits = 18;
+	static const int64_t SegmentSize = int64_t(1) << SegmentBits;
+
+private:
+	enum SegmentState : uint8_t { Pending, Claimed, Done };
+
+	AudioProvider const& source;
+	const int64_t num_samples;
+	const size_t segment_count;
+	std::atomic<int64_t>& decoded_samples;
+	DecodeFunc decode;
+	DoneFunc done;
+
+	/// One bit per decoded segment, which can be checked without locking
+	std::unique_ptr<std::atomic<uint64_t>[]> done_bits;
+
+	/// Protects state and urgent
+	std::mutex mutex;
+	std::vector<SegmentState> state;
+	/// Segments which have been prioritized, most recent first
+	std::deque<size_t> urgent;
+
+	/// Clone() isn't required to be thread-safe
+	std::mutex clone_mutex;
+	std::atomic<bool> cancelled{false};
+	std::vector<std::thread> workers;
+
+	size_t Claim(size_t previous);
+	void Work(size_t index);
+
+public:
+	/// @param source          Provider to decode from; cloned for the additional threads
+	/// @param decoded_samples Counter of decoded samples to keep up to date
+	/// @param decode          Function which decodes a range into the cache
+	/// @param done            Optional function called after each segment is finished
+	/// @param already_decoded Segments which are already in the cache
+	SegmentedDecoder(AudioProvider const& source, std::atomic<int64_t>& decoded_samples,
+	                 DecodeFunc decode, DoneFunc done = nullptr,
+	                 std::vector<bool> const& already_decoded = {});
+	~SegmentedDecoder();
+
+	size_t GetSegmentCount() const { return segment_count; }
+
+	bool IsSegmentDecoded(size_t segment) const {
+		return (done_bits[segment / 64].load(std::memory_order_acquire) >> (segment % 64)) & 1;
+	}
+
+	/// Are all of the segments overlapping the given range decoded?
+	bool IsRangeDecoded(int64_t start, int64_t count) const;
+
+	/// Decode the segments overlapping the given range before anything else
+	void Prioritize(int64_t start, int64_t count);
+
+	/// Split a range into runs which are either entirely decoded or entirely
+	/// not, calling func(start, count, decoded) for each
+	template<typename Func>
+	void ForEachRun(int64_t start, int64_t count, Func&& func) const {
+		while (count > 0) {
+			const bool decoded = IsSegmentDecoded(size_t(start >> SegmentBits));
+			int64_t end = ((start >> SegmentBits) + 1) << SegmentBits;
+			while (end < start + count && IsSegmentDecoded(size_t(end >> SegmentBits)) == decoded)
+				end += SegmentSize;
+			end = std::min(end, start + count);
+			func(start, end - start, decoded);
+			count -= end - start;
+			start = end;
+		}
+	}
+};
+}
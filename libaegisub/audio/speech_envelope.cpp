@@ -0,0 +1,179 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include "libaegisub/audio/speech_envelope.h"
+
+#include "libaegisub/audio/provider.h"
+#include "libaegisub/log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+/// Number of frames analyzed at a time
+const int64_t block_frames = 100;
+
+/// How far above the noise floor a frame has to be to count as speech, in dB
+const float speech_threshold = 12.f;
+/// Frames quieter than this are never speech, however quiet the noise is
+const float min_speech_level = -50.f;
+/// How quickly the noise floor estimate creeps up towards the level of the
+/// audio, in dB per frame. It drops immediately to anything quieter.
+const float floor_rise = 0.02f;
+
+/// Shortest run of speech frames which starts speech
+const int min_speech_frames = 5;
+/// Shortest run of quiet frames which stops speech
+const int min_gap_frames = 15;
+}
+
+namespace agi {
+SpeechEnvelope::SpeechEnvelope(AudioProvider const* provider)
+: provider(provider)
+, frame_count((provider->GetNumSamples() * 1000 / FrameMs + provider->GetSampleRate() - 1) / provider->GetSampleRate())
+, worker([this] { Work(); })
+{
+}
+
+SpeechEnvelope::~SpeechEnvelope() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		cancelled = true;
+	}
+	cancel_cond.notify_all();
+	worker.join();
+}
+
+int64_t SpeechEnvelope::FrameStart(int64_t frame) const {
+	return frame * provider->GetSampleRate() * FrameMs / 1000;
+}
+
+void SpeechEnvelope::Work() {
+	const int64_t num_samples = provider->GetNumSamples();
+	std::vector<int16_t> samples;
+	std::vector<float> new_levels;
+	std::vector<int> new_onsets, new_offsets;
+
+	float noise_floor = MinLevel;
+	bool in_speech = false;
+	// Current run of frames which disagree with in_speech
+	int64_t run_start = 0;
+	int run_length = 0;
+
+	for (int64_t first = 0; first < frame_count && !cancelled; first += block_frames) {
+		const int64_t frames = std::min(block_frames, frame_count - first);
+		const int64_t start = FrameStart(first);
+		const int64_t count = std::min(FrameStart(first + frames), num_samples) - start;
+
+		// Wait for the cache to have this part of the audio rather than
+		// analyzing the silence it returns for undecoded audio
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while (!cancelled && !provider->IsRangeDecoded(start, count))
+				cancel_cond.wait_for(lock, std::chrono::milliseconds(50));
+			if (cancelled) return;
+		}
+
+		samples.resize(count);
+		provider->GetInt16MonoAudio(samples.data(), start, count);
+
+		new_levels.clear();
+		new_onsets.clear();
+		new_offsets.clear();
+		for (int64_t frame = first; frame < first + frames; ++frame) {
+			const int64_t begin = FrameStart(frame) - start;
+			const int64_t end = std::min(FrameStart(frame + 1), num_samples) - start;
+
+			int64_t sum = 0;
+			for (int64_t i = begin; i < end; ++i)
+				sum += int32_t(samples[i]) * samples[i];
+
+			float level = MinLevel;
+			if (sum > 0 && end > begin)
+				level = std::max(MinLevel, 10.f * std::log10(float(sum) / float(end - begin) / (32768.f * 32768.f)));
+			new_levels.push_back(level);
+
+			if (frame == 0 || level < noise_floor)
+				noise_floor = level;
+			else
+				noise_floor = std::min(noise_floor + floor_rise, level);
+
+			const bool speech = level >= min_speech_level && level > noise_floor + speech_threshold;
+			if (speech == in_speech) {
+				run_length = 0;
+				continue;
+			}
+
+			if (run_length++ == 0)
+				run_start = frame;
+			if (run_length >= (in_speech ? min_gap_frames : min_speech_frames)) {
+				(in_speech ? new_offsets : new_onsets).push_back(int(run_start * FrameMs));
+				in_speech = !in_speech;
+				run_length = 0;
+			}
+		}
+
+		// Speech which runs to the end of the audio stops there
+		if (first + frames == frame_count && in_speech)
+			new_offsets.push_back(int((run_length ? run_start : frame_count) * FrameMs));
+
+		std::lock_guard<std::mutex> lock(mutex);
+		levels.insert(levels.end(), new_levels.begin(), new_levels.end());
+		onsets.insert(onsets.end(), new_onsets.begin(), new_onsets.end());
+		offsets.insert(offsets.end(), new_offsets.begin(), new_offsets.end());
+	}
+
+	if (!cancelled)
+		LOG_D("audio/speech_envelope") << "found " << onsets.size() << " speech onsets in " << frame_count << " frames";
+}
+
+int SpeechEnvelope::Nearest(std::vector<int> const& times, int ms, int range_ms) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = std::lower_bound(times.begin(), times.end(), ms);
+	int best = -1;
+	if (it != times.end() && *it - ms <= range_ms)
+		best = *it;
+	if (it != times.begin() && ms - *(it - 1) <= range_ms && (best < 0 || ms - *(it - 1) < best - ms))
+		best = *(it - 1);
+	return best;
+}
+
+int SpeechEnvelope::NearestOnset(int ms, int range_ms) const {
+	return Nearest(onsets, ms, range_ms);
+}
+
+int SpeechEnvelope::NearestOffset(int ms, int range_ms) const {
+	return Nearest(offsets, ms, range_ms);
+}
+
+float SpeechEnvelope::GetLevel(int ms) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (ms < 0 || size_t(ms / FrameMs) >= levels.size())
+		return MinLevel;
+	return levels[ms / FrameMs];
+}
+
+int SpeechEnvelope::GetAnalyzedMs() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return int(levels.size() * FrameMs);
+}
+
+bool SpeechEnvelope::IsComplete() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return int64_t(levels.size()) == frame_count;
+}
+}
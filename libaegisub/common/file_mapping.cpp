@@ -71,6 +71,25 @@ char *map(int64_t s_offset, uint64_t length, boost::interprocess::mode_t mode,
 	return static_cast<char *>(region->get_address()) + offset - mapping_start;
 }
 
+void resize(agi::file_mapping const& file, agi::fs::path const& filename, uint64_t size) {
+	auto handle = file.get_mapping_handle().handle;
+#ifdef _WIN32
+	LARGE_INTEGER li;
+	li.QuadPart = size;
+	SetFilePointerEx(handle, li, nullptr, FILE_BEGIN);
+	SetEndOfFile(handle);
+#else
+	if (ftruncate(handle, size) == -1) {
+		switch (errno) {
+		case EBADF:  throw agi::InternalError("Error opening file " + filename.string() + " not handled");
+		case EFBIG:  throw agi::fs::DriveFull(filename);
+		case EINVAL: throw agi::InternalError("File opened incorrectly: " + filename.string());
+		case EROFS:  throw agi::fs::WriteDenied(filename);
+		default: throw agi::fs::FileSystemUnknownError("Unknown error opening file: " + filename.string());
+		}
+	}
+#endif
+}
 }
 
 namespace agi {
@@ -140,24 +159,10 @@ temp_file_mapping::temp_file_mapping(fs::path const& filename, uint64_t size)
 : file(filename, true)
 , file_size(size)
 {
-	auto handle = file.get_mapping_handle().handle;
-#ifdef _WIN32
-	LARGE_INTEGER li;
-	li.QuadPart = size;
-	SetFilePointerEx(handle, li, nullptr, FILE_BEGIN);
-	SetEndOfFile(handle);
-#else
+#ifndef _WIN32
 	unlink(filename.string().c_str());
-	if (ftruncate(handle, size) == -1) {
-		switch (errno) {
-		case EBADF:  throw InternalError("Error opening file " + filename.string() + " not handled");
-		case EFBIG:  throw fs::DriveFull(filename);
-		case EINVAL: throw InternalError("File opened incorrectly: " + filename.string());
-		case EROFS:  throw fs::WriteDenied(filename);
-		default: throw fs::FileSystemUnknownError("Unknown error opening file: " + filename.string());
-		}
-	}
 #endif
+	resize(file, filename, size);
 }
 
 temp_file_mapping::~temp_file_mapping() { }
@@ -169,4 +174,34 @@ const char *temp_file_mapping::read(int64_t offset, uint64_t length) {
 char *temp_file_mapping::write(int64_t offset, uint64_t length) {
 	return map(offset, length, read_write, file_size, file, write_region, write_mapping_start);
 }
+
+write_file_mapping::write_file_mapping(fs::path const& filename, uint64_t size)
+: file(filename, true)
+, file_size(size)
+{
+	resize(file, filename, size);
+}
+
+write_file_mapping::~write_file_mapping() { }
+
+const char *write_file_mapping::read(int64_t offset, uint64_t length) {
+	return map(offset, length, read_only, file_size, file, read_region, read_mapping_start);
+}
+
+char *write_file_mapping::write(int64_t offset, uint64_t length) {
+	return map(offset, length, read_write, file_size, file, write_region, write_mapping_start);
+}
+
+void write_file_mapping::flush(int64_t offset, uint64_t length) {
+	if (length == 0) return;
+	write(offset, length);
+
+	// The start of the range has to be page-aligned; the mapping itself
+	// always starts on a page boundary
+	auto start = static_cast<uint64_t>(offset) - write_mapping_start;
+	auto aligned = start & ~static_cast<uint64_t>(mapped_region::get_page_size() - 1);
+	length += start - aligned;
+	if (!write_region->flush(static_cast<size_t>(aligned), static_cast<size_t>(length), false))
+		throw fs::FileSystemUnknownError("Failed flushing the file");
+}
 }
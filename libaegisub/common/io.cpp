@@ -57,6 +57,7 @@ Save::Save(fs::path const& file, bool binary)
 }
 
 Save::~Save() noexcept(false) {
+	if (!fp) return; // Cancelled
 	fp.reset(); // Need to close before rename on Windows to unlock the file
 	for (int i = 0; i < 10; ++i) {
 		try {
@@ -72,5 +73,15 @@ Save::~Save() noexcept(false) {
 	}
 }
 
+void Save::Cancel() noexcept {
+	fp.reset();
+	try {
+		fs::Remove(tmp_name);
+	}
+	catch (agi::fs::FileSystemError const&) {
+		LOG_W("agi/io/save/file") << "Could not remove " << tmp_name;
+	}
+}
+
 	} // namespace io
 } // namespace agi
@@ -0,0 +1,71 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#pragma once
+
+#include <boost/range/iterator_range.hpp>
+
+namespace agi { namespace ass {
+typedef boost::iterator_range<const char *> CharRange;
+
+/// Find the first instance of a character in a buffer
+/// @return Pointer to the character, or end if it was not found
+///
+/// Uses AVX2 or SSE2 when available, picked at runtime.
+const char *FindChar(const char *begin, const char *end, char c);
+
+/// @class FieldScanner
+/// @brief Splits a comma-separated line into fields without copying
+///
+/// This has the same semantics as agi::Split: an empty line has no fields and
+/// a trailing comma produces a final empty field.
+class FieldScanner {
+	const char *cur;
+	const char *end;
+	bool is_end;
+
+public:
+	FieldScanner(const char *begin, const char *end)
+	: cur(begin), end(end), is_end(begin == end) { }
+
+	/// Are there any fields left?
+	bool AtEnd() const { return is_end; }
+
+	/// Get the next field
+	/// @param[out] field Field read, not including the separator
+	/// @return false if there were no fields left
+	bool Next(CharRange &field) {
+		if (is_end) return false;
+		const char *sep = FindChar(cur, end, ',');
+		field = CharRange(cur, sep);
+		if (sep == end)
+			is_end = true;
+		else
+			cur = sep + 1;
+		return true;
+	}
+};
+
+/// Trim ASCII whitespace from both ends of a range
+CharRange Trim(CharRange range);
+
+/// @brief Parse a range consisting of just an optionally signed decimal integer
+/// @param range Text to parse
+/// @param[out] out Parsed value
+/// @return false if the range was empty, contained anything else, or was too
+///         long to be parsed without risking overflow
+bool ParseInt(CharRange range, int &out);
+} }
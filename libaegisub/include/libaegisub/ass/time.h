@@ -26,6 +26,8 @@ class Time {
 public:
 	Time(int ms = 0);
 	Time(std::string const& text);
+	/// Parse a time from a range of characters without copying it
+	Time(const char *begin, const char *end);
 
 	/// Get millisecond, rounded to centisecond precision
 	// Always round up for 5ms because the range is [start, stop)
@@ -34,6 +36,8 @@ public:
 	/// Return the time as a string
 	/// @param ms Use milliseconds precision, for non-ASS formats
 	std::string GetAssFormatted(bool ms=false) const;
+	/// Append the time in ASS format with centisecond precision to a string
+	void AppendAssFormatted(std::string &out) const;
 
 	/// Return the time as a string
 	std::string GetSrtFormatted() const;
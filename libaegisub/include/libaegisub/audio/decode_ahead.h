@@ -0,0 +1,120 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace agi {
+class AudioProvider;
+class PlaybackStats;
+
+/// @class DecodeAheadBuffer
+/// @brief Audio decoded ahead of playback on a background thread
+///
+/// Audio players read from a single-producer single-consumer ring buffer
+/// which a background thread keeps filled to the lead time, so that reading
+/// is only ever a copy and a slow read from the provider doesn't turn
+/// straight into an underrun.
+///
+/// Read() is lock-free and is meant to be called from the player's audio
+/// thread or callback. Start() and Stop() must not be called at the same
+/// time as Read(); SetEndPosition() and SetVolume() can be called at any
+/// time.
+class DecodeAheadBuffer {
+	AudioProvider *provider;
+	/// Decode 16-bit mono rather than the provider's own format
+	const bool mono16;
+	/// Size of each frame in bytes
+	const size_t frame_size;
+	/// Number of frames to decode ahead of playback
+	const int64_t lead;
+	/// Size of the ring in frames, which is a power of two
+	const int64_t capacity;
+	/// Most frames to decode at a time
+	const int64_t chunk;
+	std::unique_ptr<char[]> ring;
+
+	/// Frames written and read since Start(); only the decoder writes the
+	/// former and only the reader writes the latter
+	std::atomic<int64_t> written{0};
+	std::atomic<int64_t> read{0};
+
+	std::atomic<int64_t> end_position{0};
+	std::atomic<double> volume{1.0};
+
+	/// Held while decoding and while changing what's being decoded
+	std::mutex mutex;
+	std::condition_variable cond;
+	/// Sample position of the start of the ring's contents
+	int64_t start_position = 0;
+	bool active = false;
+	bool closing = false;
+
+	/// The player's counters, which reads and provider reads are recorded
+	/// in; may be null
+	PlaybackStats *player_stats;
+
+	std::thread thread;
+
+	/// Decode up to count frames into the ring; mutex must be held
+	/// @return Number of frames decoded
+	int64_t DecodeChunk(int64_t count);
+	void Work();
+
+public:
+	/// @param provider Audio to decode
+	/// @param mono16   Decode 16-bit mono rather than the provider's own format
+	/// @param lead_ms  How far ahead of playback to decode, in milliseconds
+	/// @param player_stats Player's counters to record reads in, or null
+	DecodeAheadBuffer(AudioProvider *provider, bool mono16, int lead_ms, PlaybackStats *player_stats = nullptr);
+	~DecodeAheadBuffer();
+
+	/// @brief Start decoding a range, discarding anything already buffered
+	/// @param start   First sample to decode
+	/// @param end     Sample to stop decoding at
+	/// @param prefill Number of frames to decode before returning, so that
+	///                the first read doesn't underrun
+	void Start(int64_t start, int64_t end, int64_t prefill);
+
+	/// Stop decoding and discard anything buffered
+	void Stop();
+
+	/// Change where decoding stops
+	void SetEndPosition(int64_t end) { end_position = end; }
+
+	/// Change the volume of audio decoded from now on
+	void SetVolume(double vol) { volume = vol; }
+
+	/// @brief Copy decoded audio out of the buffer
+	/// @param buf    Buffer to fill
+	/// @param frames Most frames to copy
+	/// @return Number of frames copied, which is less than asked for if
+	///         decoding has fallen behind or the end has been reached
+	int64_t Read(void *buf, int64_t frames);
+
+	/// Sample position of the next frame Read() will return
+	int64_t GetReadPosition() const { return start_position + read; }
+
+	/// Size in bytes of each frame Read() returns
+	size_t GetFrameSize() const { return frame_size; }
+};
+}
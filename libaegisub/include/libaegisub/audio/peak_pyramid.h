@@ -0,0 +1,108 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace agi {
+class AudioProvider;
+
+/// Peak and average amplitude of a range of samples
+struct AudioPeak {
+	/// Most negative sample
+	int16_t min = 0;
+	/// Most positive sample
+	int16_t max = 0;
+	/// Sum of the negative samples divided by the number of samples
+	int16_t avg_min = 0;
+	/// Sum of the positive samples divided by the number of samples
+	int16_t avg_max = 0;
+};
+
+/// @class AudioPeakPyramid
+/// @brief Multi-resolution min/max/average summary of an audio stream
+///
+/// The stream is split into chunks of 2^ChunkBits samples, each of which has
+/// a pyramid of peaks for buckets of 2^BucketBits samples up to the whole
+/// chunk. Chunks are filled in on the provider's decoding threads as each
+/// range finishes decoding, so the cost of reading the audio is paid once and
+/// off the main thread, and looking up the peaks of a range only touches a
+/// handful of buckets regardless of its length. Chunks which were decoded
+/// before the pyramid was created, or by a provider which doesn't decode in
+/// the background, are filled in the first time they are queried instead.
+class AudioPeakPyramid {
+public:
+	/// log2 of the number of samples in the smallest bucket
+	static const int BucketBits = 8;
+	/// log2 of the number of samples in a chunk
+	static const int ChunkBits = 16;
+
+	/// @param provider Provider to read from, which the pyramid listens to
+	///                 for decoded ranges until it's destroyed
+	AudioPeakPyramid(AudioProvider *provider);
+	~AudioPeakPyramid();
+
+	/// Smallest range for which the pyramid is used; anything shorter is
+	/// cheap enough to read from the provider directly
+	static int64_t MinSamples() { return int64_t(1) << BucketBits; }
+
+	/// @brief Get the peaks of a range of samples; main thread only
+	/// @param start First sample of the range
+	/// @param count Number of samples in the range, at least MinSamples()
+	///
+	/// The range is rounded to bucket boundaries of the coarsest level with
+	/// buckets no longer than count, so the result may include up to one
+	/// bucket's worth of samples on either side of the requested range.
+	AudioPeak Get(int64_t start, int64_t count);
+
+private:
+	/// Number of levels in each chunk's pyramid
+	static const int Levels = ChunkBits - BucketBits + 1;
+	/// Number of buckets in all levels of a chunk
+	static const size_t ChunkSize = (size_t(2) << (ChunkBits - BucketBits)) - 1;
+
+	AudioProvider *provider;
+	/// Protects chunks, which the decoding threads fill in
+	std::mutex chunks_mutex;
+	/// Pyramids for each chunk which has been fully decoded, level 0 first;
+	/// once set an entry is never changed
+	std::vector<std::unique_ptr<AudioPeak[]>> chunks;
+	/// Pyramid for a chunk which is only partially decoded, which is
+	/// rebuilt whenever more of it has been decoded
+	std::unique_ptr<AudioPeak[]> scratch;
+	/// Index of the chunk currently in scratch, or -1
+	int64_t scratch_chunk = -1;
+	/// Number of decoded samples when scratch was built
+	int64_t scratch_decoded = -1;
+	/// Buffer for decoded audio used by the main thread
+	std::vector<int16_t> samples;
+
+	/// Get the pyramid for a chunk, building it if needed
+	AudioPeak const* GetChunk(int64_t chunk);
+	/// Store the pyramid for a fully decoded chunk unless it already has one
+	/// @return The chunk's pyramid
+	AudioPeak const* StoreChunk(int64_t chunk, std::unique_ptr<AudioPeak[]> pyramid);
+	/// Fill in the pyramid for a chunk from the provider
+	void BuildChunk(int64_t chunk, AudioPeak *out, std::vector<int16_t>& buffer) const;
+	/// Build the chunks which lie within a range that has just been decoded;
+	/// called on the decoding threads
+	void OnDecoded(int64_t start, int64_t count);
+};
+}
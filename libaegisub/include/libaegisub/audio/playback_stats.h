@@ -0,0 +1,128 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace agi {
+/// @class PlaybackStats
+/// @brief Counters for how well an audio player is keeping up with playback
+///
+/// The player's audio thread, the decoder and the video clock record into
+/// these as playback goes on, and they can be read from any thread at any
+/// time. Every counter is a separate relaxed atomic, so a snapshot taken
+/// during playback may mix values from either side of an update, which is
+/// fine for what they're for.
+class PlaybackStats {
+public:
+	/// Number of buckets in the provider read time histogram. Bucket i counts
+	/// reads which took less than ReadTimeLimit(i) microseconds, and the last
+	/// bucket counts everything slower.
+	static const int ReadTimeBuckets = 12;
+
+	/// Upper limit of a histogram bucket in microseconds, starting at 100
+	/// and doubling for each bucket after that
+	static int64_t ReadTimeLimit(int bucket) { return int64_t(100) << bucket; }
+
+	struct Snapshot {
+		/// Number of reads the player made from its buffer
+		uint64_t reads = 0;
+		/// Reads which got less audio than they asked for
+		uint64_t underruns = 0;
+		/// Times the output device itself ran out of audio
+		uint64_t device_underruns = 0;
+		/// Least and average audio left buffered after a read, in milliseconds
+		int64_t min_fill_ms = 0;
+		int64_t avg_fill_ms = 0;
+		/// Number of reads from the audio provider
+		uint64_t provider_reads = 0;
+		/// Histogram of how long the provider reads took
+		uint64_t read_time[ReadTimeBuckets] = {};
+		/// Slowest provider read, in microseconds
+		int64_t max_read_us = 0;
+		/// Latest and largest measured output latency in milliseconds, or
+		/// -1 if the player hasn't measured it
+		int64_t latency_ms = -1;
+		int64_t max_latency_ms = -1;
+		/// Number of times the audio position was compared with the video clock
+		uint64_t drift_samples = 0;
+		/// Latest audio position minus video clock, in milliseconds
+		int64_t drift_ms = 0;
+		/// Largest drift in either direction, in milliseconds
+		int64_t max_drift_ms = 0;
+	};
+
+private:
+	std::atomic<int> sample_rate{0};
+
+	std::atomic<uint64_t> reads{0};
+	std::atomic<uint64_t> underruns{0};
+	std::atomic<uint64_t> device_underruns{0};
+	std::atomic<int64_t> min_fill{INT64_MAX};
+	std::atomic<int64_t> total_fill{0};
+
+	std::atomic<uint64_t> provider_reads{0};
+	std::atomic<uint64_t> read_time[ReadTimeBuckets];
+	std::atomic<int64_t> max_read_us{0};
+
+	std::atomic<int64_t> latency{-1};
+	std::atomic<int64_t> max_latency{-1};
+
+	std::atomic<uint64_t> drift_samples{0};
+	std::atomic<int64_t> drift_ms{0};
+	std::atomic<int64_t> max_drift_ms{0};
+
+public:
+	/// @param sample_rate Sample rate of the audio, to convert frame counts to times
+	PlaybackStats(int sample_rate = 0);
+
+	/// Change the sample rate frame counts are converted with
+	void SetSampleRate(int rate) { sample_rate = rate; }
+
+	/// Clear every counter, at the start of playback
+	void Reset();
+
+	/// @brief Record a read by the player from its buffer
+	/// @param fill     Frames left buffered after the read
+	/// @param underrun The read got less audio than it asked for before the end
+	void RecordRead(int64_t fill, bool underrun);
+
+	/// Record how long a read from the audio provider took
+	void RecordProviderRead(std::chrono::steady_clock::duration time);
+
+	/// Record that the output device ran out of audio and had to be recovered
+	void RecordDeviceUnderrun();
+
+	/// Record the output latency the device reports, in frames
+	void RecordLatency(int64_t frames);
+
+	/// Record the audio position minus the video clock, in milliseconds
+	void RecordDrift(int64_t ms);
+
+	/// Get the current values of all of the counters
+	Snapshot Get() const;
+
+	/// @brief Format a snapshot as a single line of space-separated key=value pairs
+	///
+	/// The keys don't change between versions without good reason so that
+	/// logs can be collected and compared with scripts.
+	static std::string Format(Snapshot const& snapshot);
+};
+}
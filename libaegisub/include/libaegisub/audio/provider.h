@@ -20,21 +20,36 @@
 #include <libaegisub/fs_fwd.h>
 
 #include <atomic>
+#include <functional>
 #include <vector>
 #include <memory>
 
 namespace agi {
+/// Space used by a cache provider for each of the streams it serves, in bytes
+struct AudioCacheUsage {
+	/// 16-bit mono audio for the waveform and spectrum, if cached separately
+	/// from the playback stream
+	int64_t display = 0;
+	/// Audio in the source's own format, if it's cached rather than decoded
+	/// on demand for playback
+	int64_t playback = 0;
+	/// Is the cache in RAM rather than in a file?
+	bool in_memory = false;
+};
+
 class AudioProvider {
 protected:
 	int channels = 0;
 	/// Total number of samples per channel
 	int64_t num_samples = 0;
 	/// Samples per channel which have been decoded and can be fetched with FillBuffer
-	/// Only applicable for the cache providers
+	/// Only applicable for the cache providers, which may not decode in order
 	std::atomic<int64_t> decoded_samples{0};
 	int sample_rate = 0;
 	int bytes_per_sample = 0;
 	bool float_samples = false;
+	/// Index of the track used for providers which pick one of several
+	int track = 0;
 
 	virtual void FillBuffer(void *buf, int64_t start, int64_t count) const = 0;
 	virtual void FillBufferInt16Mono(int16_t* buf, int64_t start, int64_t count) const;
@@ -55,9 +70,39 @@ public:
 	int     GetBytesPerSample() const { return bytes_per_sample; }
 	int     GetChannels()       const { return channels; }
 	bool    AreSamplesFloat()   const { return float_samples; }
+	int     GetTrack()          const { return track; }
 
 	/// Does this provider benefit from external caching?
 	virtual bool NeedsCache() const { return false; }
+
+	/// Have all of the samples in the given range been decoded?
+	///
+	/// The cache providers decode in the background and give silence for
+	/// anything which isn't decoded yet, not necessarily from the start. When
+	/// a cache only holds the 16-bit mono stream this is about that stream,
+	/// as GetAudio() then decodes on demand.
+	virtual bool IsRangeDecoded(int64_t start, int64_t count) const;
+
+	/// Ask a cache provider which is still decoding to do the given range next
+	virtual void Prioritize(int64_t start, int64_t count) { }
+
+	/// Called on a decoding thread when a range of samples has been decoded
+	using DecodedFunc = std::function<void (int64_t start, int64_t count)>;
+
+	/// @brief Set the function to tell about ranges as the background decoder finishes them
+	/// @param listener Function to call, or nullptr to stop
+	///
+	/// Only the cache providers decode in the background, and only ranges
+	/// finished after this is called are reported. Once this returns the old
+	/// listener is no longer running and won't be called again.
+	virtual void SetDecodedListener(DecodedFunc listener) { }
+
+	/// Open another instance of this provider which can be used on a different
+	/// thread at the same time as this one, or nullptr if that isn't supported
+	virtual std::unique_ptr<AudioProvider> Clone() const { return nullptr; }
+
+	/// How much space is used for caching, for cache providers
+	virtual AudioCacheUsage GetCacheUsage() const { return {}; }
 };
 
 /// Helper base class for an audio provider which wraps another provider
@@ -74,6 +119,7 @@ public:
 		sample_rate = source->GetSampleRate();
 		bytes_per_sample = source->GetBytesPerSample();
 		float_samples = source->AreSamplesFloat();
+		track = source->GetTrack();
 	}
 };
 
@@ -95,5 +141,18 @@ std::unique_ptr<AudioProvider> CreateLockAudioProvider(std::unique_ptr<AudioProv
 std::unique_ptr<AudioProvider> CreateHDAudioProvider(std::unique_ptr<AudioProvider> source_provider, fs::path const& dir);
 std::unique_ptr<AudioProvider> CreateRAMAudioProvider(std::unique_ptr<AudioProvider> source_provider);
 
+/// @brief Cache decoded audio in a file which is kept between sessions
+/// @param source_provider Provider to decode audio from
+/// @param cache_file      File to cache the audio in, which should be named
+///                        for the source file and track
+///
+/// If cache_file already holds audio in the same format as source_provider
+/// it is used as-is if complete, or decoding resumes from where it stopped.
+/// Otherwise it is overwritten. source_provider is only taken on success, so
+/// that it can still be cached some other way if this throws. The file's
+/// modification time is updated in every case, so it's safe to clean up the
+/// cache directory by age once this returns.
+std::unique_ptr<AudioProvider> CreatePersistentAudioProvider(std::unique_ptr<AudioProvider>& source_provider, fs::path const& cache_file);
+
 void SaveAudioClip(AudioProvider const& provider, fs::path const& path, int start_time, int end_time);
 }
@@ -0,0 +1,56 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace agi {
+/// @brief Convert samples to signed 16-bit
+/// @param src              Source samples
+/// @param dst              Destination buffer with room for count samples
+/// @param count            Number of samples to convert, counting each channel separately
+/// @param bytes_per_sample Size of each source sample
+/// @param is_float         Are the source samples float or double?
+///
+/// Floating point samples are scaled from [-1, 1) and clamped; 8-bit samples
+/// are assumed to be unsigned with a bias of 128; wider integer samples keep
+/// their most significant 16 bits. dst may be the same as src for 16-bit
+/// input, in which case it's left alone.
+///
+/// Uses AVX2 or SSE2 when available, picked at runtime.
+void ConvertSamplesToInt16(const void *src, int16_t *dst, size_t count, int bytes_per_sample, bool is_float);
+
+/// @brief Average interleaved 16-bit channels into one
+/// @param src      Interleaved source samples
+/// @param dst      Destination buffer with room for frames samples
+/// @param frames   Number of samples per channel
+/// @param channels Number of channels in src
+///
+/// The average is rounded toward zero. dst may be the same as src.
+void DownmixInt16(const int16_t *src, int16_t *dst, size_t frames, int channels);
+
+/// @brief Scale 16-bit samples in place
+/// @param buf    Samples to scale
+/// @param count  Number of samples
+/// @param volume Factor to scale by
+/// @param round  Add 0.5 before truncating toward zero
+///
+/// Results outside of the 16-bit range are clamped rather than wrapped.
+/// Uses AVX2 or SSE2 when available, picked at runtime.
+void ScaleInt16(int16_t *buf, size_t count, double volume, bool round);
+}
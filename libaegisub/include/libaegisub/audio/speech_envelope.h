@@ -0,0 +1,100 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace agi {
+class AudioProvider;
+
+/// @class SpeechEnvelope
+/// @brief Energy envelope of an audio stream and where speech starts and stops in it
+///
+/// A background thread reads the 16-bit mono stream as the provider finishes
+/// decoding it and records the level of each FrameMs-long frame. A frame is
+/// counted as speech when it's well above a running estimate of the noise
+/// floor, and short blips and short pauses are smoothed over so that
+/// boundaries fall between phrases rather than between syllables.
+///
+/// The boundaries are kept sorted, so finding the nearest one to a time is
+/// a binary search. Queries can be made from any thread at any time and
+/// only see the part of the audio which has been analyzed so far.
+class SpeechEnvelope {
+public:
+	/// Length of each frame of the envelope in milliseconds
+	static const int FrameMs = 10;
+
+	/// Level of a frame of digital silence, in dBFS
+	static constexpr float MinLevel = -100.f;
+
+private:
+	AudioProvider const* provider;
+	/// Number of frames in the whole stream
+	const int64_t frame_count;
+
+	/// Protects everything below which the worker writes
+	mutable std::mutex mutex;
+	/// Level of each frame analyzed so far, in dBFS
+	std::vector<float> levels;
+	/// Times in milliseconds where speech starts and stops, in order
+	std::vector<int> onsets, offsets;
+
+	std::atomic<bool> cancelled{false};
+	std::condition_variable cancel_cond;
+	std::thread worker;
+
+	void Work();
+
+	/// Nearest time in a sorted list within range_ms of ms, or -1
+	int Nearest(std::vector<int> const& times, int ms, int range_ms) const;
+
+	/// First sample of a frame
+	int64_t FrameStart(int64_t frame) const;
+
+public:
+	/// @param provider Provider to analyze, which must outlive the envelope
+	SpeechEnvelope(AudioProvider const* provider);
+	~SpeechEnvelope();
+
+	/// @brief Find the nearest point where speech starts
+	/// @param ms       Time to search around, in milliseconds
+	/// @param range_ms Maximum distance from ms to look
+	/// @return Time of the onset in milliseconds, or -1 if there isn't one in range
+	int NearestOnset(int ms, int range_ms) const;
+
+	/// @brief Find the nearest point where speech stops
+	/// @param ms       Time to search around, in milliseconds
+	/// @param range_ms Maximum distance from ms to look
+	/// @return Time of the offset in milliseconds, or -1 if there isn't one in range
+	int NearestOffset(int ms, int range_ms) const;
+
+	/// @brief Get the level of the audio at a time
+	/// @return Level in dBFS, or MinLevel if that part hasn't been analyzed yet
+	float GetLevel(int ms) const;
+
+	/// Get the time up to which the audio has been analyzed, in milliseconds
+	int GetAnalyzedMs() const;
+
+	/// Has all of the audio been analyzed?
+	bool IsComplete() const;
+};
+}
@@ -63,4 +63,28 @@ namespace agi {
 		const char *read(int64_t offset, uint64_t length);
 		char *write(int64_t offset, uint64_t length);
 	};
+
+	/// Like temp_file_mapping, but the file is kept once it's closed, and any
+	/// existing contents within the new size are left as they were
+	class write_file_mapping {
+		file_mapping file;
+		uint64_t file_size = 0;
+
+		std::unique_ptr<boost::interprocess::mapped_region> read_region;
+		uint64_t read_mapping_start = 0;
+		std::unique_ptr<boost::interprocess::mapped_region> write_region;
+		uint64_t write_mapping_start = 0;
+
+	public:
+		write_file_mapping(fs::path const& filename, uint64_t size);
+		~write_file_mapping();
+
+		uint64_t size() const { return file_size; }
+		const char *read(int64_t offset, uint64_t length);
+		char *write(int64_t offset, uint64_t length);
+
+		/// Write a range of the file out to the disk, returning once it's
+		/// been written
+		void flush(int64_t offset, uint64_t length);
+	};
 }
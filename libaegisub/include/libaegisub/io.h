@@ -40,6 +40,9 @@ public:
 	Save(fs::path const& file, bool binary = false);
 	~Save() noexcept(false);
 	std::ostream& Get() { return *fp; }
+
+	/// Throw away what's been written, leaving the destination untouched
+	void Cancel() noexcept;
 };
 
 	} // namespace io
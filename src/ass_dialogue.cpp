@@ -36,16 +36,18 @@
 #include "utils.h"
 
 #include <libaegisub/of_type_adaptor.h>
-#include <libaegisub/split.h>
+#include <libaegisub/ass/field_scanner.h>
 #include <libaegisub/make_unique.h>
 
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/join.hpp>
-#include <boost/algorithm/string/trim.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/regex.hpp>
 #include <boost/spirit/include/karma_generate.hpp>
 #include <boost/spirit/include/karma_int.hpp>
+#include <iterator>
+#include <list>
+#include <unordered_map>
 
 using namespace boost::adaptors;
 
@@ -71,57 +73,75 @@ AssDialogue::AssDialogue(std::string const& data) {
 
 AssDialogue::~AssDialogue () { }
 
+namespace {
 class tokenizer {
-	agi::StringRange str;
-	agi::split_iterator<agi::StringRange::const_iterator> pos;
+	agi::ass::CharRange str;
+	agi::ass::FieldScanner scanner;
 
 public:
-	tokenizer(agi::StringRange const& str) : str(str) , pos(agi::Split(str, ',')) { }
+	tokenizer(agi::ass::CharRange const& str) : str(str), scanner(str.begin(), str.end()) { }
 
-	agi::StringRange next_tok() {
-		if (pos.eof())
+	agi::ass::CharRange next_tok() {
+		agi::ass::CharRange tok;
+		if (!scanner.Next(tok))
 			throw SubtitleFormatParseError("Failed parsing line: " + std::string(str.begin(), str.end()));
-		return *pos++;
+		return tok;
 	}
 
-	std::string next_str() { return agi::str(next_tok()); }
-	std::string next_str_trim() { return agi::str(boost::trim_copy(next_tok())); }
+	agi::ass::CharRange next_tok_trim() { return agi::ass::Trim(next_tok()); }
+
+	int next_int(agi::ass::CharRange tok) {
+		int value;
+		if (agi::ass::ParseInt(tok, value))
+			return value;
+		// Let lexical_cast deal with (and report) anything unusual
+		return boost::lexical_cast<int>(std::string(tok.begin(), tok.end()));
+	}
 };
+}
 
 void AssDialogue::Parse(std::string const& raw) {
-	agi::StringRange str;
+	size_t prefix;
 	if (boost::starts_with(raw, "Dialogue:")) {
 		Comment = false;
-		str = agi::StringRange(raw.begin() + 10, raw.end());
+		prefix = 10;
 	}
 	else if (boost::starts_with(raw, "Comment:")) {
 		Comment = true;
-		str = agi::StringRange(raw.begin() + 9, raw.end());
+		prefix = 9;
 	}
 	else
 		throw SubtitleFormatParseError("Failed parsing line: " + raw);
 
+	const char *line_end = raw.data() + raw.size();
+	agi::ass::CharRange str(raw.data() + std::min(prefix, raw.size()), line_end);
 	tokenizer tkn(str);
 
 	// Get first token and see if it has "Marked=" in it
-	auto tmp = tkn.next_str_trim();
+	auto tmp = tkn.next_tok_trim();
 	bool ssa = boost::istarts_with(tmp, "marked=");
 
 	// Get layer number
 	if (ssa)
 		Layer = 0;
 	else
-		Layer = boost::lexical_cast<int>(tmp);
+		Layer = tkn.next_int(tmp);
+
+	auto time = tkn.next_tok();
+	Start = agi::Time(time.begin(), time.end());
+	time = tkn.next_tok();
+	End = agi::Time(time.begin(), time.end());
 
-	Start = tkn.next_str_trim();
-	End = tkn.next_str_trim();
-	Style = tkn.next_str_trim();
-	Actor = tkn.next_str_trim();
+	auto field = tkn.next_tok_trim();
+	Style = std::string(field.begin(), field.end());
+	field = tkn.next_tok_trim();
+	Actor = std::string(field.begin(), field.end());
 	for (int& margin : Margin)
-		margin = mid(-9999, boost::lexical_cast<int>(tkn.next_str()), 99999);
-	Effect = tkn.next_str_trim();
+		margin = mid(-9999, tkn.next_int(tkn.next_tok()), 99999);
+	field = tkn.next_tok_trim();
+	Effect = std::string(field.begin(), field.end());
 
-	std::string text{tkn.next_tok().begin(), str.end()};
+	std::string text{tkn.next_tok().begin(), line_end};
 
 	if (text.size() > 1 && text[0] == '{' && text[1] == '=') {
 		static const boost::regex extradata_test("^\\{(=\\d+)+\\}");
@@ -151,11 +171,6 @@ static void append_int(std::string &str, int v) {
 	str += ',';
 }
 
-static void append_str(std::string &out, std::string const& str) {
-	out += str;
-	out += ',';
-}
-
 static void append_unsafe_str(std::string &out, std::string const& str) {
 	for (auto c : str) {
 		if (c == ',')
@@ -167,12 +182,20 @@ static void append_unsafe_str(std::string &out, std::string const& str) {
 }
 
 std::string AssDialogue::GetEntryData() const {
-	std::string str = Comment ? "Comment: " : "Dialogue: ";
-	str.reserve(51 + Style.get().size() + Actor.get().size() + Effect.get().size() + Text.get().size());
+	std::string str;
+	str.reserve(61 + Style.get().size() + Actor.get().size() + Effect.get().size() + Text.get().size());
+	AppendEntryData(str);
+	return str;
+}
+
+void AssDialogue::AppendEntryData(std::string &str) const {
+	str += Comment ? "Comment: " : "Dialogue: ";
 
 	append_int(str, Layer);
-	append_str(str, Start.GetAssFormatted());
-	append_str(str, End.GetAssFormatted());
+	Start.AppendAssFormatted(str);
+	str += ',';
+	End.AppendAssFormatted(str);
+	str += ',';
 	append_unsafe_str(str, Style);
 	append_unsafe_str(str, Actor);
 	for (auto margin : Margin)
@@ -188,12 +211,13 @@ std::string AssDialogue::GetEntryData() const {
 		str += '}';
 	}
 
-	for (auto c : Text.get()) {
-		if (c != '\n' && c != '\r')
-			str += c;
+	auto const& text = Text.get();
+	for (size_t pos = 0; pos < text.size(); ) {
+		size_t next = text.find_first_of("\r\n", pos);
+		if (next == std::string::npos) next = text.size();
+		str.append(text, pos, next - pos);
+		pos = next + 1;
 	}
-
-	return str;
 }
 
 std::vector<std::unique_ptr<AssDialogueBlock>> AssDialogue::ParseTags() const {
@@ -266,6 +290,57 @@ plain:
 	return Blocks;
 }
 
+namespace {
+/// Bounded LRU cache of parsed line texts
+///
+/// Entries are keyed on the address of the flyweight's shared string, so all
+/// lines with the same text hit the same entry. Each entry holds a reference
+/// to the flyweight so that the string can't be freed and its address reused
+/// for a different text while it is cached.
+class parsed_text_cache {
+	using blocks = std::vector<std::unique_ptr<const AssDialogueBlock>>;
+	using blocks_ptr = std::shared_ptr<const blocks>;
+
+	struct entry {
+		boost::flyweight<std::string> text;
+		blocks_ptr blocks;
+	};
+
+	static const size_t max_size = 512;
+
+	std::list<entry> lru;
+	std::unordered_map<std::string const*, std::list<entry>::iterator> index;
+
+public:
+	blocks_ptr get(AssDialogue const& line) {
+		auto it = index.find(&line.Text.get());
+		if (it != index.end()) {
+			lru.splice(lru.begin(), lru, it->second);
+			return it->second->blocks;
+		}
+
+		auto parsed = line.ParseTags();
+		lru.push_front(entry{line.Text, std::make_shared<const blocks>(
+			std::make_move_iterator(parsed.begin()), std::make_move_iterator(parsed.end()))});
+		index[&line.Text.get()] = lru.begin();
+
+		if (lru.size() > max_size) {
+			index.erase(&lru.back().text.get());
+			lru.pop_back();
+		}
+
+		return lru.front().blocks;
+	}
+};
+}
+
+std::shared_ptr<const std::vector<std::unique_ptr<const AssDialogueBlock>>> AssDialogue::ParseTagsCached() const {
+	// Override parameters are parsed lazily on access, so parsed blocks
+	// can't be shared between threads
+	thread_local parsed_text_cache cache;
+	return cache.get(*this);
+}
+
 void AssDialogue::StripTags() {
 	Text = GetStrippedText();
 }
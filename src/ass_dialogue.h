@@ -29,6 +29,7 @@
 #pragma once
 
 #include "ass_entry.h"
+#include "ass_entry_arena.h"
 #include "ass_override.h"
 #include "fold_controller.h"
 
@@ -36,6 +37,7 @@
 
 #include <array>
 #include <boost/flyweight.hpp>
+#include <memory>
 #include <vector>
 
 enum class AssBlockType {
@@ -62,8 +64,8 @@ enum class AssBlockType {
 /// Also note how {}s are discarded.
 /// Override blocks are further divided in AssOverrideTags.
 ///
-/// The GetText() method generates a new value for the "text" field from
-/// the other fields in the specific class, and returns the new value.
+/// The GetText() method generates the block's text from the other fields in
+/// the specific class.
 /// @endverbatim
 class AssDialogueBlock {
 protected:
@@ -74,7 +76,7 @@ public:
 	virtual ~AssDialogueBlock() = default;
 
 	virtual AssBlockType GetType() const = 0;
-	virtual std::string GetText() { return text; }
+	virtual std::string GetText() const { return text; }
 };
 
 class AssDialogueBlockPlain final : public AssDialogueBlock {
@@ -106,7 +108,7 @@ public:
 	std::vector<AssOverrideTag> Tags;
 
 	AssBlockType GetType() const override { return AssBlockType::OVERRIDE; }
-	std::string GetText() override;
+	std::string GetText() const override;
 	void ParseTags();
 	void AddTag(std::string const& tag);
 
@@ -152,15 +154,26 @@ struct AssDialogueBase {
 };
 
 class AssDialogue final : public AssEntry, public AssDialogueBase, public AssEntryListHook {
+public:
 	/// @brief Parse raw ASS data into everything else
 	/// @param data ASS line
+	///
+	/// Does not touch the line's ID, so lines can be created up front and
+	/// then parsed in parallel.
 	void Parse(std::string const& data);
-public:
+
 	AssEntryGroup Group() const override { return AssEntryGroup::DIALOGUE; }
 
 	/// Parse text as ASS and return block information
 	std::vector<std::unique_ptr<AssDialogueBlock>> ParseTags() const;
 
+	/// @brief Parse text as ASS and return read-only block information
+	///
+	/// Parsed blocks are cached by text, so the result may be shared with
+	/// other lines and other callers and the blocks are const. Use ParseTags
+	/// to get blocks which can be edited and passed to UpdateText.
+	std::shared_ptr<const std::vector<std::unique_ptr<const AssDialogueBlock>>> ParseTagsCached() const;
+
 	/// Strip all ASS tags from the text
 	void StripTags();
 	/// Strip a specific ASS tag from the text
@@ -170,10 +183,15 @@ public:
 	/// Update the text of the line from parsed blocks
 	void UpdateText(std::vector<std::unique_ptr<AssDialogueBlock>>& blocks);
 	std::string GetEntryData() const;
+	/// Append the line as it should appear in an ASS file to a string
+	void AppendEntryData(std::string &out) const;
 
 	/// Does this line collide with the passed line?
 	bool CollidesWith(const AssDialogue *target) const;
 
+	static void *operator new(size_t size) { return EntryArena::Allocate(size); }
+	static void operator delete(void *ptr) { EntryArena::Free(ptr); }
+
 	AssDialogue();
 	AssDialogue(AssDialogue const&);
 	AssDialogue(AssDialogueBase const&);
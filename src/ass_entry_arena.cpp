@@ -0,0 +1,124 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file ass_entry_arena.cpp
+/// @brief Slab allocator for subtitle entries
+/// @ingroup subs_storage
+
+#include "ass_entry_arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+struct EntryArena::Slab {
+	/// Live allocations in this slab, plus one for the arena while it's open
+	std::atomic<size_t> refs{1};
+	char *pos;
+	char *end;
+
+	void Release() noexcept {
+		if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			this->~Slab();
+			::operator delete(this);
+		}
+	}
+};
+
+const size_t EntryArena::max_slab_size;
+
+namespace {
+thread_local EntryArena *current_arena = nullptr;
+
+size_t round_up(size_t size) {
+	return (size + EntryArena::overhead - 1) / EntryArena::overhead * EntryArena::overhead;
+}
+}
+
+EntryArena::EntryArena(size_t bytes)
+: remaining(bytes)
+, prev(current_arena)
+{
+	static_assert(sizeof(Slab *) <= overhead, "Entry header doesn't fit a slab pointer");
+	if (bytes)
+		NextSlab();
+	current_arena = this;
+}
+
+EntryArena::~EntryArena() {
+	current_arena = prev;
+	if (slab)
+		slab->Release();
+}
+
+void EntryArena::NextSlab() {
+	if (slab) {
+		// Whatever's left at the end of the old slab goes back into the
+		// budget so that the arena's total capacity is what was asked for
+		remaining += slab->end - slab->pos;
+		slab->Release();
+		slab = nullptr;
+	}
+
+	size_t bytes = std::min(remaining, max_slab_size);
+	remaining -= bytes;
+
+	size_t header = round_up(sizeof(Slab));
+	char *mem = static_cast<char *>(::operator new(header + bytes));
+	slab = new (mem) Slab;
+	slab->pos = mem + header;
+	slab->end = slab->pos + bytes;
+}
+
+void *EntryArena::Allocate(size_t size) {
+	size = round_up(size) + overhead;
+
+	// Move on to the arena's next slab if this one is full and the rest of
+	// the requested size has room for the allocation
+	EntryArena *arena = current_arena;
+	if (arena && arena->slab) {
+		size_t left = arena->slab->end - arena->slab->pos;
+		if (left < size && size <= std::min(arena->remaining + left, max_slab_size))
+			arena->NextSlab();
+	}
+
+	// Every allocation is preceded by a pointer to the slab it came from, or
+	// null if it came from the regular heap
+	Slab *slab = arena ? arena->slab : nullptr;
+	char *mem;
+	if (slab && size_t(slab->end - slab->pos) >= size) {
+		mem = slab->pos;
+		slab->pos += size;
+		slab->refs.fetch_add(1, std::memory_order_relaxed);
+	}
+	else {
+		mem = static_cast<char *>(::operator new(size));
+		slab = nullptr;
+	}
+
+	*reinterpret_cast<Slab **>(mem) = slab;
+	return mem + overhead;
+}
+
+void EntryArena::Free(void *ptr) noexcept {
+	if (!ptr) return;
+
+	char *mem = static_cast<char *>(ptr) - overhead;
+	if (Slab *slab = *reinterpret_cast<Slab **>(mem))
+		slab->Release();
+	else
+		::operator delete(mem);
+}
@@ -0,0 +1,76 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file ass_entry_arena.h
+/// @see ass_entry_arena.cpp
+/// @ingroup subs_storage
+
+#pragma once
+
+#include <cstddef>
+
+/// @class EntryArena
+/// @brief Slab allocation for bulk creation of subtitle entries
+///
+/// Entries are normally allocated one at a time, which scatters a file's
+/// lines across the heap and makes copying a large file tens of thousands of
+/// trips through the allocator. While an EntryArena is alive, entries
+/// allocated on its thread are instead carved out of a single slab.
+///
+/// Entries allocated from a slab are otherwise no different from any other
+/// entry: they can be deleted individually, moved to other files and outlive
+/// the arena. A slab is only freed when the last entry in it is deleted, so
+/// a single line which outlives the rest of its batch (e.g. one kept by the
+/// undo stack after the file it was copied for is gone) keeps its whole slab
+/// alive. To bound this, large arenas are split into slabs of at most
+/// max_slab_size bytes.
+class EntryArena {
+	struct Slab;
+	Slab *slab = nullptr;
+	/// Bytes of the requested size not yet handed out as a slab
+	size_t remaining;
+	EntryArena *prev;
+
+	/// Replace the current slab with a new one from the remaining size
+	void NextSlab();
+
+public:
+	/// Space needed per entry in addition to the size of the entry itself
+	static const size_t overhead = alignof(std::max_align_t);
+	/// Largest slab an arena allocates at once, and so the most memory a
+	/// single surviving entry can keep alive
+	static const size_t max_slab_size = 1 << 20;
+
+	/// @param bytes Expected total size of the entries which will be allocated
+	///              on this thread while the arena is alive, including overhead
+	explicit EntryArena(size_t bytes);
+	~EntryArena();
+
+	EntryArena(EntryArena const&) = delete;
+	EntryArena& operator=(EntryArena const&) = delete;
+
+	/// Get the size to pass to the constructor for count objects of type T
+	template<typename T>
+	static size_t SizeFor(size_t count) {
+		return count * ((sizeof(T) + overhead - 1) / overhead * overhead + overhead);
+	}
+
+	/// Allocate memory for an entry, from the current thread's arena if
+	/// there is one and it has room
+	static void *Allocate(size_t size);
+	/// Free memory returned by Allocate
+	static void Free(void *ptr) noexcept;
+};
@@ -36,9 +36,11 @@
 
 #include "ass_export_filter.h"
 #include "ass_file.h"
+#include "ass_file_snapshot.h"
 #include "compat.h"
 #include "include/aegisub/context.h"
 #include "project.h"
+#include "subs_controller.h"
 #include "subtitle_format.h"
 
 #include <memory>
@@ -80,7 +82,7 @@ std::vector<std::string> AssExporter::GetAllFilterNames() const {
 }
 
 void AssExporter::Export(agi::fs::path const& filename, std::string const& charset, wxWindow *export_dialog) {
-	AssFile subs(*c->ass);
+	AssFile subs(*c->subsController->Snapshot());
 
 	for (auto filter : filters) {
 		filter->LoadSettings(is_default, c);
@@ -18,6 +18,7 @@
 
 #include "ass_attachment.h"
 #include "ass_dialogue.h"
+#include "ass_file_snapshot.h"
 #include "ass_info.h"
 #include "ass_style.h"
 #include "ass_style_storage.h"
@@ -72,6 +73,10 @@ AssFile::AssFile(const AssFile &from)
 , Extradata(from.Extradata)
 , next_extradata_id(from.next_extradata_id)
 {
+	// Put all of the copied lines in one slab
+	EntryArena arena(EntryArena::SizeFor<AssStyle>(from.Styles.size())
+		+ EntryArena::SizeFor<AssDialogue>(from.Events.size()));
+
 	Styles.clone_from(from.Styles,
 		[](AssStyle const& e) { return new AssStyle(e); },
 		[](AssStyle *e) { delete e; });
@@ -80,6 +85,30 @@ AssFile::AssFile(const AssFile &from)
 		[](AssDialogue *e) { delete e; });
 }
 
+AssFile::AssFile(AssFileSnapshot const& snapshot)
+: Attachments(snapshot.attachments)
+, Extradata(snapshot.extradata)
+, next_extradata_id(snapshot.next_extradata_id)
+{
+	Info.reserve(snapshot.script_info.size());
+	for (auto const& info : snapshot.script_info)
+		Info.emplace_back(info.first, info.second);
+
+	EntryArena arena(EntryArena::SizeFor<AssStyle>(snapshot.styles.size())
+		+ EntryArena::SizeFor<AssDialogue>(snapshot.LineCount()));
+	for (auto const& style : snapshot.styles)
+		Styles.push_back(*new AssStyle(style));
+
+	int row = 0;
+	for (auto const& chunk : snapshot.events) {
+		for (auto const& event : *chunk) {
+			auto line = new AssDialogue(event);
+			line->Row = row++;
+			Events.push_back(*line);
+		}
+	}
+}
+
 void AssFile::swap(AssFile& from) throw() {
 	Info.swap(from.Info);
 	Styles.swap(from.Styles);
@@ -88,6 +117,8 @@ void AssFile::swap(AssFile& from) throw() {
 	Extradata.swap(from.Extradata);
 	std::swap(Properties, from.Properties);
 	std::swap(next_extradata_id, from.next_extradata_id);
+	time_index.Invalidate();
+	from.time_index.Invalidate();
 }
 
 AssFile& AssFile::operator=(AssFile from) {
@@ -101,6 +132,12 @@ EntryList<AssDialogue>::iterator AssFile::iterator_to(AssDialogue& line) {
 	return in_list ? Events.iterator_to(line) : Events.end();
 }
 
+AssTimeIndex const& AssFile::TimeIndex() {
+	if (!time_index.IsValid())
+		time_index.Build(Events);
+	return time_index;
+}
+
 void AssFile::InsertAttachment(agi::fs::path const& filename) {
 	AssEntryGroup group = AssEntryGroup::GRAPHIC;
 
@@ -195,6 +232,9 @@ int AssFile::Commit(wxString const& desc, int type, int amend_id, AssDialogue *s
 			event.Row = i++;
 	}
 
+	if (type == COMMIT_NEW || (type & (COMMIT_DIAG_ADDREM | COMMIT_ORDER | COMMIT_DIAG_TIME)))
+		time_index.Invalidate();
+
 	AnnouncePreCommit(type, single_line);
 
 	PushState({desc, &amend_id, single_line});
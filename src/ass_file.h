@@ -30,6 +30,7 @@
 #pragma once
 
 #include "ass_entry.h"
+#include "ass_time_index.h"
 
 #include <libaegisub/fs_fwd.h>
 #include <libaegisub/signal.h>
@@ -41,6 +42,7 @@
 
 class AssAttachment;
 class AssDialogue;
+class AssFileSnapshot;
 class AssInfo;
 class AssStyle;
 class wxString;
@@ -88,6 +90,10 @@ class AssFile {
 	agi::signal::Signal<int, const AssDialogue*> AnnouncePreCommit;
 	agi::signal::Signal<AssFileCommit> PushState;
 
+	/// Index of the dialogue lines by time, rebuilt on first use after any
+	/// commit which may have changed it
+	AssTimeIndex time_index;
+
 	void SetExtradataValue(AssDialogue& line, std::string const& key, std::string const& value, bool del);
 public:
 	/// The lines in the file
@@ -102,11 +108,25 @@ public:
 
 	AssFile();
 	AssFile(const AssFile &from);
+	/// Create a file with the contents of a snapshot, minus the project properties
+	explicit AssFile(AssFileSnapshot const& snapshot);
 	AssFile& operator=(AssFile from);
 	~AssFile();
 
 	EntryList<AssDialogue>::iterator iterator_to(AssDialogue& line);
 
+	/// Get the index of the dialogue lines by time, building it if needed
+	///
+	/// The index is invalidated by commits which add, remove, reorder or
+	/// retime lines, so it should not be used while lines are being modified
+	/// but before the changes have been committed.
+	AssTimeIndex const& TimeIndex();
+
+	/// @brief Update the time index after replacing a line without committing
+	/// @param old_line Line which was removed from Events
+	/// @param new_line Line which was inserted in its place
+	void ReplaceIndexedLine(AssDialogue const *old_line, AssDialogue *new_line) { time_index.Replace(old_line, new_line); }
+
 	/// @brief Load default file
 	/// @param defline Add a blank line to the file
 	/// @param style_catalog Style catalog name to fill styles from, blank to use default style
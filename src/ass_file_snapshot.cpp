@@ -0,0 +1,122 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file ass_file_snapshot.cpp
+/// @brief Shareable copies of subtitle files
+/// @ingroup subs_storage
+
+#include "ass_file_snapshot.h"
+
+#include "ass_info.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+/// Upper bound on the number of lines in a chunk
+const size_t max_chunk_size = 256;
+
+/// Should a chunk end after the line with the given id?
+///
+/// Boundaries are picked from the line IDs rather than positions so that
+/// inserting or deleting a line only changes the chunk containing it
+/// rather than every chunk after it. This splits after roughly one line
+/// in 64.
+bool is_chunk_boundary(int id) {
+	return (uint32_t(id) * 2654435761u) >> 26 == 0;
+}
+}
+
+bool SameLine(AssDialogueBase const& a, AssDialogueBase const& b) {
+	return a.Id == b.Id
+		&& a.Comment == b.Comment
+		&& a.Layer == b.Layer
+		&& a.Margin == b.Margin
+		&& a.Start == b.Start
+		&& a.End == b.End
+		&& a.Style == b.Style
+		&& a.Actor == b.Actor
+		&& a.Effect == b.Effect
+		&& a.ExtradataIds == b.ExtradataIds
+		&& a.Text == b.Text;
+}
+
+AssFileSnapshot::AssFileSnapshot(AssFile const& file, AssFileSnapshot const* prev)
+: attachments(file.Attachments)
+, extradata(file.Extradata)
+, next_extradata_id(file.next_extradata_id)
+{
+	script_info.reserve(file.Info.size());
+	for (auto const& info : file.Info)
+		script_info.emplace_back(info.Key(), info.Value());
+
+	styles.assign(file.Styles.begin(), file.Styles.end());
+
+	// Split the lines into chunks, reusing the previous snapshot's chunks for
+	// any runs of lines which have not changed
+	std::unordered_map<int, std::shared_ptr<const EventChunk> const*> prev_chunks;
+	if (prev) {
+		prev_chunks.reserve(prev->events.size());
+		for (auto const& chunk : prev->events)
+			prev_chunks[chunk->front().Id] = &chunk;
+	}
+
+	auto const& lines = file.Events;
+	auto chunk_start = lines.begin();
+	size_t chunk_size = 0;
+	auto finish_chunk = [&](EntryList<AssDialogue>::const_iterator chunk_end) {
+		auto it = prev_chunks.find(chunk_start->Id);
+		if (it != prev_chunks.end()) {
+			auto const& chunk = **it->second;
+			if (chunk.size() == chunk_size && std::equal(chunk.begin(), chunk.end(), chunk_start, SameLine)) {
+				events.push_back(*it->second);
+				return;
+			}
+		}
+		events.push_back(std::make_shared<EventChunk>(chunk_start, chunk_end));
+		unshared_lines += chunk_size;
+	};
+
+	for (auto it = lines.begin(); it != lines.end(); ) {
+		int id = it->Id;
+		++it;
+		if (++chunk_size == max_chunk_size || is_chunk_boundary(id) || it == lines.end()) {
+			finish_chunk(it);
+			chunk_start = it;
+			chunk_size = 0;
+		}
+	}
+}
+
+void AssFileSnapshot::UpdateLine(AssDialogueBase const& line) {
+	for (auto& chunk : events) {
+		for (size_t i = 0; i < chunk->size(); ++i) {
+			if ((*chunk)[i].Id != line.Id) continue;
+
+			auto copy = std::make_shared<EventChunk>(*chunk);
+			(*copy)[i] = line;
+			chunk = std::move(copy);
+			return;
+		}
+	}
+}
+
+size_t AssFileSnapshot::LineCount() const {
+	size_t count = 0;
+	for (auto const& chunk : events)
+		count += chunk->size();
+	return count;
+}
@@ -0,0 +1,73 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file ass_file_snapshot.h
+/// @see ass_file_snapshot.cpp
+/// @ingroup subs_storage
+
+#pragma once
+
+#include "ass_attachment.h"
+#include "ass_dialogue.h"
+#include "ass_file.h"
+#include "ass_style.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// @class AssFileSnapshot
+/// @brief The contents of an AssFile at a point in time
+///
+/// Dialogue lines are stored in immutable chunks which are shared with
+/// earlier snapshots wherever the lines in them haven't changed, so a new
+/// snapshot only has to copy the lines which were modified. Snapshots are
+/// passed around as shared_ptr<const AssFileSnapshot> and can be read from
+/// any thread; SubsController creates one for each commit.
+class AssFileSnapshot {
+public:
+	/// A run of consecutive lines
+	using EventChunk = std::vector<AssDialogueBase>;
+
+	std::vector<std::pair<std::string, std::string>> script_info;
+	std::vector<AssStyle> styles;
+	std::vector<std::shared_ptr<const EventChunk>> events;
+	std::vector<AssAttachment> attachments;
+	std::vector<ExtradataEntry> extradata;
+	uint32_t next_extradata_id;
+
+	/// Number of lines in chunks not shared with the previous snapshot
+	size_t unshared_lines = 0;
+
+	/// @brief Capture the current contents of a file
+	/// @param file File to capture
+	/// @param prev Earlier snapshot of the same file whose chunks should be
+	///             reused where possible, if any
+	AssFileSnapshot(AssFile const& file, AssFileSnapshot const* prev);
+
+	/// Replace a single line with the same ID, copying the chunk containing it
+	///
+	/// Only valid on snapshots which have not been shared yet.
+	void UpdateLine(AssDialogueBase const& line);
+
+	/// Total number of dialogue lines
+	size_t LineCount() const;
+};
+
+/// Are two lines identical for the purposes of snapshots? Row and fold
+/// information are recalculated on commit and so are ignored.
+bool SameLine(AssDialogueBase const& a, AssDialogueBase const& b);
@@ -411,9 +411,8 @@ void AssDialogueBlockOverride::AddTag(std::string const& tag) {
 }
 
 static std::string tag_str(AssOverrideTag const& t) { return t; }
-std::string AssDialogueBlockOverride::GetText() {
-	text = "{" + join(Tags | transformed(tag_str), std::string()) + "}";
-	return text;
+std::string AssDialogueBlockOverride::GetText() const {
+	return "{" + join(Tags | transformed(tag_str), std::string()) + "}";
 }
 
 void AssDialogueBlockOverride::ProcessParameters(ProcessParametersCallback callback, void *userData) {
@@ -33,6 +33,8 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/regex.hpp>
 #include <boost/variant.hpp>
+#include <exception>
+#include <thread>
 #include <unordered_map>
 
 class AssParser::HeaderToProperty {
@@ -94,10 +96,11 @@ public:
 	}
 };
 
-AssParser::AssParser(AssFile *target, int version)
+AssParser::AssParser(AssFile *target, int version, unsigned max_threads)
 : property_handler(agi::make_unique<HeaderToProperty>())
 , target(target)
 , version(version)
+, max_threads(max_threads ? max_threads : std::max(1u, std::thread::hardware_concurrency()))
 , state(&AssParser::ParseScriptInfoLine)
 {
 }
@@ -178,7 +181,7 @@ void AssParser::ParseMetadataLine(std::string const& data) {
 
 void AssParser::ParseEventLine(std::string const& data) {
 	if (boost::starts_with(data, "Dialogue:") || boost::starts_with(data, "Comment:"))
-		target->Events.push_back(*new AssDialogue(data));
+		pending_events.push_back(data);
 }
 
 void AssParser::ParseStyleLine(std::string const& data) {
@@ -265,3 +268,58 @@ void AssParser::AddLine(std::string const& data) {
 
 	(this->*state)(data);
 }
+
+void AssParser::Finish() {
+	// Create all of the lines up front so that they get the same IDs in the
+	// same order as if they had been parsed one at a time
+	std::vector<AssDialogue *> lines;
+	lines.reserve(pending_events.size());
+	{
+		EntryArena arena(EntryArena::SizeFor<AssDialogue>(pending_events.size()));
+		for (size_t i = 0; i < pending_events.size(); ++i) {
+			lines.push_back(new AssDialogue);
+			target->Events.push_back(*lines.back());
+		}
+	}
+
+	// Splitting the work isn't worth it for small files
+	const size_t min_lines_per_thread = 5000;
+	size_t thread_count = std::min<size_t>(max_threads, pending_events.size() / min_lines_per_thread);
+
+	if (thread_count <= 1) {
+		for (size_t i = 0; i < lines.size(); ++i)
+			lines[i]->Parse(pending_events[i]);
+		pending_events.clear();
+		return;
+	}
+
+	// Each thread parses a contiguous range of lines and remembers the first
+	// error it hits, so that the error reported is the same one as a serial
+	// parse would have thrown
+	std::vector<std::exception_ptr> errors(thread_count);
+	auto parse_range = [&](size_t n) {
+		size_t begin = lines.size() * n / thread_count;
+		size_t end = lines.size() * (n + 1) / thread_count;
+		try {
+			for (size_t i = begin; i < end; ++i)
+				lines[i]->Parse(pending_events[i]);
+		}
+		catch (...) {
+			errors[n] = std::current_exception();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(thread_count - 1);
+	for (size_t i = 1; i < thread_count; ++i)
+		threads.emplace_back(parse_range, i);
+	parse_range(0);
+	for (auto& thread : threads)
+		thread.join();
+
+	pending_events.clear();
+	for (auto const& error : errors) {
+		if (error)
+			std::rethrow_exception(error);
+	}
+}
@@ -13,6 +13,8 @@
 // OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 #include <memory>
+#include <string>
+#include <vector>
 
 class AssAttachment;
 class AssFile;
@@ -23,9 +25,13 @@ class AssParser {
 
 	AssFile *target;
 	int version;
+	unsigned max_threads;
 	std::unique_ptr<AssAttachment> attach;
 	void (AssParser::*state)(std::string const&);
 
+	/// Event lines which have been read but not yet parsed
+	std::vector<std::string> pending_events;
+
 	void ParseAttachmentLine(std::string const& data);
 	void ParseEventLine(std::string const& data);
 	void ParseStyleLine(std::string const& data);
@@ -36,8 +42,18 @@ class AssParser {
 	void ParseExtradataLine(std::string const &data);
 	void UnknownLine(std::string const&) { }
 public:
-	AssParser(AssFile *target, int version);
+	/// @param target      File to add the parsed entries to
+	/// @param version     ASS version of the file; 0 for SSA
+	/// @param max_threads Most threads to parse events on, or 0 for one per core
+	AssParser(AssFile *target, int version, unsigned max_threads = 0);
 	~AssParser();
 
 	void AddLine(std::string const& data);
+
+	/// @brief Parse all of the buffered event lines into the target file
+	///
+	/// Event lines are only parsed once the entire file has been read so
+	/// that large files can be parsed on multiple threads. This must be
+	/// called after the last line has been added.
+	void Finish();
 };
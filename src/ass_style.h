@@ -27,7 +27,10 @@
 //
 // Aegisub Project http://www.aegisub.org/
 
+#pragma once
+
 #include "ass_entry.h"
+#include "ass_entry_arena.h"
 
 #include <libaegisub/color.h>
 
@@ -70,6 +73,9 @@ public:
 	/// @brief Get a list of valid ASS font encodings
 	static void GetEncodings(wxArrayString &encodingStrings);
 
+	static void *operator new(size_t size) { return EntryArena::Allocate(size); }
+	static void operator delete(void *ptr) { EntryArena::Free(ptr); }
+
 	AssStyle();
 	AssStyle(std::string const& data, int version=1);
 
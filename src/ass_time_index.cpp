@@ -0,0 +1,123 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file ass_time_index.cpp
+/// @brief Index of dialogue lines by time
+/// @ingroup subs_storage
+///
+
+#include "ass_time_index.h"
+
+#include "ass_dialogue.h"
+
+#include <algorithm>
+#include <limits>
+
+void AssTimeIndex::Invalidate() {
+	entries.clear();
+	max_end.clear();
+	entry_of.clear();
+	leaves = 0;
+	valid = false;
+}
+
+void AssTimeIndex::BuildTree() {
+	std::stable_sort(begin(entries), end(entries), [](Entry const& a, Entry const& b) {
+		return a.start < b.start;
+	});
+
+	leaves = 1;
+	while (leaves < entries.size())
+		leaves *= 2;
+
+	max_end.assign(leaves * 2, std::numeric_limits<int>::min());
+	for (size_t i = 0; i < entries.size(); ++i)
+		max_end[leaves + i] = entries[i].end;
+	for (size_t i = leaves - 1; i > 0; --i)
+		max_end[i] = std::max(max_end[i * 2], max_end[i * 2 + 1]);
+
+	entry_of.clear();
+	entry_of.reserve(entries.size());
+	for (size_t i = 0; i < entries.size(); ++i)
+		entry_of[entries[i].line] = i;
+
+	valid = true;
+}
+
+void AssTimeIndex::Collect(size_t node, size_t lo, size_t hi, size_t limit, int start, std::vector<Entry const*> &out) const {
+	if (lo >= limit || max_end[node] <= start) return;
+	if (hi - lo == 1) {
+		out.push_back(&entries[lo]);
+		return;
+	}
+
+	size_t mid = (lo + hi) / 2;
+	Collect(node * 2, lo, mid, limit, start, out);
+	Collect(node * 2 + 1, mid, hi, limit, start, out);
+}
+
+void AssTimeIndex::Replace(AssDialogue const *old_line, AssDialogue *new_line) {
+	if (!valid) return;
+
+	auto it = entry_of.find(old_line);
+	if (it == entry_of.end()) return;
+
+	auto& entry = entries[it->second];
+	if (entry.start != (int)new_line->Start || entry.end != (int)new_line->End) {
+		Invalidate();
+		return;
+	}
+
+	const size_t i = it->second;
+	entry_of.erase(it);
+	entry.line = new_line;
+	entry_of[new_line] = i;
+}
+
+std::vector<AssTimeIndex::Entry const*> AssTimeIndex::Matches(int start, int end_time) const {
+	std::vector<Entry const*> matches;
+	if (entries.empty()) return matches;
+
+	// Only lines which start before the end of the range can overlap it
+	auto limit = std::lower_bound(begin(entries), end(entries), end_time, [](Entry const& e, int time) {
+		return e.start < time;
+	}) - begin(entries);
+
+	Collect(1, 0, leaves, limit, start, matches);
+
+	sort(begin(matches), end(matches), [](Entry const* a, Entry const* b) {
+		return a->pos < b->pos;
+	});
+	return matches;
+}
+
+std::vector<size_t> AssTimeIndex::Positions(int start, int end_time) const {
+	auto matches = Matches(start, end_time);
+	std::vector<size_t> ret;
+	ret.reserve(matches.size());
+	for (auto entry : matches)
+		ret.push_back(entry->pos);
+	return ret;
+}
+
+std::vector<AssDialogue *> AssTimeIndex::Overlapping(int start, int end_time) const {
+	auto matches = Matches(start, end_time);
+	std::vector<AssDialogue *> ret;
+	ret.reserve(matches.size());
+	for (auto entry : matches)
+		ret.push_back(entry->line);
+	return ret;
+}
@@ -0,0 +1,104 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file ass_time_index.h
+/// @see ass_time_index.cpp
+/// @ingroup subs_storage
+///
+
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+class AssDialogue;
+
+/// @class AssTimeIndex
+/// @brief Index of dialogue lines by their start and end times
+///
+/// Lines are stored sorted by start time along with a tree of the maximum end
+/// time of each range of lines, so finding the lines which overlap a time
+/// range only has to look at the lines which actually match rather than every
+/// line in the file.
+class AssTimeIndex {
+	struct Entry {
+		int start;
+		int end;
+		/// Position of the line in the file when the index was built
+		size_t pos;
+		AssDialogue *line;
+	};
+
+	/// Indexed lines, sorted by start time
+	std::vector<Entry> entries;
+	/// Implicit binary tree of the maximum end time of each range of entries
+	std::vector<int> max_end;
+	/// Index in entries of each line, for updating a line without a search
+	std::unordered_map<AssDialogue const*, size_t> entry_of;
+	/// Number of leaves in the tree
+	size_t leaves = 0;
+	bool valid = false;
+
+	void BuildTree();
+	void Collect(size_t node, size_t lo, size_t hi, size_t limit, int start, std::vector<Entry const*> &out) const;
+	/// Get the entries which overlap a time range, in the indexed order
+	std::vector<Entry const*> Matches(int start, int end) const;
+
+public:
+	/// Has the index been built since it was last invalidated?
+	bool IsValid() const { return valid; }
+
+	/// Discard the index
+	void Invalidate();
+
+	/// Build the index from a sequence of lines
+	/// @param lines Lines to index, in file order or any other order which
+	///              results should be reported in
+	template<typename Container>
+	void Build(Container &lines) {
+		entries.clear();
+		size_t pos = 0;
+		for (auto& line : lines)
+			entries.push_back(Entry{(int)line.Start, (int)line.End, pos++, &line});
+		BuildTree();
+	}
+
+	/// @brief Update the index after a line has been replaced with a copy
+	/// @param old_line Line which is no longer in the file
+	/// @param new_line Line which took its place
+	///
+	/// If the times of the line have changed the index is invalidated.
+	void Replace(AssDialogue const *old_line, AssDialogue *new_line);
+
+	/// @brief Get the positions of the lines which overlap a time range
+	/// @param start Start of the range in milliseconds, inclusive
+	/// @param end End of the range in milliseconds, exclusive
+	/// @return Positions in the sequence the index was built from of the
+	///         lines with Start < end and End > start, in ascending order
+	std::vector<size_t> Positions(int start, int end) const;
+
+	/// @brief Get the lines which overlap a time range
+	/// @param start Start of the range in milliseconds, inclusive
+	/// @param end End of the range in milliseconds, exclusive
+	/// @return Matching lines, in file order
+	std::vector<AssDialogue *> Overlapping(int start, int end) const;
+
+	/// @brief Get the lines which are visible at a time
+	/// @param time Time in milliseconds
+	/// @return Lines with Start <= time < End, in file order
+	std::vector<AssDialogue *> At(int time) const { return Overlapping(time, time + 1); }
+};
@@ -18,12 +18,17 @@
 
 #include "ass_dialogue.h"
 #include "ass_file.h"
+#include "ass_file_snapshot.h"
 #include "export_fixstyle.h"
 #include "include/aegisub/subtitles_provider.h"
 #include "video_frame.h"
 #include "video_provider_manager.h"
 
 #include <libaegisub/dispatch.h>
+#include <libaegisub/log.h>
+#include <libaegisub/make_unique.h>
+
+#include <algorithm>
 
 #if BOOST_VERSION >= 106900
 #include <boost/gil.hpp>
@@ -69,6 +74,7 @@ std::shared_ptr<VideoFrame> AsyncVideoProvider::ProcFrame(int frame_number, doub
 			if (single_frame != NEW_SUBS_FILE) {
 				subs_provider->LoadSubtitles(subs.get());
 				single_frame = SUBS_FILE_ALREADY_LOADED;
+				LOG_D("video/provider/async") << "loaded subtitles, parsed " << subs_provider->GetEventsParsed() << " events";
 			}
 			else {
 				AssFixStylesFilter::ProcessSubs(subs.get());
@@ -159,14 +165,15 @@ AsyncVideoProvider::~AsyncVideoProvider() {
 	worker->Sync([]{});
 }
 
-void AsyncVideoProvider::LoadSubtitles(const AssFile *new_subs) throw() {
+void AsyncVideoProvider::LoadSubtitles(std::shared_ptr<const AssFileSnapshot> new_subs) throw() {
 	uint_fast32_t req_version = ++version;
 
-	auto copy = new AssFile(*new_subs);
 	worker->Async([=]{
-		subs.reset(copy);
+		subs = agi::make_unique<AssFile>(*new_subs);
 		single_frame = NEW_SUBS_FILE;
+		prefetch.Invalidate(frame_number + 1);
 		ProcAsync(req_version, false);
+		QueuePrefetch();
 	});
 }
 
@@ -182,26 +189,99 @@ void AsyncVideoProvider::UpdateSubtitles(const AssFile *new_subs, const AssDialo
 		std::advance(it, copy->Row - i);
 		i = copy->Row;
 		subs->Events.insert(it, *copy);
+		subs->ReplaceIndexedLine(&*it, copy);
 		delete &*it--;
 
-		single_frame = NEW_SUBS_FILE;
+		// If the renderer has the whole file loaded, patch just the changed
+		// event into it rather than reloading everything on the next seek
+		if (single_frame == SUBS_FILE_ALREADY_LOADED && subs_provider) {
+			try {
+				if (!subs_provider->UpdateSubtitles(*copy))
+					single_frame = NEW_SUBS_FILE;
+				else
+					LOG_D("video/provider/async") << "updated subtitles, reparsed " << subs_provider->GetEventsParsed() << " events";
+			}
+			catch (agi::Exception const&) {
+				single_frame = NEW_SUBS_FILE;
+			}
+		}
+		else
+			single_frame = NEW_SUBS_FILE;
+		prefetch.Invalidate(frame_number + 1);
 		ProcAsync(req_version, true);
+		QueuePrefetch();
 	});
 }
 
 void AsyncVideoProvider::RequestFrame(int new_frame, double new_time) throw() {
 	uint_fast32_t req_version = ++version;
+	uint_fast32_t request = ++frame_requests;
 
 	worker->Async([=]{
 		time = new_time;
 		frame_number = new_frame;
-		ProcAsync(req_version, false);
+		if (prefetch.IsActive() && request < frame_requests)
+			++dropped_frames;
+		ProcAsync(req_version, false, true);
+		QueuePrefetch();
+	});
+}
+
+void AsyncVideoProvider::StartPlayback(int frame, agi::vfr::Framerate const& fps, int count) throw() {
+	dropped_frames = 0;
+	prefetch.ResetCounters();
+
+	worker->Async([=]{
+		prefetch_fps = fps;
+		prefetch.Start(frame + 1, GetFrameCount(), std::max(count, 0));
+		QueuePrefetch();
+	});
+}
+
+void AsyncVideoProvider::StopPlayback() throw() {
+	worker->Async([=]{
+		prefetch.Stop();
+
+		// Let go of the extra buffers the prefetched frames were produced in
+		size_t unused = 0;
+		for (size_t i = 0; i < buffers.size(); ) {
+			if (buffers[i].use_count() == 1 && ++unused > 2)
+				buffers.erase(buffers.begin() + i);
+			else
+				++i;
+		}
 	});
 }
 
+void AsyncVideoProvider::QueuePrefetch() {
+	if (prefetch_queued || prefetch.NextToProduce() < 0) return;
+	prefetch_queued = true;
+	worker->Async([=]{ PrefetchNext(); });
+}
+
+void AsyncVideoProvider::PrefetchNext() {
+	prefetch_queued = false;
+	const int frame = prefetch.NextToProduce();
+	if (frame < 0) return;
+
+	const double frame_time = prefetch_fps.TimeAtFrame(frame, agi::vfr::EXACT);
+	try {
+		prefetch.Push(FramePrefetchQueue::Frame{frame, frame_time, ProcFrame(frame, frame_time)});
+	}
+	catch (wxEvent const&) {
+		// Leave reporting the error to the request for the frame
+		prefetch.Stop();
+		return;
+	}
+
+	// Only one frame is produced per job so that requests queued meanwhile
+	// don't have to wait for the whole queue to fill
+	QueuePrefetch();
+}
+
 bool AsyncVideoProvider::NeedUpdate(std::vector<AssDialogueBase const*> const& visible_lines) {
 	// Always need to render after a seek
-	if (single_frame != NEW_SUBS_FILE || frame_number != last_rendered)
+	if (frame_number != last_rendered)
 		return true;
 
 	// Obviously need to render if the number of visible lines has changed
@@ -228,14 +308,14 @@ bool AsyncVideoProvider::NeedUpdate(std::vector<AssDialogueBase const*> const& v
 	return false;
 }
 
-void AsyncVideoProvider::ProcAsync(uint_fast32_t req_version, bool check_updated) {
+void AsyncVideoProvider::ProcAsync(uint_fast32_t req_version, bool check_updated, bool frame_request) {
 	// Only actually produce the frame if there's no queued changes waiting
 	if (req_version < version || frame_number < 0) return;
 
 	std::vector<AssDialogueBase const*> visible_lines;
-	for (auto const& line : subs->Events) {
-		if (!line.Comment && !(line.Start > time || line.End <= time))
-			visible_lines.push_back(&line);
+	for (auto line : subs->TimeIndex().At((int)time)) {
+		if (!line->Comment)
+			visible_lines.push_back(line);
 	}
 
 	if (check_updated && !NeedUpdate(visible_lines)) return;
@@ -246,6 +326,14 @@ void AsyncVideoProvider::ProcAsync(uint_fast32_t req_version, bool check_updated
 		last_lines.push_back(*line);
 	last_rendered = frame_number;
 
+	FramePrefetchQueue::Frame prefetched;
+	if (frame_request && prefetch.Take(frame_number, time, prefetched)) {
+		FrameReadyEvent *evt = new FrameReadyEvent(std::move(prefetched.image), time);
+		evt->SetEventType(EVT_FRAME_READY);
+		parent->QueueEvent(evt);
+		return;
+	}
+
 	try {
 		FrameReadyEvent *evt = new FrameReadyEvent(ProcFrame(frame_number, time), time);
 		evt->SetEventType(EVT_FRAME_READY);
@@ -264,7 +352,11 @@ std::shared_ptr<VideoFrame> AsyncVideoProvider::GetFrame(int frame, double time,
 }
 
 void AsyncVideoProvider::SetColorSpace(std::string const& matrix) {
-	worker->Async([=] { source_provider->SetColorSpace(matrix); });
+	worker->Async([=] {
+		source_provider->SetColorSpace(matrix);
+		prefetch.Invalidate(frame_number + 1);
+		QueuePrefetch();
+	});
 }
 
 wxDEFINE_EVENT(EVT_FRAME_READY, FrameReadyEvent);
@@ -15,6 +15,7 @@
 // Aegisub Project http://www.aegisub.org/
 
 #include "include/aegisub/video_provider.h"
+#include "video_prefetch.h"
 
 #include <libaegisub/exception.h>
 #include <libaegisub/fs_fwd.h>
@@ -26,6 +27,7 @@
 
 class AssDialogue;
 class AssFile;
+class AssFileSnapshot;
 class SubtitlesProvider;
 class VideoProvider;
 class VideoProviderError;
@@ -69,8 +71,10 @@ class AsyncVideoProvider {
 
 	std::shared_ptr<VideoFrame> ProcFrame(int frame, double time, bool raw = false);
 
-	/// Produce a frame if req_version is still the current version
-	void ProcAsync(uint_fast32_t req_version, bool check_updated);
+	/// Produce a frame if req_version is still the current version, taking
+	/// it from the prefetched frames if it's a new frame rather than a
+	/// re-render of the current one
+	void ProcAsync(uint_fast32_t req_version, bool check_updated, bool frame_request = false);
 
 	/// Monotonic counter used to drop frames when changes arrive faster than
 	/// they can be rendered
@@ -78,16 +82,36 @@ class AsyncVideoProvider {
 
 	std::vector<std::shared_ptr<VideoFrame>> buffers;
 
+	/// Frames decoded and rendered ahead of playback
+	FramePrefetchQueue prefetch;
+	/// Timecodes giving the prefetched frames their presentation times
+	agi::vfr::Framerate prefetch_fps;
+	/// A PrefetchNext() job is waiting in the worker's queue
+	bool prefetch_queued = false;
+
+	/// Number of frame requests made, so that a request can tell whether a
+	/// newer one has replaced it
+	std::atomic<uint_fast32_t> frame_requests{ 0 };
+	/// Frame requests made during playback which were replaced by a newer
+	/// request before they were rendered
+	std::atomic<uint64_t> dropped_frames{ 0 };
+
+	/// Produce the next frame for the prefetch queue
+	void PrefetchNext();
+	/// Queue a PrefetchNext() job if there's room in the queue and one
+	/// isn't already waiting
+	void QueuePrefetch();
+
 	// Returns a monochromatic frame with the current dimensions
 	VideoFrame GetBlankFrame(bool white);
 
 public:
 	/// @brief Load the passed subtitle file
-	/// @param subs File to load
+	/// @param subs Snapshot of the file to load
 	///
-	/// This function blocks until is it is safe for the calling thread to
-	/// modify subs
-	void LoadSubtitles(const AssFile *subs) throw();
+	/// The worker thread builds its own copy of the file from the snapshot, so
+	/// this returns immediately.
+	void LoadSubtitles(std::shared_ptr<const AssFileSnapshot> subs) throw();
 
 	/// @brief Update a previously loaded subtitle file
 	/// @param subs Subtitle file which was last passed to LoadSubtitles
@@ -120,6 +144,27 @@ public:
 	/// purposes like copying the current subtitles to the clipboard.
 	VideoFrame GetSubtitles(double time);
 
+	/// @brief Start decoding frames ahead of the ones requested for playback
+	/// @param frame Frame currently being shown; prefetching starts after it
+	/// @param fps   Timecodes to get the frames' presentation times from
+	/// @param count Most frames to decode ahead; 0 just resets the counters
+	///
+	/// Requests for the frames which follow are then answered from the
+	/// prefetched frames when they're ready. Anything queued is thrown away
+	/// when the subtitles or color space change.
+	void StartPlayback(int frame, agi::vfr::Framerate const& fps, int count) throw();
+
+	/// Stop decoding ahead and release any frames decoded ahead
+	void StopPlayback() throw();
+
+	/// Frame requests since StartPlayback() which were answered from the
+	/// prefetched frames and which weren't
+	uint64_t GetPrefetchHits() const   { return prefetch.GetHits(); }
+	uint64_t GetPrefetchMisses() const { return prefetch.GetMisses(); }
+	/// Frame requests since StartPlayback() which were replaced by a newer
+	/// request before they could be rendered
+	uint64_t GetDroppedFrames() const  { return dropped_frames; }
+
 	/// Ask the video provider to change YCbCr matricies
 	void SetColorSpace(std::string const& matrix);
 
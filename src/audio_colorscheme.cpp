@@ -32,6 +32,7 @@
 #include "audio_rendering_style.h"
 #include "colorspace.h"
 #include "options.h"
+#include "spectrum_rows.h"
 
 #include <libaegisub/exception.h>
 
@@ -68,3 +69,8 @@ AudioColorScheme::AudioColorScheme(int prec, std::string const& scheme_name, int
 			&palette[i * 3 + 2]);
 	}
 }
+
+void AudioColorScheme::map(const float *vals, size_t count, float scale, unsigned char *pixel, ptrdiff_t step) const
+{
+	MapSpectrumColumn(vals, count, scale, palette.data(), factor, pixel, step);
+}
@@ -92,6 +92,17 @@ public:
 		pixel[2] = color[2];
 	}
 
+	/// @brief Map a column of floating point values to RGB
+	/// @param vals  [in] The values to map from
+	/// @param count Number of values
+	/// @param scale Factor to multiply each value by before mapping it
+	/// @param pixel [out] First byte of the first pixel to write
+	/// @param step  Offset in bytes from each pixel to the next
+	///
+	/// Gives the same result as calling map() for each value, but converts
+	/// several values at once.
+	void map(const float *vals, size_t count, float scale, unsigned char *pixel, ptrdiff_t step) const;
+
 	/// @brief Get a floating point value's colour as a wxColour
 	/// @param val The value to map from
 	/// @return The corresponding wxColour
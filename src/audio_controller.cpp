@@ -29,364 +29,126 @@
 
 #include "audio_controller.h"
 
+#include "audio_time_stretch.h"
 #include "audio_timing.h"
 #include "include/aegisub/audio_player.h"
 #include "include/aegisub/context.h"
 #include "options.h"
 #include "project.h"
+#include "utils.h"
 
 #include <libaegisub/audio/provider.h>
 #include <libaegisub/log.h>
+#include <libaegisub/make_unique.h>
 
 #include <algorithm>
 #include <atomic>
 #include <cmath>
-#include <mutex>
 #include <memory>
 #include <vector>
 
-#ifdef WITH_SOUNDTOUCH
-#include <SoundTouch.h>
-#endif
-
-class AudioController::SpeedProvider final : public agi::AudioProvider {
-	agi::AudioProvider *source = nullptr;
-	std::atomic<double> speed{1.0};
-	std::atomic<double> sample_offset{0.0};
-	std::atomic<bool> keep_pitch{true};
-
-#ifdef WITH_SOUNDTOUCH
-	class SoundTouchTimeStretch {
-		soundtouch::SoundTouch st;
-		int sample_rate = 0;
-		int channels = 0;
-
-	public:
-		void Configure(int sr, int ch, double new_speed) {
-			sample_rate = sr;
-			channels = ch;
-			st.setSampleRate(sample_rate);
-			st.setChannels(channels);
-			st.setPitch(1.0f);
-			st.setRate(1.0f);
-			st.setTempo(static_cast<float>(new_speed));
-		}
+namespace {
+/// How far ahead of playback to time-stretch audio; a change of speed is
+/// heard after about this long plus whatever the player has buffered
+const int stretch_lead_ms = 100;
 
-		void Clear() { st.clear(); }
-		void Flush() { st.flush(); }
-		int Receive(float *out, int frames) { return st.receiveSamples(out, frames); }
-		void Put(const float *in, int frames) { st.putSamples(in, frames); }
-	};
+/// Slowest speed the stretched stream is long enough to play the whole
+/// source at, which is the slowest speed the playback speed commands offer
+const double min_speed = 0.25;
 
-	mutable SoundTouchTimeStretch stretch;
-#endif
-
-	mutable std::mutex stretch_mutex;
-	mutable int64_t stream_output_pos = 0;
-	mutable int64_t stream_source_pos = 0;
-	mutable bool stream_flushed = false;
+double valid_speed(double speed) {
+	if (!std::isfinite(speed) || speed <= 0.0)
+		return 1.0;
+	return std::max(speed, min_speed);
+}
+}
 
+/// @class AudioController::SpeedProvider
+/// @brief The output of a TimeStretchBuffer, presented as an audio provider for the players
+///
+/// Positions in this provider are positions in the stretched output, which
+/// is played from 0 for each range. The stretching is all done ahead of
+/// time by the buffer's own thread, so reads from the player just copy, and
+/// at 1.0x the samples come out exactly as they went in.
+class AudioController::SpeedProvider final : public agi::AudioProvider {
+	mutable TimeStretchBuffer stretch;
 	mutable std::vector<float> float_buffer;
-	mutable std::vector<float> stretch_output;
-	mutable std::vector<int16_t> int_buffer;
 
 	static std::atomic<bool> warned_soundtouch_missing;
 
+	/// The inverse of the stretcher's conversion to float, so that 16-bit
+	/// audio which is only copied through is unchanged
 	static int16_t FloatToInt16(float sample) {
-		float clamped = std::max(-1.0f, std::min(1.0f, sample));
-		int value = static_cast<int>(std::lround(clamped * 32767.0f));
-		if (value < -0x8000) value = -0x8000;
-		else if (value > 0x7FFF) value = 0x7FFF;
-		return static_cast<int16_t>(value);
-	}
-
-	static float Int16ToFloat(int16_t sample) {
-		return static_cast<float>(sample) / 32768.0f;
-	}
-
-	static constexpr int kChunkFrames = 2048;
-
-	void ResetStreamLocked(double cur_speed, double cur_offset, int64_t start) const {
-		stream_output_pos = start;
-		double start_pos = std::isfinite(cur_offset) ? cur_offset + start * cur_speed : 0.0;
-		if (!std::isfinite(start_pos))
-			start_pos = 0.0;
-		stream_source_pos = static_cast<int64_t>(std::llround(start_pos));
-		stream_flushed = false;
-#ifdef WITH_SOUNDTOUCH
-		stretch.Clear();
-		stretch.Configure(sample_rate, channels, cur_speed);
-#endif
-	}
-
-	void FillLegacy(void *buf, int64_t start, int64_t count, double cur_speed, double cur_offset) const {
-		if (channels <= 0 || count <= 0) {
-			ZeroFill(buf, count);
-			return;
-		}
-
-		const double src_first_pos = cur_offset + start * cur_speed;
-		const double src_last_pos = cur_offset + (start + count - 1) * cur_speed;
-
-		int64_t src_start = static_cast<int64_t>(std::floor(src_first_pos));
-		int64_t src_end = static_cast<int64_t>(std::floor(src_last_pos)) + 2;
-		int64_t src_count = src_end - src_start;
-		if (src_count <= 0) {
-			ZeroFill(buf, count);
-			return;
-		}
-
-		if (float_samples && bytes_per_sample == sizeof(float)) {
-			std::vector<float> src(static_cast<size_t>(src_count * channels));
-			source->GetAudio(src.data(), src_start, src_count);
-
-			auto *dst = static_cast<float *>(buf);
-			for (int64_t i = 0; i < count; ++i) {
-				const double src_pos = cur_offset + (start + i) * cur_speed;
-				const int64_t base = static_cast<int64_t>(std::floor(src_pos)) - src_start;
-				const double frac = src_pos - std::floor(src_pos);
-
-				for (int ch = 0; ch < channels; ++ch) {
-					float s0 = 0.0f, s1 = 0.0f;
-					if (base >= 0 && base < src_count)
-						s0 = src[static_cast<size_t>((base * channels) + ch)];
-					if ((base + 1) >= 0 && (base + 1) < src_count)
-						s1 = src[static_cast<size_t>(((base + 1) * channels) + ch)];
-
-					dst[static_cast<size_t>(i * channels + ch)] = static_cast<float>((1.0 - frac) * s0 + frac * s1);
-				}
-			}
-			return;
-		}
-
-		if (bytes_per_sample != static_cast<int>(sizeof(int16_t))) {
-			ZeroFill(buf, count);
-			return;
-		}
-
-		std::vector<int16_t> src(static_cast<size_t>(src_count * channels));
-		source->GetAudio(src.data(), src_start, src_count);
-
-		auto *dst = static_cast<int16_t *>(buf);
-		for (int64_t i = 0; i < count; ++i) {
-			const double src_pos = cur_offset + (start + i) * cur_speed;
-			const int64_t base = static_cast<int64_t>(std::floor(src_pos)) - src_start;
-			const double frac = src_pos - std::floor(src_pos);
-
-			for (int ch = 0; ch < channels; ++ch) {
-				const int64_t idx0 = base * channels + ch;
-				const int64_t idx1 = (base + 1) * channels + ch;
-
-				int s0 = (idx0 >= 0 && idx0 < static_cast<int64_t>(src.size())) ? src[static_cast<size_t>(idx0)] : 0;
-				int s1 = (idx1 >= 0 && idx1 < static_cast<int64_t>(src.size())) ? src[static_cast<size_t>(idx1)] : 0;
-
-				int value = static_cast<int>(std::lround((1.0 - frac) * s0 + frac * s1));
-				value = std::clamp(value, -0x8000, 0x7FFF);
-				dst[static_cast<size_t>(i * channels + ch)] = static_cast<int16_t>(value);
-			}
-		}
-	}
-
-	int64_t FillWithSoundTouch(void *buf, int64_t start, int64_t count, double cur_speed, double cur_offset) const {
-#ifdef WITH_SOUNDTOUCH
-		if (channels <= 0) {
-			ZeroFill(buf, count);
-			return 0;
-		}
-
-		std::lock_guard<std::mutex> lock(stretch_mutex);
-		stretch.Configure(sample_rate, channels, cur_speed);
-
-		if (start != stream_output_pos)
-			ResetStreamLocked(cur_speed, cur_offset, start);
-
-		int64_t produced = 0;
-		const int64_t source_limit = source ? source->GetNumSamples() : 0;
-
-		while (produced < count) {
-			const int frames_needed = static_cast<int>(std::min<int64_t>(kChunkFrames, count - produced));
-			int got = 0;
-
-			if (float_samples && bytes_per_sample == sizeof(float)) {
-				got = stretch.Receive(static_cast<float *>(buf) + static_cast<size_t>(produced * channels), frames_needed);
-			}
-			else {
-				stretch_output.resize(static_cast<size_t>(frames_needed * channels));
-				got = stretch.Receive(stretch_output.data(), frames_needed);
-				if (got > 0) {
-					auto *dst = static_cast<int16_t *>(buf) + static_cast<size_t>(produced * channels);
-					for (int i = 0; i < got * channels; ++i)
-						dst[static_cast<size_t>(i)] = FloatToInt16(stretch_output[static_cast<size_t>(i)]);
-				}
-			}
-
-			if (got > 0) {
-				produced += got;
-				continue;
-			}
-
-			if (!stream_flushed && stream_source_pos >= source_limit) {
-				stretch.Flush();
-				stream_flushed = true;
-				continue;
-			}
-
-			if (stream_flushed && stream_source_pos >= source_limit) {
-				if (float_samples && bytes_per_sample == sizeof(float)) {
-					std::fill_n(static_cast<float *>(buf) + static_cast<size_t>(produced * channels), static_cast<size_t>((count - produced) * channels), 0.0f);
-				}
-				else {
-					std::fill_n(static_cast<int16_t *>(buf) + static_cast<size_t>(produced * channels), static_cast<size_t>((count - produced) * channels), 0);
-				}
-				produced = count;
-				break;
-			}
-
-			const int64_t available = std::max<int64_t>(source_limit - stream_source_pos, 0);
-			if (available <= 0) {
-				stream_flushed = true;
-				continue;
-			}
-
-			int frames_to_read = static_cast<int>(std::min<int64_t>(available, std::max<int64_t>(frames_needed * static_cast<int64_t>(std::ceil(std::max(cur_speed, 1.0 / std::max(cur_speed, 1e-6)))), static_cast<int64_t>(kChunkFrames))));
-			if (frames_to_read <= 0)
-				frames_to_read = static_cast<int>(std::min<int64_t>(available, static_cast<int64_t>(kChunkFrames)));
-
-			float_buffer.resize(static_cast<size_t>(frames_to_read * channels));
-
-			if (source->AreSamplesFloat()) {
-				source->GetAudio(float_buffer.data(), stream_source_pos, frames_to_read);
-			}
-			else {
-				int_buffer.resize(static_cast<size_t>(frames_to_read * channels));
-				source->GetAudio(int_buffer.data(), stream_source_pos, frames_to_read);
-				for (size_t i = 0; i < float_buffer.size(); ++i)
-					float_buffer[i] = Int16ToFloat(int_buffer[i]);
-			}
-
-			stretch.Put(float_buffer.data(), frames_to_read);
-			stream_source_pos += frames_to_read;
-		}
-
-		stream_output_pos = start + produced;
-		return produced;
-#else
-		ZeroFill(buf, count);
-		return 0;
-#endif
-	}
-
-	bool UseSoundTouch(double cur_speed) const {
-#ifdef WITH_SOUNDTOUCH
-		return keep_pitch.load(std::memory_order_relaxed) && std::abs(cur_speed - 1.0) >= 1e-9;
-#else
-		(void)cur_speed;
-		return false;
-#endif
+		return static_cast<int16_t>(mid<long>(-32768, std::lround(sample * 32768.0f), 32767));
 	}
 
 public:
-	explicit SpeedProvider(agi::AudioProvider *src) : source(src) {
-		SetSource(src);
-	}
-
-	void SetSource(agi::AudioProvider *src) {
-		source = src;
-		if (source) {
-			channels = source->GetChannels();
-			bytes_per_sample = source->GetBytesPerSample();
-			float_samples = source->AreSamplesFloat();
-			sample_rate = source->GetSampleRate();
-			num_samples = source->GetNumSamples();
-		}
-		else {
-			channels = 1;
-			bytes_per_sample = static_cast<int>(sizeof(int16_t));
-			float_samples = false;
-			sample_rate = 0;
-			num_samples = 0;
-		}
-		decoded_samples = num_samples;
-		speed.store(1.0, std::memory_order_relaxed);
-		sample_offset.store(0.0, std::memory_order_relaxed);
-		ResetStream();
-	}
-
-	void SetSpeed(double new_speed) {
-		if (!std::isfinite(new_speed) || new_speed <= 0.0)
-			new_speed = 1.0;
-		speed.store(new_speed, std::memory_order_relaxed);
-
-		if (!source) return;
-
-		// The output stream gets longer when playing slower than 1.0x.
-		double slowdown = std::min(new_speed, 1.0);
-		int64_t required = source->GetNumSamples();
-		if (slowdown < 1.0)
-			required = static_cast<int64_t>(std::ceil(source->GetNumSamples() / slowdown));
-
-		if (required > num_samples)
-			num_samples = required;
+	explicit SpeedProvider(agi::AudioProvider *source)
+	: stretch(source, stretch_lead_ms)
+	{
+		channels = source->GetChannels();
+		sample_rate = source->GetSampleRate();
+		float_samples = source->AreSamplesFloat();
+		bytes_per_sample = float_samples ? sizeof(float) : sizeof(int16_t);
+		num_samples = static_cast<int64_t>(std::ceil(source->GetNumSamples() / min_speed));
 		decoded_samples = num_samples;
 	}
 
-	void SetSampleOffset(double new_offset) {
-		if (!std::isfinite(new_offset))
-			new_offset = 0.0;
-		sample_offset.store(new_offset, std::memory_order_relaxed);
-	}
-
-	void SetKeepPitch(bool enable) {
-		keep_pitch.store(enable, std::memory_order_relaxed);
+	/// Start stretching a range of the source, to be played from 0; the
+	/// player must be stopped
+	void Start(int64_t start, int64_t end, double speed, bool keep_pitch) {
 #if !defined(WITH_SOUNDTOUCH)
-		if (enable && !warned_soundtouch_missing.exchange(true)) {
+		if (keep_pitch && !warned_soundtouch_missing.exchange(true)) {
 			LOG_W("audio/controller") << "SoundTouch not available; falling back to legacy speed playback without pitch preservation.";
 		}
 #endif
+		stretch.Start(0, start, end, valid_speed(speed), keep_pitch);
 	}
 
-	void ResetStream() {
-		std::lock_guard<std::mutex> lock(stretch_mutex);
-		const double cur_speed = speed.load(std::memory_order_relaxed);
-		const double cur_offset = sample_offset.load(std::memory_order_relaxed);
-		ResetStreamLocked(cur_speed, cur_offset, 0);
+	void Stop() { stretch.Stop(); }
+
+	/// Change the speed without interrupting playback
+	void SetSpeed(double speed) {
+		stretch.SetSpeed(valid_speed(speed));
 	}
 
+	/// Source sample played at a position in this provider
+	double GetSourcePosition(int64_t pos) const { return stretch.GetSourcePosition(pos); }
+
+	/// Position in this provider the end of the range is played at
+	int64_t GetOutputEnd() const { return stretch.GetOutputEnd(); }
+
 protected:
 	void FillBuffer(void *buf, int64_t start, int64_t count) const override {
-		if (!source || count <= 0) {
-			ZeroFill(buf, count);
-			return;
+		// Players read in order from where playback started, so this should
+		// only happen if one rewinds. The stretcher's thread does the work
+		// of restarting from there, and this plays silence until it has.
+		if (start != stretch.GetReadPosition())
+			stretch.Seek(start);
+
+		float *out = static_cast<float *>(buf);
+		if (!float_samples) {
+			float_buffer.resize(static_cast<size_t>(count * channels));
+			out = float_buffer.data();
 		}
 
-		const double cur_speed = speed.load(std::memory_order_relaxed);
-		const double cur_offset = sample_offset.load(std::memory_order_relaxed);
+		const int64_t got = stretch.Read(out, count);
+		// Whatever isn't ready yet is played as silence
+		std::fill(out + got * channels, out + count * channels, 0.0f);
 
-		if (!std::isfinite(cur_speed) || cur_speed <= 0.0 || !std::isfinite(cur_offset)) {
-			ZeroFill(buf, count);
-			return;
+		if (!float_samples) {
+			auto dst = static_cast<int16_t *>(buf);
+			for (int64_t i = 0; i < count * channels; ++i)
+				dst[i] = FloatToInt16(out[i]);
 		}
-
-		if (UseSoundTouch(cur_speed)) {
-			FillWithSoundTouch(buf, start, count, cur_speed, cur_offset);
-			return;
-		}
-
-		FillLegacy(buf, start, count, cur_speed, cur_offset);
 	}
 };
 
 std::atomic<bool> AudioController::SpeedProvider::warned_soundtouch_missing{false};
 
-void AudioController::EnsureAudioPlayerForSpeed(double speed) {
+void AudioController::EnsureAudioPlayer(bool want_speed_provider) {
 	if (!provider) return;
 
-	if (!std::isfinite(speed) || speed <= 0.0)
-		speed = 1.0;
-
-	// Hard bypass at 1.0x: use the exact pre-playback-speed audio pipeline
-	// (player fed from the original provider) to avoid quality regressions.
-	const bool want_speed_provider = std::abs(speed - 1.0) >= 1e-9;
 	if (player && player_uses_speed_provider == want_speed_provider)
 		return;
 
@@ -401,10 +163,7 @@ void AudioController::EnsureAudioPlayerForSpeed(double speed) {
 	try {
 		if (want_speed_provider) {
 			if (!speed_provider)
-				speed_provider = std::make_unique<SpeedProvider>(provider);
-			else
-				speed_provider->SetSource(provider);
-
+				speed_provider = agi::make_unique<SpeedProvider>(provider);
 			player = AudioPlayerFactory::GetAudioPlayer(speed_provider.get(), context->parent);
 		}
 		else {
@@ -454,6 +213,13 @@ void AudioController::OnPlaybackTimer(wxTimerEvent &)
 	}
 	else
 	{
+		// The end moves once the stretcher picks up a change of speed
+		if (player_uses_speed_provider)
+		{
+			int64_t end = speed_provider->GetOutputEnd();
+			if (end != player->GetEndPosition())
+				player->SetEndPosition(end);
+		}
 		AnnouncePlaybackPosition(MillisecondsFromSamples(pos));
 	}
 }
@@ -519,12 +285,10 @@ void AudioController::OnTimingControllerUpdatedPrimaryRange()
 
 void AudioController::PlayRange(const TimeRange &range)
 {
-	EnsureAudioPlayerForSpeed(1.0);
+	EnsureAudioPlayer(false);
 	if (!player) return;
 
-	playback_speed = 1.0;
-	playback_sample_offset = 0.0;
-
+	player->GetStats().Reset();
 	player->Play(SamplesFromMilliseconds(range.begin()), SamplesFromMilliseconds(range.length()));
 	playback_mode = PM_Range;
 	playback_timer.Start(20);
@@ -534,14 +298,7 @@ void AudioController::PlayRange(const TimeRange &range)
 
 void AudioController::PlayRange(const TimeRange &range, double speed)
 {
-	if (!std::isfinite(speed) || speed <= 0.0)
-		speed = 1.0;
-	if (std::abs(speed - 1.0) < 1e-9) {
-		PlayRange(range);
-		return;
-	}
-
-	EnsureAudioPlayerForSpeed(speed);
+	EnsureAudioPlayer(true);
 	if (!player || !speed_provider) return;
 
 	int64_t start_sample = SamplesFromMilliseconds(range.begin());
@@ -549,16 +306,11 @@ void AudioController::PlayRange(const TimeRange &range, double speed)
 	if (sample_count <= 0) return;
 
 	const bool keep_pitch = OPT_GET("Audio/Keep Pitch When Changing Speed")->GetBool();
-
-	playback_speed = speed;
-	playback_sample_offset = static_cast<double>(start_sample);
-	speed_provider->SetSpeed(speed);
-	speed_provider->SetSampleOffset(playback_sample_offset);
-	speed_provider->SetKeepPitch(keep_pitch);
-	speed_provider->ResetStream();
-
-	auto out_count = static_cast<int64_t>(std::ceil(sample_count / speed));
-	player->Play(0, out_count);
+	// The stretcher can't be restarted while the player is reading from it
+	player->Stop();
+	speed_provider->Start(start_sample, start_sample + sample_count, speed, keep_pitch);
+	player->GetStats().Reset();
+	player->Play(0, speed_provider->GetOutputEnd());
 	playback_mode = PM_Range;
 	playback_timer.Start(20);
 
@@ -581,13 +333,11 @@ void AudioController::PlayToEndOfPrimary(int start_ms)
 
 void AudioController::PlayToEnd(int start_ms)
 {
-	EnsureAudioPlayerForSpeed(1.0);
+	EnsureAudioPlayer(false);
 	if (!player || !provider) return;
 
-	playback_speed = 1.0;
-	playback_sample_offset = 0.0;
-
 	int64_t start_sample = SamplesFromMilliseconds(start_ms);
+	player->GetStats().Reset();
 	player->Play(start_sample, provider->GetNumSamples()-start_sample);
 	playback_mode = PM_ToEnd;
 	playback_timer.Start(20);
@@ -597,14 +347,7 @@ void AudioController::PlayToEnd(int start_ms)
 
 void AudioController::PlayToEnd(int start_ms, double speed)
 {
-	if (!std::isfinite(speed) || speed <= 0.0)
-		speed = 1.0;
-	if (std::abs(speed - 1.0) < 1e-9) {
-		PlayToEnd(start_ms);
-		return;
-	}
-
-	EnsureAudioPlayerForSpeed(speed);
+	EnsureAudioPlayer(true);
 	if (!player || !speed_provider || !provider) return;
 
 	int64_t start_sample = SamplesFromMilliseconds(start_ms);
@@ -612,16 +355,10 @@ void AudioController::PlayToEnd(int start_ms, double speed)
 	if (sample_count <= 0) return;
 
 	const bool keep_pitch = OPT_GET("Audio/Keep Pitch When Changing Speed")->GetBool();
-
-	playback_speed = speed;
-	playback_sample_offset = static_cast<double>(start_sample);
-	speed_provider->SetSpeed(speed);
-	speed_provider->SetSampleOffset(playback_sample_offset);
-	speed_provider->SetKeepPitch(keep_pitch);
-	speed_provider->ResetStream();
-
-	auto out_count = static_cast<int64_t>(std::ceil(sample_count / speed));
-	player->Play(0, out_count);
+	player->Stop();
+	speed_provider->Start(start_sample, start_sample + sample_count, speed, keep_pitch);
+	player->GetStats().Reset();
+	player->Play(0, speed_provider->GetOutputEnd());
 	playback_mode = PM_ToEnd;
 	playback_timer.Start(20);
 
@@ -633,14 +370,41 @@ void AudioController::Stop()
 	if (!player) return;
 
 	player->Stop();
+	if (playback_mode != PM_NotPlaying)
+		LogPlaybackStats();
 	playback_mode = PM_NotPlaying;
 	playback_timer.Stop();
 	if (speed_provider)
-		speed_provider->ResetStream();
+		speed_provider->Stop();
 
 	AnnouncePlaybackStop();
 }
 
+void AudioController::LogPlaybackStats()
+{
+	auto stats = player->GetStats().Get();
+	if (!stats.reads && !stats.provider_reads) return;
+	// Underruns are worth knowing about; otherwise it's just debug noise
+	LOG_SINK("audio/playback/stats", stats.underruns || stats.device_underruns ? agi::log::Warning : agi::log::Debug)
+		<< "player=" << OPT_GET("Audio/Player")->GetString()
+		<< " speed=" << (player_uses_speed_provider ? "stretched" : "normal")
+		<< " " << agi::PlaybackStats::Format(stats);
+}
+
+agi::PlaybackStats *AudioController::GetPlaybackStats()
+{
+	return player ? &player->GetStats() : nullptr;
+}
+
+bool AudioController::SetPlaybackSpeed(double speed)
+{
+	if (!IsPlaying() || !player_uses_speed_provider)
+		return false;
+
+	speed_provider->SetSpeed(speed);
+	return true;
+}
+
 bool AudioController::IsPlaying()
 {
 	return player && playback_mode != PM_NotPlaying;
@@ -682,13 +446,12 @@ int64_t AudioController::SamplesFromMilliseconds(int64_t ms) const
 int64_t AudioController::MillisecondsFromSamples(int64_t samples) const
 {
 	if (!provider) return 0;
-	double speed = playback_speed;
-	if (!std::isfinite(speed) || speed <= 0.0)
-		speed = 1.0;
 
-	double src_samples = playback_sample_offset + samples * speed;
-	if (!std::isfinite(src_samples))
-		return 0;
+	// Positions in the stretched stream are mapped back to the source
+	// samples which were stretched to make them
+	double src_samples = static_cast<double>(samples);
+	if (player_uses_speed_provider && speed_provider)
+		src_samples = speed_provider->GetSourcePosition(samples);
 
 	return static_cast<int64_t>(src_samples * 1000.0 / provider->GetSampleRate());
 }
@@ -38,7 +38,7 @@
 class AudioPlayer;
 class AudioTimingController;
 class TimeRange;
-namespace agi { class AudioProvider; }
+namespace agi { class AudioProvider; class PlaybackStats; }
 namespace agi { struct Context; }
 
 /// @class AudioController
@@ -91,10 +91,15 @@ class AudioController final : public wxEvtHandler {
 	/// Audio provider wrapper used for playback-speed changes
 	class SpeedProvider;
 	std::unique_ptr<SpeedProvider> speed_provider;
-	double playback_speed = 1.0;
-	double playback_sample_offset = 0.0;
 
-	void EnsureAudioPlayerForSpeed(double speed);
+	/// @brief Open a player for the kind of playback about to start, if the current one isn't it
+	/// @param want_speed_provider Play through the time-stretching stage
+	///
+	/// Playback which can change speed goes through the stretching stage
+	/// even at 1.0x, where it's a straight copy, so that changing speed
+	/// never needs a new player. Playback without speed control plays the
+	/// provider directly.
+	void EnsureAudioPlayer(bool want_speed_provider);
 
 	void OnAudioProvider(agi::AudioProvider *new_provider);
 
@@ -110,6 +115,9 @@ class AudioController final : public wxEvtHandler {
 	/// Handler for the current audio player changing
 	void OnAudioPlayerChanged();
 
+	/// Log the current player's counters for the playback just finished
+	void LogPlaybackStats();
+
 #ifdef wxHAS_POWER_EVENTS
 	/// Handle computer going into suspend mode by stopping audio and closing device
 	void OnComputerSuspending(wxPowerEvent &event);
@@ -141,6 +149,9 @@ public:
 	/// The end of the played back range may be requested changed, but is not
 	/// changed automatically from any other operations.
 	void PlayRange(const TimeRange &range);
+	/// @brief Play a range at a speed which can be changed during playback
+	/// @param range Range of audio to play back
+	/// @param speed Playback speed, where 2 is twice as fast
 	void PlayRange(const TimeRange &range, double speed);
 
 	/// @brief Start or restart audio playback, playing the primary playback range
@@ -164,11 +175,23 @@ public:
 	/// playback can, it will continue until the end is reached, it is stopped,
 	/// or restarted.
 	void PlayToEnd(int start_ms);
+	/// Play from a point to the end of stream at a speed which can be
+	/// changed during playback
 	void PlayToEnd(int start_ms, double speed);
 
 	/// @brief Stop all audio playback
 	void Stop();
 
+	/// @brief Change the speed of the audio being played without restarting it
+	/// @param speed New playback speed, where 2 is twice as fast
+	/// @return False if playback needs to be restarted to change speed, as
+	///         it does when nothing is playing or the playback was started
+	///         without a speed
+	///
+	/// The new speed is heard once the audio which has already been
+	/// stretched has been played, and playback positions stay accurate.
+	bool SetPlaybackSpeed(double speed);
+
 	/// @brief Determine whether playback is ongoing
 	/// @return True if audio is being played back
 	bool IsPlaying();
@@ -179,6 +202,13 @@ public:
 	/// Returns 0 if playback is stopped. The return value is only approximate.
 	int GetPlaybackPosition();
 
+	/// @brief Get the counters for the current audio player
+	/// @return The counters, or nullptr if there is no player
+	///
+	/// The counters are reset each time playback starts, and are logged
+	/// under audio/playback/stats when it stops.
+	agi::PlaybackStats *GetPlaybackStats();
+
 	/// @brief Get the primary playback range
 	/// @return An immutable TimeRange object
 	TimeRange GetPrimaryPlaybackRange() const;
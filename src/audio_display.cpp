@@ -580,6 +580,7 @@ AudioDisplay::AudioDisplay(wxWindow *parent, AudioController *controller, agi::C
 , style_ranges({{0, 0}})
 {
 	audio_renderer->SetAmplitudeScale(scale_amplitude);
+	audio_renderer->SetCacheBitmapWidth(OPT_GET("Audio/Renderer/Bitmap Width")->GetInt());
 	SetZoomLevel(0);
 
 	SetMinClientSize(wxSize(-1, 70));
@@ -626,6 +627,8 @@ void AudioDisplay::ScrollPixelToLeft(int pixel_position)
 	scroll_left = pixel_position;
 	scrollbar->SetPosition(scroll_left);
 	timeline->SetPosition(scroll_left);
+	if (load_timer.IsRunning())
+		visible_audio_decoded = PrioritizeVisibleAudio();
 	Refresh();
 }
 
@@ -769,6 +772,11 @@ void AudioDisplay::ReloadRenderingSettings()
 			spectrum_fref_pos [spectrum_freq_curve]
 		);
 
+		// Analysis window
+		int64_t spectrum_window = OPT_GET("Audio/Renderer/Spectrum/Window")->GetInt();
+		spectrum_window = mid<int64_t>(0, spectrum_window, 2);
+		audio_spectrum_renderer->SetWindow(static_cast<FFTWindow>(spectrum_window));
+
 		audio_renderer_provider = std::move(audio_spectrum_renderer);
 	}
 	else
@@ -777,6 +785,11 @@ void AudioDisplay::ReloadRenderingSettings()
 		audio_renderer_provider = agi::make_unique<AudioWaveformRenderer>(colour_scheme_name);
 	}
 
+	audio_renderer_data_connection = audio_renderer_provider->AddDataReadyListener([=] {
+		audio_renderer->InvalidateIncomplete();
+		RefreshRect(wxRect(0, audio_top, GetClientSize().GetWidth(), audio_height), false);
+	});
+
 	audio_renderer->SetRenderer(audio_renderer_provider.get());
 	scrollbar->SetColourScheme(colour_scheme_name);
 	timeline->SetColourScheme(colour_scheme_name);
@@ -802,13 +815,13 @@ void AudioDisplay::OnLoadTimer(wxTimerEvent&)
 		if (new_pos > audio_load_position)
 			audio_load_position = new_pos;
 
-		const double left = last_sample_decoded * 1000.0 / provider->GetSampleRate() / ms_per_pixel;
-		const double right = new_decoded_count * 1000.0 / provider->GetSampleRate() / ms_per_pixel;
-
-		if (left < scroll_left + pixel_audio_width && right >= scroll_left)
+		// The cache doesn't necessarily decode in order, so anything which was
+		// visible and not yet decoded may have changed
+		if (new_decoded_count != last_sample_decoded && !visible_audio_decoded)
 			Refresh();
 		else
 			RefreshRect(scrollbar->GetBounds());
+		visible_audio_decoded = PrioritizeVisibleAudio();
 		last_sample_decoded = new_decoded_count;
 	}
 
@@ -1208,6 +1221,14 @@ int AudioDisplay::GetDuration() const
 	return (provider->GetNumSamples() * 1000 + provider->GetSampleRate() - 1) / provider->GetSampleRate();
 }
 
+bool AudioDisplay::PrioritizeVisibleAudio()
+{
+	const int64_t start = (int64_t)TimeFromRelativeX(0) * provider->GetSampleRate() / 1000;
+	const int64_t end = (int64_t)TimeFromRelativeX(GetClientRect().GetWidth()) * provider->GetSampleRate() / 1000;
+	provider->Prioritize(start, end - start);
+	return provider->IsRangeDecoded(start, end - start);
+}
+
 void AudioDisplay::OnAudioOpen(agi::AudioProvider *provider)
 {
 	this->provider = provider;
@@ -1239,11 +1260,17 @@ void AudioDisplay::OnAudioOpen(agi::AudioProvider *provider)
 				OPT_SUB("Colour/Audio Display/Waveform", &AudioDisplay::ReloadRenderingSettings, this),
 				OPT_SUB("Audio/Renderer/Spectrum/Quality", &AudioDisplay::ReloadRenderingSettings, this),
 				OPT_SUB("Audio/Renderer/Spectrum/FreqCurve", &AudioDisplay::ReloadRenderingSettings, this),
+				OPT_SUB("Audio/Renderer/Spectrum/Window", &AudioDisplay::ReloadRenderingSettings, this),
+				OPT_SUB("Audio/Renderer/Bitmap Width", [=](agi::OptionValue const& opt) {
+					audio_renderer->SetCacheBitmapWidth(opt.GetInt());
+					Refresh();
+				}),
 			});
 			OnTimingController();
 		}
 
 		last_sample_decoded = provider->GetDecodedSamples();
+		visible_audio_decoded = false;
 		audio_load_position = -1;
 		audio_load_speed = 0;
 		audio_load_start_time = std::chrono::steady_clock::now();
@@ -1276,6 +1303,10 @@ void AudioDisplay::OnPlaybackPosition(int ms)
 	int pixel_position = AbsoluteXFromTime(ms);
 	SetTrackCursor(pixel_position, false);
 
+	// Keep the audio about to be played ahead of the rest while loading
+	if (load_timer.IsRunning())
+		provider->Prioritize((int64_t)ms * provider->GetSampleRate() / 1000, provider->GetSampleRate() * 5);
+
 	if (OPT_GET("Audio/Lock Scroll on Cursor")->GetBool())
 	{
 		int client_width = GetClientSize().GetWidth();
@@ -73,6 +73,9 @@ class AudioDisplay: public wxWindow {
 	/// The current audio renderer
 	std::unique_ptr<AudioRendererBitmapProvider> audio_renderer_provider;
 
+	/// Connection for the current audio renderer finishing data in the background
+	agi::signal::Connection audio_renderer_data_connection;
+
 	/// The controller managing us
 	AudioController *controller = nullptr;
 
@@ -99,6 +102,8 @@ class AudioDisplay: public wxWindow {
 
 	wxTimer load_timer;
 	int64_t last_sample_decoded = 0;
+	/// Was all of the visible audio decoded as of the last load timer tick?
+	bool visible_audio_decoded = false;
 	/// Time at which audio loading began, for calculating loading speed
 	std::chrono::steady_clock::time_point audio_load_start_time;
 	/// Estimated speed of audio decoding in samples per ms
@@ -199,6 +204,10 @@ class AudioDisplay: public wxWindow {
 
 	int GetDuration() const;
 
+	/// Ask the audio provider to decode the visible audio before anything else
+	/// @return Has all of the visible audio already been decoded?
+	bool PrioritizeVisibleAudio();
+
 	void OnAudioOpen(agi::AudioProvider *provider);
 	void OnPlaybackPosition(int ms_position);
 	void OnSelectionChanged();
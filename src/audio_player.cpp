@@ -38,6 +38,8 @@
 #include "factory_manager.h"
 #include "options.h"
 
+#include <libaegisub/audio/provider.h>
+
 #include <boost/range/iterator_range.hpp>
 
 std::unique_ptr<AudioPlayer> CreateAlsaPlayer(agi::AudioProvider *providers, wxWindow *window);
@@ -49,6 +51,12 @@ std::unique_ptr<AudioPlayer> CreatePortAudioPlayer(agi::AudioProvider *providers
 std::unique_ptr<AudioPlayer> CreatePulseAudioPlayer(agi::AudioProvider *providers, wxWindow *window);
 std::unique_ptr<AudioPlayer> CreateOSSPlayer(agi::AudioProvider *providers, wxWindow *window);
 
+AudioPlayer::AudioPlayer(agi::AudioProvider *provider)
+: provider(provider)
+, stats(provider ? provider->GetSampleRate() : 0)
+{
+}
+
 namespace {
 	struct factory {
 		const char *name;
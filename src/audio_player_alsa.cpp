@@ -40,6 +40,7 @@
 #include "frame_main.h"
 #include "options.h"
 
+#include <libaegisub/audio/decode_ahead.h>
 #include <libaegisub/audio/provider.h>
 #include <libaegisub/log.h>
 #include <libaegisub/make_unique.h>
@@ -76,10 +77,10 @@ class AlsaPlayer final : public AudioPlayer {
 	Message message = Message::None;
 
 	std::atomic<bool> playing{false};
-	std::atomic<double> volume{1.0};
 	int64_t start_position = 0;
 	std::atomic<int64_t> end_position{0};
 	bool fallback_mono16 = false;	// whether to convert to 16 bit mono. FIXME: more flexible conversion
+	double volume = 1.0;
 
 	std::mutex position_mutex;
 	int64_t last_position = 0;
@@ -87,10 +88,18 @@ class AlsaPlayer final : public AudioPlayer {
 
 	std::vector<char> decode_buffer;
 
+	/// Audio decoded ahead of playback; created on the playback thread once
+	/// the format is known
+	std::unique_ptr<agi::DecodeAheadBuffer> decode_ahead;
+
 	std::thread thread;
 
 	snd_pcm_format_t GetPCMFormat(const agi::AudioProvider *provider);
 
+	/// Write frames to the device, recovering from underruns
+	/// @return Number of frames written, or a negative error code
+	snd_pcm_sframes_t WriteFrames(snd_pcm_t *pcm, const char *buf, snd_pcm_uframes_t frames);
+
 	void PlaybackThread();
 
 	void UpdatePlaybackPosition(snd_pcm_t *pcm, int64_t position)
@@ -98,7 +107,8 @@ class AlsaPlayer final : public AudioPlayer {
 		snd_pcm_sframes_t delay;
 		if (snd_pcm_delay(pcm, &delay) == 0)
 		{
-			std::unique_lock<std::mutex> playback_lock;
+			stats.RecordLatency(delay);
+			std::unique_lock<std::mutex> playback_lock(position_mutex);
 			last_position = position - delay;
 			last_position_time = clock::now();
 		}
@@ -112,7 +122,7 @@ public:
 	void Stop() override;
 	bool IsPlaying() override { return playing; }
 
-	void SetVolume(double vol) override { volume = vol; }
+	void SetVolume(double vol) override;
 	int64_t GetEndPosition() override { return end_position; }
 	int64_t GetCurrentPosition() override;
 	void SetEndPosition(int64_t pos) override;
@@ -148,6 +158,33 @@ snd_pcm_format_t AlsaPlayer::GetPCMFormat(const agi::AudioProvider *provider) {
 	}
 }
 
+snd_pcm_sframes_t AlsaPlayer::WriteFrames(snd_pcm_t *pcm, const char *buf, snd_pcm_uframes_t frames)
+{
+	const size_t framesize = decode_ahead->GetFrameSize();
+	snd_pcm_sframes_t total = 0;
+	while (frames > 0)
+	{
+		snd_pcm_sframes_t written = snd_pcm_writei(pcm, buf, frames);
+		if (written == -ESTRPIPE || written == -EPIPE)
+		{
+			if (written == -EPIPE)
+				stats.RecordDeviceUnderrun();
+			int err = snd_pcm_recover(pcm, written, 0);
+			if (err < 0)
+				return err;
+			continue;
+		}
+		if (written == 0)
+			break;
+		if (written < 0)
+			return written;
+		buf += written * framesize;
+		frames -= written;
+		total += written;
+	}
+	return total;
+}
+
 void AlsaPlayer::PlaybackThread()
 {
 	std::unique_lock<std::mutex> lock(mutex);
@@ -171,7 +208,12 @@ do_setup:
 		return;
 	LOG_D("audio/player/alsa") << "set pcm params";
 
-	size_t framesize = fallback_mono16 ? sizeof(int16_t) : provider->GetChannels() * provider->GetBytesPerSample();
+	// The buffer's frame size depends on the format, so it's made again
+	// whenever the device is set up
+	decode_ahead = agi::make_unique<agi::DecodeAheadBuffer>(provider, fallback_mono16,
+		OPT_GET("Player/Audio/Decode Ahead")->GetInt(), &stats);
+	decode_ahead->SetVolume(volume);
+	size_t framesize = decode_ahead->GetFrameSize();
 
 	while (true)
 	{
@@ -194,24 +236,16 @@ do_setup:
 		// Initial buffer-fill
 		{
 			auto avail = std::min(snd_pcm_avail(pcm), (snd_pcm_sframes_t)(end_position-position));
+			decode_ahead->Start(position, end_position, avail);
 			decode_buffer.resize(avail * framesize);
-			if (fallback_mono16) {
-				provider->GetInt16MonoAudioWithVolume(reinterpret_cast<int16_t*>(decode_buffer.data()), position, avail, volume);
-			} else {
-				provider->GetAudioWithVolume(decode_buffer.data(), position, avail, volume);
-			}
+			avail = decode_ahead->Read(decode_buffer.data(), avail);
 
-			snd_pcm_sframes_t written = 0;
-			while (written <= 0)
+			snd_pcm_sframes_t written = WriteFrames(pcm, decode_buffer.data(), avail);
+			if (written <= 0)
 			{
-				written = snd_pcm_writei(pcm, decode_buffer.data(), avail);
-				if (written == -ESTRPIPE)
-					snd_pcm_recover(pcm, written, 0);
-				else if (written <= 0)
-				{
-					LOG_D("audio/player/alsa") << "error filling buffer";
-					return;
-				}
+				LOG_W("audio/player/alsa") << "error filling buffer";
+				decode_ahead->Stop();
+				return;
 			}
 			position += written;
 		}
@@ -231,6 +265,7 @@ do_setup:
 			if (message == Message::Close)
 			{
 				snd_pcm_drop(pcm);
+				decode_ahead->Stop();
 				return;
 			}
 
@@ -246,9 +281,10 @@ do_setup:
 			snd_pcm_sframes_t tmp_pcm_avail = snd_pcm_avail(pcm);
 			if (tmp_pcm_avail == -EPIPE)
 			{
+				stats.RecordDeviceUnderrun();
 				if (snd_pcm_recover(pcm, -EPIPE, 1) < 0)
 				{
-					LOG_D("audio/player/alsa") << "failed to recover from underrun";
+					LOG_W("audio/player/alsa") << "failed to recover from underrun";
 					return;
 				}
 				tmp_pcm_avail = snd_pcm_avail(pcm);
@@ -258,25 +294,16 @@ do_setup:
 				continue;
 
 			{
+				// Only what has already been decoded is written, so a slow
+				// provider shortens the device's buffer rather than stalling
 				decode_buffer.resize(avail * framesize);
-				if (fallback_mono16) {
-					provider->GetInt16MonoAudioWithVolume(reinterpret_cast<int16_t*>(decode_buffer.data()), position, avail, volume);
-				} else {
-					provider->GetAudioWithVolume(decode_buffer.data(), position, avail, volume);
-				}
-				snd_pcm_sframes_t written = 0;
-				while (written <= 0)
+				avail = decode_ahead->Read(decode_buffer.data(), avail);
+				snd_pcm_sframes_t written = WriteFrames(pcm, decode_buffer.data(), avail);
+				if (written < 0)
 				{
-					written = snd_pcm_writei(pcm, decode_buffer.data(), avail);
-					if (written == -ESTRPIPE || written == -EPIPE)
-						snd_pcm_recover(pcm, written, 0);
-					else if (written == 0)
-						break;
-					else if (written < 0)
-					{
-						LOG_D("audio/player/alsa") << "error filling buffer, written=" << written;
-						return;
-					}
+					LOG_W("audio/player/alsa") << "error filling buffer, written=" << written;
+					decode_ahead->Stop();
+					return;
 				}
 				position += written;
 			}
@@ -293,6 +320,7 @@ do_setup:
 		}
 
 		playing = false;
+		decode_ahead->Stop();
 		LOG_D("audio/player/alsa") << "out of playback loop";
 
 		switch (snd_pcm_state(pcm))
@@ -357,6 +385,16 @@ void AlsaPlayer::SetEndPosition(int64_t pos)
 {
 	std::unique_lock<std::mutex> lock(mutex);
 	end_position = pos;
+	if (decode_ahead)
+		decode_ahead->SetEndPosition(pos);
+}
+
+void AlsaPlayer::SetVolume(double vol)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	volume = vol;
+	if (decode_ahead)
+		decode_ahead->SetVolume(vol);
 }
 
 int64_t AlsaPlayer::GetCurrentPosition()
@@ -365,7 +403,7 @@ int64_t AlsaPlayer::GetCurrentPosition()
 	clock::time_point lasttime;
 
 	{
-		std::unique_lock<std::mutex> playback_lock;
+		std::unique_lock<std::mutex> playback_lock(position_mutex);
 		lastpos = last_position;
 		lasttime = last_position_time;
 	}
@@ -44,6 +44,8 @@
 #include <libaegisub/log.h>
 #include <libaegisub/make_unique.h>
 
+#include <chrono>
+
 // Uncomment to enable extremely spammy debug logging
 //#define PORTAUDIO_DEBUG
 
@@ -243,16 +245,23 @@ int PortAudioPlayer::paCallback(const void *inputBuffer, void *outputBuffer,
 		<< " CPU: " << Pa_GetStreamCpuLoad(player->stream);
 #endif
 
+	if (statusFlags & paOutputUnderflow)
+		player->stats.RecordDeviceUnderrun();
+	if (timeInfo->outputBufferDacTime > timeInfo->currentTime && timeInfo->currentTime > 0)
+		player->stats.RecordLatency(int64_t((timeInfo->outputBufferDacTime - timeInfo->currentTime) * player->provider->GetSampleRate()));
+
 	// Calculate how much left
 	int64_t lenAvailable = std::min<int64_t>(player->end - player->current, framesPerBuffer);
 
 	// Play something
 	if (lenAvailable > 0) {
+		const auto read_start = std::chrono::steady_clock::now();
 		if (player->fallback_mono16) {
 			player->provider->GetInt16MonoAudioWithVolume(reinterpret_cast<int16_t*>(outputBuffer), player->current, lenAvailable, player->GetVolume());
 		} else {
 			player->provider->GetAudioWithVolume(outputBuffer, player->current, lenAvailable, player->GetVolume());
 		}
+		player->stats.RecordProviderRead(std::chrono::steady_clock::now() - read_start);
 
 		// Set play position
 		player->current += lenAvailable;
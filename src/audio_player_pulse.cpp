@@ -36,13 +36,19 @@
 #include "include/aegisub/audio_player.h"
 
 #include "audio_controller.h"
+#include "options.h"
 #include "utils.h"
 
+#include <libaegisub/audio/decode_ahead.h>
 #include <libaegisub/audio/provider.h>
 #include <libaegisub/log.h>
 #include <libaegisub/make_unique.h>
 
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
 #include <pulse/pulseaudio.h>
 #include <wx/thread.h>
 
@@ -74,6 +80,19 @@ class PulseAudioPlayer final : public AudioPlayer {
 
 	int paerror = 0;
 
+	/// Audio decoded ahead of playback, so that the write callback only has
+	/// to copy it. Start and Stop are called with the mainloop locked so that
+	/// they can't overlap with the callback's reads.
+	std::unique_ptr<agi::DecodeAheadBuffer> decode_ahead;
+
+	/// Frames written to the stream since playback started, silence included
+	int64_t written_frames = 0;
+	/// Silence written because decoding fell behind, as the stream position
+	/// it was written at and its length in frames. The stream clock counts
+	/// it as played, so it's taken back out of the playback position.
+	std::vector<std::pair<int64_t, int64_t>> silence;
+	std::mutex silence_mutex;
+
 	static void pa_setvolume_success(pa_context *c, int success, PulseAudioPlayer *thread);
 	/// Called by PA to notify about other context-related stuff
 	static void pa_context_notify(pa_context *c, PulseAudioPlayer *thread);
@@ -83,6 +102,8 @@ class PulseAudioPlayer final : public AudioPlayer {
 	static void pa_stream_write(pa_stream *p, size_t length, PulseAudioPlayer *thread);
 	/// Called by PA to notify about other stream-related stuff
 	static void pa_stream_notify(pa_stream *p, PulseAudioPlayer *thread);
+	/// Called by PA when the server ran out of data to play
+	static void pa_stream_underflow(pa_stream *p, PulseAudioPlayer *thread);
 
 	/// Find the sample format and set fallback_mono16 if necessary
 	pa_sample_format_t GetSampleFormat(const agi::AudioProvider *provider);
@@ -172,6 +193,9 @@ PulseAudioPlayer::PulseAudioPlayer(agi::AudioProvider *provider) : AudioPlayer(p
 	pa_channel_map_init_auto(&map, ss.channels, PA_CHANNEL_MAP_DEFAULT);
 	pa_cvolume_init(&volume);
 
+	decode_ahead = agi::make_unique<agi::DecodeAheadBuffer>(provider, fallback_mono16,
+		OPT_GET("Player/Audio/Decode Ahead")->GetInt(), &stats);
+
 	stream = pa_stream_new(context, "Sound", &ss, &map);
 	if (!stream) {
 		// argh!
@@ -183,6 +207,7 @@ PulseAudioPlayer::PulseAudioPlayer(agi::AudioProvider *provider) : AudioPlayer(p
 	}
 	pa_stream_set_state_callback(stream, (pa_stream_notify_cb_t)pa_stream_notify, this);
 	pa_stream_set_write_callback(stream, (pa_stream_request_cb_t)pa_stream_write, this);
+	pa_stream_set_underflow_callback(stream, (pa_stream_notify_cb_t)pa_stream_underflow, this);
 
 	// Connect stream
 	paerror = pa_stream_connect_playback(stream, nullptr, nullptr, (pa_stream_flags_t)(PA_STREAM_INTERPOLATE_TIMING|PA_STREAM_NOT_MONOTONOUS|PA_STREAM_AUTO_TIMING_UPDATE), nullptr, nullptr);
@@ -236,16 +261,23 @@ void PulseAudioPlayer::Play(int64_t start,int64_t count)
 	cur_frame = start;
 	end_frame = start + count;
 
+	pa_threaded_mainloop_lock(mainloop);
+	const size_t writable = pa_stream_writable_size(stream);
+	decode_ahead->Start(start, start + count, writable / bpf);
+	written_frames = 0;
+	{
+		std::lock_guard<std::mutex> lock(silence_mutex);
+		silence.clear();
+	}
 	is_playing = true;
 
 	play_start_time = 0;
-	pa_threaded_mainloop_lock(mainloop);
 	paerror = pa_stream_get_time(stream, (pa_usec_t*) &play_start_time);
-	pa_threaded_mainloop_unlock(mainloop);
 	if (paerror)
 		LOG_E("audio/player/pulse") << "Error getting stream time: " << pa_strerror(paerror) << "(" << paerror << ")";
 
-	PulseAudioPlayer::pa_stream_write(stream, pa_stream_writable_size(stream), this);
+	PulseAudioPlayer::pa_stream_write(stream, writable, this);
+	pa_threaded_mainloop_unlock(mainloop);
 
 	pa_threaded_mainloop_lock(mainloop);
 	pa_operation *op = pa_stream_trigger(stream, (pa_stream_success_cb_t)pa_stream_success, this);
@@ -270,6 +302,7 @@ void PulseAudioPlayer::Stop()
 
 	// Flush the stream of data
 	pa_threaded_mainloop_lock(mainloop);
+	decode_ahead->Stop();
 	pa_operation *op = pa_stream_flush(stream, (pa_stream_success_cb_t)pa_stream_success, this);
 	pa_threaded_mainloop_unlock(mainloop);
 	stream_success.Wait();
@@ -283,6 +316,7 @@ void PulseAudioPlayer::Stop()
 void PulseAudioPlayer::SetEndPosition(int64_t pos)
 {
 	end_frame = pos;
+	decode_ahead->SetEndPosition(pos);
 }
 
 int64_t PulseAudioPlayer::GetCurrentPosition()
@@ -296,8 +330,19 @@ int64_t PulseAudioPlayer::GetCurrentPosition()
 	pa_usec_t play_cur_time;
 	pa_stream_get_time(stream, &play_cur_time);
 	pa_usec_t playtime = play_cur_time - play_start_time;
+	const int64_t played = playtime * provider->GetSampleRate() / (1000*1000);
+
+	// Leave out whatever silence has been played so far
+	int64_t skipped = 0;
+	{
+		std::lock_guard<std::mutex> lock(silence_mutex);
+		for (auto const& gap : silence) {
+			if (gap.first < played)
+				skipped += std::min(gap.second, played - gap.first);
+		}
+	}
 
-	return start_frame + playtime * provider->GetSampleRate() / (1000*1000);
+	return start_frame + played - skipped;
 }
 
 void PulseAudioPlayer::SetVolume(double vol) {
@@ -336,6 +381,7 @@ void PulseAudioPlayer::pa_stream_write(pa_stream *p, size_t length, PulseAudioPl
 		void *buf = calloc(length, 1);
 		::pa_stream_write(p, buf, length, free, 0, PA_SEEK_RELATIVE);
 		thread->cur_frame += length / thread->bpf;
+		thread->written_frames += length / thread->bpf;
 		return;
 	}
 
@@ -343,14 +389,36 @@ void PulseAudioPlayer::pa_stream_write(pa_stream *p, size_t length, PulseAudioPl
 	unsigned long frames = length / thread->bpf;
 	unsigned long maxframes = thread->end_frame - thread->cur_frame;
 	if (frames > maxframes) frames = maxframes;
+	pa_usec_t latency;
+	int negative;
+	if (pa_stream_get_latency(p, &latency, &negative) == 0 && !negative)
+		thread->stats.RecordLatency(int64_t(latency * thread->provider->GetSampleRate() / (1000*1000)));
+
 	void *buf = malloc(frames * bpf);
-	if (thread->fallback_mono16) {
-		thread->provider->GetInt16MonoAudio(reinterpret_cast<int16_t *>(buf), thread->cur_frame, frames);
-	} else {
-		thread->provider->GetAudio(buf, thread->cur_frame, frames);
+	unsigned long got = thread->decode_ahead->Read(buf, frames);
+	if (got == 0) {
+		// Decoding has fallen behind, so play silence rather than leave the
+		// stream without any data to ask for more with. The source position
+		// doesn't move, so the silence is noted to keep the clock in step.
+		// Pulse can ask for far more than the decode-ahead buffer holds, so
+		// only fill the smallest request it'll make (or 20 ms if it won't
+		// say) and let the next request pick up real audio once it's ready.
+		unsigned long gap = thread->provider->GetSampleRate() / 50;
+		if (const pa_buffer_attr *attr = pa_stream_get_buffer_attr(p))
+			gap = std::max<unsigned long>(attr->minreq / bpf, 1);
+		frames = std::min(frames, gap);
+		memset(buf, 0, frames * bpf);
+		::pa_stream_write(p, buf, frames*bpf, free, 0, PA_SEEK_RELATIVE);
+		{
+			std::lock_guard<std::mutex> lock(thread->silence_mutex);
+			thread->silence.emplace_back(thread->written_frames, int64_t(frames));
+		}
+		thread->written_frames += frames;
+		return;
 	}
-	::pa_stream_write(p, buf, frames*bpf, free, 0, PA_SEEK_RELATIVE);
-	thread->cur_frame += frames;
+	::pa_stream_write(p, buf, got*bpf, free, 0, PA_SEEK_RELATIVE);
+	thread->cur_frame += got;
+	thread->written_frames += got;
 }
 
 /// @brief Called by PA to notify about other stuff
@@ -359,6 +427,14 @@ void PulseAudioPlayer::pa_stream_notify(pa_stream *p, PulseAudioPlayer *thread)
 	thread->sstate = pa_stream_get_state(thread->stream);
 	thread->stream_notify.Post();
 }
+
+/// @brief Called by PA when the server had nothing left to play
+void PulseAudioPlayer::pa_stream_underflow(pa_stream *p, PulseAudioPlayer *thread)
+{
+	// Running dry after the end is just the drain
+	if (thread->is_playing)
+		thread->stats.RecordDeviceUnderrun();
+}
 }
 
 std::unique_ptr<AudioPlayer> CreatePulseAudioPlayer(agi::AudioProvider *provider, wxWindow *) {
@@ -41,18 +41,30 @@ class BSAudioProvider final : public agi::AudioProvider {
 	std::map<std::string, std::string> bsopts;
 	std::unique_ptr<BestAudioSource> bs;
 	BSAudioProperties properties;
+	agi::fs::path filename;
+	std::string cache_file;
+	int64_t max_cache_size;
+	bool needs_cache;
 
 	void FillBuffer(void *Buf, int64_t Start, int64_t Count) const override;
+
+	/// Open another BestAudioSource for the same track, reusing the index
+	BSAudioProvider(BSAudioProvider const& other);
 public:
 	BSAudioProvider(agi::fs::path const& filename, agi::BackgroundRunner *br);
 
-	bool NeedsCache() const override { return OPT_GET("Provider/Audio/BestSource/Aegisub Cache")->GetBool(); }
+	bool NeedsCache() const override { return needs_cache; }
+	std::unique_ptr<agi::AudioProvider> Clone() const override;
 };
 
 /// @brief Constructor
 /// @param filename The filename to open
 BSAudioProvider::BSAudioProvider(agi::fs::path const& filename, agi::BackgroundRunner *br) try
 : bsopts()
+, filename(filename)
+, cache_file(provider_bs::GetCacheFile(filename))
+, max_cache_size(OPT_GET("Provider/Audio/BestSource/Max Cache Size")->GetInt() << 20)
+, needs_cache(OPT_GET("Provider/Audio/BestSource/Aegisub Cache")->GetBool())
 {
 	provider_bs::CleanBSCache();
 	auto track = provider_bs::SelectTrack(filename, true).first;
@@ -67,7 +79,7 @@ BSAudioProvider::BSAudioProvider(agi::fs::path const& filename, agi::BackgroundR
 		ps->SetTitle(from_wx(_("Indexing")));
 		ps->SetMessage(from_wx(_("Indexing file... This will take a while!")));
 		try {
-			bs = agi::make_unique<BestAudioSource>(filename.string(), static_cast<int>(track), -1, false, 0, 1, provider_bs::GetCacheFile(filename), &bsopts, 0, [=](int Track, int64_t Current, int64_t Total) {
+			bs = agi::make_unique<BestAudioSource>(filename.string(), static_cast<int>(track), -1, false, 0, 1, cache_file, &bsopts, 0, [=](int Track, int64_t Current, int64_t Total) {
 				ps->SetProgress(Current, Total);
 				return !ps->IsCancelled();
 			});
@@ -81,19 +93,49 @@ BSAudioProvider::BSAudioProvider(agi::fs::path const& filename, agi::BackgroundR
 	if (cancelled)
 		throw agi::UserCancelException("audio loading cancelled by user");
 
-	bs->SetMaxCacheSize(OPT_GET("Provider/Audio/BestSource/Max Cache Size")->GetInt() << 20);
+	bs->SetMaxCacheSize(max_cache_size);
 	properties = bs->GetAudioProperties();
+	this->track = static_cast<int>(track);
 	float_samples = properties.AF.Float;
 	bytes_per_sample = properties.AF.BytesPerSample;
 	sample_rate = properties.SampleRate;
 	channels = properties.Channels;
 	num_samples = properties.NumSamples;
-	decoded_samples = OPT_GET("Provider/Audio/BestSource/Aegisub Cache")->GetBool() ? 0 : num_samples;
+	decoded_samples = needs_cache ? 0 : num_samples;
 }
 catch (BestSourceException const& err) {
 	throw agi::AudioProviderError("Failed to create BestAudioSource");
 }
 
+BSAudioProvider::BSAudioProvider(BSAudioProvider const& other)
+: bsopts(other.bsopts)
+, bs(agi::make_unique<BestAudioSource>(other.filename.string(), other.track, -1, false, 0, 1, other.cache_file, &bsopts, 0, nullptr))
+, properties(other.properties)
+, filename(other.filename)
+, cache_file(other.cache_file)
+, max_cache_size(other.max_cache_size)
+, needs_cache(other.needs_cache)
+{
+	bs->SetMaxCacheSize(max_cache_size);
+	track = other.track;
+	float_samples = other.float_samples;
+	bytes_per_sample = other.bytes_per_sample;
+	sample_rate = other.sample_rate;
+	channels = other.channels;
+	num_samples = other.num_samples;
+	decoded_samples = num_samples;
+}
+
+std::unique_ptr<agi::AudioProvider> BSAudioProvider::Clone() const {
+	try {
+		return std::unique_ptr<agi::AudioProvider>(new BSAudioProvider(*this));
+	}
+	catch (BestSourceException const& err) {
+		LOG_W("audio_provider/bestsource") << "Could not open another decoder: " << err.what();
+		return nullptr;
+	}
+}
+
 void BSAudioProvider::FillBuffer(void *Buf, int64_t Start, int64_t Count) const {
 	bs->GetPackedAudio(reinterpret_cast<uint8_t *>(Buf), Start, Count);
 }
@@ -27,6 +27,7 @@
 #include <libaegisub/log.h>
 #include <libaegisub/path.h>
 
+#include <boost/crc.hpp>
 #include <boost/range/iterator_range.hpp>
 
 using namespace agi;
@@ -139,12 +140,63 @@ std::unique_ptr<agi::AudioProvider> SelectAudioProvider(fs::path const& filename
 	return provider;
 }
 
+namespace {
+/// Name of the persistent cache file for audio from a file, or an empty path
+/// if the audio can't be identified well enough to be cached persistently
+fs::path PersistentCacheName(fs::path const& filename, AudioProvider const& provider) {
+	// Scripts can produce different audio without being modified themselves
+	if (fs::HasExtension(filename, "avs") || fs::HasExtension(filename, "py") || fs::HasExtension(filename, "vpy"))
+		return fs::path();
+
+	try {
+		// Like FFmpegSourceProvider::GetCacheFilename, but with the track and
+		// format in the hash, as those depend on the provider and its options
+		auto key = agi::format("%s|%d|%d|%d|%d|%d|%d", filename.string(), provider.GetTrack(),
+			provider.GetChannels(), provider.GetSampleRate(), provider.GetBytesPerSample(),
+			provider.AreSamplesFloat(), provider.GetNumSamples());
+		boost::crc_32_type hash;
+		hash.process_bytes(key.data(), key.size());
+		return agi::format("%u_%d_%d.pcmcache", hash.checksum(), fs::Size(filename), fs::ModifiedTime(filename));
+	}
+	catch (fs::FileSystemError const&) {
+		// Not a real file, e.g. dummy audio
+		return fs::path();
+	}
+}
+
+fs::path PersistentCacheDirectory(Path const& path_helper, int cache_type) {
+	// Keep the cache with the HD cache if the user has picked a place for it
+	auto path = OPT_GET("Audio/Cache/HD/Location")->GetString();
+	if (cache_type != 2 || path == "default")
+		return path_helper.Decode("?local/audiocache/");
+	return path_helper.MakeAbsolute(path_helper.Decode(path), "?temp");
+}
+
+void CleanPersistentCache(fs::path const& dir) {
+	CleanCache(dir, "*.pcmcache",
+		OPT_GET("Audio/Cache/Persistent/Size")->GetInt(),
+		OPT_GET("Audio/Cache/Persistent/Files")->GetInt());
+}
+
+/// Log how much of the cache each stream of the audio takes up
+std::unique_ptr<AudioProvider> LogCacheUsage(std::unique_ptr<AudioProvider> provider) {
+	auto usage = provider->GetCacheUsage();
+	LOG_I("audio_provider") << "Audio cache " << (usage.in_memory ? "in memory" : "on disk")
+		<< ": display stream " << usage.display / (1024 * 1024) << " MB"
+		<< ", playback stream " << usage.playback / (1024 * 1024) << " MB";
+	return provider;
+}
+}
+
 std::unique_ptr<agi::AudioProvider> GetAudioProvider(fs::path const& filename,
                                                      Path const& path_helper,
                                                      BackgroundRunner *br) {
 	std::unique_ptr<agi::AudioProvider> provider = SelectAudioProvider(filename, path_helper, br);
 
 	bool needs_cache = provider->NeedsCache();
+	// Identify the decoded audio before conversion, since the converted
+	// format is the same for a lot of different sources
+	auto cache_name = PersistentCacheName(filename, *provider);
 
 	// Give it a converter if needed
 	if (provider->GetBytesPerSample() != 2 || provider->GetSampleRate() < 32000 || provider->GetChannels() != 1)
@@ -155,8 +207,22 @@ std::unique_ptr<agi::AudioProvider> GetAudioProvider(fs::path const& filename,
 	if (!cache || !needs_cache)
 		return CreateLockAudioProvider(std::move(provider));
 
+	// Reuse audio decoded by an earlier session if possible
+	if (!cache_name.empty() && OPT_GET("Audio/Cache/Persistent/Enable")->GetBool()) {
+		auto cache_dir = PersistentCacheDirectory(path_helper, cache);
+		try {
+			fs::CreateDirectory(cache_dir);
+			auto cached = CreatePersistentAudioProvider(provider, cache_dir / cache_name);
+			CleanPersistentCache(cache_dir);
+			return LogCacheUsage(std::move(cached));
+		}
+		catch (agi::Exception const& e) {
+			LOG_W("audio_provider") << "Could not use persistent audio cache: " << e.GetMessage();
+		}
+	}
+
 	// Convert to RAM
-	if (cache == 1) return CreateRAMAudioProvider(std::move(provider));
+	if (cache == 1) return LogCacheUsage(CreateRAMAudioProvider(std::move(provider)));
 
 	// Convert to HD
 	if (cache == 2) {
@@ -164,7 +230,7 @@ std::unique_ptr<agi::AudioProvider> GetAudioProvider(fs::path const& filename,
 		if (path == "default")
 			path = "?temp";
 		auto cache_dir = path_helper.MakeAbsolute(path_helper.Decode(path), "?temp");
-		return CreateHDAudioProvider(std::move(provider), cache_dir);
+		return LogCacheUsage(CreateHDAudioProvider(std::move(provider), cache_dir));
 	}
 
 	throw InternalError("Invalid audio caching method");
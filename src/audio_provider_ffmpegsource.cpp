@@ -40,6 +40,7 @@
 #include "options.h"
 
 #include <libaegisub/fs.h>
+#include <libaegisub/log.h>
 #include <libaegisub/make_unique.h>
 
 #include <map>
@@ -52,16 +53,26 @@ class FFmpegSourceAudioProvider final : public agi::AudioProvider, FFmpegSourceP
 	mutable char FFMSErrMsg[1024];			///< FFMS error message
 	mutable FFMS_ErrorInfo ErrInfo;			///< FFMS error codes/messages
 
+	agi::fs::path FileName;					///< File the audio is from
+	agi::fs::path CacheName;				///< Index file, for opening more instances
+	bool Downmix = false;					///< Was downmixing enabled when the file was opened?
+
+	void InitErrInfo();
 	void LoadAudio(agi::fs::path const& filename);
+	void OpenAudioSource(FFMS_Index *Index);
 	void FillBuffer(void *Buf, int64_t Start, int64_t Count) const override {
 		if (FFMS_GetAudio(AudioSource, Buf, Start, Count, &ErrInfo))
 			throw agi::AudioDecodeError(std::string("Failed to get audio samples: ") + ErrInfo.Buffer);
 	}
 
+	/// Open another audio source for the same track
+	FFmpegSourceAudioProvider(FFmpegSourceAudioProvider const& other);
+
 public:
 	FFmpegSourceAudioProvider(agi::fs::path const& filename, agi::BackgroundRunner *br);
 
 	bool NeedsCache() const override { return true; }
+	std::unique_ptr<agi::AudioProvider> Clone() const override;
 };
 
 /// @brief Constructor
@@ -70,10 +81,7 @@ FFmpegSourceAudioProvider::FFmpegSourceAudioProvider(agi::fs::path const& filena
 : FFmpegSourceProvider(br)
 , AudioSource(nullptr, FFMS_DestroyAudioSource)
 {
-	ErrInfo.Buffer		= FFMSErrMsg;
-	ErrInfo.BufferSize	= sizeof(FFMSErrMsg);
-	ErrInfo.ErrorType	= FFMS_ERROR_SUCCESS;
-	ErrInfo.SubType		= FFMS_ERROR_SUCCESS;
+	InitErrInfo();
 	SetLogLevel();
 
 	LoadAudio(filename);
@@ -82,6 +90,40 @@ catch (agi::EnvironmentError const& err) {
 	throw agi::AudioProviderError(err.GetMessage());
 }
 
+FFmpegSourceAudioProvider::FFmpegSourceAudioProvider(FFmpegSourceAudioProvider const& other)
+: FFmpegSourceProvider(other)
+, AudioSource(nullptr, FFMS_DestroyAudioSource)
+, FileName(other.FileName)
+, CacheName(other.CacheName)
+, Downmix(other.Downmix)
+{
+	InitErrInfo();
+	track = other.track;
+
+	agi::scoped_holder<FFMS_Index*, void (FFMS_CC*)(FFMS_Index*)>
+		Index(FFMS_ReadIndex(CacheName.string().c_str(), &ErrInfo), FFMS_DestroyIndex);
+	if (!Index)
+		throw agi::AudioProviderError(std::string("Failed to read index: ") + ErrInfo.Buffer);
+	OpenAudioSource(Index);
+}
+
+void FFmpegSourceAudioProvider::InitErrInfo() {
+	ErrInfo.Buffer		= FFMSErrMsg;
+	ErrInfo.BufferSize	= sizeof(FFMSErrMsg);
+	ErrInfo.ErrorType	= FFMS_ERROR_SUCCESS;
+	ErrInfo.SubType		= FFMS_ERROR_SUCCESS;
+}
+
+std::unique_ptr<agi::AudioProvider> FFmpegSourceAudioProvider::Clone() const {
+	try {
+		return std::unique_ptr<agi::AudioProvider>(new FFmpegSourceAudioProvider(*this));
+	}
+	catch (agi::AudioProviderError const& err) {
+		LOG_W("audio_provider/ffms") << "Could not open another decoder: " << err.GetMessage();
+		return nullptr;
+	}
+}
+
 void FFmpegSourceAudioProvider::LoadAudio(agi::fs::path const& filename) {
 	FFMS_Indexer *Indexer = FFMS_CreateIndexer(filename.string().c_str(), &ErrInfo);
 	if (!Indexer) {
@@ -111,7 +153,8 @@ void FFmpegSourceAudioProvider::LoadAudio(agi::fs::path const& filename) {
 		throw agi::AudioDataNotFound("no audio tracks found");
 
 	// generate a name for the cache file
-	agi::fs::path CacheName = GetCacheFilename(filename);
+	FileName = filename;
+	CacheName = GetCacheFilename(filename);
 
 	// try to read index
 	agi::scoped_holder<FFMS_Index*, void (FFMS_CC*)(FFMS_Index*)>
@@ -146,7 +189,13 @@ void FFmpegSourceAudioProvider::LoadAudio(agi::fs::path const& filename) {
 	// update access time of index file so it won't get cleaned away
 	agi::fs::Touch(CacheName);
 
-	AudioSource = FFMS_CreateAudioSource(filename.string().c_str(), TrackNumber, Index, FFMS_DELAY_FIRST_VIDEO_TRACK, &ErrInfo);
+	track = TrackNumber;
+	Downmix = OPT_GET("Provider/Audio/FFmpegSource/Downmix")->GetBool();
+	OpenAudioSource(Index);
+}
+
+void FFmpegSourceAudioProvider::OpenAudioSource(FFMS_Index *Index) {
+	AudioSource = FFMS_CreateAudioSource(FileName.string().c_str(), track, Index, FFMS_DELAY_FIRST_VIDEO_TRACK, &ErrInfo);
 	if (!AudioSource)
 		throw agi::AudioProviderError(std::string("Failed to open audio track: ") + ErrInfo.Buffer);
 
@@ -169,7 +218,7 @@ void FFmpegSourceAudioProvider::LoadAudio(agi::fs::path const& filename) {
 			throw agi::AudioProviderError("unknown or unsupported sample format");
 	}
 
-	if (OPT_GET("Provider/Audio/FFmpegSource/Downmix")->GetBool()) {
+	if (Downmix) {
 		if (channels > 2 || bytes_per_sample != 2 || float_samples) {
 			std::unique_ptr<FFMS_ResampleOptions, decltype(&FFMS_DestroyResampleOptions)>
 				opt(FFMS_CreateResampleOptions(AudioSource), FFMS_DestroyResampleOptions);
@@ -37,6 +37,7 @@
 #include <libaegisub/make_unique.h>
 
 #include <algorithm>
+#include <cmath>
 #include <wx/dc.h>
 
 namespace {
@@ -133,6 +134,16 @@ void AudioRenderer::SetAudioProvider(agi::AudioProvider *const _provider)
 	}
 }
 
+void AudioRenderer::SetCacheBitmapWidth(const int width)
+{
+	// Narrower bitmaps than this are mostly overhead
+	if (compare_and_set(cache_bitmap_width, std::max(width, 16)))
+	{
+		Invalidate();
+		ResetBlockCount();
+	}
+}
+
 void AudioRenderer::SetCacheMaxSize(const size_t max_size)
 {
 	// Limit the bitmap cache sizes to 16 MB hard, to avoid the risk of exhausting
@@ -149,13 +160,24 @@ void AudioRenderer::ResetBlockCount()
 	{
 		const size_t total_blocks = NumBlocks(provider->GetNumSamples());
 		for (auto& bmp : bitmaps) bmp.SetBlockCount(total_blocks);
+		incomplete.clear();
 	}
 }
 
 size_t AudioRenderer::NumBlocks(const int64_t samples) const
 {
+	// The last bitmap can extend past the end of the audio, so that the end
+	// isn't left blank when the bitmaps are wide
 	const double duration = samples * 1000.0 / provider->GetSampleRate();
-	return static_cast<size_t>(duration / pixel_ms / cache_bitmap_width);
+	return static_cast<size_t>(std::ceil(duration / pixel_ms / cache_bitmap_width));
+}
+
+bool AudioRenderer::IsBlockDecoded(const int i) const
+{
+	const double samples_per_block = cache_bitmap_width * pixel_ms * provider->GetSampleRate() / 1000.0;
+	const int64_t start = static_cast<int64_t>(i * samples_per_block);
+	const int64_t end = static_cast<int64_t>(std::ceil((i + 1) * samples_per_block));
+	return provider->IsRangeDecoded(start, end - start);
 }
 
 wxBitmap const& AudioRenderer::GetCachedBitmap(const int i, const AudioRenderingStyle style)
@@ -167,7 +189,8 @@ wxBitmap const& AudioRenderer::GetCachedBitmap(const int i, const AudioRendering
 	auto& bmp = bitmaps[style].Get(i, &created);
 	if (created)
 	{
-		renderer->Render(bmp, i*cache_bitmap_width, style);
+		if (!renderer->Render(bmp, i*cache_bitmap_width, style))
+			incomplete.emplace_back(i, style);
 		needs_age = true;
 	}
 
@@ -192,16 +215,21 @@ void AudioRenderer::Render(wxDC &dc, wxPoint origin, const int start, const int
 	// And the offset in it to start its use at
 	const int firstbitmapoffset = start % cache_bitmap_width;
 	// The last bitmap required
-	const int lastbitmap = std::min<int>(end / cache_bitmap_width, NumBlocks(provider->GetDecodedSamples()) - 1);
+	const int lastbitmap = std::min<int>(end / cache_bitmap_width, NumBlocks(provider->GetNumSamples()) - 1);
 
 	// Set a clipping region so that the first and last bitmaps don't draw
 	// outside the requested range
 	const wxDCClipper clipper(dc, wxRect(origin, wxSize(length, pixel_height)));
 	origin.x -= firstbitmapoffset;
 
+	// Audio which hasn't been decoded yet is drawn blank, and since the cache
+	// may not decode in order that can be anywhere
 	for (int i = firstbitmap; i <= lastbitmap; ++i)
 	{
-		dc.DrawBitmap(GetCachedBitmap(i, style), origin);
+		if (IsBlockDecoded(i))
+			dc.DrawBitmap(GetCachedBitmap(i, style), origin);
+		else
+			renderer->RenderBlank(dc, wxRect(origin.x, origin.y, cache_bitmap_width, pixel_height), style);
 		origin.x += cache_bitmap_width;
 	}
 
@@ -220,9 +248,17 @@ void AudioRenderer::Render(wxDC &dc, wxPoint origin, const int start, const int
 void AudioRenderer::Invalidate()
 {
 	for (auto& bmp : bitmaps) bmp.Age(0);
+	incomplete.clear();
 	needs_age = false;
 }
 
+void AudioRenderer::InvalidateIncomplete()
+{
+	for (auto const& bmp : incomplete)
+		bitmaps[bmp.second].Remove(bmp.first);
+	incomplete.clear();
+}
+
 void AudioRendererBitmapProvider::SetProvider(agi::AudioProvider *const _provider)
 {
 	if (compare_and_set(provider, _provider))
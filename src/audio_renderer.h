@@ -37,6 +37,8 @@
 #include "audio_rendering_style.h"
 #include "block_cache.h"
 
+#include <libaegisub/signal.h>
+
 class AudioRenderer;
 class AudioRendererBitmapProvider;
 class wxDC;
@@ -86,11 +88,15 @@ class AudioRenderer {
 	/// Vertical zoom level/amplitude scale
 	float amplitude_scale = 0.f;
 
-	/// Width of bitmaps to store in cache
-	const int cache_bitmap_width = 32; // Completely arbitrary value
+	/// Width of bitmaps to store in cache. Each bitmap is converted from the
+	/// renderer's pixels once, so wider bitmaps mean fewer conversions and
+	/// draws at the cost of rendering more than is visible at the edges.
+	int cache_bitmap_width = 256;
 
 	/// Cached bitmaps for audio ranges
 	std::vector<AudioRendererBitmapCache> bitmaps;
+	/// Cached bitmaps which were rendered before all of their data was available
+	std::vector<std::pair<int, AudioRenderingStyle>> incomplete;
 	/// The maximum allowed size of each bitmap cache, in bytes
 	size_t cache_bitmap_maxsize = 0;
 	/// The maximum allowed size of the renderer's cache, in bytes
@@ -123,6 +129,9 @@ class AudioRenderer {
 	/// Calculate the number of cache blocks needed for a given number of samples
 	size_t NumBlocks(int64_t samples) const;
 
+	/// Has all of the audio covered by a cache block been decoded?
+	bool IsBlockDecoded(int i) const;
+
 public:
 	/// @brief Constructor
 	///
@@ -153,6 +162,12 @@ public:
 	/// depends on the bitmap provider used.)
 	void SetAmplitudeScale(float amplitude_scale);
 
+	/// @brief Set the width of the cached bitmaps
+	/// @param width Width in pixels of each cached bitmap
+	///
+	/// Changing the width invalidates all cached bitmaps.
+	void SetCacheBitmapWidth(int width);
+
 	/// @brief Set the maximum allowed cache size
 	/// @param max_size Size in bytes that may be used for caching
 	///
@@ -213,6 +228,12 @@ public:
 	/// that will affect the rendered images, it should call this function to ensure
 	/// the cache is kept consistent.
 	void Invalidate();
+
+	/// @brief Invalidate cached bitmaps which were rendered with missing data
+	///
+	/// Should be called when the bitmap provider announces that data which
+	/// it previously didn't have is now ready.
+	void InvalidateIncomplete();
 };
 
 
@@ -229,6 +250,10 @@ protected:
 	/// Vertical zoom/amplitude scale factor
 	float amplitude_scale;
 
+	/// Announce that data which was missing from an earlier Render is now
+	/// available, so that the bitmaps can be rendered again
+	agi::signal::Signal<> AnnounceDataReady;
+
 	/// @brief Called when the audio provider changes
 	///
 	/// Implementations can override this method to do something when the audio provider is changed
@@ -256,9 +281,14 @@ public:
 	/// @param start First pixel from beginning of the audio stream to render
 	/// @param style Style to render audio in
 	///
+	/// @return false if some of the data was not ready yet and placeholders
+	///         were drawn in its place
+	///
 	/// Deriving classes must implement this method. The bitmap in bmp holds
-	/// the width and height to render.
-	virtual void Render(wxBitmap &bmp, int start, AudioRenderingStyle style) = 0;
+	/// the width and height to render. Renderers which compute their data in
+	/// the background should draw whatever they have, return false, and
+	/// signal AnnounceDataReady once the rest arrives.
+	virtual bool Render(wxBitmap &bmp, int start, AudioRenderingStyle style) = 0;
 
 	/// @brief Blank audio rendering function
 	/// @param dc    The device context to render to
@@ -287,4 +317,6 @@ public:
 	/// Deriving classes should override this method if they implement any
 	/// kind of caching.
 	virtual void AgeCache(size_t max_size) { }
+
+	DEFINE_SIGNAL_ADDERS(AnnounceDataReady, AddDataReadyListener)
 };
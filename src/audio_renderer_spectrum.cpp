@@ -35,37 +35,172 @@
 #include "audio_renderer_spectrum.h"
 
 #include "audio_colorscheme.h"
-#ifndef WITH_FFTW3
-#include "fft.h"
-#endif
 
 #include <libaegisub/audio/provider.h>
+#include <libaegisub/dispatch.h>
+#include <libaegisub/log.h>
 #include <libaegisub/make_unique.h>
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 #include <wx/image.h>
 #include <wx/dcmemory.h>
 
+namespace {
+/// Settings used to compute blocks, copied for each block so that the
+/// renderer can change them while blocks are being computed
+struct SpectrumParams {
+	agi::AudioProvider *provider = nullptr;
+	size_t derivation_size = 0;
+	size_t derivation_dist = 0;
+	size_t derivation_size_user = 0;
+	/// Analysis window coefficients, or null for none
+	std::shared_ptr<const std::vector<float>> window;
+#ifdef WITH_FFTW3
+	fftw_plan dft_plan = nullptr;
+#endif
+};
+
+/// Buffers for computing blocks, one set per worker thread
+struct SpectrumScratch {
+	/// derivation_size the buffers are allocated for
+	size_t derivation_size = 0;
+
+	/// Raw audio data
+	std::vector<int16_t> audio;
+
+#ifdef WITH_FFTW3
+	/// Input array for FFTW
+	double *dft_input = nullptr;
+	/// Output array for FFTW
+	fftw_complex *dft_output = nullptr;
+
+	~SpectrumScratch()
+	{
+		fftw_free(dft_input);
+		fftw_free(dft_output);
+	}
+#else
+	/// Transform for the current derivation size
+	std::unique_ptr<FFT> fft;
+	/// Windowed input to the transform
+	std::vector<float> fft_input;
+	/// Real and imaginary parts of the spectrum
+	std::vector<float> fft_real, fft_imag;
+#endif
+
+	void Resize(size_t size)
+	{
+		if (derivation_size == size && !audio.empty())
+			return;
+		derivation_size = size;
+
+		audio.resize(2 << derivation_size);
+#ifdef WITH_FFTW3
+		// fftw_alloc gives the same alignment the plan was made with, which
+		// fftw_execute_dft_r2c requires
+		fftw_free(dft_input);
+		fftw_free(dft_output);
+		dft_input = fftw_alloc_real(2<<derivation_size);
+		dft_output = fftw_alloc_complex(2<<derivation_size);
+#else
+		fft = agi::make_unique<FFT>(2 << derivation_size);
+		fft_input.resize(2 << derivation_size);
+		fft_real.resize((1 << derivation_size) + 1);
+		fft_imag.resize((1 << derivation_size) + 1);
+#endif
+	}
+};
+
+/// @brief Convert audio data to float range [-1;+1) and apply the analysis window
+/// @param src    Samples to convert
+/// @param window Window coefficients, or null for none
+/// @param dest   Buffer to fill
+template<class T>
+void ConvertToFloat(std::vector<int16_t> const& src, std::vector<float> const* window, T *dest) {
+	if (!window)
+	{
+		for (size_t si = 0; si < src.size(); ++si)
+			dest[si] = (T)(src[si]) / 32768.0;
+		return;
+	}
+
+	assert(window->size() == src.size());
+	const float *w = window->data();
+	for (size_t si = 0; si < src.size(); ++si)
+		dest[si] = (T)(src[si] * w[si]) / 32768.0;
+}
+
+/// @brief Fill a block with frequency-power data for a time range
+/// @param      params      Settings to compute the block with
+/// @param      block_index Index of the block to fill data for
+/// @param[out] block       Address to write the data to
+void FillBlock(SpectrumParams const& params, size_t block_index, float *block)
+{
+	assert(block);
+
+	static thread_local SpectrumScratch scratch;
+	scratch.Resize(params.derivation_size);
+
+	const size_t derivation_size = params.derivation_size;
+	int64_t first_sample = (((int64_t)block_index) << params.derivation_dist) - ((int64_t)1 << derivation_size);
+	params.provider->GetInt16MonoAudio(scratch.audio.data(), first_sample, 2 << derivation_size);
+
+	// Because the FFTs used here are unnormalized DFTs, we have to compensate
+	// the possible length difference between derivation_size used in the
+	// calculations and its user-provided counterpart. Thus, the display is
+	// kept independent of the sampling rate.
+	const float scale_fix =
+		1.f / sqrtf (float (1 << (derivation_size - params.derivation_size_user)));
+
+#ifdef WITH_FFTW3
+	ConvertToFloat(scratch.audio, params.window.get(), scratch.dft_input);
+
+	fftw_execute_dft_r2c(params.dft_plan, scratch.dft_input, scratch.dft_output);
+
+	double scale_factor = scale_fix * 9 / sqrt(2 << (derivation_size + 1));
+
+	fftw_complex *o = scratch.dft_output;
+	for (size_t si = (size_t)1<<derivation_size; si > 0; --si)
+	{
+		*block++ = log10( sqrt(o[0][0] * o[0][0] + o[0][1] * o[0][1]) * scale_factor + 1 );
+		o++;
+	}
+#else
+	ConvertToFloat(scratch.audio, params.window.get(), scratch.fft_input.data());
+
+	scratch.fft->Transform(scratch.fft_input.data(), scratch.fft_real.data(), scratch.fft_imag.data());
+	const float *fft_real = scratch.fft_real.data();
+	const float *fft_imag = scratch.fft_imag.data();
+
+	float scale_factor = scale_fix * 9 / sqrt(2 * (float)(2<<derivation_size));
+
+	for (size_t si = 1<<derivation_size; si > 0; --si)
+	{
+		// With x in range [0;1], log10(x*9+1) will also be in range [0;1],
+		// although the FFT output can apparently get greater magnitudes than 1
+		// despite the input being limited to [-1;+1).
+		*block++ = log10( sqrt(*fft_real * *fft_real + *fft_imag * *fft_imag) * scale_factor + 1 );
+		fft_real++; fft_imag++;
+	}
+#endif
+}
+}
+
 /// Allocates blocks of derived data for the audio spectrum
+///
+/// Blocks are only ever produced by AudioSpectrumWorkers and inserted into
+/// the cache, so this just describes them.
 struct AudioSpectrumCacheBlockFactory {
-	typedef std::unique_ptr<float, std::default_delete<float[]>> BlockType;
+	typedef std::unique_ptr<float[]> BlockType;
 
 	/// Pointer back to the owning spectrum renderer
 	AudioSpectrumRenderer *spectrum;
 
-	/// @brief Allocate and fill a data block
-	/// @param i Index of the block to produce data for
-	/// @return Newly allocated and filled block
-	///
-	/// The filling is delegated to the spectrum renderer
-	BlockType ProduceBlock(size_t i)
-	{
-		auto res = new float[((size_t)1)<<spectrum->derivation_size];
-		spectrum->FillBlock(i, res);
-		return BlockType(res);
-	}
-
 	/// @brief Calculate the in-memory size of a spec
 	/// @return The size in bytes of a spectrum cache block
 	size_t GetBlockSize() const
@@ -84,7 +219,180 @@ public:
 	}
 };
 
+/// @class AudioSpectrumWorkers
+/// @brief Computes spectrum blocks on the background dispatch queue
+///
+/// At most one task per core pulls blocks from the queue, so that a long
+/// backlog of blocks doesn't crowd out other background work. Finished blocks
+/// are collected and handed to the renderer on the main thread in batches,
+/// with a single announcement per batch rather than a redraw per block.
+class AudioSpectrumWorkers final : public std::enable_shared_from_this<AudioSpectrumWorkers> {
+	std::mutex lock;
+	/// Signalled when the last block being computed finishes
+	std::condition_variable idle;
+
+	/// Blocks waiting to be computed. Blocks are taken from the back, where
+	/// blocks on screen are added, so that the most recently displayed area
+	/// is filled in first; prefetched blocks are added to the front.
+	std::deque<size_t> queue;
+
+	/// Settings for computing blocks
+	SpectrumParams params;
+
+	/// Incremented whenever params changes, so that blocks which were
+	/// computed with the old settings can be discarded. Only written on the
+	/// main thread.
+	uint64_t generation = 0;
+
+	/// Number of tasks posted to the background queue
+	unsigned active = 0;
+
+	/// Number of blocks currently being computed
+	unsigned computing = 0;
+
+	/// Maximum number of tasks to post
+	const unsigned max_active = std::max(1u, std::thread::hardware_concurrency());
+
+	/// A computed block waiting to be handed to the renderer
+	struct Finished {
+		size_t block_index;
+		/// The block's data, or null if computing it failed
+		std::unique_ptr<float[]> block;
+		/// Why computing the block failed
+		std::string error;
+		uint64_t generation;
+	};
+	std::vector<Finished> finished;
+
+	/// A task to deliver the finished blocks has been posted to the main
+	/// thread and hasn't run yet
+	bool delivery_posted = false;
+
+	void Run();
+
+	/// Hand all of the finished blocks to the renderer; main thread only
+	void Deliver();
+
+public:
+	/// Renderer to deliver blocks to; only used on the main thread
+	AudioSpectrumRenderer *renderer;
+
+	AudioSpectrumWorkers(AudioSpectrumRenderer *renderer) : renderer(renderer) { }
+
+	/// @brief Queue a block to be computed
+	/// @param block_index Index of the block
+	/// @param prefetch Compute the block after everything already queued
+	void Request(size_t block_index, bool prefetch);
+
+	/// @brief Change the settings used to compute blocks
+	///
+	/// Discards all queued blocks and waits for any which are being computed
+	/// with the old settings to finish.
+	void Reset(SpectrumParams const& new_params);
+};
+
+void AudioSpectrumWorkers::Request(size_t block_index, bool prefetch)
+{
+	std::lock_guard<std::mutex> l(lock);
+	if (prefetch)
+		queue.push_front(block_index);
+	else
+		queue.push_back(block_index);
+
+	if (active < max_active)
+	{
+		++active;
+		auto self = shared_from_this();
+		agi::dispatch::Background().Async([self] { self->Run(); });
+	}
+}
+
+void AudioSpectrumWorkers::Run()
+{
+	std::unique_lock<std::mutex> l(lock);
+	while (!queue.empty())
+	{
+		const size_t block_index = queue.back();
+		queue.pop_back();
+		const SpectrumParams block_params = params;
+		const uint64_t block_generation = generation;
+		++computing;
+		l.unlock();
+
+		std::unique_ptr<float[]> block;
+		std::string error;
+		try
+		{
+			block.reset(new float[((size_t)1)<<block_params.derivation_size]);
+			FillBlock(block_params, block_index, block.get());
+		}
+		catch (agi::Exception const& e)
+		{
+			block.reset();
+			error = e.GetMessage();
+		}
+		catch (std::exception const& e)
+		{
+			block.reset();
+			error = e.what();
+		}
+		catch (...)
+		{
+			block.reset();
+			error = "unknown error";
+		}
+
+		l.lock();
+		finished.push_back(Finished{block_index, std::move(block), std::move(error), block_generation});
+		if (!delivery_posted)
+		{
+			delivery_posted = true;
+			auto self = shared_from_this();
+			agi::dispatch::Main().Async([self] { self->Deliver(); });
+		}
+		if (--computing == 0)
+			idle.notify_all();
+	}
+	--active;
+}
+
+void AudioSpectrumWorkers::Deliver()
+{
+	std::vector<Finished> batch;
+	uint64_t current_generation;
+	{
+		std::lock_guard<std::mutex> l(lock);
+		batch.swap(finished);
+		delivery_posted = false;
+		current_generation = generation;
+	}
+
+	if (!renderer) return;
+
+	bool received = false;
+	for (auto& done : batch)
+	{
+		// Blocks computed with old settings are no use
+		if (done.generation != current_generation) continue;
+		renderer->ReceiveBlock(done.block_index, std::move(done.block), done.error);
+		received = true;
+	}
+	if (received)
+		renderer->AnnounceDataReady();
+}
+
+void AudioSpectrumWorkers::Reset(SpectrumParams const& new_params)
+{
+	std::unique_lock<std::mutex> l(lock);
+	queue.clear();
+	++generation;
+	idle.wait(l, [&] { return computing == 0; });
+	finished.clear();
+	params = new_params;
+}
+
 AudioSpectrumRenderer::AudioSpectrumRenderer(std::string const& color_scheme_name)
+: workers(std::make_shared<AudioSpectrumWorkers>(this))
 {
 	colors.reserve(AudioStyle_MAX);
 	for (int i = 0; i < AudioStyle_MAX; ++i)
@@ -94,6 +402,7 @@ AudioSpectrumRenderer::AudioSpectrumRenderer(std::string const& color_scheme_nam
 AudioSpectrumRenderer::~AudioSpectrumRenderer()
 {
 	// This sequence will clean up
+	workers->renderer = nullptr;
 	provider = nullptr;
 	RecreateCache();
 }
@@ -102,39 +411,48 @@ void AudioSpectrumRenderer::RecreateCache()
 {
 	update_derivation_values ();
 
+	// Wait for blocks using the old plan and provider before freeing them
+	workers->Reset(SpectrumParams());
+	pending.clear();
+	failed.clear();
+
 #ifdef WITH_FFTW3
 	if (dft_plan)
 	{
 		fftw_destroy_plan(dft_plan);
-		fftw_free(dft_input);
-		fftw_free(dft_output);
 		dft_plan = nullptr;
-		dft_input = nullptr;
-		dft_output = nullptr;
 	}
 #endif
 
 	if (provider)
 	{
-		size_t block_count = (size_t)((provider->GetNumSamples() + ((size_t)1<<derivation_dist) - 1) >> derivation_dist);
+		block_count = (size_t)((provider->GetNumSamples() + ((size_t)1<<derivation_dist) - 1) >> derivation_dist);
 		cache = agi::make_unique<AudioSpectrumCache>(block_count, this);
 
+		SpectrumParams params;
+		params.provider = provider;
+		params.derivation_size = derivation_size;
+		params.derivation_dist = derivation_dist;
+		params.derivation_size_user = derivation_size_user;
+		if (window != FFTWindow::Rectangular)
+			params.window = std::make_shared<const std::vector<float>>(MakeFFTWindow(window, 2 << derivation_size));
+
 #ifdef WITH_FFTW3
-		dft_input = fftw_alloc_real(2<<derivation_size);
-		dft_output = fftw_alloc_complex(2<<derivation_size);
+		// Planning overwrites the arrays, so plan with throwaway ones and
+		// have each worker execute the plan on its own
+		double *dft_input = fftw_alloc_real(2<<derivation_size);
+		fftw_complex *dft_output = fftw_alloc_complex(2<<derivation_size);
 		dft_plan = fftw_plan_dft_r2c_1d(
 			2<<derivation_size,
 			dft_input,
 			dft_output,
 			FFTW_MEASURE);
-#else
-		// Allocate scratch for 6x the derivation size:
-		// 2x for the input sample data
-		// 2x for the real part of the output
-		// 2x for the imaginary part of the output
-		fft_scratch.resize(6 << derivation_size);
+		fftw_free(dft_input);
+		fftw_free(dft_output);
+		params.dft_plan = dft_plan;
 #endif
-		audio_scratch.resize(2 << derivation_size);
+
+		workers->Reset(params);
 	}
 }
 
@@ -145,16 +463,19 @@ void AudioSpectrumRenderer::OnSetProvider()
 
 void AudioSpectrumRenderer::SetResolution(size_t _derivation_size, size_t _derivation_dist)
 {
-	if (derivation_dist_user != _derivation_dist)
+	if (derivation_dist_user != _derivation_dist || derivation_size_user != _derivation_size)
 	{
 		derivation_dist_user = _derivation_dist;
-		update_derivation_values ();
-		AgeCache (0);
+		derivation_size_user = _derivation_size;
+		RecreateCache();
 	}
+}
 
-	if (derivation_size_user != _derivation_size)
+void AudioSpectrumRenderer::SetWindow(FFTWindow new_window)
+{
+	if (window != new_window)
 	{
-		derivation_size_user = _derivation_size;
+		window = new_window;
 		RecreateCache();
 	}
 }
@@ -167,15 +488,6 @@ void AudioSpectrumRenderer::set_reference_frequency_position (float pos_fref_)
 	pos_fref = pos_fref_;
 }
 
-
-template<class T>
-void AudioSpectrumRenderer::ConvertToFloat(size_t count, T *dest) {
-	for (size_t si = 0; si < count; ++si)
-	{
-		dest[si] = (T)(audio_scratch[si]) / 32768.0;
-	}
-}
-
 void AudioSpectrumRenderer::update_derivation_values ()
 {
 	// Below this sampling rate (Hz), the derivation values are identical to
@@ -202,65 +514,33 @@ void AudioSpectrumRenderer::update_derivation_values ()
 	}
 }
 
-void AudioSpectrumRenderer::FillBlock(size_t block_index, float *block)
+bool AudioSpectrumRenderer::RequestBlock(size_t block_index, bool prefetch)
 {
-	assert(cache);
-	assert(block);
-
-	int64_t first_sample = (((int64_t)block_index) << derivation_dist) - ((int64_t)1 << derivation_size);
-	provider->GetInt16MonoAudio(audio_scratch.data(), first_sample, 2 << derivation_size);
-	
-	// Because the FFTs used here are unnormalized DFTs, we have to compensate
-	// the possible length difference between derivation_size used in the
-	// calculations and its user-provided counterpart. Thus, the display is
-	// kept independent of the sampling rate.
-	const float scale_fix =
-		1.f / sqrtf (float (1 << (derivation_size - derivation_size_user)));
-
-#ifdef WITH_FFTW3
-	ConvertToFloat(2 << derivation_size, dft_input);
-
-	fftw_execute(dft_plan);
-
-	double scale_factor = scale_fix * 9 / sqrt(2 << (derivation_size + 1));
+	if (failed.count(block_index))
+		return false;
+	if (pending.insert(block_index).second)
+		workers->Request(block_index, prefetch);
+	return true;
+}
 
-	fftw_complex *o = dft_output;
-	for (size_t si = (size_t)1<<derivation_size; si > 0; --si)
+void AudioSpectrumRenderer::ReceiveBlock(size_t block_index, std::unique_ptr<float[]> block, std::string const& error)
+{
+	pending.erase(block_index);
+	if (!block)
 	{
-		*block++ = log10( sqrt(o[0][0] * o[0][0] + o[0][1] * o[0][1]) * scale_factor + 1 );
-		o++;
+		// Drawn as silence from now on rather than retried on every render
+		LOG_E("audio/renderer/spectrum") << "Computing block " << block_index << " failed: " << error;
+		failed.insert(block_index);
+		return;
 	}
-#else
-	ConvertToFloat(2 << derivation_size, &fft_scratch[0]);
 
-	float *fft_input = &fft_scratch[0];
-	float *fft_real = &fft_scratch[0] + (2 << derivation_size);
-	float *fft_imag = &fft_scratch[0] + (4 << derivation_size);
-
-	FFT fft;
-	fft.Transform(2<<derivation_size, fft_input, fft_real, fft_imag);
-
-	float scale_factor = scale_fix * 9 / sqrt(2 * (float)(2<<derivation_size));
-
-	for (size_t si = 1<<derivation_size; si > 0; --si)
-	{
-		// With x in range [0;1], log10(x*9+1) will also be in range [0;1],
-		// although the FFT output can apparently get greater magnitudes than 1
-		// despite the input being limited to [-1;+1).
-		*block++ = log10( sqrt(*fft_real * *fft_real + *fft_imag * *fft_imag) * scale_factor + 1 );
-		fft_real++; fft_imag++;
-	}
-#endif
+	cache->Insert(block_index, std::move(block));
 }
 
-void AudioSpectrumRenderer::Render(wxBitmap &bmp, int start, AudioRenderingStyle style)
+bool AudioSpectrumRenderer::Render(wxBitmap &bmp, int start, AudioRenderingStyle style)
 {
-	// Misc. utility functions
-	auto floor_int = [] (float val) { return int (floorf (val       )); };
-	auto round_int = [] (float val) { return int (floorf (val + 0.5f)); };
-
 	if (!cache)
-		return;
+		return true;
 
 	assert(bmp.IsOk());
 	assert(bmp.GetDepth() == 24 || bmp.GetDepth() == 32);
@@ -272,103 +552,71 @@ void AudioSpectrumRenderer::Render(wxBitmap &bmp, int start, AudioRenderingStyle
 	assert(end >= start);
 
 	// Prepare an image buffer to write
-	wxImage img(bmp.GetSize());
-	unsigned char *imgdata = img.GetData();
-	ptrdiff_t stride = img.GetWidth()*3;
-	int imgheight = img.GetHeight();
+	if (!image.IsOk() || image.GetSize() != bmp.GetSize())
+		image.Create(bmp.GetSize(), false);
+	unsigned char *imgdata = image.GetData();
+	ptrdiff_t stride = image.GetWidth()*3;
+	int imgheight = image.GetHeight();
 
 	const AudioColorScheme *pal = &colors[style];
 
-	// Sampling rate, in Hz.
-	const float sample_rate = float (provider->GetSampleRate ());
-
-	// Number of FFT bins, excluding the "Nyquist" one
-	const int nbr_bins = 1 << derivation_size;
-
-	// minband and maxband define an half-open range.
-	int minband = 1; // Starts at 1, we don't care about showing the DC.
-	int maxband = std::min (
-		round_int (nbr_bins * max_freq / (sample_rate * 0.5f)),
-		nbr_bins
-	);
-	assert (minband < maxband);
-
-	// Precomputes this once, this will be useful for the log curve.
-	const float scale_log = logf (maxband / minband);
-
-	// Turns the user-specified 1 kHz position into a ratio between the linear
-	// and logarithmic curves that we can directly use in the following
-	// calculations.
-	assert (pos_fref > 0);
-	assert (pos_fref < 1);
-	float b_fref         = nbr_bins * freq_ref / (sample_rate * 0.5f);
-	b_fref               = mid (1.f, b_fref, float (maxband - 1));
-	const float clin     = minband + (maxband - minband) * pos_fref;
-	const float clog     = minband * expf (pos_fref * scale_log);
-	float log_ratio_calc = (b_fref - clin) / (clog - clin);
-	log_ratio_calc       = mid (0.f, log_ratio_calc, 1.f);
+	// Working out which bins each row shows is only done when something it
+	// depends on changes
+	SpectrumRowParams row_params;
+	row_params.height = imgheight;
+	row_params.derivation_size = derivation_size;
+	row_params.sample_rate = float (provider->GetSampleRate ());
+	row_params.max_freq = max_freq;
+	row_params.freq_ref = freq_ref;
+	row_params.pos_fref = pos_fref;
+	if (!row_map || row_map->GetParams() != row_params)
+		row_map = agi::make_unique<SpectrumRowMap>(row_params);
+	column.resize(imgheight);
+
+	auto block_at = [&] (int ax) {
+		return (size_t)(ax * pixel_ms * provider->GetSampleRate() / 1000) >> derivation_dist;
+	};
+
+	bool complete = true;
 
 	// ax = absolute x, absolute to the virtual spectrum bitmap
 	for (int ax = start; ax < end; ++ax)
 	{
-		// Derived audio data
-		size_t block_index = (size_t)(ax * pixel_ms * provider->GetSampleRate() / 1000) >> derivation_dist;
-		float *power = &cache->Get(block_index);
+		// Derived audio data; the last bitmap can extend past the end of
+		// the audio, which is drawn as silence
+		size_t block_index = block_at(ax);
+		float *power = block_index < block_count ? cache->TryGet(block_index) : nullptr;
 
-		// Prepare bitmap writing
+		// Columns are written from the bottom up
 		unsigned char *px = imgdata + (imgheight-1) * stride + (ax - start) * 3;
 
-		float bin_prv = minband;
-		float bin_cur = minband;
-		for (int y = 0; y < imgheight; ++y)
+		// Draw silence until the workers have computed the block
+		if (!power)
 		{
-			assert (bin_cur < float (maxband));
-
-			float       bin_nxt = maxband;
-			if (y + 1 < imgheight)
-			{
-				// Bin index is an interpolation between the linear and log curves.
-				const float pos_rel = float (y + 1) / float (imgheight);
-				const float b_lin   = minband + pos_rel * (maxband - minband);
-				const float b_log   = minband * expf (pos_rel * scale_log);
-				bin_nxt = b_lin + log_ratio_calc * (b_log - b_lin);
-			}
-
-			float val = 0;
-
-			// Interpolate between consecutive bins
-			if (bin_nxt - bin_prv < 2)
-			{
-				const int   bin_0 = floor_int (bin_cur);
-				const int   bin_1 = std::min (bin_0 + 1, nbr_bins - 1);
-				const float frac  = bin_cur - float (bin_0);
-				const float v0    = power [bin_0];
-				const float v1    = power [bin_1];
-				val = v0 + frac * (v1 - v0);
-			}
-
-			// Pick the greatest bin on the interval
-			else
-			{
-				int bin_inf = floor_int ((bin_prv + bin_cur) * 0.5f);
-				int bin_sup = floor_int ((bin_cur + bin_nxt) * 0.5f);
-				bin_inf = std::min (bin_inf, nbr_bins - 2);
-				bin_sup = std::min (bin_sup, nbr_bins - 1);
-				assert (bin_inf < bin_sup);
-				val = *std::max_element (&power [bin_inf], &power [bin_sup]);
-			}
-
-			pal->map (val * amplitude_scale, px);
-
-			px     -= stride;
-			bin_prv = bin_cur;
-			bin_cur = bin_nxt;
+			if (block_index < block_count && RequestBlock(block_index, false))
+				complete = false;
+			std::fill(column.begin(), column.end(), 0.f);
 		}
+		else
+			row_map->MapColumn(power, column.data());
+
+		pal->map(column.data(), column.size(), amplitude_scale, px, -stride);
+	}
+
+	// The display is usually scrolled forwards, so get a bitmap's worth of
+	// blocks past this one started as well
+	for (int ax = end; ax < end + (end - start); ++ax)
+	{
+		size_t block_index = block_at(ax);
+		if (block_index >= block_count) break;
+		if (!cache->TryGet(block_index))
+			RequestBlock(block_index, true);
 	}
 
-	wxBitmap tmpbmp(img);
+	wxBitmap tmpbmp(image);
 	wxMemoryDC targetdc(bmp);
 	targetdc.DrawBitmap(tmpbmp, 0, 0);
+	return complete;
 }
 
 void AudioSpectrumRenderer::RenderBlank(wxDC &dc, const wxRect &rect, AudioRenderingStyle style)
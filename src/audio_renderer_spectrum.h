@@ -34,10 +34,16 @@
 /// Calculate and render a frequency-power spectrum for PCM audio data.
 
 #include <cstdint>
+#include <string>
 #include <memory>
+#include <unordered_set>
 #include <vector>
 
 #include "audio_renderer.h"
+#include "fft.h"
+#include "spectrum_rows.h"
+
+#include <wx/image.h>
 
 #ifdef WITH_FFTW3
 #include <fftw3.h>
@@ -45,6 +51,7 @@
 
 class AudioColorScheme;
 class AudioSpectrumCache;
+class AudioSpectrumWorkers;
 struct AudioSpectrumCacheBlockFactory;
 
 /// @class AudioSpectrumRenderer
@@ -52,12 +59,29 @@ struct AudioSpectrumCacheBlockFactory;
 ///
 /// Renders frequency-power spectrum graphs of PCM audio data using a derivation function
 /// such as the fast fourier transform.
+///
+/// The derivations are done on background threads, so rendering never waits
+/// for them. Columns whose data isn't ready yet are drawn as silence and
+/// AnnounceDataReady is signalled as the data comes in.
 class AudioSpectrumRenderer final : public AudioRendererBitmapProvider {
 	friend struct AudioSpectrumCacheBlockFactory;
+	friend class AudioSpectrumWorkers;
 
 	/// Internal cache management for the spectrum
 	std::unique_ptr<AudioSpectrumCache> cache;
 
+	/// Number of blocks in the cache
+	size_t block_count = 0;
+
+	/// Background tasks computing blocks for the cache
+	std::shared_ptr<AudioSpectrumWorkers> workers;
+
+	/// Blocks which have been requested from the workers but not received yet
+	std::unordered_set<size_t> pending;
+
+	/// Blocks which couldn't be computed, which are drawn as silence
+	std::unordered_set<size_t> failed;
+
 	/// Colour tables used for rendering
 	std::vector<AudioColorScheme> colors;
 
@@ -67,6 +91,9 @@ class AudioSpectrumRenderer final : public AudioRendererBitmapProvider {
 	/// User-provided value for derivation_dist
 	size_t derivation_dist_user = 0;
 
+	/// Analysis window applied to the audio before each derivation
+	FFTWindow window = FFTWindow::Hann;
+
 	/// Maximum audible, displayed frequency. Avoids wasting the display space
 	/// with ultrasonic content at sampling rates > 40 kHz.
 	float max_freq = 20000.f;
@@ -81,6 +108,15 @@ class AudioSpectrumRenderer final : public AudioRendererBitmapProvider {
 	/// Reference frequency which vertical position is constant, Hz.
 	const float freq_ref = 1000.0f;
 
+	/// Bins shown by each pixel row, for the parameters it was last built with
+	std::unique_ptr<SpectrumRowMap> row_map;
+
+	/// Values of the rows of the column being rendered
+	std::vector<float> column;
+
+	/// Image the bitmaps are rendered into, reused while the size is unchanged
+	wxImage image;
+
 	/// Binary logarithm of number of samples to use in deriving frequency-power data
 	/// This could differ from the user-provided value because the actual value
 	/// used in computations may be scaled, depending on the sampling rate.
@@ -103,35 +139,29 @@ class AudioSpectrumRenderer final : public AudioRendererBitmapProvider {
 	/// e.g. new audio provider or new resolution.
 	void RecreateCache();
 
-	/// @brief Fill a block with frequency-power data for a time range
-	/// @param      block_index Index of the block to fill data for
-	/// @param[out] block       Address to write the data to
-	void FillBlock(size_t block_index, float *block);
+	/// @brief Queue a block to be computed if it isn't already
+	/// @param block_index Index of the block
+	/// @param prefetch Is the block not on screen yet?
+	/// @return False if computing the block has already failed
+	bool RequestBlock(size_t block_index, bool prefetch);
 
-	/// @brief Convert audio data to float range [-1;+1)
-	/// @param count Samples to convert
-	/// @param dest Buffer to fill
-	template<class T>
-	void ConvertToFloat(size_t count, T *dest);
+	/// @brief Store a block computed by the workers
+	/// @param block_index Index of the block
+	/// @param block       The block's data, or null if computing it failed
+	/// @param error       Why computing the block failed, if it did
+	///
+	/// The workers announce that data is ready once they've handed over a
+	/// batch of blocks.
+	void ReceiveBlock(size_t block_index, std::unique_ptr<float[]> block, std::string const& error);
 
 	/// @brief Updates the derivation_* after a derivation_*_user change.
 	void update_derivation_values ();
 
 #ifdef WITH_FFTW3
-	/// FFTW plan data
+	/// FFTW plan data, shared by all of the workers
 	fftw_plan dft_plan = nullptr;
-	/// Pre-allocated input array for FFTW
-	double *dft_input = nullptr;
-	/// Pre-allocated output array for FFTW
-	fftw_complex *dft_output = nullptr;
-#else
-	/// Pre-allocated scratch area for doing FFT derivations
-	std::vector<float> fft_scratch;
 #endif
 
-	/// Pre-allocated scratch area for storing raw audio data
-	std::vector<int16_t> audio_scratch;
-
 public:
 	/// @brief Constructor
 	/// @param color_scheme_name Name of the color scheme to use
@@ -144,7 +174,7 @@ public:
 	/// @param bmp   [in,out] Bitmap to render into, also carries length information
 	/// @param start First column of pixel data in display to render
 	/// @param style Style to render audio in
-	void Render(wxBitmap &bmp, int start, AudioRenderingStyle style) override;
+	bool Render(wxBitmap &bmp, int start, AudioRenderingStyle style) override;
 
 	/// @brief Render blank area
 	void RenderBlank(wxDC &dc, const wxRect &rect, AudioRenderingStyle style) override;
@@ -160,6 +190,13 @@ public:
 	/// is specified too large, it will be clamped to the size.
 	void SetResolution(size_t derivation_size, size_t derivation_dist);
 
+	/// @brief Set the analysis window applied to the audio before deriving
+	/// @param window Window to use
+	///
+	/// Windowing reduces the leakage of strong frequencies into the
+	/// surrounding bins at the cost of slightly wider peaks.
+	void SetWindow(FFTWindow window);
+
 	/// @brief Set the vertical relative position of the reference frequency (1 kHz)
 	/// @param fref_pos_ Vertical position of the 1 kHz frequency. Between 0 and 1, boundaries excluded.
 	///
@@ -32,10 +32,13 @@
 #include "audio_colorscheme.h"
 #include "options.h"
 
+#include <libaegisub/audio/peak_pyramid.h>
 #include <libaegisub/audio/provider.h>
 
+#include <libaegisub/make_unique.h>
+
 #include <algorithm>
-#include <wx/dcmemory.h>
+#include <wx/dc.h>
 
 enum {
 	/// Only render the peaks
@@ -55,9 +58,17 @@ AudioWaveformRenderer::AudioWaveformRenderer(std::string const& color_scheme_nam
 
 AudioWaveformRenderer::~AudioWaveformRenderer() { }
 
-void AudioWaveformRenderer::Render(wxBitmap &bmp, int start, AudioRenderingStyle style)
+void AudioWaveformRenderer::OnSetProvider()
+{
+	audio_buffer.reset();
+	peaks.reset();
+	// Created up front so that it's filled in as the audio is decoded
+	if (provider)
+		peaks = agi::make_unique<agi::AudioPeakPyramid>(provider);
+}
+
+bool AudioWaveformRenderer::Render(wxBitmap &bmp, int start, AudioRenderingStyle style)
 {
-	wxMemoryDC dc(bmp);
 	wxRect rect(wxPoint(0, 0), bmp.GetSize());
 	int midpoint = rect.height / 2;
 
@@ -65,67 +76,94 @@ void AudioWaveformRenderer::Render(wxBitmap &bmp, int start, AudioRenderingStyle
 
 	double pixel_samples = pixel_ms * provider->GetSampleRate() / 1000.0;
 
-	// Fill the background
-	dc.SetBrush(wxBrush(pal->get(0.0f)));
-	dc.SetPen(*wxTRANSPARENT_PEN);
-	dc.DrawRectangle(rect);
+	double cur_sample = start * pixel_samples;
+
+	raster.Reset(rect.width, rect.height);
+
+	const bool use_peaks = pixel_samples >= agi::AudioPeakPyramid::MinSamples();
 
 	// Make sure we've got a buffer to fill with audio data
-	if (!audio_buffer)
+	if (!use_peaks && !audio_buffer)
 	{
 		// Buffer for one pixel strip of audio
 		size_t buffer_needed = pixel_samples * provider->GetChannels() * provider->GetBytesPerSample();
 		audio_buffer.reset(new char[buffer_needed]);
 	}
 
-	double cur_sample = start * pixel_samples;
-
-	wxPen pen_peaks(wxPen(pal->get(0.4f)));
-	wxPen pen_avgs(wxPen(pal->get(0.7f)));
-
 	for (int x = 0; x < rect.width; ++x)
 	{
-		provider->GetInt16MonoAudio(reinterpret_cast<int16_t*>(audio_buffer.get()), (int64_t)cur_sample, (int64_t)pixel_samples);
-		cur_sample += pixel_samples;
-
 		int peak_min = 0, peak_max = 0;
-		int64_t avg_min_accum = 0, avg_max_accum = 0;
-		auto aud = reinterpret_cast<const int16_t *>(audio_buffer.get());
-		for (int si = pixel_samples; si > 0; --si, ++aud)
+		int avg_min, avg_max;
+
+		if (use_peaks)
 		{
-			if (*aud > 0)
-			{
-				peak_max = std::max(peak_max, (int)*aud);
-				avg_max_accum += *aud;
-			}
-			else
+			auto first = (int64_t)cur_sample;
+			cur_sample += pixel_samples;
+			auto peak = peaks->Get(first, (int64_t)cur_sample - first);
+
+			peak_min = peak.min;
+			peak_max = peak.max;
+			avg_min = std::max((int)(peak.avg_min * amplitude_scale * midpoint) / 0x8000, -midpoint);
+			avg_max = std::min((int)(peak.avg_max * amplitude_scale * midpoint) / 0x8000, midpoint);
+		}
+		else
+		{
+			provider->GetInt16MonoAudio(reinterpret_cast<int16_t*>(audio_buffer.get()), (int64_t)cur_sample, (int64_t)pixel_samples);
+			cur_sample += pixel_samples;
+
+			int64_t avg_min_accum = 0, avg_max_accum = 0;
+			auto aud = reinterpret_cast<const int16_t *>(audio_buffer.get());
+			for (int si = pixel_samples; si > 0; --si, ++aud)
 			{
-				peak_min = std::min(peak_min, (int)*aud);
-				avg_min_accum += *aud;
+				if (*aud > 0)
+				{
+					peak_max = std::max(peak_max, (int)*aud);
+					avg_max_accum += *aud;
+				}
+				else
+				{
+					peak_min = std::min(peak_min, (int)*aud);
+					avg_min_accum += *aud;
+				}
 			}
+
+			avg_min = std::max((int)(avg_min_accum * amplitude_scale * midpoint / pixel_samples) / 0x8000, -midpoint);
+			avg_max = std::min((int)(avg_max_accum * amplitude_scale * midpoint / pixel_samples) / 0x8000, midpoint);
 		}
 
 		// midpoint is half height
 		peak_min = std::max((int)(peak_min * amplitude_scale * midpoint) / 0x8000, -midpoint);
 		peak_max = std::min((int)(peak_max * amplitude_scale * midpoint) / 0x8000, midpoint);
-		int avg_min = std::max((int)(avg_min_accum * amplitude_scale * midpoint / pixel_samples) / 0x8000, -midpoint);
-		int avg_max = std::min((int)(avg_max_accum * amplitude_scale * midpoint / pixel_samples) / 0x8000, midpoint);
-
-		dc.SetPen(pen_peaks);
-		dc.DrawLine(x, midpoint - peak_max, x, midpoint - peak_min);
-		if (render_averages) {
-			dc.SetPen(pen_avgs);
-			dc.DrawLine(x, midpoint - avg_max, x, midpoint - avg_min);
-		}
+
+		if (render_averages)
+			raster.SetColumn(x, midpoint - peak_max, midpoint - peak_min, midpoint - avg_max, midpoint - avg_min);
+		else
+			raster.SetColumn(x, midpoint - peak_max, midpoint - peak_min, 0, 0);
 	}
 
-	// Horizontal zero-point line
-	if (render_averages)
-		dc.SetPen(wxPen(pal->get(1.0f)));
-	else
-		dc.SetPen(pen_peaks);
+	// The horizontal zero-point line is drawn in the average colour, or the
+	// peak colour if there are no averages
+	const wxColour colours[] = {
+		pal->get(0.0f),
+		pal->get(0.4f),
+		pal->get(0.7f),
+		render_averages ? pal->get(1.0f) : pal->get(0.4f)
+	};
+	unsigned char palette[4][3];
+	for (int i = 0; i < 4; ++i)
+	{
+		palette[i][0] = colours[i].Red();
+		palette[i][1] = colours[i].Green();
+		palette[i][2] = colours[i].Blue();
+	}
 
-	dc.DrawLine(0, midpoint, rect.width, midpoint);
+	// Only the conversion to a bitmap goes through wx, once for the whole
+	// bitmap rather than for each line
+	if (!image.IsOk() || image.GetSize() != bmp.GetSize())
+		image.Create(bmp.GetSize(), false);
+	raster.Rasterize(palette, midpoint, image.GetData());
+	bmp = wxBitmap(image, 24);
+	return true;
 }
 
 void AudioWaveformRenderer::RenderBlank(wxDC &dc, const wxRect &rect, AudioRenderingStyle style)
@@ -28,12 +28,16 @@
 // Aegisub Project http://www.aegisub.org/
 
 #include "audio_renderer.h"
+#include "waveform_raster.h"
 
 #include <memory>
 #include <vector>
 
+#include <wx/image.h>
+
 class AudioColorScheme;
 class wxArrayString;
+namespace agi { class AudioPeakPyramid; }
 
 /// Render a waveform display of PCM audio data
 class AudioWaveformRenderer final : public AudioRendererBitmapProvider {
@@ -43,10 +47,20 @@ class AudioWaveformRenderer final : public AudioRendererBitmapProvider {
 	/// Pre-allocated buffer for audio fetched from provider
 	std::unique_ptr<char[]> audio_buffer;
 
+	/// Precomputed peaks used when zoomed out far enough that each column
+	/// covers at least one bucket, filled in as the provider decodes
+	std::unique_ptr<agi::AudioPeakPyramid> peaks;
+
 	/// Whether to render max+avg or just max
 	bool render_averages;
 
-	void OnSetProvider() override { audio_buffer.reset(); }
+	/// Spans of the columns of the bitmap being rendered
+	WaveformRaster raster;
+
+	/// Image the bitmaps are rendered into, reused while the size is unchanged
+	wxImage image;
+
+	void OnSetProvider() override;
 	void OnSetMillisecondsPerPixel() override { audio_buffer.reset(); }
 
 public:
@@ -61,7 +75,7 @@ public:
 	/// @param bmp   [in,out] Bitmap to render into, also carries length information
 	/// @param start First column of pixel data in display to render
 	/// @param style Style to render audio in
-	void Render(wxBitmap &bmp, int start, AudioRenderingStyle style) override;
+	bool Render(wxBitmap &bmp, int start, AudioRenderingStyle style) override;
 
 	/// @brief Render blank area
 	void RenderBlank(wxDC &dc, const wxRect &rect, AudioRenderingStyle style) override;
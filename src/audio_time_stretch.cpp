@@ -0,0 +1,397 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file audio_time_stretch.cpp
+/// @brief Time-stretching audio ahead of playback on a background thread
+/// @ingroup audio_output
+
+#include "audio_time_stretch.h"
+
+#include <libaegisub/audio/provider.h>
+#include <libaegisub/make_unique.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#ifdef WITH_SOUNDTOUCH
+#include <SoundTouch.h>
+#endif
+
+namespace {
+int64_t round_up_pow2(int64_t n) {
+	int64_t pow2 = 1;
+	while (pow2 < n) pow2 *= 2;
+	return pow2;
+}
+
+/// How long the stretcher waits for room in the ring before checking again;
+/// the reader never blocks, so it doesn't wake the stretcher
+const auto poll_interval = std::chrono::milliseconds(5);
+
+/// Most source frames to give SoundTouch at a time
+const int64_t source_chunk = 2048;
+}
+
+#ifdef WITH_SOUNDTOUCH
+struct TimeStretchBuffer::Stretcher {
+	soundtouch::SoundTouch st;
+};
+#else
+struct TimeStretchBuffer::Stretcher { };
+#endif
+
+TimeStretchBuffer::TimeStretchBuffer(agi::AudioProvider *source, int lead_ms)
+: source(source)
+, channels(std::max(source->GetChannels(), 1))
+, lead(std::max<int64_t>(int64_t(source->GetSampleRate()) * lead_ms / 1000, 256))
+, capacity(round_up_pow2(lead))
+, chunk(std::max<int64_t>(lead / 4, 64))
+, ring(new float[capacity * channels])
+, stretcher(agi::make_unique<Stretcher>())
+, thread([this] { Work(); })
+{
+}
+
+TimeStretchBuffer::~TimeStretchBuffer() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closing = true;
+		active = false;
+	}
+	cond.notify_all();
+	thread.join();
+}
+
+void TimeStretchBuffer::ReadSource(int64_t start, int64_t count) {
+	float_buffer.resize(count * channels);
+	if (source->AreSamplesFloat() && source->GetBytesPerSample() == sizeof(float))
+		source->GetAudio(float_buffer.data(), start, count);
+	else if (!source->AreSamplesFloat() && source->GetBytesPerSample() == sizeof(int16_t)) {
+		int_buffer.resize(count * channels);
+		source->GetAudio(int_buffer.data(), start, count);
+		for (size_t i = 0; i < float_buffer.size(); ++i)
+			float_buffer[i] = int_buffer[i] / 32768.f;
+	}
+	else
+		std::fill(float_buffer.begin(), float_buffer.end(), 0.f);
+}
+
+void TimeStretchBuffer::AddSegment(int64_t output, double source_pos, double new_speed) {
+	std::lock_guard<std::mutex> lock(segments_mutex);
+	if (!segments.empty() && segments.back().output == output)
+		segments.back() = Segment{output, source_pos, new_speed};
+	else
+		segments.push_back(Segment{output, source_pos, new_speed});
+}
+
+void TimeStretchBuffer::ResetSoundTouch(double new_speed) {
+#ifdef WITH_SOUNDTOUCH
+	auto& st = stretcher->st;
+	st.clear();
+	st.setSampleRate(unsigned(source->GetSampleRate()));
+	st.setChannels(unsigned(channels));
+	st.setPitch(1.0f);
+	st.setRate(1.0f);
+	st.setTempo(float(new_speed));
+#else
+	(void)new_speed;
+#endif
+}
+
+void TimeStretchBuffer::ApplySpeed() {
+	const double new_speed = speed.load(std::memory_order_relaxed);
+	if (new_speed == applied_speed) return;
+
+	int64_t output = start_position + written.load(std::memory_order_relaxed);
+	double source_pos = source_position;
+#ifdef WITH_SOUNDTOUCH
+	if (soundtouch_active) {
+		// Whatever SoundTouch has already stretched is played at the old
+		// speed, and whatever it hasn't got to yet at the new one
+		auto& st = stretcher->st;
+		output += st.numSamples();
+		source_pos -= st.numUnprocessedSamples();
+		st.setTempo(float(new_speed));
+	}
+	else if (keep_pitch) {
+		// Up to now the audio has been copied straight through, so there's
+		// nothing buffered and SoundTouch can start from here
+		ResetSoundTouch(new_speed);
+		soundtouch_active = true;
+	}
+#endif
+	applied_speed = new_speed;
+	AddSegment(output, source_pos, new_speed);
+}
+
+int64_t TimeStretchBuffer::Resample(float *dst, int64_t count) {
+	const double step = applied_speed;
+	count = std::min<int64_t>(count, int64_t(std::ceil((source_end - source_position) / step)));
+	if (count <= 0) {
+		finished = true;
+		return 0;
+	}
+
+	// Linearly interpolate between the source frames either side of each
+	// output frame's position
+	const int64_t first = int64_t(std::floor(source_position));
+	const int64_t last = int64_t(std::floor(source_position + (count - 1) * step)) + 1;
+	ReadSource(first, last - first + 1);
+
+	for (int64_t i = 0; i < count; ++i) {
+		const double pos = source_position + i * step;
+		const double base = std::floor(pos);
+		const float frac = float(pos - base);
+		const float *src = &float_buffer[(int64_t(base) - first) * channels];
+		for (int ch = 0; ch < channels; ++ch)
+			*dst++ = src[ch] + (src[ch + channels] - src[ch]) * frac;
+	}
+
+	source_position += count * step;
+	return count;
+}
+
+int64_t TimeStretchBuffer::StretchSoundTouch(float *dst, int64_t count) {
+#ifdef WITH_SOUNDTOUCH
+	auto& st = stretcher->st;
+	while (true) {
+		if (st.numSamples() > 0)
+			return st.receiveSamples(dst, unsigned(count));
+
+		if (source_position < source_end) {
+			const int64_t start = int64_t(source_position);
+			const int64_t frames = std::min(source_chunk, source_end - start);
+			ReadSource(start, frames);
+			st.putSamples(float_buffer.data(), unsigned(frames));
+			source_position += frames;
+		}
+		else if (!flushed) {
+			st.flush();
+			flushed = true;
+		}
+		else {
+			finished = true;
+			return 0;
+		}
+	}
+#else
+	(void)dst;
+	(void)count;
+	finished = true;
+	return 0;
+#endif
+}
+
+int64_t TimeStretchBuffer::StretchChunk(int64_t count) {
+	// Nothing more is written after a seek until the reader has reset its
+	// own position to match
+	if (finished || reader_generation.load(std::memory_order_acquire) != generation.load(std::memory_order_relaxed))
+		return 0;
+
+	const int64_t write_pos = written.load(std::memory_order_relaxed);
+	const int64_t buffered = write_pos - read.load(std::memory_order_acquire);
+
+	float *dst;
+	if (buffered < 0) {
+		// The reader has already played silence in place of these frames,
+		// so they're stretched and thrown away to keep the positions right
+		count = std::min(count, -buffered);
+		discard_buffer.resize(count * channels);
+		dst = discard_buffer.data();
+	}
+	else {
+		// Don't wrap within a single chunk
+		const int64_t offset = write_pos & (capacity - 1);
+		count = std::min({count, lead - buffered, capacity - offset});
+		dst = ring.get() + offset * channels;
+	}
+	if (count <= 0) return 0;
+
+	ApplySpeed();
+	const int64_t got = soundtouch_active ? StretchSoundTouch(dst, count) : Resample(dst, count);
+	written.store(write_pos + got, std::memory_order_release);
+	return got;
+}
+
+void TimeStretchBuffer::Restart(int64_t output) {
+	const double source_pos = GetSourcePosition(output);
+
+	start_position = output;
+	written = 0;
+	source_position = source_pos;
+	finished = false;
+	flushed = false;
+	if (soundtouch_active)
+		ResetSoundTouch(applied_speed);
+
+	{
+		// Positions before the seek may still be asked about while the
+		// audio already sent to the device plays out
+		std::lock_guard<std::mutex> lock(segments_mutex);
+		auto it = std::lower_bound(segments.begin(), segments.end(), output,
+			[](Segment const& segment, int64_t pos) { return segment.output < pos; });
+		segments.erase(it, segments.end());
+		segments.push_back(Segment{output, source_pos, applied_speed});
+	}
+
+	seek_done.store(output, std::memory_order_relaxed);
+	generation.fetch_add(1, std::memory_order_release);
+}
+
+void TimeStretchBuffer::Work() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!closing) {
+		const int64_t seek = seek_request.exchange(-1);
+		if (seek >= 0 && active)
+			Restart(seek);
+
+		if (!active || StretchChunk(chunk) == 0) {
+			cond.wait_for(lock, poll_interval);
+			continue;
+		}
+
+		// Give Start() and Stop() a chance to get in between chunks
+		lock.unlock();
+		std::this_thread::yield();
+		lock.lock();
+	}
+}
+
+void TimeStretchBuffer::Start(int64_t output, int64_t start, int64_t end, double new_speed, bool new_keep_pitch) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		start_position = output;
+		source_position = double(start);
+		written = 0;
+		read = 0;
+		finished = false;
+		flushed = false;
+		speed = new_speed;
+		applied_speed = new_speed;
+
+		// The reader isn't running, so its side of any seek can be reset here
+		seek_request = -1;
+		pending_seek = -1;
+		seek_silence = 0;
+		reader_generation = generation.load();
+
+#ifdef WITH_SOUNDTOUCH
+		keep_pitch = new_keep_pitch;
+#else
+		(void)new_keep_pitch;
+		keep_pitch = false;
+#endif
+		soundtouch_active = keep_pitch && new_speed != 1.0;
+		if (soundtouch_active)
+			ResetSoundTouch(new_speed);
+
+		{
+			std::lock_guard<std::mutex> segments_lock(segments_mutex);
+			source_end = end;
+			segments.assign(1, Segment{output, double(start), new_speed});
+		}
+
+		active = true;
+		while (StretchChunk(lead) > 0) ;
+	}
+	cond.notify_all();
+}
+
+void TimeStretchBuffer::Stop() {
+	std::lock_guard<std::mutex> lock(mutex);
+	active = false;
+	written = 0;
+	read = 0;
+	seek_request = -1;
+	pending_seek = -1;
+	seek_silence = 0;
+	reader_generation = generation.load();
+}
+
+void TimeStretchBuffer::SetSpeed(double new_speed) {
+	speed = new_speed;
+	cond.notify_all();
+}
+
+void TimeStretchBuffer::Seek(int64_t output) {
+	pending_seek = output;
+	seek_silence = 0;
+	seek_request.store(output, std::memory_order_relaxed);
+}
+
+int64_t TimeStretchBuffer::Read(float *buf, int64_t frames) {
+	if (pending_seek >= 0) {
+		// Wait for the stretcher to carry out the seek, then take up from
+		// however far the silence played in the meantime has got
+		const uint32_t gen = generation.load(std::memory_order_acquire);
+		if (gen == reader_generation.load(std::memory_order_relaxed) || seek_done.load(std::memory_order_relaxed) != pending_seek) {
+			seek_silence += frames;
+			return 0;
+		}
+		read.store(seek_silence, std::memory_order_relaxed);
+		reader_generation.store(gen, std::memory_order_release);
+		pending_seek = -1;
+	}
+
+	const int64_t read_pos = read.load(std::memory_order_relaxed);
+	const int64_t available = written.load(std::memory_order_acquire) - read_pos;
+	const int64_t count = std::max<int64_t>(std::min(available, frames), 0);
+
+	// Copy in up to two pieces if the range wraps around the end of the ring
+	const int64_t offset = read_pos & (capacity - 1);
+	const int64_t first = std::min(count, capacity - offset);
+	memcpy(buf, ring.get() + offset * channels, first * channels * sizeof(float));
+	if (count > first)
+		memcpy(buf + first * channels, ring.get(), (count - first) * channels * sizeof(float));
+
+	// Anything not copied is played as silence, either because the end has
+	// been reached or because the stretcher has fallen behind, and the
+	// position moves on past it just the same
+	read.store(read_pos + frames, std::memory_order_release);
+	return count;
+}
+
+int64_t TimeStretchBuffer::GetReadPosition() const {
+	if (pending_seek >= 0)
+		return pending_seek + seek_silence;
+	return start_position + read;
+}
+
+int64_t TimeStretchBuffer::GetAvailable() const {
+	if (pending_seek >= 0)
+		return 0;
+	return std::max<int64_t>(written.load(std::memory_order_acquire) - read.load(std::memory_order_relaxed), 0);
+}
+
+double TimeStretchBuffer::GetSourcePosition(int64_t output) const {
+	std::lock_guard<std::mutex> lock(segments_mutex);
+	if (segments.empty()) return 0;
+
+	auto it = std::upper_bound(segments.begin(), segments.end(), output,
+		[](int64_t pos, Segment const& segment) { return pos < segment.output; });
+	if (it != segments.begin()) --it;
+	// SoundTouch pads the end with silence, which shouldn't move the position
+	return std::min(it->source + (output - it->output) * it->speed, double(source_end));
+}
+
+int64_t TimeStretchBuffer::GetOutputEnd() const {
+	std::lock_guard<std::mutex> lock(segments_mutex);
+	if (segments.empty()) return 0;
+	auto const& last = segments.back();
+	return last.output + int64_t(std::ceil((source_end - last.source) / last.speed));
+}
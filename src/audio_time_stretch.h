@@ -0,0 +1,224 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file audio_time_stretch.h
+/// @brief Time-stretching audio ahead of playback on a background thread
+/// @ingroup audio_output
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace agi { class AudioProvider; }
+
+/// @class TimeStretchBuffer
+/// @brief Audio played at a different speed, stretched ahead of playback
+///
+/// A background thread reads the source, changes its speed and writes the
+/// result to a single-producer single-consumer ring of interleaved float
+/// frames, staying up to the lead time ahead of the reader. Stretching is
+/// done with SoundTouch when the pitch is to be kept and it's available, and
+/// otherwise by resampling, which changes the pitch along with the speed.
+///
+/// The speed can be changed at any time, and the new speed is used for the
+/// next chunk stretched, so it's heard once the audio already in the ring
+/// has been played. Each change is recorded along with the output frame it
+/// takes effect at, after allowing for whatever the stretcher has buffered,
+/// so that output positions can be mapped back to source positions
+/// accurately however the speed has changed. At 1.0x the audio is copied
+/// straight through, and SoundTouch is only brought in once the speed first
+/// moves away from that.
+///
+/// Read(), Seek() and GetReadPosition() are meant to be called from the
+/// player and never block or take the stretcher's lock. If the stretcher
+/// falls behind, the reader plays silence and carries on, and the stretcher
+/// stretches and throws away the audio the silence stood in for, so that
+/// output positions still map to the right source positions. Start() and
+/// Stop() must not be called at the same time as Read().
+class TimeStretchBuffer {
+	agi::AudioProvider *source;
+	const int channels;
+	/// Number of output frames to stretch ahead of the reader
+	const int64_t lead;
+	/// Size of the ring in frames, which is a power of two
+	const int64_t capacity;
+	/// Most output frames to produce at a time
+	const int64_t chunk;
+	std::unique_ptr<float[]> ring;
+
+	/// Frames written and read since Start(); only the stretcher writes the
+	/// former and only the reader writes the latter. Read runs ahead of
+	/// written when the reader has played silence in place of audio which
+	/// wasn't ready yet.
+	std::atomic<int64_t> written{0};
+	std::atomic<int64_t> read{0};
+
+	/// Output position of the first frame after Start() or the last seek
+	std::atomic<int64_t> start_position{0};
+	std::atomic<bool> active{false};
+	/// Everything up to source_end has been stretched
+	std::atomic<bool> finished{false};
+
+	/// Output position the reader has asked to seek to, or -1
+	std::atomic<int64_t> seek_request{-1};
+	/// Output position of the seek the stretcher last carried out
+	std::atomic<int64_t> seek_done{-1};
+	/// Bumped by the stretcher each time it carries out a seek. The
+	/// stretcher doesn't write anything more until the reader has caught up
+	/// with it, as only the reader can reset read.
+	std::atomic<uint32_t> generation{0};
+	std::atomic<uint32_t> reader_generation{0};
+
+	/// Reader-side state of a seek the stretcher hasn't carried out yet: the
+	/// position asked for, or -1, and the frames of silence played since
+	int64_t pending_seek = -1;
+	int64_t seek_silence = 0;
+
+	/// Speed requested by SetSpeed() which the stretcher hasn't picked up yet
+	std::atomic<double> speed{1.0};
+
+	/// A change of speed, and where in the output and source it happened
+	struct Segment {
+		int64_t output;
+		double source;
+		double speed;
+	};
+	/// Speed changes since Start(), in order
+	std::vector<Segment> segments;
+	mutable std::mutex segments_mutex;
+
+	/// Held while stretching and while changing what's being stretched
+	std::mutex mutex;
+	/// Wakes the stretcher
+	std::condition_variable cond;
+	/// Source frame to stop at
+	int64_t source_end = 0;
+	/// Next source frame to hand to the stretcher, or to resample from
+	double source_position = 0;
+	/// Speed the stretcher is currently using
+	double applied_speed = 1.0;
+	bool closing = false;
+
+	/// SoundTouch's state, when it's available
+	struct Stretcher;
+	std::unique_ptr<Stretcher> stretcher;
+	/// Keep the pitch for the current playback, if SoundTouch is available
+	bool keep_pitch = false;
+	/// SoundTouch is in use rather than resampling, which is the case once
+	/// the pitch is to be kept and the speed isn't 1.0x
+	bool soundtouch_active = false;
+	/// The source has all been given to the stretcher
+	bool flushed = false;
+
+	std::vector<float> float_buffer;
+	std::vector<int16_t> int_buffer;
+	/// Where audio the reader has already played silence for is stretched to
+	std::vector<float> discard_buffer;
+
+	std::thread thread;
+
+	/// Read source frames as interleaved floats into float_buffer
+	void ReadSource(int64_t start, int64_t count);
+
+	/// Record a change of speed which takes effect at the given output frame
+	void AddSegment(int64_t output, double source, double speed);
+
+	/// Clear SoundTouch and set it up for the source at a speed; mutex must be held
+	void ResetSoundTouch(double speed);
+
+	/// Pick up a speed change from SetSpeed(); mutex must be held
+	void ApplySpeed();
+
+	/// Carry out a seek asked for by the reader; mutex must be held
+	void Restart(int64_t output);
+
+	/// Stretch up to count frames into the ring; mutex must be held
+	/// @return Number of frames written
+	int64_t Resample(float *dst, int64_t count);
+	int64_t StretchSoundTouch(float *dst, int64_t count);
+
+	/// Stretch the next chunk into the ring; mutex must be held
+	/// @return Number of frames written
+	int64_t StretchChunk(int64_t count);
+
+	void Work();
+
+public:
+	/// @param source  Audio to stretch, in either 16-bit or float samples
+	/// @param lead_ms How far ahead of playback to stretch, in milliseconds
+	TimeStretchBuffer(agi::AudioProvider *source, int lead_ms);
+	~TimeStretchBuffer();
+
+	/// @brief Start stretching, discarding anything already buffered
+	/// @param output     Output position of the first frame to be read
+	/// @param start      First source frame to play
+	/// @param end        Source frame to stop at
+	/// @param speed      Playback speed, where 2 is twice as fast
+	/// @param keep_pitch Keep the pitch of the audio the same, if SoundTouch is available
+	///
+	/// The first lead-time's worth of audio is stretched before returning.
+	void Start(int64_t output, int64_t start, int64_t end, double speed, bool keep_pitch);
+
+	/// Stop stretching and discard anything buffered
+	void Stop();
+
+	/// Change the speed of the audio stretched from now on
+	void SetSpeed(double new_speed);
+
+	/// @brief Copy stretched audio out of the buffer
+	/// @param buf    Buffer for frames of interleaved float samples
+	/// @param frames Number of frames to copy
+	/// @return Number of frames copied
+	///
+	/// Whatever isn't copied is to be played as silence, and the read
+	/// position moves on past it all the same.
+	int64_t Read(float *buf, int64_t frames);
+
+	/// @brief Continue from a different output position without stopping
+	/// @param output Output position to read from next
+	///
+	/// The stretcher carries out the seek on its own thread, and reads play
+	/// silence until it has.
+	void Seek(int64_t output);
+
+	/// Output position of the next frame Read() will return; call from the
+	/// reading thread
+	int64_t GetReadPosition() const;
+
+	/// Number of frames Read() can copy without running out; call from the
+	/// reading thread
+	int64_t GetAvailable() const;
+
+	/// Has everything up to the end of the range been stretched?
+	bool IsFinished() const { return finished; }
+
+	/// @brief Map an output position to the source position played there
+	/// @param output Output position, as passed to Start() and counted from there
+	/// @return Source position, in frames
+	double GetSourcePosition(int64_t output) const;
+
+	/// @brief Estimate the output position the end of the source is played at
+	///
+	/// The estimate uses the latest speed the stretcher has picked up, so it
+	/// changes after a speed change is applied.
+	int64_t GetOutputEnd() const;
+};
@@ -36,10 +36,12 @@
 #include "include/aegisub/context.h"
 #include "options.h"
 #include "pen.h"
+#include "project.h"
 #include "selection_controller.h"
 #include "utils.h"
 
 #include <libaegisub/ass/time.h>
+#include <libaegisub/audio/speech_envelope.h>
 #include <libaegisub/make_unique.h>
 
 #include <boost/range/algorithm.hpp>
@@ -332,6 +334,7 @@ class AudioTimingControllerDialogue final : public AudioTimingController {
 	const agi::OptionValue *inactive_line_mode = OPT_GET("Audio/Inactive Lines Display Mode");
 	const agi::OptionValue *inactive_line_comments = OPT_GET("Audio/Display/Draw/Inactive Comments");
 	const agi::OptionValue *drag_timing = OPT_GET("Audio/Drag Timing");
+	const agi::OptionValue *snap_speech = OPT_GET("Audio/Snap/Speech Boundaries");
 
 	agi::signal::Connection commit_connection;
 	agi::signal::Connection audio_open_connection;
@@ -886,6 +889,9 @@ int AudioTimingControllerDialogue::SnapMarkers(int snap_range, std::vector<Audio
 			snap_distance = dist;
 	};
 
+	// Start markers snap to where speech starts and end markers to where it stops
+	const agi::SpeechEnvelope *envelope = snap_speech->GetBool() ? context->project->SpeechEnvelope() : nullptr;
+
 	int prev = -1;
 	AudioMarkerVector snap_markers;
 	for (const auto active_marker : active)
@@ -904,6 +910,16 @@ int AudioTimingControllerDialogue::SnapMarkers(int snap_range, std::vector<Audio
 			if (snap_distance == 0) return 0;
 		}
 
+		if (envelope)
+		{
+			int boundary = active_marker->GetFeet() == AudioMarker::Feet_Right
+				? envelope->NearestOnset(pos, snap_range)
+				: envelope->NearestOffset(pos, snap_range);
+			if (boundary >= 0)
+				check(boundary, pos);
+			if (snap_distance == 0) return 0;
+		}
+
 		for (auto it = boost::lower_bound(inactive_markers, range.begin()); it != end(inactive_markers); ++it)
 		{
 			check(*it, pos);
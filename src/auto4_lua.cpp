@@ -55,6 +55,7 @@
 #include "video_frame.h"
 #include "utils.h"
 
+#include <libaegisub/audio/speech_envelope.h>
 #include <libaegisub/dispatch.h>
 #include <libaegisub/format.h>
 #include <libaegisub/lua/ffi.h>
@@ -393,6 +394,23 @@ namespace {
 		return 2;
 	}
 
+	template<int (agi::SpeechEnvelope::*nearest)(int, int) const>
+	int lua_speech_boundary(lua_State *L)
+	{
+		const agi::Context *c = get_context(L);
+		int ms = check_int(L, 1);
+		int range = check_int(L, 2);
+		lua_pop(L, 2);
+		int boundary = -1;
+		if (c && c->project->SpeechEnvelope())
+			boundary = (c->project->SpeechEnvelope()->*nearest)(ms, range);
+		if (boundary >= 0)
+			push_value(L, boundary);
+		else
+			lua_pushnil(L);
+		return 1;
+	}
+
 	int lua_set_status_text(lua_State *L)
 	{
 		const agi::Context *c = get_context(L);
@@ -648,6 +666,8 @@ namespace {
 		set_field<get_translation>(L, "gettext");
 		set_field<project_properties>(L, "project_properties");
 		set_field<lua_get_audio_selection>(L, "get_audio_selection");
+		set_field<lua_speech_boundary<&agi::SpeechEnvelope::NearestOnset>>(L, "speech_onset");
+		set_field<lua_speech_boundary<&agi::SpeechEnvelope::NearestOffset>>(L, "speech_offset");
 		set_field<lua_set_status_text>(L, "set_status_text");
 		set_field<get_frame>(L, "get_frame");
 		lua_createtable(L, 0, 5);
@@ -261,9 +261,10 @@ void BaseGrid::OnSeek() {
 	int lines = GetClientSize().GetHeight() / lineHeight + 1;
 	lines = mid(0, lines, GetVisRows() - yPos);
 
+	auto displayed = DisplayedLines();
 	auto it = begin(visible_rows);
 	for (int i : boost::irange(yPos, yPos + lines)) {
-		if (IsDisplayed(vis_index_line_map[i])) {
+		if (displayed.count(vis_index_line_map[i])) {
 			if (it == end(visible_rows) || *it != i) {
 				Refresh(false);
 				return;
@@ -358,6 +359,11 @@ void BaseGrid::OnPaint(wxPaintEvent &) {
 	auto const& selection = context->selectionController->GetSelectedSet();
 	visible_rows.clear();
 
+	std::unordered_set<const AssDialogue *> displayed;
+	if (OPT_GET("Subtitle/Grid/Highlight Subtitles in Frame")->GetBool())
+		displayed = DisplayedLines();
+	const auto colliding = CollidingLines(active_line);
+
 	for (int i : agi::util::range(nDraw)) {
 		wxBrush color = row_colors.Default;
 		AssDialogue *curDiag = vis_index_line_map[i + yPos];
@@ -370,7 +376,7 @@ void BaseGrid::OnPaint(wxPaintEvent &) {
 		else if (curDiag->Comment)
 			color = row_colors.Comment;
 
-		if (OPT_GET("Subtitle/Grid/Highlight Subtitles in Frame")->GetBool() && IsDisplayed(curDiag)) {
+		if (displayed.count(curDiag)) {
 			if (color == row_colors.Default)
 				color = row_colors.Visible;
 			visible_rows.push_back(i + yPos);
@@ -388,7 +394,7 @@ void BaseGrid::OnPaint(wxPaintEvent &) {
 			dc.DrawRectangle(grid_x, (i + 1) * lineHeight + 1, w, lineHeight);
 		}
 
-		if (active_line != curDiag && curDiag->CollidesWith(active_line))
+		if (colliding.count(curDiag))
 			dc.SetTextForeground(text_collision);
 		else if (inSel)
 			dc.SetTextForeground(text_selection);
@@ -670,6 +676,36 @@ bool BaseGrid::IsDisplayed(const AssDialogue *line) const {
 		&& context->project->Timecodes().FrameAtTime(line->End, agi::vfr::END) >= frame;
 }
 
+std::unordered_set<const AssDialogue *> BaseGrid::DisplayedLines() const {
+	std::unordered_set<const AssDialogue *> displayed;
+	if (!context->project->VideoProvider()) return displayed;
+
+	// Look up the lines around the frame in the time index, then apply the
+	// exact rules for which frames a line is on to those
+	auto const& tc = context->project->Timecodes();
+	int frame = context->videoController->GetFrameN();
+	int start = tc.TimeAtFrame(std::max(frame - 1, 0));
+	int end = tc.TimeAtFrame(frame + 2);
+	for (auto line : context->ass->TimeIndex().Overlapping(start, end)) {
+		if (IsDisplayed(line))
+			displayed.insert(line);
+	}
+	return displayed;
+}
+
+std::unordered_set<const AssDialogue *> BaseGrid::CollidingLines(const AssDialogue *line) const {
+	std::unordered_set<const AssDialogue *> colliding;
+	if (!line) return colliding;
+
+	// Widened by a millisecond so that zero-length lines starting where the
+	// line starts are included
+	for (auto other : context->ass->TimeIndex().Overlapping(line->Start - 1, line->End)) {
+		if (other != line && other->CollidesWith(line))
+			colliding.insert(other);
+	}
+	return colliding;
+}
+
 void BaseGrid::OnCharHook(wxKeyEvent &event) {
 	if (hotkey::check("Subtitle Grid", context, event))
 		return;
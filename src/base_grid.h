@@ -31,6 +31,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 #include <wx/window.h>
 
@@ -112,6 +113,10 @@ class BaseGrid final : public wxWindow {
 	void SetColumnWidths();
 
 	bool IsDisplayed(const AssDialogue *line) const;
+	/// Get the lines which are displayed on the current video frame
+	std::unordered_set<const AssDialogue *> DisplayedLines() const;
+	/// Get the lines other than line which overlap it in time
+	std::unordered_set<const AssDialogue *> CollidingLines(const AssDialogue *line) const;
 
 	void UpdateMaps();
 	void UpdateStyle();
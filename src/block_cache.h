@@ -94,6 +94,32 @@ class DataBlockCache {
 		age.erase(mb.position);
 	}
 
+	/// @brief Mark a block's macroblock as most recently used
+	/// @param i Index of the block
+	/// @return The slot for the block, which may be empty
+	typename BlockFactoryT::BlockType& Touch(size_t i)
+	{
+		size_t mbi = i >> MacroblockExponent;
+		assert(mbi < data.size());
+
+		auto &mb = data[mbi];
+
+		// Move this macroblock to the front of the age list
+		if (mb.blocks.empty())
+		{
+			mb.blocks.resize(macroblock_size);
+			age.push_front(&mb);
+		}
+		else if (mb.position != begin(age))
+			age.splice(begin(age), age, mb.position);
+
+		mb.position = age.begin();
+
+		size_t block_index = i & macroblock_index_mask;
+		assert(block_index < mb.blocks.size());
+		return mb.blocks[block_index];
+	}
+
 public:
 	/// @brief Constructor
 	/// @param block_count Total number of blocks the cache will manage
@@ -162,31 +188,13 @@ public:
 	/// It is legal to pass 0 (null) for created, in this case nothing is returned in it.
 	BlockT& Get(size_t i, bool *created = nullptr)
 	{
-		size_t mbi = i >> MacroblockExponent;
-		assert(mbi < data.size());
-
-		auto &mb = data[mbi];
-
-		// Move this macroblock to the front of the age list
-		if (mb.blocks.empty())
-		{
-			mb.blocks.resize(macroblock_size);
-			age.push_front(&mb);
-		}
-		else if (mb.position != begin(age))
-			age.splice(begin(age), age, mb.position);
-
-		mb.position = age.begin();
-
-		size_t block_index = i & macroblock_index_mask;
-		assert(block_index < mb.blocks.size());
-
-		BlockT *b = mb.blocks[block_index].get();
+		auto& slot = Touch(i);
+		BlockT *b = slot.get();
 
 		if (!b)
 		{
-			mb.blocks[block_index] = factory.ProduceBlock(i);
-			b = mb.blocks[block_index].get();
+			slot = factory.ProduceBlock(i);
+			b = slot.get();
 			assert(b != nullptr);
 			size += factory.GetBlockSize();
 
@@ -197,4 +205,43 @@ public:
 
 		return *b;
 	}
+
+	/// @brief Obtain a data block only if it is already in the cache
+	/// @param i Index of the block to retrieve
+	/// @return The block, or nullptr if it has not been produced
+	BlockT *TryGet(size_t i)
+	{
+		assert((i >> MacroblockExponent) < data.size());
+		auto& mb = data[i >> MacroblockExponent];
+		if (mb.blocks.empty() || !mb.blocks[i & macroblock_index_mask])
+			return nullptr;
+		return Touch(i).get();
+	}
+
+	/// @brief Store a block which was produced outside of the cache
+	/// @param i     Index of the block
+	/// @param block The block to store, replacing any existing one
+	void Insert(size_t i, typename BlockFactoryT::BlockType block)
+	{
+		assert(block);
+		auto& slot = Touch(i);
+		if (!slot)
+			size += factory.GetBlockSize();
+		slot = std::move(block);
+	}
+
+	/// @brief Discard a single block so that it is produced again when next requested
+	/// @param i Index of the block
+	void Remove(size_t i)
+	{
+		size_t mbi = i >> MacroblockExponent;
+		assert(mbi < data.size());
+
+		auto& blocks = data[mbi].blocks;
+		if (blocks.empty() || !blocks[i & macroblock_index_mask])
+			return;
+
+		blocks[i & macroblock_index_mask].reset();
+		size -= factory.GetBlockSize();
+	}
 };
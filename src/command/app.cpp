@@ -187,6 +187,18 @@ struct app_log final : public Command {
 	}
 };
 
+struct app_playback_stats final : public Command {
+	CMD_NAME("app/playback_stats")
+	CMD_ICON(about_menu)
+	STR_MENU("&Playback statistics")
+	STR_DISP("Playback statistics")
+	STR_HELP("View how well audio playback is keeping up")
+
+	void operator()(agi::Context *c) override {
+		ShowPlaybackStatsWindow(c);
+	}
+};
+
 struct app_new_window final : public Command {
 	CMD_NAME("app/new_window")
 	CMD_ICON(new_window_menu)
@@ -312,6 +324,7 @@ namespace cmd {
 		reg(agi::make_unique<app_exit>());
 		reg(agi::make_unique<app_language>());
 		reg(agi::make_unique<app_log>());
+		reg(agi::make_unique<app_playback_stats>());
 		reg(agi::make_unique<app_new_window>());
 		reg(agi::make_unique<app_options>());
 		reg(agi::make_unique<app_toggle_global_hotkeys>());
@@ -0,0 +1,154 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file dialog_playback_stats.cpp
+/// @brief Live view of the audio and video playback counters
+/// @ingroup secondary_ui
+
+#include "audio_controller.h"
+#include "dialog_manager.h"
+#include "format.h"
+#include "include/aegisub/context.h"
+#include "video_controller.h"
+
+#include <libaegisub/audio/playback_stats.h>
+
+#include <wx/button.h>
+#include <wx/dialog.h>
+#include <wx/sizer.h>
+#include <wx/stattext.h>
+#include <wx/timer.h>
+
+namespace {
+class PlaybackStatsWindow final : public wxDialog {
+	agi::Context *c;
+	wxTimer timer;
+
+	wxStaticText *player_reads;
+	wxStaticText *underruns;
+	wxStaticText *device_underruns;
+	wxStaticText *fill;
+	wxStaticText *latency;
+	wxStaticText *drift;
+	wxStaticText *provider_reads;
+	wxStaticText *read_time[agi::PlaybackStats::ReadTimeBuckets];
+	wxStaticText *video_frames;
+	wxStaticText *video_dropped;
+	wxStaticText *video_prefetch;
+
+	void Update();
+
+public:
+	PlaybackStatsWindow(agi::Context *c);
+};
+
+PlaybackStatsWindow::PlaybackStatsWindow(agi::Context *c)
+: wxDialog(c->parent, -1, _("Playback statistics"), wxDefaultPosition, wxDefaultSize, wxCAPTION | wxCLOSE_BOX)
+, c(c)
+, timer(this)
+{
+	auto make_grid = [&](wxString const& title) {
+		auto box = new wxStaticBoxSizer(wxVERTICAL, this, title);
+		auto grid = new wxFlexGridSizer(2, 2, 12);
+		box->Add(grid, wxSizerFlags(1).Expand().Border());
+		return std::make_pair(box, grid);
+	};
+	auto make_field = [&](wxFlexGridSizer *grid, wxString const& name) {
+		grid->Add(new wxStaticText(this, -1, name));
+		auto value = new wxStaticText(this, -1, "", wxDefaultPosition, wxSize(160, -1));
+		grid->Add(value);
+		return value;
+	};
+
+	auto playback = make_grid(_("Playback"));
+	player_reads = make_field(playback.second, _("Buffer reads:"));
+	underruns = make_field(playback.second, _("Buffer underruns:"));
+	device_underruns = make_field(playback.second, _("Device underruns:"));
+	fill = make_field(playback.second, _("Buffered (min / avg):"));
+	latency = make_field(playback.second, _("Output latency (now / max):"));
+	drift = make_field(playback.second, _("Video drift (now / max):"));
+
+	auto video = make_grid(_("Video"));
+	video_frames = make_field(video.second, _("Frames shown:"));
+	video_dropped = make_field(video.second, _("Frames dropped:"));
+	video_prefetch = make_field(video.second, _("Decoded ahead (hits / misses):"));
+
+	auto reads = make_grid(_("Provider read times"));
+	provider_reads = make_field(reads.second, _("Reads:"));
+	for (int i = 0; i < agi::PlaybackStats::ReadTimeBuckets; ++i) {
+		read_time[i] = make_field(reads.second, i < agi::PlaybackStats::ReadTimeBuckets - 1
+			? fmt_wx(_("Under %.1f ms:"), agi::PlaybackStats::ReadTimeLimit(i) / 1000.)
+			: fmt_wx(_("%.1f ms or more:"), agi::PlaybackStats::ReadTimeLimit(i - 1) / 1000.));
+	}
+
+	auto reset = new wxButton(this, -1, _("&Reset"));
+	reset->Bind(wxEVT_BUTTON, [=](wxCommandEvent&) {
+		if (auto stats = c->audioController->GetPlaybackStats())
+			stats->Reset();
+		Update();
+	});
+
+	auto buttons = new wxBoxSizer(wxHORIZONTAL);
+	buttons->Add(reset, wxSizerFlags(0).Border());
+	buttons->AddStretchSpacer();
+	buttons->Add(new wxButton(this, wxID_OK), wxSizerFlags(0).Border());
+
+	auto left = new wxBoxSizer(wxVERTICAL);
+	left->Add(playback.first, wxSizerFlags(0).Expand().Border(wxBOTTOM));
+	left->Add(video.first, wxSizerFlags(0).Expand());
+
+	auto columns = new wxBoxSizer(wxHORIZONTAL);
+	columns->Add(left, wxSizerFlags(0).Expand().Border(wxRIGHT));
+	columns->Add(reads.first, wxSizerFlags(0).Expand());
+
+	auto sizer = new wxBoxSizer(wxVERTICAL);
+	sizer->Add(columns, wxSizerFlags(1).Expand().Border());
+	sizer->Add(buttons, wxSizerFlags(0).Expand());
+	SetSizerAndFit(sizer);
+
+	Bind(wxEVT_TIMER, [=](wxTimerEvent&) { Update(); });
+	Update();
+	timer.Start(250);
+}
+
+void PlaybackStatsWindow::Update() {
+	auto stats = c->audioController->GetPlaybackStats();
+	auto s = stats ? stats->Get() : agi::PlaybackStats::Snapshot();
+
+	auto ms = [](int64_t value) -> wxString {
+		return value < 0 ? _("n/a") : fmt_wx(_("%d ms"), value);
+	};
+
+	player_reads->SetLabel(std::to_wstring(s.reads));
+	underruns->SetLabel(std::to_wstring(s.underruns));
+	device_underruns->SetLabel(std::to_wstring(s.device_underruns));
+	fill->SetLabel(s.reads ? ms(s.min_fill_ms) + " / " + ms(s.avg_fill_ms) : _("n/a"));
+	latency->SetLabel(ms(s.latency_ms) + " / " + ms(s.max_latency_ms));
+	drift->SetLabel(s.drift_samples ? fmt_wx(_("%+d ms"), s.drift_ms) + " / " + ms(s.max_drift_ms) : _("n/a"));
+	provider_reads->SetLabel(s.provider_reads ? fmt_wx(_("%d (slowest %.1f ms)"), s.provider_reads, s.max_read_us / 1000.) : _("n/a"));
+	for (int i = 0; i < agi::PlaybackStats::ReadTimeBuckets; ++i)
+		read_time[i]->SetLabel(std::to_wstring(s.read_time[i]));
+
+	auto v = c->videoController->GetPlaybackStats();
+	video_frames->SetLabel(std::to_wstring(v.shown));
+	video_dropped->SetLabel(std::to_wstring(v.dropped));
+	video_prefetch->SetLabel(std::to_wstring(v.prefetch_hits) + L" / " + std::to_wstring(v.prefetch_misses));
+}
+}
+
+void ShowPlaybackStatsWindow(agi::Context *c) {
+	c->dialog->Show<PlaybackStatsWindow>(c);
+}
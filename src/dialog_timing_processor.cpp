@@ -29,6 +29,7 @@
 
 #include "ass_dialogue.h"
 #include "ass_file.h"
+#include "ass_time_index.h"
 #include "async_video_provider.h"
 #include "compat.h"
 #include "format.h"
@@ -42,9 +43,11 @@
 
 #include <libaegisub/address_of_adaptor.h>
 #include <libaegisub/ass/time.h>
+#include <libaegisub/audio/speech_envelope.h>
 
 #include <algorithm>
 #include <boost/range/adaptor/filtered.hpp>
+#include <boost/range/adaptor/indirected.hpp>
 #include <boost/range/algorithm.hpp>
 #include <boost/range/algorithm_ext/push_back.hpp>
 #include <functional>
@@ -78,12 +81,14 @@ struct DialogTimingProcessor {
 	int afterEnd;    ///< Maximum time in milliseconds to move end time of line forwards to land on a keyframe
 	int adjGap;      ///< Maximum gap in milliseconds to snap adjacent lines to each other
 	int adjOverlap;  ///< Maximum overlap in milliseconds to snap adjacent lines to each other
+	int speechDist;  ///< Maximum distance in milliseconds to move a start or end time to a speech boundary
 
 	wxCheckBox *onlySelection; ///< Only process selected lines of the selected styles
 	wxCheckBox *hasLeadIn;     ///< Enable adding lead-in
 	wxCheckBox *hasLeadOut;    ///< Enable adding lead-out
 	wxCheckBox *keysEnable;    ///< Enable snapping to keyframes
 	wxCheckBox *adjsEnable;    ///< Enable snapping adjacent lines to each other
+	wxCheckBox *speechEnable;  ///< Enable snapping to where speech starts and stops
 	wxSlider *adjacentBias;    ///< Bias between shifting start and end times when snapping adjacent lines
 	wxCheckListBox *StyleList; ///< List of styles to process
 	wxButton *ApplyButton;     ///< Button to apply the processing
@@ -152,6 +157,7 @@ DialogTimingProcessor::DialogTimingProcessor(agi::Context *c)
 	afterEnd = OPT_GET("Tool/Timing Post Processor/Threshold/Key End After")->GetInt();
 	adjGap = OPT_GET("Tool/Timing Post Processor/Threshold/Adjacent Gap")->GetInt();
 	adjOverlap = OPT_GET("Tool/Timing Post Processor/Threshold/Adjacent Overlap")->GetInt();
+	speechDist = OPT_GET("Tool/Timing Post Processor/Threshold/Speech")->GetInt();
 
 	// Styles box
 	auto LeftSizer = new wxStaticBoxSizer(wxVERTICAL,&d,_("Apply to styles"));
@@ -170,6 +176,22 @@ DialogTimingProcessor::DialogTimingProcessor(agi::Context *c)
 	onlySelection->SetValue(OPT_GET("Tool/Timing Post Processor/Only Selection")->GetBool());
 	optionsSizer->Add(onlySelection,1,wxALL,0);
 
+	// Speech boundaries box
+	auto SpeechSizer = new wxStaticBoxSizer(wxHORIZONTAL, &d, _("Speech boundary snapping"));
+	speechEnable = make_check(SpeechSizer, _("Ena&ble"),
+		"Tool/Timing Post Processor/Enable/Speech",
+		_("Move start times to the nearest point where speech starts and end times to where it stops, if within the maximum distance. This is done before adding lead-in and lead-out."));
+
+	// Speech boundaries are only available if audio is loaded
+	if (!c->project->SpeechEnvelope()) {
+		speechEnable->SetValue(false);
+		speechEnable->Enable(false);
+	}
+
+	make_ctrl(SpeechSizer, _("Max distance:"), &speechDist, speechEnable,
+		_("Maximum distance to move a start or end time to a speech boundary, in milliseconds"));
+	SpeechSizer->AddStretchSpacer(1);
+
 	// Lead-in/out box
 	auto LeadSizer = new wxStaticBoxSizer(wxHORIZONTAL, &d, _("Lead-in/Lead-out"));
 
@@ -251,6 +273,7 @@ DialogTimingProcessor::DialogTimingProcessor(agi::Context *c)
 	// Right Sizer
 	auto RightSizer = new wxBoxSizer(wxVERTICAL);
 	RightSizer->Add(optionsSizer,0,wxBOTTOM|wxEXPAND,5);
+	RightSizer->Add(SpeechSizer,0,wxBOTTOM|wxEXPAND,5);
 	RightSizer->Add(LeadSizer,0,wxBOTTOM|wxEXPAND,5);
 	RightSizer->Add(AdjacentSizer,0,wxBOTTOM|wxEXPAND,5);
 	RightSizer->Add(KeyframesSizer,0,wxBOTTOM|wxEXPAND,5);
@@ -299,7 +322,7 @@ void DialogTimingProcessor::UpdateControls() {
 	size_t len = StyleList->GetCount();
 	for (size_t i = 0; !any_checked && i < len; ++i)
 		any_checked = StyleList->IsChecked(i);
-	ApplyButton->Enable(any_checked && (hasLeadIn->IsChecked() || hasLeadOut->IsChecked() || keysEnable->IsChecked() || adjsEnable->IsChecked()));
+	ApplyButton->Enable(any_checked && (speechEnable->IsChecked() || hasLeadIn->IsChecked() || hasLeadOut->IsChecked() || keysEnable->IsChecked() || adjsEnable->IsChecked()));
 }
 
 void DialogTimingProcessor::OnApply(wxCommandEvent &) {
@@ -313,9 +336,11 @@ void DialogTimingProcessor::OnApply(wxCommandEvent &) {
 	OPT_SET("Tool/Timing Post Processor/Threshold/Key End After")->SetInt(afterEnd);
 	OPT_SET("Tool/Timing Post Processor/Threshold/Adjacent Gap")->SetInt(adjGap);
 	OPT_SET("Tool/Timing Post Processor/Threshold/Adjacent Overlap")->SetInt(adjOverlap);
+	OPT_SET("Tool/Timing Post Processor/Threshold/Speech")->SetInt(speechDist);
 	OPT_SET("Tool/Timing Post Processor/Adjacent Bias")->SetDouble(adjacentBias->GetValue() / 100.0);
 	OPT_SET("Tool/Timing Post Processor/Enable/Lead/IN")->SetBool(hasLeadIn->IsChecked());
 	OPT_SET("Tool/Timing Post Processor/Enable/Lead/OUT")->SetBool(hasLeadOut->IsChecked());
+	if (speechEnable->IsEnabled()) OPT_SET("Tool/Timing Post Processor/Enable/Speech")->SetBool(speechEnable->IsChecked());
 	if (keysEnable->IsEnabled()) OPT_SET("Tool/Timing Post Processor/Enable/Keyframe")->SetBool(keysEnable->IsChecked());
 	OPT_SET("Tool/Timing Post Processor/Enable/Adjacent")->SetBool(adjsEnable->IsChecked());
 	OPT_SET("Tool/Timing Post Processor/Only Selection")->SetBool(onlySelection->IsChecked());
@@ -368,35 +393,79 @@ static int get_closest_kf(std::vector<int> const& kf, int frame) {
 	return (pos == begin(kf) || *pos - frame < frame - *(pos - 1)) ? *pos : *(pos - 1);
 }
 
-template<class Iter, class Field>
-static int safe_time(Iter begin, Iter end, AssDialogue *comp, int initial, Field field, int const& (*cmp)(int const&, int const&)) {
-	// Compare to every previous line (yay for O(n^2)!) to see if it's OK to add lead-in
-	for (; begin != end; ++begin) {
-		// If the line doesn't already collide with this line, extend it only
-		// to the edge of the line
-		if (!comp->CollidesWith(*begin))
-			initial = cmp(initial, (*begin)->*field);
-	}
-	return initial;
+/// Index lines by time, reporting their positions in the vector
+static AssTimeIndex index_lines(std::vector<AssDialogue*>& lines) {
+	AssTimeIndex index;
+	auto deref = lines | indirected;
+	index.Build(deref);
+	return index;
 }
 
 void DialogTimingProcessor::Process() {
 	std::vector<AssDialogue*> sorted = SortDialogues();
 	if (sorted.empty()) return;
 
-	// Add lead-in/out
+	// Snap to speech boundaries before the lead-in/out is added around them
+	if (speechEnable->IsChecked()) {
+		auto envelope = c->project->SpeechEnvelope();
+		for (AssDialogue *cur : sorted) {
+			int start = envelope->NearestOnset(cur->Start, speechDist);
+			int end = envelope->NearestOffset(cur->End, speechDist);
+			if (start < 0) start = cur->Start;
+			if (end < 0) end = cur->End;
+			// Don't snap a short line to boundaries which would invert it
+			if (start < end) {
+				cur->Start = start;
+				cur->End = end;
+			}
+		}
+
+		// Snapping can move lines past each other
+		boost::stable_sort(sorted, [](const AssDialogue *a, const AssDialogue *b) {
+			return a->Start < b->Start;
+		});
+	}
+
+	// Add lead-in/out. A line can only be extended up to the edge of a line
+	// which it doesn't already collide with, and only lines near it in time
+	// can be that edge, so they're found with an index rather than by
+	// comparing every pair of lines.
+	//
+	// Later lines never end before where a line started before the lead-in
+	// was added, which bounds the search for lines limiting its lead-out.
+	std::vector<int> sorted_start;
+	for (auto line : sorted)
+		sorted_start.push_back(line->Start);
+
 	if (hasLeadIn->IsChecked() && leadIn) {
-		for (size_t i = 0; i < sorted.size(); ++i)
-			sorted[i]->Start = safe_time(sorted.rend() - i, sorted.rend(),
-				sorted[i], sorted[i]->Start - leadIn,
-				&AssDialogue::End, &std::max<int>);
+		auto index = index_lines(sorted);
+		for (size_t i = 0; i < sorted.size(); ++i) {
+			AssDialogue *cur = sorted[i];
+			// Only earlier lines which end within the lead-in can limit it
+			int start = cur->Start - leadIn;
+			for (size_t j : index.Positions(start, cur->Start + 1)) {
+				if (j >= i) break;
+				if (!cur->CollidesWith(sorted[j]))
+					start = std::max<int>(start, sorted[j]->End);
+			}
+			cur->Start = start;
+		}
 	}
 
 	if (hasLeadOut->IsChecked() && leadOut) {
-		for (size_t i = 0; i < sorted.size(); ++i)
-			sorted[i]->End = safe_time(sorted.begin() + i + 1, sorted.end(),
-				sorted[i], sorted[i]->End + leadOut,
-				&AssDialogue::Start, &std::min<int>);
+		// Rebuilt since the lead-in changed the start times
+		auto index = index_lines(sorted);
+		for (size_t i = 0; i < sorted.size(); ++i) {
+			AssDialogue *cur = sorted[i];
+			// Only later lines which start within the lead-out can limit it
+			int end = cur->End + leadOut;
+			for (size_t j : index.Positions(sorted_start[i] - 1, end)) {
+				if (j <= i) continue;
+				if (!cur->CollidesWith(sorted[j]))
+					end = std::min<int>(end, sorted[j]->Start);
+			}
+			cur->End = end;
+		}
 	}
 
 	// Make adjacent
@@ -30,142 +30,162 @@
 /// @file fft.cpp
 /// @brief Fast Fourier-transform implementation
 /// @ingroup utility
-///
-/// Most of this code was taken from http://www.codeproject.com/audio/waveInFFT.asp
-/// And rewriten by Rodrigo Braz Monteiro
 
 #include "fft.h"
 
-#ifndef WITH_FFTW3
 #include <libaegisub/exception.h>
 
 #include <cmath>
 
-void FFT::DoTransform (size_t n_samples,float *input,float *output_r,float *output_i,bool inverse) {
-	if (!IsPowerOfTwo(n_samples))
-		throw agi::InternalError("FFT requires power of two input.");
-
-	// Inverse transform
-	float angle_num = 2.0f * 3.1415926535897932384626433832795f;
-	if (inverse) angle_num = -angle_num;
-
-	// Variables
-	unsigned int i, j, k, n;
-	float tr, ti;
-
-	// Calculate needed bits
-	unsigned int NumBits;
-	NumBits = NumberOfBitsNeeded(n_samples);
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AGI_FFT_SSE2
+#endif
 
-	// Copy samples to output buffers
-	for (i=0;i<n_samples;i++) {
-		j = ReverseBits (i,NumBits);
-		output_r[j] = input[i];
-		output_i[j] = 0.0f;
+namespace {
+const double pi = 3.1415926535897932384626433832795;
+
+/// Combine the first two radix-2 passes into one radix-4 pass, which has no
+/// multiplications since its twiddle factors are 1 and -i
+void radix4_first_pass(float *re, float *im, size_t count) {
+	for (size_t i = 0; i < count; i += 4) {
+		const float a0r = re[i] + re[i + 1], a0i = im[i] + im[i + 1];
+		const float a1r = re[i] - re[i + 1], a1i = im[i] - im[i + 1];
+		const float a2r = re[i + 2] + re[i + 3], a2i = im[i + 2] + im[i + 3];
+		const float a3r = re[i + 2] - re[i + 3], a3i = im[i + 2] - im[i + 3];
+
+		re[i] = a0r + a2r;
+		im[i] = a0i + a2i;
+		re[i + 2] = a0r - a2r;
+		im[i + 2] = a0i - a2i;
+		// a3 * -i
+		re[i + 1] = a1r + a3i;
+		im[i + 1] = a1i - a3r;
+		re[i + 3] = a1r - a3i;
+		im[i + 3] = a1i + a3r;
 	}
+}
 
-	unsigned int BlockEnd = 1;
-	unsigned int BlockSize;
-	for (BlockSize = 2;BlockSize<=n_samples;BlockSize<<=1) {
-		// Calculate variables for this iteration
-		float delta_angle = angle_num / (float)BlockSize;
-		float sm2 = sin (-2 * delta_angle);
-		float sm1 = sin (-delta_angle);
-		float cm2 = cos (-2 * delta_angle);
-		float cm1 = cos (-delta_angle);
-		float w = 2 * cm1;
-		float ar0, ar1, ar2, ai0, ai1, ai2;
-
-		// Apply for every sample
-		for(i=0;i<n_samples;i+=BlockSize) {
-			ar1 = cm1;
-			ar2 = cm2;
-			ai1 = sm1;
-			ai2 = sm2;
-
-			for (j=i,n=0;n<BlockEnd;j++,n++) {
-				k = j + BlockEnd;
-
-				ar0 = w*ar1 - ar2;
-				ai0 = w*ai1 - ai2;
-				ar2 = ar1;
-				ai2 = ai1;
-				ar1 = ar0;
-				ai1 = ai0;
-
-				tr = ar0*output_r[k] - ai0*output_i[k];
-				ti = ar0*output_i[k] + ai0*output_r[k];
-
-				output_r[k] = output_r[j] - tr;
-				output_i[k] = output_i[j] - ti;
-
-				output_r[j] += tr;
-				output_i[j] += ti;
-			}
+/// One radix-2 pass combining pairs of transforms of length half
+void radix2_pass(float *re, float *im, size_t count, size_t half, const float *wr, const float *wi) {
+	for (size_t i = 0; i < count; i += half * 2) {
+		float *lo_r = re + i, *lo_i = im + i;
+		float *hi_r = lo_r + half, *hi_i = lo_i + half;
+		size_t j = 0;
+#ifdef AGI_FFT_SSE2
+		for (; j + 4 <= half; j += 4) {
+			const __m128 w_r = _mm_loadu_ps(wr + j), w_i = _mm_loadu_ps(wi + j);
+			const __m128 h_r = _mm_loadu_ps(hi_r + j), h_i = _mm_loadu_ps(hi_i + j);
+			const __m128 l_r = _mm_loadu_ps(lo_r + j), l_i = _mm_loadu_ps(lo_i + j);
+			const __m128 t_r = _mm_sub_ps(_mm_mul_ps(w_r, h_r), _mm_mul_ps(w_i, h_i));
+			const __m128 t_i = _mm_add_ps(_mm_mul_ps(w_r, h_i), _mm_mul_ps(w_i, h_r));
+			_mm_storeu_ps(hi_r + j, _mm_sub_ps(l_r, t_r));
+			_mm_storeu_ps(hi_i + j, _mm_sub_ps(l_i, t_i));
+			_mm_storeu_ps(lo_r + j, _mm_add_ps(l_r, t_r));
+			_mm_storeu_ps(lo_i + j, _mm_add_ps(l_i, t_i));
 		}
-
-		// Set next block end to current size
-		BlockEnd = BlockSize;
-	}
-
-	// Divide everything by number of samples if it's an inverse transform
-	if (inverse) {
-		float denom = 1.0f/(float)n_samples;
-		for (i=0;i<n_samples;i++) {
-			output_r[i] *= denom;
-			output_i[i] *= denom;
+#endif
+		for (; j < half; ++j) {
+			const float t_r = wr[j] * hi_r[j] - wi[j] * hi_i[j];
+			const float t_i = wr[j] * hi_i[j] + wi[j] * hi_r[j];
+			hi_r[j] = lo_r[j] - t_r;
+			hi_i[j] = lo_i[j] - t_i;
+			lo_r[j] += t_r;
+			lo_i[j] += t_i;
 		}
 	}
 }
-
-void FFT::Transform(size_t n_samples,float *input,float *output_r,float *output_i) {
-	DoTransform(n_samples,input,output_r,output_i,false);
 }
 
-void FFT::InverseTransform(size_t n_samples,float *input,float *output_r,float *output_i) {
-	DoTransform(n_samples,input,output_r,output_i,true);
+std::vector<float> MakeFFTWindow(FFTWindow window, size_t size) {
+	std::vector<float> coefficients;
+	if (window == FFTWindow::Rectangular)
+		return coefficients;
+
+	// Periodic rather than symmetric windows, as the spectrum is computed
+	// from overlapping blocks. Dividing by the mean keeps a tone at the
+	// same level whichever window is used.
+	coefficients.resize(size);
+	for (size_t i = 0; i < size; ++i) {
+		const double x = 2 * pi * i / size;
+		if (window == FFTWindow::Hann)
+			coefficients[i] = float((0.5 - 0.5 * cos(x)) / 0.5);
+		else
+			coefficients[i] = float((0.42 - 0.5 * cos(x) + 0.08 * cos(2 * x)) / 0.42);
+	}
+	return coefficients;
 }
 
-/// @brief Checks if number is a power of two
-bool FFT::IsPowerOfTwo (unsigned int x) {
-	if (x < 2) return false;
-	if (x & (x-1)) return false;
-    return true;
-}
+FFT::FFT(size_t size)
+: size(size)
+{
+	if (size < 4 || (size & (size - 1)))
+		throw agi::InternalError("FFT requires power of two input.");
 
-/// @brief Bits needed by the FFT
-unsigned int FFT::NumberOfBitsNeeded (unsigned int n_samples) {
-	int i;
+	const size_t half = size / 2;
+	size_t bits = 0;
+	while ((size_t(1) << bits) < half) ++bits;
 
-	if (n_samples < 2) {
-		return 0;
+	bitrev.resize(half);
+	for (size_t i = 0; i < half; ++i) {
+		uint32_t rev = 0;
+		for (size_t b = 0; b < bits; ++b)
+			rev |= ((i >> b) & 1) << (bits - 1 - b);
+		bitrev[i] = rev;
 	}
 
-	for (i=0; ;i++) {
-		if(n_samples & (1 << i)) return i;
-    }
-}
-
-/// @brief Get reversed bit position
-unsigned int FFT::ReverseBits (unsigned int index, unsigned int bits) {
-	unsigned int i, rev;
+	// The twiddle factors for the pass combining transforms of length h start
+	// at index h - 1, so each pass reads its factors contiguously
+	twiddle_r.resize(half);
+	twiddle_i.resize(half);
+	for (size_t h = 1; h < half; h *= 2) {
+		for (size_t j = 0; j < h; ++j) {
+			twiddle_r[h - 1 + j] = float(cos(-pi * j / h));
+			twiddle_i[h - 1 + j] = float(sin(-pi * j / h));
+		}
+	}
 
-	for(i=rev=0;i<bits;i++) {
-		rev = (rev << 1) | (index & 1);
-		index >>= 1;
+	split_r.resize(half + 1);
+	split_i.resize(half + 1);
+	for (size_t k = 0; k <= half; ++k) {
+		split_r[k] = float(cos(-2 * pi * k / size));
+		split_i[k] = float(sin(-2 * pi * k / size));
 	}
 
-	return rev;
+	work_r.resize(half);
+	work_i.resize(half);
 }
 
-/// @brief Get frequency at index
-float FFT::FrequencyAtIndex (unsigned int baseFreq, unsigned int n_samples, unsigned int index) {
-	if (index >= n_samples) return 0.0;
-	else if (index <= n_samples/2) {
-		return ((float)index / (float)n_samples * baseFreq);
+void FFT::Transform(const float *input, float *output_r, float *output_i) {
+	const size_t half = size / 2;
+	float *re = work_r.data(), *im = work_i.data();
+
+	// Pack pairs of samples into complex values in bit-reversed order
+	for (size_t i = 0; i < half; ++i) {
+		re[bitrev[i]] = input[2 * i];
+		im[bitrev[i]] = input[2 * i + 1];
 	}
-	else {
-		return (-(float)(n_samples-index) / (float)n_samples * baseFreq);
+
+	size_t h = 1;
+	if (half >= 4) {
+		radix4_first_pass(re, im, half);
+		h = 4;
+	}
+	for (; h < half; h *= 2)
+		radix2_pass(re, im, half, h, &twiddle_r[h - 1], &twiddle_i[h - 1]);
+
+	// Split the transform of the packed signal into that of the even and odd
+	// samples, and combine them into the spectrum of the real signal
+	output_r[0] = re[0] + im[0];
+	output_i[0] = 0;
+	output_r[half] = re[0] - im[0];
+	output_i[half] = 0;
+	for (size_t k = 1; k < half; ++k) {
+		const float a = re[k], b = im[k];
+		const float c = re[half - k], d = im[half - k];
+		const float even_r = (a + c) * 0.5f, even_i = (b - d) * 0.5f;
+		const float odd_r = (b + d) * 0.5f, odd_i = (c - a) * 0.5f;
+		output_r[k] = even_r + split_r[k] * odd_r - split_i[k] * odd_i;
+		output_i[k] = even_i + split_r[k] * odd_i + split_i[k] * odd_r;
 	}
 }
-#endif
@@ -27,16 +27,66 @@
 //
 // Aegisub Project http://www.aegisub.org/
 
-#include <cstdlib>
+/// @file fft.h
+/// @brief Real-input fast Fourier transform and analysis windows
+/// @ingroup utility
 
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Analysis windows which can be applied to audio before transforming it
+enum class FFTWindow {
+	/// No window; cheapest, but with the most spectral leakage
+	Rectangular,
+	/// Hann window; good frequency resolution with much less leakage
+	Hann,
+	/// Blackman window; wider peaks but even lower leakage
+	Blackman
+};
+
+/// @brief Compute the coefficients of an analysis window
+/// @param window Window to compute
+/// @param size   Number of samples the window is applied to
+/// @return Coefficients scaled so that their mean is 1, so that windowing
+///         doesn't change the magnitude of a tone, or an empty vector for
+///         the rectangular window
+std::vector<float> MakeFFTWindow(FFTWindow window, size_t size);
+
+/// @class FFT
+/// @brief Fast Fourier transform of real input of a fixed power-of-two size
+///
+/// The input is transformed as a complex signal of half the length with the
+/// even samples as the real part and the odd ones as the imaginary part,
+/// which is then split into the spectrum of the real signal. The twiddle
+/// factors and bit reversal for the size are computed once when the FFT is
+/// created, so an FFT should be reused for every transform of its size.
+/// Transform() uses buffers in the object, so each thread needs its own.
 class FFT {
-	void DoTransform(size_t n_samples,float *input,float *output_r,float *output_i,bool inverse);
+	/// Number of real input samples
+	size_t size;
+	/// Bit-reversed index of each element of the half-length transform
+	std::vector<uint32_t> bitrev;
+	/// Twiddle factors for each radix-2 pass, one pass after another
+	std::vector<float> twiddle_r, twiddle_i;
+	/// Twiddle factors for splitting the half-length transform
+	std::vector<float> split_r, split_i;
+	/// Working data for the half-length transform
+	std::vector<float> work_r, work_i;
 
 public:
-	void Transform(size_t n_samples,float *input,float *output_r,float *output_i);
-	void InverseTransform(size_t n_samples,float *input,float *output_r,float *output_i);
-	bool IsPowerOfTwo(unsigned int x);
-	unsigned int NumberOfBitsNeeded(unsigned int n_samples);
-	unsigned int ReverseBits(unsigned int index, unsigned int bits);
-	float FrequencyAtIndex(unsigned int baseFreq, unsigned int n_samples, unsigned int index);
+	/// @param size Number of real samples to transform; must be a power of two of at least 4
+	explicit FFT(size_t size);
+
+	size_t GetSize() const { return size; }
+
+	/// @brief Transform real samples to their spectrum
+	/// @param      input    size samples
+	/// @param[out] output_r Real part of bins 0 to size / 2 inclusive
+	/// @param[out] output_i Imaginary part of bins 0 to size / 2 inclusive
+	///
+	/// The transform is unnormalized, as with FFTW.
+	void Transform(const float *input, float *output_r, float *output_i);
 };
@@ -34,6 +34,7 @@
 
 #pragma once
 
+#include <libaegisub/audio/playback_stats.h>
 #include <libaegisub/exception.h>
 
 #include <cstdint>
@@ -48,8 +49,12 @@ class AudioPlayer {
 protected:
 	agi::AudioProvider *provider;
 
+	/// Counters for how well playback is keeping up, which each backend
+	/// records whatever it can measure in
+	agi::PlaybackStats stats;
+
 public:
-	AudioPlayer(agi::AudioProvider *provider) : provider(provider) { }
+	AudioPlayer(agi::AudioProvider *provider);
 	virtual ~AudioPlayer() = default;
 
 	virtual void Play(int64_t start,int64_t count)=0;	// Play sample range
@@ -61,6 +66,9 @@ public:
 	virtual int64_t GetEndPosition()=0;
 	virtual int64_t GetCurrentPosition()=0;
 	virtual void SetEndPosition(int64_t pos)=0;
+
+	/// Get the playback counters, which can be read from any thread
+	agi::PlaybackStats& GetStats() { return stats; }
 };
 
 struct AudioPlayerFactory {
@@ -38,16 +38,44 @@
 #include <string>
 #include <vector>
 
+class AssDialogue;
 class AssFile;
 struct VideoFrame;
 
 class SubtitlesProvider {
 	std::vector<char> buffer;
+	/// Rows of the events in the loaded track, in track order. Only valid
+	/// when the whole file was loaded.
+	std::vector<int> event_rows;
+	/// Does the loaded track contain every visible line of the file?
+	bool full_file = false;
+	/// Number of events parsed by the last load or update
+	size_t events_parsed = 0;
+
 	virtual void LoadSubtitles(const char *data, size_t len)=0;
 
+	/// @brief Replace a range of events in the loaded track
+	///
+	/// Removes the events in [index, index + count) and inserts the
+	/// Dialogue lines in the given buffer in their place.
+	/// @return Was the track updated? If false the caller must reload the file.
+	virtual bool ReplaceEvents(size_t, size_t, const char *, size_t) { return false; }
+
 public:
 	virtual ~SubtitlesProvider() = default;
 	void LoadSubtitles(AssFile *subs, int time = -1);
+
+	/// @brief Patch a single changed line into the currently loaded track
+	/// @param line Changed line, with Row matching the line it replaces
+	/// @return false if the whole file needs to be reloaded instead
+	///
+	/// Only valid after LoadSubtitles was called without a time, and only
+	/// for changes to existing lines.
+	bool UpdateSubtitles(AssDialogue const& line);
+
+	/// Get the number of events parsed by the most recent load or update
+	size_t GetEventsParsed() const { return events_parsed; }
+
 	virtual void DrawSubtitles(VideoFrame &dst, double time)=0;
 	virtual void Reinitialize() { }
 };
@@ -37,10 +37,20 @@
 #include <libaegisub/exception.h>
 #include <libaegisub/vfr.h>
 
+#include <cstdint>
 #include <string>
 
 struct VideoFrame;
 
+/// How well a provider's frame cache is doing
+struct VideoCacheStats {
+	uint64_t hits = 0;   ///< Frames returned from the cache
+	uint64_t misses = 0; ///< Frames which had to be decoded
+	size_t frames = 0;   ///< Frames currently cached
+	size_t bytes = 0;    ///< Size of the cached frames in bytes
+	size_t max_bytes = 0; ///< Most bytes the cache will hold
+};
+
 /// Color matrix constants matching the constants in ffmpeg
 /// (specifically libavutil's AVColorSpace) and/or H.273.
 typedef enum AGI_ColorSpaces {
@@ -117,6 +127,10 @@ public:
 	/// @return Returns true if caching is desired, false otherwise.
 	virtual bool WantsCaching() const { return false; }
 
+	/// Get the counters for the frame cache wrapped around this provider, if
+	/// there is one; this may be called from any thread
+	virtual VideoCacheStats GetCacheStats() const { return {}; }
+
 	/// Should the video properties in the script be set to this video's property if they already have values?
 	virtual bool ShouldSetVideoProperties() const { return true; }
 
@@ -292,6 +292,7 @@ void MatroskaWrapper::GetSubtitles(agi::fs::path const& filename, AssFile *targe
 
 	if (!result)
 		throw MatroskaException("Failed to read subtitles");
+	parser.Finish();
 }
 
 bool MatroskaWrapper::HasSubtitles(agi::fs::path const& filename) {
@@ -207,6 +207,7 @@ void Audio(wxTreebook *book, Preferences *parent) {
 	p->OptionAdd(general, _("Default mouse wheel to zoom"), "Audio/Wheel Default to Zoom");
 	p->OptionAdd(general, _("Lock scroll on cursor"), "Audio/Lock Scroll on Cursor");
 	p->OptionAdd(general, _("Snap markers by default"), "Audio/Snap/Enable");
+	p->OptionAdd(general, _("Snap markers to speech boundaries"), "Audio/Snap/Speech Boundaries");
 	p->OptionAdd(general, _("Auto-focus on mouse over"), "Audio/Auto/Focus");
 	p->OptionAdd(general, _("Play audio when stepping in video"), "Audio/Plays When Stepping Video");
 	p->OptionAdd(general, _("Keep pitch when changing speed"), "Audio/Keep Pitch When Changing Speed");
@@ -549,6 +550,12 @@ void Advanced_Audio(wxTreebook *book, Preferences *parent) {
 	wxArrayString ct_choice(3, ct_arr);
 	p->OptionChoice(cache, _("Cache type"), ct_choice, "Audio/Cache/Type");
 	p->OptionBrowse(cache, _("Path"), "Audio/Cache/HD/Location");
+	p->OptionAdd(cache, _("Keep decoded audio between sessions"), "Audio/Cache/Persistent/Enable");
+	p->OptionAdd(cache, _("Max persistent cache size (MB)"), "Audio/Cache/Persistent/Size", 0, 1000000);
+	p->OptionAdd(cache, _("Max persistent cache files"), "Audio/Cache/Persistent/Files", 0, 1000);
+
+	auto display = p->PageSizer(_("Rendering"));
+	p->OptionAdd(display, _("Cached bitmap width (pixels)"), "Audio/Renderer/Bitmap Width", 16, 4096);
 
 	auto spectrum = p->PageSizer(_("Spectrum"));
 
@@ -560,8 +567,15 @@ void Advanced_Audio(wxTreebook *book, Preferences *parent) {
 	wxArrayString sc_choice(5, sc_arr);
 	p->OptionChoice(spectrum, _("Frequency mapping"), sc_choice, "Audio/Renderer/Spectrum/FreqCurve");
 
+	const wxString sw_arr[3] = { _("None"), _("Hann"), _("Blackman") };
+	wxArrayString sw_choice(3, sw_arr);
+	p->OptionChoice(spectrum, _("Window"), sw_choice, "Audio/Renderer/Spectrum/Window");
+
 	p->OptionAdd(spectrum, _("Cache memory max (MB)"), "Audio/Renderer/Spectrum/Memory Max", 2, 1024);
 
+	auto playback = p->PageSizer(_("Playback"));
+	p->OptionAdd(playback, _("Decode ahead (ms)"), "Player/Audio/Decode Ahead", 20, 5000);
+
 #ifdef WITH_AVISYNTH
 	auto avisynth = p->PageSizer("Avisynth");
 	const wxString adm_arr[4] = { "None", "ConvertToMono", "GetLeftChannel", "GetRightChannel" };
@@ -620,6 +634,8 @@ void Advanced_Video(wxTreebook *book, Preferences *parent) {
 	wxArrayString sp_choice = to_wx(SubtitlesProviderFactory::GetClasses());
 	p->OptionChoice(expert, _("Subtitles provider"), sp_choice, "Subtitle/Provider");
 
+	p->OptionAdd(expert, _("Frames to decode ahead during playback"), "Video/Prefetch Frames", 0, 64);
+
 
 #ifdef WITH_AVISYNTH
 	auto avisynth = p->PageSizer("Avisynth");
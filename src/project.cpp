@@ -38,6 +38,7 @@
 #include "video_display.h"
 
 #include <libaegisub/audio/provider.h>
+#include <libaegisub/audio/speech_envelope.h>
 #include <libaegisub/format_path.h>
 #include <libaegisub/fs.h>
 #include <libaegisub/keyframe.h>
@@ -252,9 +253,10 @@ void Project::DoLoadAudio(agi::fs::path const& path, bool quiet) {
 	if (!progress)
 		progress = new DialogProgress(context->parent);
 
+	std::unique_ptr<agi::AudioProvider> new_provider;
 	try {
 		try {
-			audio_provider = GetAudioProvider(path, *context->path, progress);
+			new_provider = GetAudioProvider(path, *context->path, progress);
 		}
 		catch (agi::UserCancelException const&) { return; }
 		catch (...) {
@@ -280,6 +282,13 @@ void Project::DoLoadAudio(agi::fs::path const& path, bool quiet) {
 		return ShowError(e.GetMessage());
 	}
 
+	// The envelope reads from the old provider until it's destroyed
+	speech_envelope.reset();
+	// Everything else which uses the old provider lets go of it when told
+	// about the new one, so it's kept alive until after that
+	audio_provider.swap(new_provider);
+	speech_envelope = agi::make_unique<agi::SpeechEnvelope>(audio_provider.get());
+
 	SetPath(audio_file, "?audio", "Audio", path);
 	AnnounceAudioProviderModified(audio_provider.get());
 	context->videoController->ResetPlaybackSpeedToDefault();
@@ -291,6 +300,7 @@ void Project::LoadAudio(agi::fs::path path) {
 
 void Project::CloseAudio() {
 	AnnounceAudioProviderModified(nullptr);
+	speech_envelope.reset();
 	audio_provider.reset();
 	SetPath(audio_file, "?audio", "", "");
 }
@@ -317,7 +327,7 @@ bool Project::DoLoadVideo(agi::fs::path const& path) {
 	AnnounceVideoProviderModified(video_provider.get());
 
 	UpdateVideoProperties(context->ass.get(), video_provider.get(), context->parent);
-	video_provider->LoadSubtitles(context->ass.get());
+	video_provider->LoadSubtitles(context->subsController->Snapshot());
 
 	timecodes = video_provider->GetFPS();
 	keyframes = video_provider->GetKeyFrames();
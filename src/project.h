@@ -26,11 +26,14 @@ class AsyncVideoProvider;
 class DialogProgress;
 class wxString;
 namespace agi { class AudioProvider; }
+namespace agi { class SpeechEnvelope; }
 namespace agi { struct Context; }
 struct ProjectProperties;
 
 class Project {
 	std::unique_ptr<agi::AudioProvider> audio_provider;
+	/// Speech boundaries in the audio, which reads from audio_provider
+	std::unique_ptr<agi::SpeechEnvelope> speech_envelope;
 	std::unique_ptr<AsyncVideoProvider> video_provider;
 	agi::vfr::Framerate timecodes;
 	std::vector<int> keyframes;
@@ -76,6 +79,7 @@ public:
 	void ReloadAudio();
 	void CloseAudio();
 	agi::AudioProvider *AudioProvider() const { return audio_provider.get(); }
+	agi::SpeechEnvelope *SpeechEnvelope() const { return speech_envelope.get(); }
 	agi::fs::path const& AudioName() const { return audio_file; }
 
 	void LoadVideo(agi::fs::path path);
@@ -0,0 +1,193 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file spectrum_rows.cpp
+/// @brief Mapping of the spectrum display's pixel rows to frequency bins
+/// @ingroup audio_ui
+
+#include "spectrum_rows.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AGI_SPECTRUM_SSE2
+#endif
+
+namespace {
+int floor_int(float val) { return int(floorf(val)); }
+int round_int(float val) { return int(floorf(val + 0.5f)); }
+
+/// Greatest value in [begin, end), which must not be empty
+float range_max(const float *begin, const float *end) {
+	float result = *begin++;
+#ifdef AGI_SPECTRUM_SSE2
+	if (end - begin >= 8) {
+		__m128 m0 = _mm_set1_ps(result), m1 = m0;
+		for (; end - begin >= 8; begin += 8) {
+			m0 = _mm_max_ps(m0, _mm_loadu_ps(begin));
+			m1 = _mm_max_ps(m1, _mm_loadu_ps(begin + 4));
+		}
+		m0 = _mm_max_ps(m0, m1);
+		m0 = _mm_max_ps(m0, _mm_shuffle_ps(m0, m0, _MM_SHUFFLE(1, 0, 3, 2)));
+		m0 = _mm_max_ps(m0, _mm_shuffle_ps(m0, m0, _MM_SHUFFLE(2, 3, 0, 1)));
+		result = _mm_cvtss_f32(m0);
+	}
+#endif
+	for (; begin != end; ++begin)
+		result = std::max(result, *begin);
+	return result;
+}
+}
+
+SpectrumRowMap::SpectrumRowMap(SpectrumRowParams const& p)
+: params(p)
+, first(std::max(p.height, 0))
+, last(std::max(p.height, 0))
+, frac(std::max(p.height, 0))
+{
+	const int height = params.height;
+
+	// Number of FFT bins, excluding the "Nyquist" one
+	const int nbr_bins = 1 << params.derivation_size;
+
+	// minband and maxband define an half-open range.
+	const int minband = 1; // Starts at 1, we don't care about showing the DC.
+	const int maxband = std::min(
+		round_int(nbr_bins * params.max_freq / (params.sample_rate * 0.5f)),
+		nbr_bins
+	);
+	assert(minband < maxband);
+
+	// Precomputes this once, this will be useful for the log curve.
+	const float scale_log = logf(maxband / minband);
+
+	// Turns the 1 kHz position into a ratio between the linear and
+	// logarithmic curves that we can directly use in the following
+	// calculations.
+	assert(params.pos_fref > 0);
+	assert(params.pos_fref < 1);
+	float b_fref         = nbr_bins * params.freq_ref / (params.sample_rate * 0.5f);
+	b_fref               = std::min(std::max(b_fref, 1.f), float(maxband - 1));
+	const float clin     = minband + (maxband - minband) * params.pos_fref;
+	const float clog     = minband * expf(params.pos_fref * scale_log);
+	float log_ratio_calc = (b_fref - clin) / (clog - clin);
+	log_ratio_calc       = std::min(std::max(log_ratio_calc, 0.f), 1.f);
+
+	float bin_prv = minband;
+	float bin_cur = minband;
+	for (int y = 0; y < height; ++y)
+	{
+		assert(bin_cur < float(maxband));
+
+		float bin_nxt = maxband;
+		if (y + 1 < height)
+		{
+			// Bin index is an interpolation between the linear and log curves.
+			const float pos_rel = float(y + 1) / float(height);
+			const float b_lin   = minband + pos_rel * (maxband - minband);
+			const float b_log   = minband * expf(pos_rel * scale_log);
+			bin_nxt = b_lin + log_ratio_calc * (b_log - b_lin);
+		}
+
+		// Interpolate between consecutive bins
+		if (bin_nxt - bin_prv < 2)
+		{
+			const int bin_0 = floor_int(bin_cur);
+			first[y] = bin_0;
+			last[y] = std::min(bin_0 + 1, nbr_bins - 1);
+			frac[y] = bin_cur - float(bin_0);
+		}
+
+		// Pick the greatest bin on the interval
+		else
+		{
+			int bin_inf = floor_int((bin_prv + bin_cur) * 0.5f);
+			int bin_sup = floor_int((bin_cur + bin_nxt) * 0.5f);
+			bin_inf = std::min(bin_inf, nbr_bins - 2);
+			bin_sup = std::min(bin_sup, nbr_bins - 1);
+			assert(bin_inf < bin_sup);
+			first[y] = bin_inf;
+			last[y] = bin_sup;
+			frac[y] = -1.f;
+		}
+
+		bin_prv = bin_cur;
+		bin_cur = bin_nxt;
+	}
+}
+
+void SpectrumRowMap::MapColumn(const float *power, float *out) const
+{
+	const int32_t *f = first.data();
+	const int32_t *l = last.data();
+	const float *w = frac.data();
+	const int height = params.height;
+
+	// The rows which interpolate are all at the bottom, as the rows only get
+	// further apart going up, so this is one run of each in practice
+	for (int y = 0; y < height; ++y)
+	{
+		if (w[y] >= 0)
+		{
+			const float v0 = power[f[y]];
+			out[y] = v0 + w[y] * (power[l[y]] - v0);
+		}
+		else
+			out[y] = range_max(power + f[y], power + l[y]);
+	}
+}
+
+void MapSpectrumColumn(const float *values, size_t count, float scale,
+                       const unsigned char *palette, size_t factor,
+                       unsigned char *pixel, ptrdiff_t step)
+{
+	const float fmax = float(factor);
+	size_t i = 0;
+
+#ifdef AGI_SPECTRUM_SSE2
+	// Clamp and convert four values at a time; only copying the pixels is
+	// left to do one by one
+	const __m128 vscale = _mm_set1_ps(scale);
+	const __m128 vmax = _mm_set1_ps(fmax);
+	const __m128 vzero = _mm_setzero_ps();
+	alignas(16) int32_t index[4];
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 v = _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(values + i), vscale), vmax);
+		v = _mm_min_ps(_mm_max_ps(v, vzero), vmax);
+		_mm_store_si128(reinterpret_cast<__m128i *>(index), _mm_cvttps_epi32(v));
+		for (int j = 0; j < 4; ++j, pixel += step)
+		{
+			const unsigned char *color = palette + index[j] * 3;
+			pixel[0] = color[0];
+			pixel[1] = color[1];
+			pixel[2] = color[2];
+		}
+	}
+#endif
+
+	for (; i < count; ++i, pixel += step)
+	{
+		const float v = std::min(std::max(values[i] * scale * fmax, 0.f), fmax);
+		const unsigned char *color = palette + size_t(v) * 3;
+		pixel[0] = color[0];
+		pixel[1] = color[1];
+		pixel[2] = color[2];
+	}
+}
@@ -0,0 +1,98 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file spectrum_rows.h
+/// @brief Mapping of the spectrum display's pixel rows to frequency bins
+/// @ingroup audio_ui
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Settings which determine which bins each row of the spectrum shows
+struct SpectrumRowParams {
+	/// Height of the display in pixels
+	int height = 0;
+	/// Binary logarithm of half the number of samples in each derivation
+	size_t derivation_size = 0;
+	/// Sampling rate of the audio, in Hz
+	float sample_rate = 0;
+	/// Highest frequency displayed, in Hz
+	float max_freq = 0;
+	/// Frequency which is kept at a constant vertical position, in Hz
+	float freq_ref = 0;
+	/// Relative vertical position of freq_ref, in (0 ; 1)
+	float pos_fref = 0;
+
+	bool operator==(SpectrumRowParams const& other) const {
+		return height == other.height
+			&& derivation_size == other.derivation_size
+			&& sample_rate == other.sample_rate
+			&& max_freq == other.max_freq
+			&& freq_ref == other.freq_ref
+			&& pos_fref == other.pos_fref;
+	}
+	bool operator!=(SpectrumRowParams const& other) const { return !(*this == other); }
+};
+
+/// @class SpectrumRowMap
+/// @brief Precomputed mapping from the rows of the spectrum display to bins
+///
+/// Each row's frequency is an interpolation between a linear and a
+/// logarithmic curve. Rows which are less than a bin apart interpolate
+/// between the two bins around their frequency, and the rest show the
+/// greatest bin in the range they cover. Working that out involves an
+/// expf() per row, so it's done once for each set of parameters rather than
+/// for every pixel of every column.
+class SpectrumRowMap {
+	SpectrumRowParams params;
+
+	/// First bin of each row, bottom row first
+	std::vector<int32_t> first;
+	/// For rows showing the greatest of several bins, one past the last bin.
+	/// For interpolated rows, the second bin to interpolate with.
+	std::vector<int32_t> last;
+	/// For interpolated rows, the weight of the second bin, and otherwise -1
+	std::vector<float> frac;
+
+public:
+	explicit SpectrumRowMap(SpectrumRowParams const& params);
+
+	SpectrumRowParams const& GetParams() const { return params; }
+	int GetHeight() const { return params.height; }
+
+	/// @brief Compute the value displayed in each row for a block of spectrum data
+	/// @param      power Power of each bin, 2^derivation_size values
+	/// @param[out] out   Value of each row, bottom row first
+	void MapColumn(const float *power, float *out) const;
+};
+
+/// @brief Write a column of values to an RGB image through a palette
+/// @param values  Values to map, which are multiplied by scale
+/// @param count   Number of values
+/// @param scale   Amplitude scale
+/// @param palette RGB triples for each palette entry, factor + 1 of them
+/// @param factor  Index of the palette entry for a scaled value of 1
+/// @param pixel   First pixel to write
+/// @param step    Byte offset from each pixel to the next one to write
+///
+/// Values are clamped to [0 ; 1] after scaling, so this matches mapping each
+/// value with AudioColorScheme::map().
+void MapSpectrumColumn(const float *values, size_t count, float scale,
+                       const unsigned char *palette, size_t factor,
+                       unsigned char *pixel, ptrdiff_t step);
@@ -19,6 +19,7 @@
 #include "ass_attachment.h"
 #include "ass_dialogue.h"
 #include "ass_file.h"
+#include "ass_file_snapshot.h"
 #include "ass_info.h"
 #include "ass_style.h"
 #include "compat.h"
@@ -36,9 +37,13 @@
 #include <libaegisub/dispatch.h>
 #include <libaegisub/format_path.h>
 #include <libaegisub/fs.h>
+#include <libaegisub/log.h>
+#include <libaegisub/make_unique.h>
 #include <libaegisub/path.h>
 #include <libaegisub/util.h>
 
+#include <algorithm>
+#include <unordered_map>
 #include <wx/msgdlg.h>
 
 namespace {
@@ -55,37 +60,31 @@ struct SubsController::UndoInfo {
 	wxString undo_description;
 	int commit_id;
 
-	std::vector<std::pair<std::string, std::string>> script_info;
-	std::vector<AssStyle> styles;
-	std::vector<AssDialogueBase> events;
-	std::vector<AssAttachment> attachments;
-	std::vector<ExtradataEntry> extradata;
+	/// The state of the file, shared with anything which asked for a snapshot
+	std::shared_ptr<AssFileSnapshot> file;
 
 	mutable std::vector<int> selection;
 	int active_line_id = 0;
 	int pos = 0, sel_start = 0, sel_end = 0;
 
-	UndoInfo(const agi::Context *c, wxString const& d, int commit_id)
+	UndoInfo(const agi::Context *c, wxString const& d, int commit_id, UndoInfo const* prev)
 	: undo_description(d)
 	, commit_id(commit_id)
-	, attachments(c->ass->Attachments)
-	, extradata(c->ass->Extradata)
+	, file(std::make_shared<AssFileSnapshot>(*c->ass, prev ? prev->file.get() : nullptr))
 	{
-		script_info.reserve(c->ass->Info.size());
-		for (auto const& info : c->ass->Info)
-			script_info.emplace_back(info.Key(), info.Value());
-
-		styles.reserve(c->ass->Styles.size());
-		styles.assign(c->ass->Styles.begin(), c->ass->Styles.end());
-
-		events.reserve(c->ass->Events.size());
-		events.assign(c->ass->Events.begin(), c->ass->Events.end());
-
 		UpdateActiveLine(c);
 		UpdateSelection(c);
 		UpdateTextSelection(c);
 	}
 
+	/// Replace a single line, copying the snapshot first if it has been
+	/// handed out as snapshots are immutable once shared
+	void UpdateLine(AssDialogueBase const& line) {
+		if (file.use_count() > 1)
+			file = std::make_shared<AssFileSnapshot>(*file);
+		file->UpdateLine(line);
+	}
+
 	void Apply(agi::Context *c) const {
 		// Keep old dialogue lines alive until after the commit is complete
 		// since a bunch of stuff holds references to them
@@ -101,20 +100,55 @@ struct SubsController::UndoInfo {
 		AssDialogue *active_line = nullptr;
 		Selection new_sel;
 
-		for (auto const& info : script_info)
+		// Lines which are unchanged in the state being restored are moved
+		// over as-is, so only the lines which differ have to be rebuilt
+		std::unordered_map<int, AssDialogue *> current_lines;
+		for (auto& line : old.Events)
+			current_lines[line.Id] = &line;
+
+		for (auto const& info : file->script_info)
 			c->ass->Info.push_back(*new AssInfo(info.first, info.second));
-		for (auto const& style : styles)
+		for (auto const& style : file->styles)
 			c->ass->Styles.push_back(*new AssStyle(style));
-		c->ass->Attachments = attachments;
-		for (auto const& event : events) {
-			auto copy = new AssDialogue(event);
-			c->ass->Events.push_back(*copy);
-			if (copy->Id == active_line_id)
-				active_line = copy;
-			if (binary_search(begin(selection), end(selection), copy->Id))
-				new_sel.insert(copy);
+		c->ass->Attachments = file->attachments;
+
+		// Work out which lines can be reused first so that the ones which
+		// can't can be allocated together
+		std::vector<std::pair<AssDialogueBase const*, AssDialogue *>> restored;
+		size_t rebuilt = 0;
+		for (auto const& chunk : file->events) {
+			for (auto const& event : *chunk) {
+				AssDialogue *line = nullptr;
+				auto it = current_lines.find(event.Id);
+				if (it != current_lines.end() && SameLine(*it->second, event)) {
+					line = it->second;
+					current_lines.erase(it);
+				}
+				else
+					++rebuilt;
+				restored.emplace_back(&event, line);
+			}
 		}
-		c->ass->Extradata = extradata;
+
+		{
+			EntryArena arena(EntryArena::SizeFor<AssDialogue>(rebuilt));
+			for (auto& event : restored) {
+				AssDialogue *line = event.second;
+				if (line)
+					line->unlink();
+				else
+					line = new AssDialogue(*event.first);
+
+				c->ass->Events.push_back(*line);
+				if (line->Id == active_line_id)
+					active_line = line;
+				if (binary_search(begin(selection), end(selection), line->Id))
+					new_sel.insert(line);
+			}
+		}
+		c->ass->Extradata = file->extradata;
+
+		LOG_D("subs/undo") << "restored commit " << commit_id << ", rebuilt " << rebuilt << " lines";
 
 		c->ass->Commit("", AssFile::COMMIT_NEW);
 		c->selectionController->SetSelectionAndActive(std::move(new_sel), active_line);
@@ -268,10 +302,10 @@ void SubsController::AutoSave() {
 
 	autosaved_commit_id = commit_id;
 	auto frame = context->frame;
-	auto subs_copy = new AssFile(*context->ass);
-	autosave_queue->Async([subs_copy, name, directory, frame] {
+	auto snapshot = Snapshot();
+	autosave_queue->Async([snapshot, name, directory, frame] {
 		wxString msg;
-		std::unique_ptr<AssFile> subs(subs_copy);
+		auto subs = agi::make_unique<AssFile>(*snapshot);
 
 		try {
 			agi::fs::CreateDirectory(directory);
@@ -318,12 +352,7 @@ void SubsController::OnCommit(AssFileCommit c) {
 	if (commit_id == *c.commit_id+1 && redo_stack.empty() && saved_commit_id+1 != commit_id) {
 		// If only one line changed just modify it instead of copying the file
 		if (c.single_line && c.single_line->Group() == AssEntryGroup::DIALOGUE) {
-			for (auto& diag : undo_stack.back().events) {
-				if (diag.Id == c.single_line->Id) {
-					diag = *c.single_line;
-					break;
-				}
-			}
+			undo_stack.back().UpdateLine(*c.single_line);
 			*c.commit_id = commit_id;
 			return;
 		}
@@ -341,7 +370,11 @@ void SubsController::OnCommit(AssFileCommit c) {
 
 	redo_stack.clear();
 
-	undo_stack.emplace_back(context, c.message, commit_id);
+	undo_stack.emplace_back(context, c.message, commit_id, undo_stack.empty() ? nullptr : &undo_stack.back());
+	auto const& undo = undo_stack.back();
+	LOG_D("subs/undo") << "commit " << commit_id << ": " << undo.file->events.size() << " chunks, "
+		<< undo.file->unshared_lines << " of " << undo.file->LineCount() << " lines unshared ("
+		<< undo.file->unshared_lines * sizeof(AssDialogueBase) << " bytes)";
 
 	int depth = std::max<int>(OPT_GET("Limits/Undo Levels")->GetInt(), 2);
 	while ((int)undo_stack.size() > depth)
@@ -406,6 +439,14 @@ wxString SubsController::GetUndoDescription() const {
 	return IsUndoStackEmpty() ? wxString() : undo_stack.back().undo_description;
 }
 
+std::shared_ptr<const AssFileSnapshot> SubsController::Snapshot() const {
+	// Nothing has been committed yet, so the file as it is now is the state
+	// as of the last commit
+	if (undo_stack.empty())
+		return std::make_shared<AssFileSnapshot>(*context->ass, nullptr);
+	return undo_stack.back().file;
+}
+
 wxString SubsController::GetRedoDescription() const {
 	return IsRedoStackEmpty() ? wxString() : redo_stack.back().undo_description;
 }
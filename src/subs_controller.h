@@ -28,6 +28,7 @@ namespace agi {
 	}
 	struct Context;
 }
+class AssFileSnapshot;
 struct AssFileCommit;
 struct ProjectProperties;
 
@@ -135,4 +136,12 @@ public:
 	wxString GetUndoDescription() const;
 	/// Get the description of the first redoable change
 	wxString GetRedoDescription() const;
+
+	/// @brief Get the state of the file as of the last commit
+	///
+	/// This is shared with the undo history and so is cheap to get regardless
+	/// of the size of the file. The snapshot is immutable and can safely be
+	/// handed off to other threads. Never null; before anything has been
+	/// committed it's a fresh snapshot of the current file.
+	std::shared_ptr<const AssFileSnapshot> Snapshot() const;
 };
@@ -40,6 +40,7 @@ void AssSubtitleFormat::ReadFile(AssFile *target, agi::fs::path const& filename,
 	AssParser parser(target, version);
 	while (file.HasMoreLines())
 		parser.AddLine(file.ReadLineFromFile());
+	parser.Finish();
 }
 
 #ifdef _WIN32
@@ -83,10 +84,20 @@ struct Writer {
 				group = line.Group();
 			}
 
-			file.WriteLineToFile(line.GetEntryData());
+			WriteEntry(line);
 		}
 	}
 
+	template<typename T>
+	void WriteEntry(T const& line) {
+		file.WriteLineToFile(line.GetEntryData());
+	}
+
+	void WriteEntry(AssDialogue const& line) {
+		// Format straight into the output buffer as there can be a lot of these
+		file.AppendLineToFile([&](std::string &out) { line.AppendEntryData(out); });
+	}
+
 	void Write(ProjectProperties const& properties) {
 		file.WriteLineToFile("");
 		file.WriteLineToFile("[Aegisub Project Garbage]");
@@ -159,6 +170,7 @@ void AssSubtitleFormat::WriteFile(const AssFile *src, agi::fs::path const& filen
 	writer.Write(src->Attachments);
 	writer.Write(src->Events);
 	writer.WriteExtradata(src->Extradata);
+	writer.file.Close();
 }
 
 void AssSubtitleFormat::ExportFile(const AssFile *src, agi::fs::path const& filename, agi::vfr::Framerate const& fps, std::string const& encoding) const {
@@ -167,4 +179,5 @@ void AssSubtitleFormat::ExportFile(const AssFile *src, agi::fs::path const& file
 	writer.Write(src->Styles);
 	writer.Write(src->Attachments);
 	writer.Write(src->Events);
+	writer.file.Close();
 }
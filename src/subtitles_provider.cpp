@@ -21,55 +21,14 @@
 #include "ass_file.h"
 #include "ass_info.h"
 #include "ass_style.h"
-#include "factory_manager.h"
-#include "options.h"
-#include "subtitles_provider_csri.h"
-#include "subtitles_provider_libass.h"
 
-namespace {
-	struct factory {
-		std::string name;
-		std::string subtype;
-		std::unique_ptr<SubtitlesProvider> (*create)(std::string const& subtype, agi::BackgroundRunner *br);
-		bool hidden;
-	};
-
-	std::vector<factory> const& factories() {
-		static std::vector<factory> factories;
-		if (factories.size()) return factories;
-#ifdef WITH_CSRI
-		for (auto const& subtype : csri::List())
-			factories.push_back(factory{"CSRI/" + subtype, subtype, csri::Create, false});
-#endif
-		factories.push_back(factory{"libass", "", libass::Create, false});
-		return factories;
-	}
-}
-
-std::vector<std::string> SubtitlesProviderFactory::GetClasses() {
-	return ::GetClasses(factories());
-}
-
-std::unique_ptr<SubtitlesProvider> SubtitlesProviderFactory::GetProvider(agi::BackgroundRunner *br) {
-	auto preferred = OPT_GET("Subtitle/Provider")->GetString();
-	auto sorted = GetSorted(factories(), preferred);
-
-	std::string error;
-	for (auto factory : sorted) {
-		try {
-			auto provider = factory->create(factory->subtype, br);
-			if (provider) return provider;
-		}
-		catch (agi::UserCancelException const&) { throw; }
-		catch (agi::Exception const& err) { error += factory->name + ": " + err.GetMessage() + "\n"; }
-		catch (...) { error += factory->name + ": Unknown error\n"; }
-	}
-
-	throw error;
-}
+#include <algorithm>
+#include <cstring>
 
 void SubtitlesProvider::LoadSubtitles(AssFile *subs, int time) {
 	buffer.clear();
+	event_rows.clear();
+	full_file = time < 0;
 
 	auto push_header = [&](const char *str) {
 		buffer.insert(buffer.end(), str, str + strlen(str));
@@ -99,10 +58,56 @@ void SubtitlesProvider::LoadSubtitles(AssFile *subs, int time) {
 	}
 
 	push_header("[Events]\n");
-	for (auto const& line : subs->Events) {
-		if (!line.Comment && (time < 0 || !(line.Start > time || line.End <= time)))
-			push_line(line.GetEntryData());
+	events_parsed = 0;
+	if (full_file) {
+		for (auto const& line : subs->Events) {
+			if (!line.Comment) {
+				push_line(line.GetEntryData());
+				event_rows.push_back(line.Row);
+			}
+		}
+		events_parsed = event_rows.size();
+	}
+	else {
+		for (auto line : subs->TimeIndex().At(time)) {
+			if (!line->Comment) {
+				push_line(line->GetEntryData());
+				++events_parsed;
+			}
+		}
 	}
 
 	LoadSubtitles(&buffer[0], buffer.size());
 }
+
+bool SubtitlesProvider::UpdateSubtitles(AssDialogue const& line) {
+	if (!full_file) return false;
+
+	auto it = lower_bound(begin(event_rows), end(event_rows), line.Row);
+	bool loaded = it != end(event_rows) && *it == line.Row;
+	size_t index = distance(begin(event_rows), it);
+
+	// Commented lines aren't sent to the renderer, so toggling the comment
+	// flag turns into an insertion or removal
+	std::string data;
+	if (!line.Comment) {
+		data = line.GetEntryData();
+		data += '\n';
+	}
+	else if (!loaded) {
+		events_parsed = 0;
+		return true;
+	}
+
+	if (!ReplaceEvents(index, loaded, data.data(), data.size())) {
+		full_file = false;
+		return false;
+	}
+
+	if (loaded && line.Comment)
+		event_rows.erase(it);
+	else if (!loaded)
+		event_rows.insert(it, line.Row);
+	events_parsed = !line.Comment;
+	return true;
+}
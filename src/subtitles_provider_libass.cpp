@@ -45,6 +45,7 @@
 #include <libaegisub/make_unique.h>
 #include <libaegisub/util.h>
 
+#include <algorithm>
 #include <atomic>
 #include <boost/gil.hpp>
 #include <memory>
@@ -125,6 +126,30 @@ public:
 		if (!ass_track) throw agi::InternalError("libass failed to load subtitles.");
 	}
 
+	bool ReplaceEvents(size_t index, size_t count, const char *data, size_t len) override {
+		if (!ass_track || index + count > size_t(ass_track->n_events)) return false;
+
+		// libass only appends events, so parse the new lines onto the end
+		// of the track and then rotate them into place
+		size_t old_count = ass_track->n_events;
+		if (len)
+			ass_process_data(ass_track, const_cast<char *>(data), len);
+		size_t added = ass_track->n_events - old_count;
+		if (len && !added) return false;
+
+		auto events = ass_track->events;
+		for (size_t i = index; i < index + count; ++i)
+			ass_free_event(ass_track, i);
+		std::rotate(events + index, events + index + count, events + old_count + added);
+		ass_track->n_events -= count;
+		std::rotate(events + index, events + old_count - count, events + ass_track->n_events);
+
+		// Events with equal layers are drawn in read order
+		for (int i = index; i < ass_track->n_events; ++i)
+			events[i].ReadOrder = i;
+		return true;
+	}
+
 	void DrawSubtitles(VideoFrame &dst, double time) override;
 
 	void Reinitialize() override {
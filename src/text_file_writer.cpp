@@ -34,32 +34,58 @@ TextFileWriter::TextFileWriter(agi::fs::path const& filename, std::string encodi
 {
 	if (encoding.empty())
 		encoding = OPT_GET("App/Save Charset")->GetString();
-	if (encoding != "utf-8" && encoding != "UTF-8") {
+	if (encoding != "utf-8" && encoding != "UTF-8")
 		conv = agi::make_unique<agi::charset::IconvWrapper>("utf-8", encoding.c_str(), true);
-		newline = conv->Convert(newline);
-	}
 
 	try {
 		// Write the BOM
-		WriteLineToFile("\xEF\xBB\xBF", false);
+		std::string bom = conv ? conv->Convert("\xEF\xBB\xBF") : "\xEF\xBB\xBF";
+		file->Get().write(bom.data(), bom.size());
 	}
 	catch (agi::charset::ConversionFailure&) {
 		// If the BOM could not be converted to the target encoding it isn't needed
 	}
+
+	buffer.reserve(block_size + block_size / 8);
 }
 
 TextFileWriter::~TextFileWriter() {
-	// Explicit empty destructor required with a unique_ptr to an incomplete class
+	// Anything not closed was abandoned part way through, most likely due to
+	// a write having failed, so don't replace the file with half of it
+	if (file)
+		file->Cancel();
 }
 
-void TextFileWriter::WriteLineToFile(std::string const& line, bool addLineBreak) {
+void TextFileWriter::Close() {
+	Flush();
+	if (!file->Get().flush()) {
+		file->Cancel();
+		file.reset();
+		throw agi::io::IOError("Failed to write the file");
+	}
+
+	// Destroying the Save moves the file into place, which can throw, and
+	// unique_ptr::reset() is noexcept
+	delete file.release();
+}
+
+void TextFileWriter::Flush() {
+	if (buffer.empty()) return;
+
 	if (conv) {
-		auto converted = conv->Convert(line);
+		converted.clear();
+		conv->Convert(buffer.data(), buffer.size(), converted);
 		file->Get().write(converted.data(), converted.size());
 	}
 	else
-		file->Get().write(line.data(), line.size());
+		file->Get().write(buffer.data(), buffer.size());
+	buffer.clear();
+}
 
+void TextFileWriter::WriteLineToFile(std::string const& line, bool addLineBreak) {
+	buffer += line;
 	if (addLineBreak)
-		file->Get().write(newline.data(), newline.size());
+		buffer += newline;
+	if (buffer.size() >= block_size)
+		Flush();
 }
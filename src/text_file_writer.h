@@ -33,14 +33,41 @@ class TextFileWriter {
 	std::unique_ptr<agi::io::Save> file;
 	std::unique_ptr<agi::charset::IconvWrapper> conv;
 #ifdef _WIN32
-	std::string newline = "\r\n";
+	const char *newline = "\r\n";
 #else
-	std::string newline = "\n";
+	const char *newline = "\n";
 #endif
 
+	/// UTF-8 text which has not yet been converted and written
+	std::string buffer;
+	/// Reused output buffer for charset conversion
+	std::string converted;
+
+	/// Flush the buffer once it gets this large
+	static const size_t block_size = 1 << 20;
+
+	/// Convert and write everything in the buffer
+	void Flush();
+
 public:
 	TextFileWriter(agi::fs::path const& filename, std::string encoding="");
+	/// Throws away everything written if Close() wasn't called, leaving the
+	/// file as it was
 	~TextFileWriter();
 
+	/// @brief Write out anything buffered and replace the file with what's been written
+	/// @throws agi::io::IOError if writing failed, in which case the file is left as it was
+	void Close();
+
 	void WriteLineToFile(std::string const& line, bool addLineBreak=true);
+
+	/// @brief Write a line by having a function format it directly into the output buffer
+	/// @param fill Function which appends the line (without a line break) to the string passed to it
+	template<typename Func>
+	void AppendLineToFile(Func&& fill) {
+		fill(buffer);
+		buffer += newline;
+		if (buffer.size() >= block_size)
+			Flush();
+	}
 };
@@ -37,12 +37,14 @@
 #include "options.h"
 #include "project.h"
 #include "selection_controller.h"
+#include "subs_controller.h"
 #include "time_range.h"
 #include "async_video_provider.h"
 #include "utils.h"
 #include "video_frame.h"
 
 #include <libaegisub/ass/time.h>
+#include <libaegisub/log.h>
 
 #include <cmath>
 #include <wx/log.h>
@@ -64,6 +66,8 @@ VideoController::VideoController(agi::Context *c)
 }
 
 void VideoController::OnNewVideoProvider(AsyncVideoProvider *new_provider) {
+	// The old provider may already be gone, so don't tell it playback stopped
+	provider = nullptr;
 	Stop();
 	provider = new_provider;
 	color_matrix = provider ? provider->GetColorSpace() : "";
@@ -81,7 +85,7 @@ void VideoController::OnSubtitlesCommit(int type, const AssDialogue *changed) {
 	}
 
 	if (!changed)
-		provider->LoadSubtitles(context->ass.get());
+		provider->LoadSubtitles(context->subsController->Snapshot());
 	else
 		provider->UpdateSubtitles(context->ass.get(), changed);
 }
@@ -149,8 +153,7 @@ void VideoController::Play() {
 	audio_playback_mode = AudioPlaybackMode::ToEnd;
 	context->audioController->PlayToEnd(start_ms, playback_speed);
 
-	playback_start_time = std::chrono::steady_clock::now();
-	playback.Start(10);
+	StartPlayback();
 }
 
 void VideoController::PlayLine() {
@@ -170,6 +173,14 @@ void VideoController::PlayLine() {
 
 	JumpToFrame(startFrame);
 
+	StartPlayback();
+}
+
+void VideoController::StartPlayback() {
+	stats = VideoPlaybackStats();
+	if (provider)
+		provider->StartPlayback(frame_n, context->project->Timecodes(), OPT_GET("Video/Prefetch Frames")->GetInt());
+
 	playback_start_time = std::chrono::steady_clock::now();
 	playback.Start(10);
 }
@@ -179,9 +190,27 @@ void VideoController::Stop() {
 		playback.Stop();
 		audio_playback_mode = AudioPlaybackMode::NoAudio;
 		context->audioController->Stop();
+
+		if (provider) {
+			provider->StopPlayback();
+			auto s = GetPlaybackStats();
+			LOG_SINK("video/playback", s.dropped ? agi::log::Warning : agi::log::Debug)
+				<< "frames=" << s.shown << " dropped=" << s.dropped
+				<< " prefetch_hits=" << s.prefetch_hits << " prefetch_misses=" << s.prefetch_misses;
+		}
 	}
 }
 
+VideoPlaybackStats VideoController::GetPlaybackStats() const {
+	VideoPlaybackStats s = stats;
+	if (provider) {
+		s.dropped += provider->GetDroppedFrames();
+		s.prefetch_hits = provider->GetPrefetchHits();
+		s.prefetch_misses = provider->GetPrefetchMisses();
+	}
+	return s;
+}
+
 void VideoController::OnPlayTimer(wxTimerEvent &) {
 	using namespace std::chrono;
 	double speed = playback_speed;
@@ -190,12 +219,24 @@ void VideoController::OnPlayTimer(wxTimerEvent &) {
 
 	auto elapsed_ms = duration_cast<milliseconds>(steady_clock::now() - playback_start_time).count();
 	auto target_ms = static_cast<int64_t>(start_ms) + static_cast<int64_t>(std::llround(elapsed_ms * speed));
+
+	// The video follows the wall clock rather than the audio, so record how
+	// far apart they've drifted
+	if (context->audioController->IsPlaying()) {
+		if (auto stats = context->audioController->GetPlaybackStats())
+			stats->RecordDrift(context->audioController->GetPlaybackPosition() - target_ms);
+	}
+
 	int next_frame = FrameAtTime(static_cast<int>(target_ms));
 	if (next_frame == frame_n) return;
 
 	if (next_frame >= end_frame)
 		Stop();
 	else {
+		// Frames the clock has already passed are never shown at all
+		if (next_frame > frame_n + 1)
+			stats.dropped += next_frame - frame_n - 1;
+		++stats.shown;
 		frame_n = next_frame;
 		RequestFrame();
 		Seek(frame_n);
@@ -226,13 +267,16 @@ void VideoController::OnPlaybackSpeedChanged(double new_speed) {
 		case AudioPlaybackMode::NoAudio:
 			break;
 		case AudioPlaybackMode::ToEnd:
-			context->audioController->PlayToEnd(start_ms, playback_speed);
+			// Audio played with a speed changes speed without restarting;
+			// this only restarts it if it had stopped
+			if (!context->audioController->SetPlaybackSpeed(playback_speed))
+				context->audioController->PlayToEnd(start_ms, playback_speed);
 			break;
 		case AudioPlaybackMode::Range:
-			if (start_ms < audio_playback_end_ms)
-				context->audioController->PlayRange(TimeRange(start_ms, audio_playback_end_ms), playback_speed);
-			else
+			if (start_ms >= audio_playback_end_ms)
 				Stop();
+			else if (!context->audioController->SetPlaybackSpeed(playback_speed))
+				context->audioController->PlayRange(TimeRange(start_ms, audio_playback_end_ms), playback_speed);
 			break;
 	}
 }
@@ -31,6 +31,7 @@
 #include <libaegisub/vfr.h>
 
 #include <chrono>
+#include <cstdint>
 #include <set>
 
 #include <wx/timer.h>
@@ -46,6 +47,19 @@ namespace agi {
 	class OptionValue;
 }
 
+/// Counters for the current or most recent video playback
+struct VideoPlaybackStats {
+	/// Frames requested for display
+	uint64_t shown = 0;
+	/// Frames skipped by the clock or replaced by a later frame before they
+	/// could be rendered
+	uint64_t dropped = 0;
+	/// Frame requests answered from frames decoded ahead, and ones which
+	/// had to be decoded on demand
+	uint64_t prefetch_hits = 0;
+	uint64_t prefetch_misses = 0;
+};
+
 enum class AspectRatio {
 	Default = 0,
 	Fullscreen,
@@ -98,6 +112,9 @@ class VideoController final : public wxEvtHandler {
 	/// The last frame to play if video is currently playing
 	int end_frame = 0;
 
+	/// Counters for the current playback which the controller keeps itself
+	VideoPlaybackStats stats;
+
 	/// The frame number which was last requested from the video provider,
 	/// which may not be the same thing as the currently displayed frame
 	int frame_n = 0;
@@ -126,6 +143,9 @@ class VideoController final : public wxEvtHandler {
 
 	void RequestFrame();
 
+	/// Start the playback timer and decoding ahead from the current frame
+	void StartPlayback();
+
 public:
 	VideoController(agi::Context *context);
 
@@ -170,6 +190,9 @@ public:
 	/// Stop playing
 	void Stop();
 
+	/// Get the counters for the current or most recent playback
+	VideoPlaybackStats GetPlaybackStats() const;
+
 	DEFINE_SIGNAL_ADDERS(Seek, AddSeekListener)
 	DEFINE_SIGNAL_ADDERS(ARChange, AddARChangeListener)
 	DEFINE_SIGNAL_ADDERS(PlaybackSpeedChanged, AddPlaybackSpeedListener)
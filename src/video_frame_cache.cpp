@@ -0,0 +1,99 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file video_frame_cache.cpp
+/// @brief Byte-bounded LRU cache of decoded video frames
+/// @ingroup video_input
+
+#include "video_frame_cache.h"
+
+std::vector<unsigned char> VideoFrameCache::EvictOldest() {
+	auto& oldest = lru.back();
+	bytes -= oldest.frame.data.size();
+	index.erase(oldest.frame_number);
+	auto data = std::move(oldest.frame.data);
+	lru.pop_back();
+	return data;
+}
+
+void VideoFrameCache::ShrinkTo(size_t target) {
+	while (lru.size() > 1 && bytes > target)
+		EvictOldest();
+}
+
+bool VideoFrameCache::Get(int n, VideoFrame& out) {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = index.find(n);
+	if (it == index.end()) {
+		++misses;
+		return false;
+	}
+
+	lru.splice(lru.begin(), lru, it->second);
+	out = lru.front().frame;
+	++hits;
+	return true;
+}
+
+void VideoFrameCache::Insert(int n, VideoFrame const& frame) {
+	const size_t size = frame.data.size();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = index.find(n);
+	if (it != index.end()) {
+		bytes -= it->second->frame.data.size();
+		lru.erase(it->second);
+		index.erase(it);
+	}
+
+	// Frames are usually all the same size, so whatever has to be evicted to
+	// make room can give its storage to the new frame
+	std::vector<unsigned char> storage;
+	while (!lru.empty() && bytes + size > max_bytes) {
+		auto evicted = EvictOldest();
+		if (storage.capacity() < size)
+			storage = std::move(evicted);
+	}
+	storage.assign(frame.data.begin(), frame.data.end());
+
+	lru.push_front(Entry{n, VideoFrame{std::move(storage), frame.width, frame.height, frame.pitch, frame.flipped}});
+	index[n] = lru.begin();
+	bytes += size;
+}
+
+void VideoFrameCache::SetMaxSize(size_t new_max) {
+	std::lock_guard<std::mutex> lock(mutex);
+	max_bytes = new_max;
+	ShrinkTo(max_bytes);
+}
+
+void VideoFrameCache::Clear() {
+	std::lock_guard<std::mutex> lock(mutex);
+	lru.clear();
+	index.clear();
+	bytes = 0;
+}
+
+VideoCacheStats VideoFrameCache::GetStats() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	VideoCacheStats stats;
+	stats.hits = hits;
+	stats.misses = misses;
+	stats.frames = lru.size();
+	stats.bytes = bytes;
+	stats.max_bytes = max_bytes;
+	return stats;
+}
@@ -0,0 +1,93 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file video_frame_cache.h
+/// @brief Byte-bounded LRU cache of decoded video frames
+/// @ingroup video_input
+
+#pragma once
+
+#include "include/aegisub/video_provider.h"
+#include "video_frame.h"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/// @class VideoFrameCache
+/// @brief Decoded video frames, dropping the least recently used ones to
+///        stay under a size limit
+///
+/// Frames are kept in a list in order of use, with a hash map from frame
+/// number to list node, so lookups, insertions and evictions don't depend on
+/// how many frames are cached. The size of the frames is tracked exactly and
+/// the cache only goes over the limit when the most recent frame is bigger
+/// than the limit on its own, in which case it's the only frame kept, so
+/// that asking for the same frame again still doesn't decode it. Lowering
+/// the limit evicts frames straight away. A new frame reuses the storage of
+/// a frame evicted to make room for it rather than allocating.
+///
+/// All of the methods lock, so the cache can be used from the decoding
+/// thread while the limit is changed and the counters are read from others.
+class VideoFrameCache {
+	struct Entry {
+		int frame_number;
+		VideoFrame frame;
+	};
+
+	/// Cached frames with the most recently used at the front
+	std::list<Entry> lru;
+	std::unordered_map<int, std::list<Entry>::iterator> index;
+
+	/// Size of the cached frames' pixel data in bytes
+	size_t bytes = 0;
+	size_t max_bytes;
+
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+
+	mutable std::mutex mutex;
+
+	/// Drop the least recently used frame; mutex must be held
+	/// @return The frame's pixel storage, for reuse
+	std::vector<unsigned char> EvictOldest();
+
+	/// Evict frames until they fit in target bytes or only the most recent
+	/// is left; mutex must be held
+	void ShrinkTo(size_t target);
+
+public:
+	/// @param max_bytes Most bytes of frames to hold
+	explicit VideoFrameCache(size_t max_bytes) : max_bytes(max_bytes) { }
+
+	/// @brief Look up a frame and mark it as the most recently used
+	/// @param n        Frame number
+	/// @param[out] out Copy of the frame, if it was cached
+	/// @return Whether the frame was cached
+	bool Get(int n, VideoFrame& out);
+
+	/// Add a frame, evicting others as needed to make room for it
+	void Insert(int n, VideoFrame const& frame);
+
+	/// Change the size limit, evicting frames if the cache is now too big
+	void SetMaxSize(size_t max_bytes);
+
+	/// Drop every cached frame
+	void Clear();
+
+	VideoCacheStats GetStats() const;
+};
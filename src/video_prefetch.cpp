@@ -0,0 +1,87 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file video_prefetch.cpp
+/// @brief Queue of video frames decoded ahead of playback
+/// @ingroup video
+
+#include "video_prefetch.h"
+
+void FramePrefetchQueue::Clear() {
+	discarded += frames.size();
+	frames.clear();
+}
+
+void FramePrefetchQueue::Start(int first, int new_end, size_t new_capacity) {
+	Clear();
+	capacity = new_capacity;
+	end = new_end;
+	next = first;
+	active = true;
+}
+
+void FramePrefetchQueue::Stop() {
+	Clear();
+	active = false;
+}
+
+void FramePrefetchQueue::Invalidate(int from) {
+	if (!IsActive()) return;
+	Clear();
+	next = from;
+}
+
+int FramePrefetchQueue::NextToProduce() const {
+	if (!IsActive() || frames.size() >= capacity || next >= end)
+		return -1;
+	return next;
+}
+
+void FramePrefetchQueue::Push(Frame frame) {
+	next = frame.number + 1;
+	frames.push_back(std::move(frame));
+}
+
+bool FramePrefetchQueue::Take(int number, double time, Frame& out) {
+	if (!IsActive()) return false;
+
+	// Anything before the requested frame was skipped over by playback
+	while (!frames.empty() && frames.front().number < number) {
+		frames.pop_front();
+		++discarded;
+	}
+
+	if (!frames.empty() && frames.front().number == number && frames.front().time == time) {
+		out = std::move(frames.front());
+		frames.pop_front();
+		++hits;
+		return true;
+	}
+
+	// Prefetching has fallen behind or been jumped past, so start again
+	// from the frame after this one rather than producing frames which
+	// would only be thrown away
+	++misses;
+	Clear();
+	next = number + 1;
+	return false;
+}
+
+void FramePrefetchQueue::ResetCounters() {
+	hits = 0;
+	misses = 0;
+	discarded = 0;
+}
@@ -0,0 +1,111 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file video_prefetch.h
+/// @brief Queue of video frames decoded ahead of playback
+/// @ingroup video
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+struct VideoFrame;
+
+/// @class FramePrefetchQueue
+/// @brief Frames decoded and rendered ahead of playback, in presentation order
+///
+/// While playback is running the video worker fills this with the frames
+/// after the one being shown, up to a fixed number of them, whenever it has
+/// nothing else to do. A frame request which finds its frame at the front of
+/// the queue can be answered without decoding anything; frames in front of
+/// it were never shown and are thrown away, and a request which misses
+/// restarts prefetching after the requested frame.
+///
+/// Everything other than the counters must be used only from the worker.
+class FramePrefetchQueue {
+public:
+	struct Frame {
+		/// Frame number
+		int number;
+		/// Presentation time the subtitles were rendered at, in milliseconds
+		double time;
+		std::shared_ptr<VideoFrame> image;
+	};
+
+private:
+	std::deque<Frame> frames;
+	/// Most frames to hold
+	size_t capacity = 0;
+	/// Playback is running, so requests are answered from the queue
+	bool active = false;
+	/// Next frame to produce
+	int next = 0;
+	/// Frame to stop producing at
+	int end = 0;
+
+	std::atomic<uint64_t> hits{0};
+	std::atomic<uint64_t> misses{0};
+	std::atomic<uint64_t> discarded{0};
+
+	void Clear();
+
+public:
+	/// @brief Start prefetching, discarding anything already queued
+	/// @param first    First frame to produce
+	/// @param end      Frame to stop at, which is usually the frame count
+	/// @param capacity Most frames to hold; with 0 nothing is prefetched
+	///                 but requests are still counted as misses
+	void Start(int first, int end, size_t capacity);
+
+	/// Stop prefetching and release the queued frames
+	void Stop();
+
+	/// Discard the queued frames because they no longer look right, and
+	/// produce them again starting from a frame
+	void Invalidate(int from);
+
+	/// Is playback prefetching frames?
+	bool IsActive() const { return active; }
+
+	/// Get the frame to produce next, or -1 if the queue is full, has
+	/// reached the end or isn't active
+	int NextToProduce() const;
+
+	/// Add the frame NextToProduce() asked for
+	void Push(Frame frame);
+
+	/// @brief Take a frame for presentation
+	/// @param number Frame number to take
+	/// @param time   Time the frame needs to have been rendered at
+	/// @param[out] out The frame, if it was queued
+	/// @return Whether the frame was queued
+	bool Take(int number, double time, Frame& out);
+
+	/// Number of frames in the queue
+	size_t Size() const { return frames.size(); }
+
+	/// Requests answered from the queue
+	uint64_t GetHits() const { return hits; }
+	/// Requests which weren't in the queue and had to be decoded on demand
+	uint64_t GetMisses() const { return misses; }
+	/// Frames which were produced but never taken
+	uint64_t GetDiscarded() const { return discarded; }
+	/// Zero the counters
+	void ResetCounters();
+};
@@ -18,22 +18,16 @@
 
 #include "options.h"
 #include "video_frame.h"
+#include "video_frame_cache.h"
 
+#include <libaegisub/log.h>
 #include <libaegisub/make_unique.h>
-
-#include <list>
+#include <libaegisub/signal.h>
 
 namespace {
-/// A video frame and its frame number
-struct CachedFrame {
-	VideoFrame frame;
-	int frame_number;
-
-	CachedFrame(VideoFrame const& frame, int frame_number)
-	: frame(frame), frame_number(frame_number) { }
-
-	CachedFrame(CachedFrame const&) = delete;
-};
+size_t cache_size_option() {
+	return size_t(OPT_GET("Provider/Video/Cache/Size")->GetInt()) << 20; // convert MB to bytes
+}
 
 /// @class VideoProviderCache
 /// @brief A wrapper around a video provider which provides LRU caching
@@ -41,25 +35,29 @@ class VideoProviderCache final : public VideoProvider {
 	/// The source provider to get frames from
 	std::unique_ptr<VideoProvider> master;
 
-	/// @brief Maximum size of the cache in bytes
-	///
-	/// Note that this is a soft limit. The cache stops allocating new frames
-	/// once it has exceeded the limit, but it never tries to shrink
-	const size_t max_cache_size = OPT_GET("Provider/Video/Cache/Size")->GetInt() << 20; // convert MB to bytes
+	/// Recently used frames, up to the size set in the options
+	VideoFrameCache cache{cache_size_option()};
 
-	/// Cache of video frames with the most recently used ones at the front
-	std::list<CachedFrame> cache;
+	agi::signal::Connection size_changed = OPT_SUB("Provider/Video/Cache/Size", [=](agi::OptionValue const&) {
+		cache.SetMaxSize(cache_size_option());
+	});
 
 public:
 	VideoProviderCache(std::unique_ptr<VideoProvider> master) : master(std::move(master)) { }
+	~VideoProviderCache() {
+		auto stats = cache.GetStats();
+		LOG_D("video/provider/cache") << "hits=" << stats.hits << " misses=" << stats.misses;
+	}
 
 	void GetFrame(int n, VideoFrame &frame) override;
 
 	void SetColorSpace(std::string const& m) override {
-		cache.clear();
+		cache.Clear();
 		return master->SetColorSpace(m);
 	}
 
+	VideoCacheStats GetCacheStats() const override { return cache.GetStats(); }
+
 	int GetFrameCount() const override             { return master->GetFrameCount(); }
 	int GetWidth() const override                  { return master->GetWidth(); }
 	int GetHeight() const override                 { return master->GetHeight(); }
@@ -75,27 +73,10 @@ public:
 };
 
 void VideoProviderCache::GetFrame(int n, VideoFrame &out) {
-	size_t total_size = 0;
-
-	for (auto cur = cache.begin(); cur != cache.end(); ++cur) {
-		if (cur->frame_number == n) {
-			cache.splice(cache.begin(), cache, cur); // Move to front
-			out = cache.front().frame;
-			return;
-		}
-
-		total_size += cur->frame.data.size();
-	}
+	if (cache.Get(n, out)) return;
 
 	master->GetFrame(n, out);
-
-	if (total_size >= max_cache_size) {
-		cache.splice(cache.begin(), cache, --cache.end()); // Move last to front
-		cache.front().frame_number = n;
-		cache.front().frame = out;
-	}
-	else
-		cache.emplace_front(out, n);
+	cache.Insert(n, out);
 }
 }
 
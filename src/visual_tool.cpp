@@ -40,7 +40,6 @@
 #include <libaegisub/of_type_adaptor.h>
 #include <libaegisub/split.h>
 
-#include <boost/algorithm/string/join.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/algorithm/string/trim.hpp>
@@ -359,7 +358,7 @@ void VisualTool<FeatureType>::RemoveSelection(FeatureType *feat) {
 typedef const std::vector<AssOverrideParameter> * param_vec;
 
 // Find a tag's parameters in a line or return nullptr if it's not found
-static param_vec find_tag(std::vector<std::unique_ptr<AssDialogueBlock>>& blocks, std::string const& tag_name) {
+static param_vec find_tag(std::vector<std::unique_ptr<const AssDialogueBlock>> const& blocks, std::string const& tag_name) {
 	for (auto ovr : blocks | agi::of_type<AssDialogueBlockOverride>()) {
 		for (auto const& tag : ovr->Tags) {
 			if (tag.Name == tag_name)
@@ -370,6 +369,10 @@ static param_vec find_tag(std::vector<std::unique_ptr<AssDialogueBlock>>& blocks
 	return nullptr;
 }
 
+static param_vec find_tag(std::shared_ptr<const std::vector<std::unique_ptr<const AssDialogueBlock>>> const& blocks, std::string const& tag_name) {
+	return find_tag(*blocks, tag_name);
+}
+
 // Get a Vector2D from the given tag parameters, or Vector2D::Bad() if they are not valid
 static Vector2D vec_or_bad(param_vec tag, size_t x_idx, size_t y_idx) {
 	if (!tag ||
@@ -382,7 +385,7 @@ static Vector2D vec_or_bad(param_vec tag, size_t x_idx, size_t y_idx) {
 }
 
 Vector2D VisualToolBase::GetLinePosition(AssDialogue *diag) {
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->ParseTagsCached();
 
 	if (Vector2D ret = vec_or_bad(find_tag(blocks, "\\pos"), 0, 1)) return ret;
 	if (Vector2D ret = vec_or_bad(find_tag(blocks, "\\move"), 0, 1)) return ret;
@@ -433,12 +436,12 @@ Vector2D VisualToolBase::GetLinePosition(AssDialogue *diag) {
 }
 
 Vector2D VisualToolBase::GetLineOrigin(AssDialogue *diag) {
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->ParseTagsCached();
 	return vec_or_bad(find_tag(blocks, "\\org"), 0, 1);
 }
 
 bool VisualToolBase::GetLineMove(AssDialogue *diag, Vector2D &p1, Vector2D &p2, int &t1, int &t2) {
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->ParseTagsCached();
 
 	param_vec tag = find_tag(blocks, "\\move");
 	if (!tag)
@@ -459,7 +462,7 @@ void VisualToolBase::GetLineRotation(AssDialogue *diag, float &rx, float &ry, fl
 	if (AssStyle *style = c->ass->GetStyle(diag->Style))
 		rz = style->angle;
 
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->ParseTagsCached();
 
 	if (param_vec tag = find_tag(blocks, "\\frx"))
 		rx = tag->front().Get(rx);
@@ -474,7 +477,7 @@ void VisualToolBase::GetLineRotation(AssDialogue *diag, float &rx, float &ry, fl
 void VisualToolBase::GetLineShear(AssDialogue *diag, float& fax, float& fay) {
 	fax = fay = 0.f;
 
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->ParseTagsCached();
 
 	if (param_vec tag = find_tag(blocks, "\\fax"))
 		fax = tag->front().Get(fax);
@@ -490,7 +493,7 @@ void VisualToolBase::GetLineScale(AssDialogue *diag, Vector2D &scale) {
 		y = style->scaley;
 	}
 
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->ParseTagsCached();
 
 	if (param_vec tag = find_tag(blocks, "\\fscx"))
 		x = tag->front().Get(x);
@@ -508,7 +511,7 @@ void VisualToolBase::GetLineOutline(AssDialogue *diag, Vector2D &outline) {
 		y = style->outline_w;
 	}
 
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->ParseTagsCached();
 
 	if (param_vec tag = find_tag(blocks, "\\bord")) {
 		x = tag->front().Get(x);
@@ -530,7 +533,7 @@ void VisualToolBase::GetLineShadow(AssDialogue *diag, Vector2D &shadow) {
 		y = style->shadow_w;
 	}
 
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->ParseTagsCached();
 
 	if (param_vec tag = find_tag(blocks, "\\shad")) {
 		x = tag->front().Get(x);
@@ -549,7 +552,7 @@ int VisualToolBase::GetLineAlignment(AssDialogue *diag) {
 
 	if (AssStyle *style = c->ass->GetStyle(diag->Style))
 		an = style->alignment;
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->ParseTagsCached();
 	if (param_vec tag = find_tag(blocks, "\\an"))
 		an = tag->front().Get(an);
 
@@ -567,13 +570,17 @@ std::pair<Vector2D, Vector2D> VisualToolBase::GetLineBaseExtents(AssDialogue *di
 		style.scaley = 100.;
 	}
 
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->ParseTagsCached();
 	param_vec ptag = find_tag(blocks, "\\p");
 
 	if (ptag && ptag->front().Get(0)) {		// A drawing
 		Spline spline;
 		spline.SetScale(ptag->front().Get(1));
-		std::string drawing_text = join(blocks | agi::of_type<AssDialogueBlockDrawing>() | boost::adaptors::transformed([&](AssDialogueBlock *d) { return d->GetText(); }), "");
+		std::string drawing_text;
+		for (auto const& block : *blocks) {
+			if (block->GetType() == AssBlockType::DRAWING)
+				drawing_text += block->GetText();
+		}
 		spline.DecodeFromAss(drawing_text);
 
 		if (!spline.size())
@@ -625,7 +632,7 @@ std::pair<Vector2D, Vector2D> VisualToolBase::GetLineBaseExtents(AssDialogue *di
 void VisualToolBase::GetLineClip(AssDialogue *diag, Vector2D &p1, Vector2D &p2, bool &inverse) {
 	inverse = false;
 
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->ParseTagsCached();
 	param_vec tag = find_tag(blocks, "\\iclip");
 	if (tag)
 		inverse = true;
@@ -643,7 +650,7 @@ void VisualToolBase::GetLineClip(AssDialogue *diag, Vector2D &p1, Vector2D &p2,
 }
 
 std::string VisualToolBase::GetLineVectorClip(AssDialogue *diag, int &scale, bool &inverse) {
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->ParseTagsCached();
 
 	scale = 1;
 	inverse = false;
@@ -0,0 +1,79 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file waveform_raster.cpp
+/// @brief Rasterizing waveform columns into an RGB buffer
+/// @ingroup audio_ui
+
+#include "waveform_raster.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+void WaveformRaster::Reset(int new_width, int new_height)
+{
+	width = std::max(new_width, 0);
+	height = std::max(new_height, 0);
+	peak_top.assign(width, 0);
+	peak_bottom.assign(width, 0);
+	avg_top.assign(width, 0);
+	avg_bottom.assign(width, 0);
+	row.resize(width);
+	prev_row.resize(width);
+}
+
+void WaveformRaster::Rasterize(const unsigned char (&palette)[4][3], int zero_line, unsigned char *rgb)
+{
+	const int32_t *pt = peak_top.data(), *pb = peak_bottom.data();
+	const int32_t *at = avg_top.data(), *ab = avg_bottom.data();
+	uint8_t *r = row.data();
+	uint8_t *prev = prev_row.data();
+	const ptrdiff_t stride = ptrdiff_t(width) * 3;
+	bool have_prev = false;
+
+	for (int y = 0; y < height; ++y, rgb += stride)
+	{
+		if (y == zero_line)
+		{
+			for (int x = 0; x < width; ++x)
+				memcpy(rgb + x * 3, palette[ZeroLine], 3);
+			have_prev = false;
+			continue;
+		}
+
+		// Written without branches so that the compiler can do several
+		// columns at once
+		for (int x = 0; x < width; ++x)
+		{
+			const uint8_t in_peak = (y >= pt[x]) & (y < pb[x]);
+			const uint8_t in_avg = (y >= at[x]) & (y < ab[x]);
+			r[x] = in_avg ? uint8_t(Average) : in_peak;
+		}
+
+		// Rows far from the middle tend to be the same as the one above
+		if (have_prev && memcmp(r, prev, row.size()) == 0)
+			memcpy(rgb, rgb - stride, stride);
+		else
+		{
+			for (int x = 0; x < width; ++x)
+				memcpy(rgb + x * 3, palette[r[x]], 3);
+		}
+
+		std::swap(r, prev);
+		have_prev = true;
+	}
+}
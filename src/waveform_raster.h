@@ -0,0 +1,79 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file waveform_raster.h
+/// @brief Rasterizing waveform columns into an RGB buffer
+/// @ingroup audio_ui
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/// @class WaveformRaster
+/// @brief The vertical spans of each column of a waveform bitmap
+///
+/// Each column has a span for the peaks and optionally one for the averages
+/// drawn over it, both as half-open ranges of rows from the top. Once all of
+/// the columns have been set the bitmap is written a row at a time, which
+/// is much cheaper than drawing a line per column through a wxDC.
+class WaveformRaster {
+	int width = 0;
+	int height = 0;
+
+	/// First and one past the last row of each column's peak span
+	std::vector<int32_t> peak_top, peak_bottom;
+	/// First and one past the last row of each column's average span
+	std::vector<int32_t> avg_top, avg_bottom;
+	/// Colour index of each pixel in the row being written and the one before
+	std::vector<uint8_t> row, prev_row;
+
+public:
+	/// Colours of the parts of the waveform, as indices into the palette
+	enum Colour : uint8_t {
+		Background,
+		Peak,
+		Average,
+		ZeroLine
+	};
+
+	/// @brief Set the size of the bitmap and clear all of the spans
+	void Reset(int width, int height);
+
+	int GetWidth() const { return width; }
+	int GetHeight() const { return height; }
+
+	/// @brief Set the spans of a column
+	/// @param x           Column to set
+	/// @param peak_top    First row of the peaks
+	/// @param peak_bottom One past the last row of the peaks
+	/// @param avg_top     First row of the averages
+	/// @param avg_bottom  One past the last row of the averages
+	///
+	/// Empty spans draw nothing, and spans are clipped to the bitmap.
+	void SetColumn(int x, int peak_top, int peak_bottom, int avg_top, int avg_bottom) {
+		this->peak_top[x] = peak_top;
+		this->peak_bottom[x] = peak_bottom;
+		this->avg_top[x] = avg_top;
+		this->avg_bottom[x] = avg_bottom;
+	}
+
+	/// @brief Write the waveform to an RGB buffer
+	/// @param palette   RGB triple for each Colour
+	/// @param zero_line Row to draw the zero line on, or -1 for none
+	/// @param rgb       Buffer of width * height RGB triples, written top row first
+	void Rasterize(const unsigned char (&palette)[4][3], int zero_line, unsigned char *rgb);
+};
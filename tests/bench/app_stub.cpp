@@ -0,0 +1,50 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file app_stub.cpp
+/// @brief Stand-ins for the parts of the application the file benchmarks link against
+///
+/// The benchmarks load and save through AssSubtitleFormat, which needs the
+/// SubtitleFormat base class from `src/subtitle_format.cpp`. That can't be
+/// linked in directly as it registers every format, so this provides just
+/// the pieces the ASS format uses.
+
+#include "../../src/subtitle_format.h"
+
+#include <libaegisub/fs.h>
+
+#include <algorithm>
+
+SubtitleFormat::SubtitleFormat(std::string name)
+: name(std::move(name))
+{
+}
+
+bool SubtitleFormat::CanReadFile(agi::fs::path const& filename, std::string const&) const {
+	auto wildcards = GetReadWildcards();
+	return any_of(begin(wildcards), end(wildcards),
+		[&](std::string const& ext) { return agi::fs::HasExtension(filename, ext); });
+}
+
+bool SubtitleFormat::CanWriteFile(agi::fs::path const& filename) const {
+	auto wildcards = GetWriteWildcards();
+	return any_of(begin(wildcards), end(wildcards),
+		[&](std::string const& ext) { return agi::fs::HasExtension(filename, ext); });
+}
+
+bool SubtitleFormat::CanSave(const AssFile *) const {
+	return false;
+}
@@ -0,0 +1,96 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file bench.h
+/// @brief Minimal harness for the aegisub-bench benchmark runner
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench {
+/// Timing state passed to each benchmark
+class State {
+	using clock = std::chrono::steady_clock;
+
+	double min_time;
+	size_t items = 1;
+	std::vector<double> samples;
+
+	bool Done(clock::time_point start) const {
+		if (samples.size() < 3) return false;
+		if (samples.size() >= 10000) return true;
+		return std::chrono::duration<double>(clock::now() - start).count() >= min_time;
+	}
+
+public:
+	explicit State(double min_time) : min_time(min_time) { }
+
+	/// @brief Set how many items each call processes
+	///
+	/// Results are reported both per call and per item, so that workloads
+	/// of different sizes can be compared.
+	void SetItems(size_t count) { items = count; }
+	size_t Items() const { return items; }
+
+	/// Timings of each call, in nanoseconds
+	std::vector<double> const& Samples() const { return samples; }
+
+	/// @brief Time a function
+	/// @param setup Untimed function to call before each timed call
+	/// @param func Function to time
+	template<typename Setup, typename Func>
+	void Run(Setup&& setup, Func&& func) {
+		// Warm up caches and any lazily-initialized state
+		setup();
+		func();
+
+		auto start = clock::now();
+		while (!Done(start)) {
+			setup();
+			auto call_start = clock::now();
+			func();
+			std::chrono::duration<double, std::nano> elapsed = clock::now() - call_start;
+			samples.push_back(elapsed.count());
+		}
+	}
+
+	/// Time a function which needs no per-call setup
+	template<typename Func>
+	void Run(Func&& func) { Run([] { }, std::forward<Func>(func)); }
+};
+
+/// Register a benchmark to be run by aegisub-bench
+/// @param name Name of the benchmark, conventionally "area/operation"
+/// @param func Benchmark function, which should do any setup and then call State::Run
+/// @return true, so that it can be used to initialize a static
+bool Register(std::string name, std::function<void (State&)> func);
+
+/// Prevent the compiler from optimizing away a computed value
+template<typename T>
+void DoNotOptimize(T const& value) {
+#if defined(__GNUC__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile const void *sink;
+	sink = &value;
+#endif
+}
+}
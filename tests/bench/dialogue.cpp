@@ -0,0 +1,267 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file dialogue.cpp
+/// @brief Benchmarks for AssDialogue and loading/saving subtitle files
+
+#include "bench.h"
+#include "workload.h"
+
+#include "../../src/ass_dialogue.h"
+#include "../../src/ass_file.h"
+#include "../../src/options.h"
+#include "../../src/subtitle_format_ass.h"
+
+#include <libaegisub/ass/field_scanner.h>
+#include <libaegisub/ass/time.h>
+#include <libaegisub/fs.h>
+#include <libaegisub/make_unique.h>
+#include <libaegisub/split.h>
+#include <libaegisub/vfr.h>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/intrusive/list.hpp>
+#include <boost/lexical_cast.hpp>
+#include <memory>
+
+namespace {
+using Events = boost::intrusive::make_list<AssDialogue,
+	boost::intrusive::constant_time_size<false>,
+	boost::intrusive::base_hook<AssEntryListHook>>::type;
+
+const size_t line_count = 10000;
+
+void destroy(Events &events) {
+	events.clear_and_dispose([](AssDialogue *e) { delete e; });
+}
+
+struct Fields {
+	int layer;
+	agi::Time start, end;
+	std::string style, actor, effect, text;
+	int margin[3];
+};
+
+/// The agi::Split based tokenizer AssDialogue::Parse used before
+/// agi::ass::FieldScanner, kept for comparison
+void parse_split(std::string const& raw, Fields &out) {
+	agi::StringRange str(raw.begin() + 10, raw.end());
+	auto pos = agi::Split(str, ',');
+	auto next_str_trim = [&] { return agi::str(boost::trim_copy(*pos++)); };
+
+	auto tmp = next_str_trim();
+	out.layer = boost::istarts_with(tmp, "marked=") ? 0 : boost::lexical_cast<int>(tmp);
+	out.start = next_str_trim();
+	out.end = next_str_trim();
+	out.style = next_str_trim();
+	out.actor = next_str_trim();
+	for (int& margin : out.margin)
+		margin = boost::lexical_cast<int>(agi::str(*pos++));
+	out.effect = next_str_trim();
+	out.text.assign((*pos).begin(), str.end());
+}
+
+void parse_scanner(std::string const& raw, Fields &out) {
+	using agi::ass::CharRange;
+	const char *end = raw.data() + raw.size();
+	agi::ass::FieldScanner scanner(raw.data() + 10, end);
+	CharRange field;
+
+	scanner.Next(field);
+	field = agi::ass::Trim(field);
+	if (boost::istarts_with(field, "marked="))
+		out.layer = 0;
+	else
+		agi::ass::ParseInt(field, out.layer);
+	scanner.Next(field);
+	out.start = agi::Time(field.begin(), field.end());
+	scanner.Next(field);
+	out.end = agi::Time(field.begin(), field.end());
+	scanner.Next(field);
+	field = agi::ass::Trim(field);
+	out.style.assign(field.begin(), field.end());
+	scanner.Next(field);
+	field = agi::ass::Trim(field);
+	out.actor.assign(field.begin(), field.end());
+	for (int& margin : out.margin) {
+		scanner.Next(field);
+		agi::ass::ParseInt(field, margin);
+	}
+	scanner.Next(field);
+	field = agi::ass::Trim(field);
+	out.effect.assign(field.begin(), field.end());
+	scanner.Next(field);
+	out.text.assign(field.begin(), end);
+}
+
+Events make_events(size_t count) {
+	Events events;
+	for (auto const& line : bench::MakeDialogueLines(count))
+		events.push_back(*new AssDialogue(line));
+	return events;
+}
+
+/// Temporary file which is deleted when the benchmark finishes
+struct TempFile {
+	agi::fs::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("aegisub-bench-%%%%%%%%.ass");
+	~TempFile() { boost::system::error_code ec; boost::filesystem::remove(path, ec); }
+};
+
+/// Write a generated subtitle file with the given number of lines
+void write_ass_file(TempFile const& file, size_t count) {
+	boost::filesystem::ofstream out(file.path, std::ios::binary);
+	auto contents = bench::MakeAssFile(count);
+	out.write(contents.data(), contents.size());
+}
+
+/// Set up the options the subtitle format reads. This can't happen during
+/// static initialization as creating the options logs.
+void init_options() {
+	static agi::Options options("", R"({
+		"App" : {
+			"Save Charset" : "UTF-8",
+			"Save UI State" : true
+		}
+	})", agi::Options::FLUSH_SKIP);
+	config::opt = &options;
+}
+
+void load(bench::State& state, size_t count) {
+	init_options();
+	TempFile file;
+	write_ass_file(file, count);
+
+	AssSubtitleFormat format;
+	std::unique_ptr<AssFile> subs;
+	state.SetItems(count);
+	state.Run([&] { subs = agi::make_unique<AssFile>(); }, [&] {
+		format.ReadFile(subs.get(), file.path, agi::vfr::Framerate(), "UTF-8");
+	});
+}
+
+void save(bench::State& state, size_t count) {
+	init_options();
+	TempFile in, out;
+	write_ass_file(in, count);
+
+	AssSubtitleFormat format;
+	AssFile subs;
+	format.ReadFile(&subs, in.path, agi::vfr::Framerate(), "UTF-8");
+
+	state.SetItems(count);
+	state.Run([&] {
+		format.WriteFile(&subs, out.path, agi::vfr::Framerate(), "UTF-8");
+	});
+}
+
+void copy(bench::State& state, bool use_arena) {
+	auto src = make_events(line_count);
+	Events copy;
+	state.SetItems(line_count);
+	state.Run([&] { destroy(copy); }, [&] {
+		std::unique_ptr<EntryArena> arena;
+		if (use_arena)
+			arena.reset(new EntryArena(EntryArena::SizeFor<AssDialogue>(line_count)));
+		copy.clone_from(src,
+			[](AssDialogue const& e) { return new AssDialogue(e); },
+			[](AssDialogue *e) { delete e; });
+	});
+	destroy(copy);
+	destroy(src);
+}
+
+void teardown(bench::State& state, bool use_arena) {
+	auto src = make_events(line_count);
+	Events copy;
+	state.SetItems(line_count);
+	state.Run([&] {
+		std::unique_ptr<EntryArena> arena;
+		if (use_arena)
+			arena.reset(new EntryArena(EntryArena::SizeFor<AssDialogue>(line_count)));
+		copy.clone_from(src,
+			[](AssDialogue const& e) { return new AssDialogue(e); },
+			[](AssDialogue *e) { delete e; });
+	}, [&] { destroy(copy); });
+	destroy(src);
+}
+
+const bool registered = [] {
+	bench::Register("dialogue/parse", [](bench::State& state) {
+		auto lines = bench::MakeDialogueLines(line_count);
+		AssDialogue diag;
+		state.SetItems(lines.size());
+		state.Run([&] {
+			for (auto const& line : lines)
+				diag.Parse(line);
+		});
+	});
+
+	bench::Register("dialogue/parse_fields_split", [](bench::State& state) {
+		auto lines = bench::MakeDialogueLines(line_count);
+		Fields fields;
+		state.SetItems(lines.size());
+		state.Run([&] {
+			for (auto const& line : lines)
+				parse_split(line, fields);
+		});
+	});
+
+	bench::Register("dialogue/parse_fields_scanner", [](bench::State& state) {
+		auto lines = bench::MakeDialogueLines(line_count);
+		Fields fields;
+		state.SetItems(lines.size());
+		state.Run([&] {
+			for (auto const& line : lines)
+				parse_scanner(line, fields);
+		});
+	});
+
+	bench::Register("dialogue/get_entry_data", [](bench::State& state) {
+		auto events = make_events(line_count);
+		state.SetItems(line_count);
+		state.Run([&] {
+			for (auto const& line : events)
+				bench::DoNotOptimize(line.GetEntryData());
+		});
+		destroy(events);
+	});
+
+	bench::Register("dialogue/parse_tags", [](bench::State& state) {
+		auto events = make_events(line_count);
+		state.SetItems(line_count);
+		state.Run([&] {
+			for (auto const& line : events)
+				bench::DoNotOptimize(line.ParseTags());
+		});
+		destroy(events);
+	});
+
+	bench::Register("entries/copy", [](bench::State& state) { copy(state, false); });
+	bench::Register("entries/copy_arena", [](bench::State& state) { copy(state, true); });
+	bench::Register("entries/destroy", [](bench::State& state) { teardown(state, false); });
+	bench::Register("entries/destroy_arena", [](bench::State& state) { teardown(state, true); });
+
+	for (auto size : {std::make_pair(1000, "1k"), std::make_pair(10000, "10k"), std::make_pair(100000, "100k")}) {
+		size_t count = size.first;
+		bench::Register(std::string("file/load/") + size.second, [=](bench::State& state) { load(state, count); });
+		bench::Register(std::string("file/save/") + size.second, [=](bench::State& state) { save(state, count); });
+	}
+	return true;
+}();
+}
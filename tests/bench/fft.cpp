@@ -0,0 +1,135 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file fft.cpp
+/// @brief Benchmarks for the FFT used by the spectrum renderer
+
+#include "bench.h"
+
+#include "../../src/fft.h"
+
+#include <cmath>
+#include <string>
+
+#ifdef WITH_FFTW3
+#include <fftw3.h>
+#endif
+
+namespace {
+const float pi = 3.1415926535897932384626433832795f;
+
+/// The complex radix-2 FFT the spectrum renderer used before the real-input
+/// FFT, kept for comparison
+void textbook_fft(size_t n_samples, const float *input, float *output_r, float *output_i) {
+	unsigned bits = 0;
+	while ((size_t(1) << bits) < n_samples) ++bits;
+
+	for (unsigned i = 0; i < n_samples; i++) {
+		unsigned j = 0;
+		for (unsigned b = 0, index = i; b < bits; b++, index >>= 1)
+			j = (j << 1) | (index & 1);
+		output_r[j] = input[i];
+		output_i[j] = 0.0f;
+	}
+
+	unsigned block_end = 1;
+	for (unsigned block_size = 2; block_size <= n_samples; block_size <<= 1) {
+		float delta_angle = 2.0f * pi / (float)block_size;
+		float sm2 = sin(-2 * delta_angle);
+		float sm1 = sin(-delta_angle);
+		float cm2 = cos(-2 * delta_angle);
+		float cm1 = cos(-delta_angle);
+		float w = 2 * cm1;
+
+		for (unsigned i = 0; i < n_samples; i += block_size) {
+			float ar1 = cm1, ar2 = cm2, ai1 = sm1, ai2 = sm2;
+			for (unsigned j = i, n = 0; n < block_end; j++, n++) {
+				unsigned k = j + block_end;
+				float ar0 = w*ar1 - ar2;
+				float ai0 = w*ai1 - ai2;
+				ar2 = ar1;
+				ai2 = ai1;
+				ar1 = ar0;
+				ai1 = ai0;
+
+				float tr = ar0*output_r[k] - ai0*output_i[k];
+				float ti = ar0*output_i[k] + ai0*output_r[k];
+				output_r[k] = output_r[j] - tr;
+				output_i[k] = output_i[j] - ti;
+				output_r[j] += tr;
+				output_i[j] += ti;
+			}
+		}
+		block_end = block_size;
+	}
+}
+
+/// A block of audio like the spectrum renderer transforms
+std::vector<float> make_input(size_t size) {
+	std::vector<float> input(size);
+	for (size_t i = 0; i < size; ++i)
+		input[i] = 0.8f * std::sin(i * (0.01f + i * 1e-7f));
+	return input;
+}
+
+/// Transform sizes used by the spectrum renderer for derivation_size 8 to 12
+const size_t min_derivation_size = 8, max_derivation_size = 12;
+
+const bool registered = [] {
+	for (size_t derivation_size = min_derivation_size; derivation_size <= max_derivation_size; ++derivation_size) {
+		const size_t size = 2 << derivation_size;
+		const std::string suffix = "_" + std::to_string(size);
+
+		bench::Register("spectrum/fft_real" + suffix, [=](bench::State& state) {
+			auto input = make_input(size);
+			std::vector<float> out_r(size / 2 + 1), out_i(size / 2 + 1);
+			FFT fft(size);
+			state.Run([&] {
+				fft.Transform(input.data(), out_r.data(), out_i.data());
+				bench::DoNotOptimize(out_r[1]);
+			});
+		});
+
+		bench::Register("spectrum/fft_textbook" + suffix, [=](bench::State& state) {
+			auto input = make_input(size);
+			std::vector<float> out_r(size), out_i(size);
+			state.Run([&] {
+				textbook_fft(size, input.data(), out_r.data(), out_i.data());
+				bench::DoNotOptimize(out_r[1]);
+			});
+		});
+
+#ifdef WITH_FFTW3
+		bench::Register("spectrum/fftw" + suffix, [=](bench::State& state) {
+			auto input = make_input(size);
+			double *in = fftw_alloc_real(size);
+			fftw_complex *out = fftw_alloc_complex(size / 2 + 1);
+			fftw_plan plan = fftw_plan_dft_r2c_1d(size, in, out, FFTW_MEASURE);
+			for (size_t i = 0; i < size; ++i)
+				in[i] = input[i];
+			state.Run([&] {
+				fftw_execute(plan);
+				bench::DoNotOptimize(out[1][0]);
+			});
+			fftw_destroy_plan(plan);
+			fftw_free(in);
+			fftw_free(out);
+		});
+#endif
+	}
+	return true;
+}();
+}
@@ -0,0 +1,191 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file libaegisub.cpp
+/// @brief Benchmarks for libaegisub text, timing and audio functions
+
+#include "bench.h"
+#include "workload.h"
+
+#include <libaegisub/ass/dialogue_parser.h>
+#include <libaegisub/audio/peak_pyramid.h>
+#include <libaegisub/audio/provider.h>
+#include <libaegisub/character_count.h>
+#include <libaegisub/vfr.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+const size_t line_count = 10000;
+
+/// Audio provider which loops a precomputed second of audio in any sample
+/// format, so that fetching it is about as cheap as from a RAM cache
+template<typename Sample>
+struct SynthAudioProvider final : agi::AudioProvider {
+	std::vector<Sample> data;
+
+	SynthAudioProvider(int channel_count, bool is_float) {
+		channels = channel_count;
+		sample_rate = 48000;
+		num_samples = int64_t(sample_rate) * 60 * 30;
+		decoded_samples = num_samples;
+		bytes_per_sample = sizeof(Sample);
+		float_samples = is_float;
+
+		data.reserve(sample_rate * channels);
+		for (int i = 0; i < sample_rate; ++i) {
+			double v = 0.8 * std::sin(i * (0.01 + i * 1e-7));
+			for (int c = 0; c < channels; ++c)
+				data.push_back(Sample(is_float ? v : v * 32767));
+		}
+	}
+
+	void FillBuffer(void *buf, int64_t start, int64_t count) const override {
+		auto out = static_cast<Sample *>(buf);
+		while (count > 0) {
+			int64_t pos = start % sample_rate;
+			int64_t n = std::min<int64_t>(count, sample_rate - pos);
+			std::copy(&data[pos * channels], &data[(pos + n) * channels], out);
+			out += n * channels;
+			start += n;
+			count -= n;
+		}
+	}
+};
+
+template<typename Sample>
+void int16_mono(bench::State& state, int channels, bool is_float) {
+	SynthAudioProvider<Sample> provider(channels, is_float);
+
+	// About the number of samples needed to draw a 2000 pixel wide waveform
+	// at the default zoom
+	const int64_t count = 48000 * 20;
+	std::vector<int16_t> buf(count);
+	int64_t start = 0;
+	state.SetItems(count);
+	state.Run([&] {
+		provider.GetInt16MonoAudio(buf.data(), start, count);
+		start = (start + count) % (provider.GetNumSamples() - count);
+	});
+}
+
+void frame_at_time(bench::State& state, agi::vfr::Framerate const& fps) {
+	std::mt19937 rng(1);
+	std::uniform_int_distribution<int> time(0, 30 * 60 * 1000);
+	std::vector<int> times(100000);
+	for (auto& t : times) t = time(rng);
+
+	state.SetItems(times.size());
+	state.Run([&] {
+		int sum = 0;
+		for (int t : times)
+			sum += fps.FrameAtTime(t);
+		bench::DoNotOptimize(sum);
+	});
+}
+
+const bool registered = [] {
+	bench::Register("text/character_count", [](bench::State& state) {
+		auto lines = bench::MakeLineText(line_count);
+		state.SetItems(lines.size());
+		state.Run([&] {
+			size_t sum = 0;
+			for (auto const& line : lines)
+				sum += agi::CharacterCount(line, agi::IGNORE_BLOCKS | agi::IGNORE_PUNCTUATION);
+			bench::DoNotOptimize(sum);
+		});
+	});
+
+	bench::Register("text/tokenize_dialogue", [](bench::State& state) {
+		auto lines = bench::MakeLineText(line_count);
+		state.SetItems(lines.size());
+		state.Run([&] {
+			for (auto const& line : lines)
+				bench::DoNotOptimize(agi::ass::TokenizeDialogueBody(line));
+		});
+	});
+
+	bench::Register("vfr/frame_at_time_cfr", [](bench::State& state) {
+		frame_at_time(state, agi::vfr::Framerate(24000, 1001));
+	});
+
+	bench::Register("vfr/frame_at_time_vfr", [](bench::State& state) {
+		// Alternating 24 and 30 fps sections
+		std::vector<int> timecodes;
+		double t = 0;
+		for (int frame = 0; t < 31 * 60 * 1000; ++frame) {
+			timecodes.push_back(int(t));
+			t += (frame / 1000) % 2 ? 1000. / 30 : 1001. / 24;
+		}
+		frame_at_time(state, agi::vfr::Framerate(std::move(timecodes)));
+	});
+
+	bench::Register("audio/int16_mono_from_int16_mono", [](bench::State& state) {
+		int16_mono<int16_t>(state, 1, false);
+	});
+	bench::Register("audio/int16_mono_from_int16_stereo", [](bench::State& state) {
+		int16_mono<int16_t>(state, 2, false);
+	});
+	bench::Register("audio/int16_mono_from_float_stereo", [](bench::State& state) {
+		int16_mono<float>(state, 2, true);
+	});
+	bench::Register("audio/int16_mono_from_double_stereo", [](bench::State& state) {
+		int16_mono<double>(state, 2, true);
+	});
+	bench::Register("audio/int16_mono_from_int32_stereo", [](bench::State& state) {
+		int16_mono<int32_t>(state, 2, false);
+	});
+	bench::Register("audio/int16_mono_from_int16_5.1", [](bench::State& state) {
+		int16_mono<int16_t>(state, 6, false);
+	});
+	bench::Register("audio/int16_mono_from_float_5.1", [](bench::State& state) {
+		int16_mono<float>(state, 6, true);
+	});
+	bench::Register("audio/int16_mono_from_float_7.1", [](bench::State& state) {
+		int16_mono<float>(state, 8, true);
+	});
+	bench::Register("audio/int16_mono_with_volume", [](bench::State& state) {
+		SynthAudioProvider<int16_t> provider(1, false);
+		const int64_t count = 48000 * 20;
+		std::vector<int16_t> buf(count);
+		state.SetItems(count);
+		state.Run([&] {
+			provider.GetInt16MonoAudioWithVolume(buf.data(), 0, count, 0.7);
+		});
+	});
+
+	bench::Register("audio/waveform_peaks_whole_file", [](bench::State& state) {
+		// Peaks for each column of a 2000 pixel wide view of the entire
+		// file, after the first run has built the pyramid
+		SynthAudioProvider<int16_t> provider(1, false);
+		agi::AudioPeakPyramid peaks(&provider);
+		const int columns = 2000;
+		const double column_samples = double(provider.GetNumSamples()) / columns;
+		state.SetItems(columns);
+		state.Run([&] {
+			int sum = 0;
+			for (int x = 0; x < columns; ++x) {
+				auto first = int64_t(x * column_samples);
+				sum += peaks.Get(first, int64_t((x + 1) * column_samples) - first).max;
+			}
+			bench::DoNotOptimize(sum);
+		});
+	});
+	return true;
+}();
+}
@@ -0,0 +1,153 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file main.cpp
+/// @brief Entry point for aegisub-bench
+///
+/// Usage: aegisub-bench [--filter <substring>] [--min-time <seconds>] [--json <file>]
+
+#include "bench.h"
+
+#include <libaegisub/cajun/elements.h>
+#include <libaegisub/cajun/writer.h>
+#include <libaegisub/dispatch.h>
+#include <libaegisub/log.h>
+
+#include <algorithm>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/locale/generator.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <map>
+
+namespace {
+std::map<std::string, std::function<void (bench::State&)>>& registry() {
+	static std::map<std::string, std::function<void (bench::State&)>> benchmarks;
+	return benchmarks;
+}
+
+struct Result {
+	std::string name;
+	size_t iterations;
+	size_t items;
+	double min, median, mean;
+};
+
+Result summarize(std::string const& name, bench::State const& state) {
+	auto samples = state.Samples();
+	std::sort(samples.begin(), samples.end());
+
+	Result r{name, samples.size(), state.Items(), 0, 0, 0};
+	if (samples.empty()) return r;
+
+	r.min = samples.front();
+	r.median = samples[samples.size() / 2];
+	for (auto s : samples) r.mean += s;
+	r.mean /= samples.size();
+	return r;
+}
+
+json::Object to_json(Result const& r) {
+	json::Object obj;
+	obj["name"] = r.name;
+	obj["iterations"] = (json::Integer)r.iterations;
+	obj["items"] = (json::Integer)r.items;
+	obj["min_ns"] = r.min;
+	obj["median_ns"] = r.median;
+	obj["mean_ns"] = r.mean;
+	obj["median_ns_per_item"] = r.median / r.items;
+	return obj;
+}
+
+std::string format_time(double ns) {
+	char buf[32];
+	if (ns >= 1e9)
+		snprintf(buf, sizeof buf, "%.2f s", ns / 1e9);
+	else if (ns >= 1e6)
+		snprintf(buf, sizeof buf, "%.2f ms", ns / 1e6);
+	else if (ns >= 1e3)
+		snprintf(buf, sizeof buf, "%.2f us", ns / 1e3);
+	else
+		snprintf(buf, sizeof buf, "%.1f ns", ns);
+	return buf;
+}
+}
+
+namespace bench {
+bool Register(std::string name, std::function<void (State&)> func) {
+	registry()[std::move(name)] = std::move(func);
+	return true;
+}
+}
+
+int main(int argc, char **argv) {
+	std::string filter, json_path;
+	double min_time = 0.5;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+			filter = argv[++i];
+		else if (!strcmp(argv[i], "--min-time") && i + 1 < argc)
+			min_time = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--json") && i + 1 < argc)
+			json_path = argv[++i];
+		else {
+			fprintf(stderr, "Usage: %s [--filter <substring>] [--min-time <seconds>] [--json <file>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	agi::dispatch::Init([](agi::dispatch::Thunk f) { });
+	std::locale::global(boost::locale::generator().generate(""));
+	// Log messages are discarded, but something has to receive them
+	agi::log::log = new agi::log::LogSink;
+
+	json::Array results;
+	printf("%-36s %10s %12s %12s %14s\n", "benchmark", "iterations", "median", "min", "median/item");
+	for (auto const& bench : registry()) {
+		if (!filter.empty() && bench.first.find(filter) == std::string::npos)
+			continue;
+
+		bench::State state(min_time);
+		bench.second(state);
+		auto r = summarize(bench.first, state);
+		printf("%-36s %10zu %12s %12s %14s\n", r.name.c_str(), r.iterations,
+			format_time(r.median).c_str(), format_time(r.min).c_str(),
+			format_time(r.median / r.items).c_str());
+		fflush(stdout);
+		results.push_back(to_json(r));
+	}
+
+	if (!json_path.empty()) {
+		json::Object root;
+		root["benchmarks"] = std::move(results);
+		root["timestamp"] = (json::Integer)time(nullptr);
+		root["min_time"] = min_time;
+
+		boost::filesystem::ofstream out(json_path);
+		agi::JsonWriter::Write(root, out);
+		if (!out.good()) {
+			fprintf(stderr, "Failed writing %s\n", json_path.c_str());
+			return 1;
+		}
+	}
+
+	delete agi::log::log;
+	return 0;
+}
@@ -0,0 +1,174 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file spectrum.cpp
+/// @brief Benchmarks for drawing spectrum bitmaps from computed blocks
+
+#include "bench.h"
+
+#include "../../src/spectrum_rows.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace {
+/// Size of the palette the audio display's colour schemes use
+const size_t palette_factor = 1 << 12;
+
+/// Blocks of spectrum data for each column of a bitmap, as the renderer
+/// gets them from its cache
+struct Columns {
+	SpectrumRowParams params;
+	int width;
+	std::vector<std::vector<float>> blocks;
+	std::vector<unsigned char> palette;
+	std::vector<unsigned char> image;
+
+	Columns(int width, int height, size_t derivation_size)
+	: width(width)
+	, palette((palette_factor + 1) * 3)
+	, image(size_t(width) * height * 3)
+	{
+		params.height = height;
+		params.derivation_size = derivation_size;
+		params.sample_rate = 48000;
+		params.max_freq = 20000;
+		params.freq_ref = 1000;
+		params.pos_fref = 1.f / 3;
+
+		// Neighbouring columns usually show the same block, so a handful of
+		// distinct ones is representative
+		for (int i = 0; i < 16; ++i) {
+			std::vector<float> block(size_t(1) << derivation_size);
+			for (size_t b = 0; b < block.size(); ++b)
+				block[b] = 0.5f + 0.5f * std::sin(b * 0.05f + i);
+			blocks.push_back(std::move(block));
+		}
+		for (size_t i = 0; i < palette.size(); ++i)
+			palette[i] = (unsigned char)(i * 7);
+	}
+
+	const float *block(int x) const { return blocks[x % blocks.size()].data(); }
+};
+
+/// Drawing a bitmap as the renderer did before the row mapping was
+/// precomputed, with an expf() and a palette lookup for every pixel
+void render_per_pixel(Columns& c) {
+	auto floor_int = [] (float val) { return int(floorf(val)); };
+	auto round_int = [] (float val) { return int(floorf(val + 0.5f)); };
+	auto const& p = c.params;
+	const ptrdiff_t stride = c.width * 3;
+
+	const int nbr_bins = 1 << p.derivation_size;
+	const int minband = 1;
+	const int maxband = std::min(round_int(nbr_bins * p.max_freq / (p.sample_rate * 0.5f)), nbr_bins);
+	const float scale_log = logf(maxband / minband);
+	float b_fref = nbr_bins * p.freq_ref / (p.sample_rate * 0.5f);
+	b_fref = std::min(std::max(b_fref, 1.f), float(maxband - 1));
+	const float clin = minband + (maxband - minband) * p.pos_fref;
+	const float clog = minband * expf(p.pos_fref * scale_log);
+	const float log_ratio_calc = std::min(std::max((b_fref - clin) / (clog - clin), 0.f), 1.f);
+
+	for (int x = 0; x < c.width; ++x) {
+		const float *power = c.block(x);
+		unsigned char *px = c.image.data() + (p.height - 1) * stride + x * 3;
+		float bin_prv = minband, bin_cur = minband;
+		for (int y = 0; y < p.height; ++y) {
+			float bin_nxt = maxband;
+			if (y + 1 < p.height) {
+				const float pos_rel = float(y + 1) / float(p.height);
+				const float b_lin = minband + pos_rel * (maxband - minband);
+				const float b_log = minband * expf(pos_rel * scale_log);
+				bin_nxt = b_lin + log_ratio_calc * (b_log - b_lin);
+			}
+
+			float val;
+			if (bin_nxt - bin_prv < 2) {
+				const int bin_0 = floor_int(bin_cur);
+				const int bin_1 = std::min(bin_0 + 1, nbr_bins - 1);
+				const float frac = bin_cur - float(bin_0);
+				val = power[bin_0] + frac * (power[bin_1] - power[bin_0]);
+			}
+			else {
+				const int bin_inf = std::min(floor_int((bin_prv + bin_cur) * 0.5f), nbr_bins - 2);
+				const int bin_sup = std::min(floor_int((bin_cur + bin_nxt) * 0.5f), nbr_bins - 1);
+				val = *std::max_element(&power[bin_inf], &power[bin_sup]);
+			}
+
+			const size_t index = std::min<size_t>(size_t(val * palette_factor), palette_factor);
+			px[0] = c.palette[index * 3 + 0];
+			px[1] = c.palette[index * 3 + 1];
+			px[2] = c.palette[index * 3 + 2];
+
+			px -= stride;
+			bin_prv = bin_cur;
+			bin_cur = bin_nxt;
+		}
+	}
+}
+
+/// Drawing a bitmap the way AudioSpectrumRenderer::Render() does now
+void render_precomputed(Columns& c, SpectrumRowMap const& map, std::vector<float>& column) {
+	const ptrdiff_t stride = c.width * 3;
+	for (int x = 0; x < c.width; ++x) {
+		map.MapColumn(c.block(x), column.data());
+		MapSpectrumColumn(column.data(), column.size(), 1.f, c.palette.data(), palette_factor,
+			c.image.data() + (c.params.height - 1) * stride + x * 3, -stride);
+	}
+}
+
+const bool registered = [] {
+	struct Size { int width, height; };
+	for (auto size : {Size{1920, 200}, Size{3840, 400}}) {
+		for (size_t derivation_size : {8, 11}) {
+			const std::string suffix = "_" + std::to_string(size.width) + "x" + std::to_string(size.height)
+				+ "_" + std::to_string(derivation_size);
+
+			// Items are columns, so the per-item time is the time per column
+			// and the per-call time is the time per rendered bitmap
+			bench::Register("spectrum/render_per_pixel" + suffix, [=](bench::State& state) {
+				Columns c(size.width, size.height, derivation_size);
+				state.SetItems(size.width);
+				state.Run([&] {
+					render_per_pixel(c);
+					bench::DoNotOptimize(c.image[0]);
+				});
+			});
+
+			bench::Register("spectrum/render_precomputed" + suffix, [=](bench::State& state) {
+				Columns c(size.width, size.height, derivation_size);
+				SpectrumRowMap map(c.params);
+				std::vector<float> column(size.height);
+				state.SetItems(size.width);
+				state.Run([&] {
+					render_precomputed(c, map, column);
+					bench::DoNotOptimize(c.image[0]);
+				});
+			});
+		}
+
+		bench::Register("spectrum/row_map_build_" + std::to_string(size.height), [=](bench::State& state) {
+			Columns c(1, size.height, 11);
+			state.Run([&] {
+				SpectrumRowMap map(c.params);
+				bench::DoNotOptimize(map);
+			});
+		});
+	}
+	return true;
+}();
+}
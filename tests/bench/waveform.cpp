@@ -0,0 +1,61 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file waveform.cpp
+/// @brief Benchmarks for rasterizing waveform bitmaps
+
+#include "bench.h"
+
+#include "../../src/waveform_raster.h"
+
+#include <cmath>
+#include <string>
+
+namespace {
+const unsigned char palette[4][3] = {
+	{0, 0, 0},
+	{40, 80, 120},
+	{80, 160, 240},
+	{255, 255, 255},
+};
+
+const bool registered = [] {
+	// 32 pixels was the width of the cached bitmaps before they were
+	// rasterized directly; 256 is the default now
+	for (int width : {32, 256, 1024}) {
+		for (int height : {100, 400}) {
+			const std::string name = "waveform/rasterize_" + std::to_string(width) + "x" + std::to_string(height);
+			bench::Register(name, [=](bench::State& state) {
+				const int midpoint = height / 2;
+				WaveformRaster raster;
+				std::vector<unsigned char> rgb(size_t(width) * height * 3);
+				state.SetItems(width);
+				state.Run([&] {
+					// Setting the spans is part of rendering each bitmap
+					raster.Reset(width, height);
+					for (int x = 0; x < width; ++x) {
+						const int peak = int(midpoint * std::fabs(std::sin(x * 0.05f)));
+						raster.SetColumn(x, midpoint - peak, midpoint + peak, midpoint - peak / 3, midpoint + peak / 3);
+					}
+					raster.Rasterize(palette, midpoint, rgb.data());
+					bench::DoNotOptimize(rgb[0]);
+				});
+			});
+		}
+	}
+	return true;
+}();
+}
@@ -0,0 +1,128 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include "workload.h"
+
+#include <cstdio>
+#include <random>
+
+namespace {
+const char *words[] = {
+	"the", "of", "and", "to", "in", "is", "you", "that", "it", "he",
+	"was", "for", "on", "are", "as", "with", "his", "they", "I", "at",
+	"be", "this", "have", "from", "or", "one", "had", "by", "word", "but",
+	"not", "what", "all", "were", "we", "when", "your", "can", "said", "there",
+	"\xE3\x81\x82\xE3\x82\x8A\xE3\x81\x8C\xE3\x81\xA8\xE3\x81\x86", "caf\xC3\xA9", "na\xC3\xAFve", "\xC3\xBC" "ber",
+};
+
+const char *styles[] = {"Default", "Alt", "Sign", "Song - JP", "Song - EN"};
+}
+
+namespace bench {
+std::vector<std::string> MakeLineText(size_t count, unsigned seed) {
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<size_t> word(0, sizeof(words) / sizeof(words[0]) - 1);
+	std::uniform_int_distribution<int> length(3, 14);
+	std::uniform_int_distribution<int> percent(0, 99);
+	std::uniform_int_distribution<int> coord(0, 1919);
+
+	std::vector<std::string> ret;
+	ret.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		std::string text;
+		int kind = percent(rng);
+		if (kind < 20) {
+			// Typeset sign
+			char buf[128];
+			snprintf(buf, sizeof buf, "{\\an7\\pos(%d,%d)\\fs%d\\bord2\\c&H%06X&\\blur0.6}",
+				coord(rng), coord(rng) / 2, 20 + coord(rng) % 60, unsigned(rng() & 0xFFFFFF));
+			text = buf;
+		}
+		else if (kind < 30) {
+			// Karaoke
+			int words_left = length(rng);
+			for (int w = 0; w < words_left; ++w) {
+				text += "{\\k" + std::to_string(10 + percent(rng)) + "}";
+				text += words[word(rng)];
+				text += ' ';
+			}
+			ret.push_back(std::move(text));
+			continue;
+		}
+		else if (kind < 35)
+			text = "{\\i1}";
+
+		int words_left = length(rng);
+		for (int w = 0; w < words_left; ++w) {
+			if (w) text += w == words_left / 2 && percent(rng) < 30 ? "\\N" : " ";
+			text += words[word(rng)];
+		}
+		if (percent(rng) < 50) text += percent(rng) < 50 ? "." : ",";
+		ret.push_back(std::move(text));
+	}
+	return ret;
+}
+
+std::vector<std::string> MakeDialogueLines(size_t count, unsigned seed) {
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> duration(800, 6000);
+	std::uniform_int_distribution<int> gap(0, 3000);
+	std::uniform_int_distribution<size_t> style(0, sizeof(styles) / sizeof(styles[0]) - 1);
+
+	auto text = MakeLineText(count, seed);
+	std::vector<std::string> ret;
+	ret.reserve(count);
+
+	int start = 0;
+	for (size_t i = 0; i < count; ++i) {
+		start += gap(rng);
+		int end = start + duration(rng);
+		char buf[256];
+		snprintf(buf, sizeof buf, "Dialogue: %d,%d:%02d:%02d.%02d,%d:%02d:%02d.%02d,%s,%s,0,0,0,,",
+			int(i % 3 == 0),
+			start / 3600000, start / 60000 % 60, start / 1000 % 60, start / 10 % 100,
+			end / 3600000, end / 60000 % 60, end / 1000 % 60, end / 10 % 100,
+			styles[style(rng)], i % 7 == 0 ? "Speaker" : "");
+		ret.push_back(buf + text[i]);
+	}
+	return ret;
+}
+
+std::string MakeAssFile(size_t count, unsigned seed) {
+	std::string file =
+		"\xEF\xBB\xBF[Script Info]\n"
+		"ScriptType: v4.00+\n"
+		"PlayResX: 1920\n"
+		"PlayResY: 1080\n"
+		"\n"
+		"[V4+ Styles]\n"
+		"Format: Name, Fontname, Fontsize, PrimaryColour, SecondaryColour, OutlineColour, BackColour, Bold, Italic, Underline, StrikeOut, ScaleX, ScaleY, Spacing, Angle, BorderStyle, Outline, Shadow, Alignment, MarginL, MarginR, MarginV, Encoding\n";
+	for (auto style : styles) {
+		file += "Style: ";
+		file += style;
+		file += ",Arial,48,&H00FFFFFF,&H000000FF,&H00000000,&H00000000,0,0,0,0,100,100,0,0,1,2,2,2,10,10,10,1\n";
+	}
+	file +=
+		"\n"
+		"[Events]\n"
+		"Format: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text\n";
+	for (auto const& line : MakeDialogueLines(count, seed)) {
+		file += line;
+		file += '\n';
+	}
+	return file;
+}
+}
@@ -0,0 +1,36 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file workload.h
+/// @brief Reproducible synthetic subtitle data for benchmarks
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace bench {
+/// @brief Generate dialogue line bodies resembling typical typeset subtitles
+/// @param count Number of lines
+/// @param seed Random seed; the same seed always produces the same lines
+std::vector<std::string> MakeLineText(size_t count, unsigned seed = 1);
+
+/// Generate complete "Dialogue: " lines in time order
+std::vector<std::string> MakeDialogueLines(size_t count, unsigned seed = 1);
+
+/// Generate the contents of an ASS file with the given number of events
+std::string MakeAssFile(size_t count, unsigned seed = 1);
+}
@@ -0,0 +1,65 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <main.h>
+
+#include "ass_dialogue.h"
+
+#include <type_traits>
+
+TEST(AssDialogue, ParseTagsCached_MatchesParseTags) {
+	AssDialogue dia;
+	dia.Text = "{\\pos(10,20)\\b1}abc{comment}def";
+
+	auto fresh = dia.ParseTags();
+	auto cached = dia.ParseTagsCached();
+	ASSERT_EQ(fresh.size(), cached->size());
+	for (size_t i = 0; i < fresh.size(); ++i) {
+		EXPECT_EQ(fresh[i]->GetType(), (*cached)[i]->GetType());
+		EXPECT_EQ(fresh[i]->GetText(), (*cached)[i]->GetText());
+	}
+}
+
+TEST(AssDialogue, ParseTagsCached_SharedBetweenLinesWithSameText) {
+	AssDialogue a, b;
+	a.Text = "{\\an8}shared text";
+	b.Text = "{\\an8}shared text";
+
+	EXPECT_EQ(a.ParseTagsCached(), b.ParseTagsCached());
+}
+
+TEST(AssDialogue, ParseTagsCached_ReparsesChangedText) {
+	AssDialogue dia;
+	dia.Text = "{\\fs10}before";
+	auto before = dia.ParseTagsCached();
+
+	dia.Text = "{\\fs20}after";
+	auto after = dia.ParseTagsCached();
+
+	EXPECT_NE(before, after);
+	ASSERT_EQ(2u, after->size());
+	EXPECT_EQ("after", (*after)[1]->GetText());
+}
+
+TEST(AssDialogue, ParseTagsCached_BlocksAreConst) {
+	AssDialogue dia;
+	dia.Text = "{\\b1}text";
+	auto cached = dia.ParseTagsCached();
+
+	// The blocks are shared with every other line with the same text, so
+	// callers mustn't be able to change them
+	static_assert(std::is_const<std::remove_reference<decltype(*cached->front())>::type>::value,
+		"cached blocks must be const");
+	EXPECT_EQ("{\\b1}", cached->front()->GetText());
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include <main.h>
+
+#include "ass_dialogue.h"
+#include "ass_entry_arena.h"
+
+#include <thread>
+#include <vector>
+
+TEST(EntryArena, allocations_are_contiguous) {
+	std::vector<char *> ptrs;
+	{
+		EntryArena arena(EntryArena::SizeFor<AssDialogue>(3));
+		for (int i = 0; i < 3; ++i)
+			ptrs.push_back(static_cast<char *>(EntryArena::Allocate(sizeof(AssDialogue))));
+	}
+	EXPECT_EQ(ptrs[1] - ptrs[0], ptrs[2] - ptrs[1]);
+	EXPECT_LT(size_t(ptrs[1] - ptrs[0]), sizeof(AssDialogue) + 2 * EntryArena::overhead);
+	for (auto ptr : ptrs)
+		EntryArena::Free(ptr);
+}
+
+TEST(EntryArena, overflow_falls_back_to_heap) {
+	EntryArena arena(EntryArena::SizeFor<AssDialogue>(1));
+	auto a = EntryArena::Allocate(sizeof(AssDialogue));
+	auto b = EntryArena::Allocate(sizeof(AssDialogue));
+	ASSERT_NE(nullptr, a);
+	ASSERT_NE(nullptr, b);
+	EntryArena::Free(b);
+	EntryArena::Free(a);
+}
+
+TEST(EntryArena, large_arenas_are_split_into_slabs) {
+	const size_t count = 3 * EntryArena::max_slab_size / sizeof(AssDialogue);
+	std::vector<char *> ptrs;
+	{
+		EntryArena arena(EntryArena::SizeFor<AssDialogue>(count));
+		for (size_t i = 0; i < count; ++i)
+			ptrs.push_back(static_cast<char *>(EntryArena::Allocate(sizeof(AssDialogue))));
+	}
+
+	// Each contiguous run of allocations is one slab
+	size_t stride = ptrs[1] - ptrs[0];
+	size_t slabs = 1;
+	char *slab_start = ptrs[0];
+	for (size_t i = 1; i < count; ++i) {
+		if (size_t(ptrs[i] - ptrs[i - 1]) != stride) {
+			++slabs;
+			slab_start = ptrs[i];
+		}
+		EXPECT_LE(size_t(ptrs[i] - slab_start), EntryArena::max_slab_size);
+	}
+	EXPECT_GE(slabs, 3u);
+
+	for (auto ptr : ptrs)
+		EntryArena::Free(ptr);
+}
+
+TEST(EntryArena, entries_outlive_arena) {
+	std::vector<AssDialogue *> lines;
+	{
+		EntryArena arena(EntryArena::SizeFor<AssDialogue>(10));
+		for (int i = 0; i < 10; ++i) {
+			lines.push_back(new AssDialogue);
+			lines.back()->Text = std::to_string(i);
+		}
+	}
+	for (int i = 0; i < 10; ++i)
+		EXPECT_EQ(std::to_string(i), lines[i]->Text.get());
+	for (auto line : lines)
+		delete line;
+}
+
+TEST(EntryArena, entries_can_be_freed_on_other_threads) {
+	std::vector<AssDialogue *> lines;
+	{
+		EntryArena arena(EntryArena::SizeFor<AssDialogue>(100));
+		for (int i = 0; i < 100; ++i)
+			lines.push_back(new AssDialogue);
+	}
+	std::thread t([&] {
+		for (size_t i = 0; i < lines.size(); i += 2)
+			delete lines[i];
+	});
+	for (size_t i = 1; i < lines.size(); i += 2)
+		delete lines[i];
+	t.join();
+}
+
+TEST(EntryArena, nested_arenas) {
+	EntryArena outer(EntryArena::SizeFor<AssDialogue>(1));
+	AssDialogue *inner_line;
+	{
+		EntryArena inner(EntryArena::SizeFor<AssDialogue>(1));
+		inner_line = new AssDialogue;
+	}
+	auto outer_line = new AssDialogue;
+	delete inner_line;
+	delete outer_line;
+}
@@ -0,0 +1,139 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <main.h>
+
+#include "ass_dialogue.h"
+#include "ass_file.h"
+#include "ass_parser.h"
+#include "subtitle_format.h"
+
+#include <libaegisub/format.h>
+#include <libaegisub/make_unique.h>
+
+#include <random>
+
+namespace {
+/// Enough lines for four threads' worth of work
+const size_t line_count = 20000;
+
+std::vector<std::string> make_events(size_t count) {
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<int> dist(0, 9);
+
+	std::vector<std::string> events;
+	events.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		int start = int(i) * 1000;
+		int kind = dist(rng);
+		if (kind == 0)
+			events.push_back(agi::format("Comment: 0,%s,%s,Default,,0,0,0,,comment %d",
+				agi::Time(start).GetAssFormatted(), agi::Time(start + 500).GetAssFormatted(), i));
+		else if (kind == 1)
+			events.push_back(agi::format("Dialogue: Marked=0,%s,%s,Alt,Actor,1,2,3,Effect,ssa line %d",
+				agi::Time(start).GetAssFormatted(), agi::Time(start + 500).GetAssFormatted(), i));
+		else
+			events.push_back(agi::format("Dialogue: %d,%s,%s,Default,,0,0,%d,,{\\b1}line %d\\Nsecond row",
+				kind, agi::Time(start).GetAssFormatted(), agi::Time(start + 2000).GetAssFormatted(), kind * 10, i));
+	}
+	return events;
+}
+
+std::unique_ptr<AssFile> parse(std::vector<std::string> const& events, unsigned threads) {
+	auto file = agi::make_unique<AssFile>();
+	AssParser parser(file.get(), 1, threads);
+	parser.AddLine("[Script Info]");
+	parser.AddLine("ScriptType: v4.00+");
+	parser.AddLine("[Events]");
+	parser.AddLine("Format: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text");
+	for (auto const& event : events)
+		parser.AddLine(event);
+	parser.Finish();
+	return file;
+}
+
+/// Parse the events, returning the file as far as it got and the error
+std::string parse_error(std::vector<std::string> const& events, unsigned threads, std::unique_ptr<AssFile> &file) {
+	file = agi::make_unique<AssFile>();
+	AssParser parser(file.get(), 1, threads);
+	parser.AddLine("[Events]");
+	for (auto const& event : events)
+		parser.AddLine(event);
+	try {
+		parser.Finish();
+	}
+	catch (agi::Exception const& e) {
+		return e.GetMessage();
+	}
+	return "";
+}
+
+void expect_same_lines(AssFile const& serial, AssFile const& parallel, size_t count) {
+	ASSERT_LE(count, serial.Events.size());
+	ASSERT_LE(count, parallel.Events.size());
+
+	auto s = serial.Events.begin(), p = parallel.Events.begin();
+	const int s_first = s->Id, p_first = p->Id;
+	for (size_t i = 0; i < count; ++i, ++s, ++p) {
+		EXPECT_EQ(s->GetEntryData(), p->GetEntryData());
+		EXPECT_EQ(s->Comment, p->Comment);
+		EXPECT_EQ(s->Id - s_first, p->Id - p_first);
+	}
+}
+}
+
+TEST(AssParser, parallel_parse_matches_serial) {
+	auto events = make_events(line_count);
+	auto serial = parse(events, 1);
+	auto parallel = parse(events, 4);
+
+	ASSERT_EQ(line_count, serial->Events.size());
+	ASSERT_EQ(line_count, parallel->Events.size());
+	expect_same_lines(*serial, *parallel, line_count);
+
+	// Lines keep the order they were in the file and get consecutive IDs
+	size_t i = 0;
+	int first_id = parallel->Events.front().Id;
+	for (auto const& line : parallel->Events) {
+		EXPECT_EQ(int(i) * 1000, int(line.Start));
+		EXPECT_EQ(first_id + int(i), line.Id);
+		++i;
+	}
+}
+
+TEST(AssParser, parallel_parse_reports_first_malformed_line) {
+	auto events = make_events(line_count);
+	// Malformed lines in the second and last thread's ranges, with the
+	// last thread's one a different kind of error
+	events[7000] = "Dialogue: 0,0:00:01.00,0:00:02.00";
+	events[19000] = "Dialogue: 0,0:00:01.00,0:00:02.00,Default";
+
+	std::unique_ptr<AssFile> serial, parallel;
+	auto serial_error = parse_error(events, 1, serial);
+	auto parallel_error = parse_error(events, 4, parallel);
+
+	EXPECT_NE("", serial_error);
+	EXPECT_EQ(serial_error, parallel_error);
+	EXPECT_EQ(serial->Events.size(), parallel->Events.size());
+	expect_same_lines(*serial, *parallel, 7000);
+}
+
+TEST(AssParser, small_files_are_parsed_serially) {
+	auto events = make_events(100);
+	events[50] = "Dialogue: 0";
+
+	std::unique_ptr<AssFile> serial, parallel;
+	EXPECT_EQ(parse_error(events, 1, serial), parse_error(events, 4, parallel));
+	expect_same_lines(*serial, *parallel, 50);
+}
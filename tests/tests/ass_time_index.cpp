@@ -0,0 +1,127 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <main.h>
+
+#include "ass_dialogue.h"
+#include "ass_time_index.h"
+
+#include <deque>
+#include <random>
+
+namespace {
+std::deque<AssDialogue> make_lines(std::initializer_list<std::pair<int, int>> times) {
+	std::deque<AssDialogue> lines(times.size());
+	auto it = lines.begin();
+	for (auto const& t : times) {
+		it->Start = t.first;
+		it->End = t.second;
+		++it;
+	}
+	return lines;
+}
+}
+
+TEST(AssTimeIndex, empty) {
+	std::deque<AssDialogue> lines;
+	AssTimeIndex index;
+	index.Build(lines);
+	EXPECT_TRUE(index.IsValid());
+	EXPECT_TRUE(index.At(0).empty());
+	EXPECT_TRUE(index.Overlapping(0, 1000).empty());
+}
+
+TEST(AssTimeIndex, at_uses_half_open_ranges) {
+	auto lines = make_lines({{0, 1000}, {1000, 2000}});
+	AssTimeIndex index;
+	index.Build(lines);
+
+	ASSERT_EQ(1u, index.At(999).size());
+	EXPECT_EQ(&lines[0], index.At(999)[0]);
+	ASSERT_EQ(1u, index.At(1000).size());
+	EXPECT_EQ(&lines[1], index.At(1000)[0]);
+	EXPECT_TRUE(index.At(2000).empty());
+}
+
+TEST(AssTimeIndex, results_are_in_file_order) {
+	auto lines = make_lines({{5000, 9000}, {0, 10000}, {3000, 6000}, {7000, 8000}});
+	AssTimeIndex index;
+	index.Build(lines);
+
+	auto visible = index.At(5500);
+	ASSERT_EQ(3u, visible.size());
+	EXPECT_EQ(&lines[0], visible[0]);
+	EXPECT_EQ(&lines[1], visible[1]);
+	EXPECT_EQ(&lines[2], visible[2]);
+
+	auto overlapping = index.Overlapping(6000, 7001);
+	ASSERT_EQ(3u, overlapping.size());
+	EXPECT_EQ(&lines[0], overlapping[0]);
+	EXPECT_EQ(&lines[1], overlapping[1]);
+	EXPECT_EQ(&lines[3], overlapping[2]);
+}
+
+TEST(AssTimeIndex, matches_linear_scan) {
+	std::deque<AssDialogue> lines(1000);
+	std::mt19937 rng(1);
+	for (auto& line : lines) {
+		int start = rng() % 100000;
+		line.Start = start;
+		line.End = start + rng() % 5000;
+	}
+
+	AssTimeIndex index;
+	index.Build(lines);
+
+	for (int time = 0; time < 110000; time += 97) {
+		std::vector<AssDialogue *> expected;
+		for (auto& line : lines) {
+			if (!(line.Start > time || line.End <= time))
+				expected.push_back(&line);
+		}
+		ASSERT_EQ(expected, index.At(time)) << time;
+	}
+}
+
+TEST(AssTimeIndex, replace) {
+	auto lines = make_lines({{0, 1000}, {500, 1500}});
+	AssTimeIndex index;
+	index.Build(lines);
+
+	AssDialogue same_times(lines[0]);
+	index.Replace(&lines[0], &same_times);
+	EXPECT_TRUE(index.IsValid());
+	EXPECT_EQ(&same_times, index.At(0)[0]);
+
+	// The replaced line can be replaced again
+	AssDialogue same_again(same_times);
+	index.Replace(&same_times, &same_again);
+	EXPECT_TRUE(index.IsValid());
+	EXPECT_EQ(&same_again, index.At(0)[0]);
+
+	AssDialogue new_times(lines[1]);
+	new_times.End = 2000;
+	index.Replace(&lines[1], &new_times);
+	EXPECT_FALSE(index.IsValid());
+}
+
+TEST(AssTimeIndex, positions_are_in_indexed_order) {
+	auto lines = make_lines({{5000, 9000}, {0, 10000}, {3000, 6000}, {7000, 8000}});
+	AssTimeIndex index;
+	index.Build(lines);
+
+	EXPECT_EQ((std::vector<size_t>{0, 1, 2}), index.Positions(5500, 5501));
+	EXPECT_EQ((std::vector<size_t>{0, 1, 3}), index.Positions(6000, 7001));
+	EXPECT_TRUE(index.Positions(10000, 20000).empty());
+}
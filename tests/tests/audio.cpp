@@ -16,13 +16,22 @@
 
 #include <main.h>
 
+#include <libaegisub/audio/decode_ahead.h>
+#include <libaegisub/audio/peak_pyramid.h>
+#include <libaegisub/audio/playback_stats.h>
 #include <libaegisub/audio/provider.h>
+#include <libaegisub/audio/sample_convert.h>
+#include <libaegisub/audio/speech_envelope.h>
 #include <libaegisub/fs.h>
 #include <libaegisub/make_unique.h>
 #include <libaegisub/path.h>
 #include <libaegisub/util.h>
 
 #include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <cmath>
+#include <mutex>
+#include <thread>
 
 namespace bfs = boost::filesystem;
 
@@ -228,6 +237,362 @@ TEST(lagi_audio, hd_cache) {
 		ASSERT_EQ(static_cast<uint16_t>((1 << 22) - 256 + i), buff[i]);
 }
 
+namespace {
+/// Samples per channel in each of the segments the caches decode in
+const int64_t segment_size = 1 << 18;
+
+/// Provider which records the first sample it's asked for, and optionally
+/// holds up everything after the first segment until released
+struct RecordingAudioProvider : TestAudioProvider<> {
+	std::atomic<int64_t>& first_request;
+	std::atomic<bool> *gate;
+
+	RecordingAudioProvider(std::atomic<int64_t>& first_request, std::atomic<bool> *gate = nullptr, int rate = 48000)
+	: TestAudioProvider(30, rate), first_request(first_request), gate(gate) { }
+
+	void FillBuffer(void *buf, int64_t start, int64_t count) const override {
+		int64_t unset = -1;
+		first_request.compare_exchange_strong(unset, start);
+		while (gate && start >= segment_size && !*gate) agi::util::sleep_for(1);
+		TestAudioProvider::FillBuffer(buf, start, count);
+	}
+};
+
+void check_cached_audio(agi::AudioProvider const& provider) {
+	uint16_t buff[512];
+	for (int64_t start : {int64_t(0), segment_size - 256, provider.GetNumSamples() - 512}) {
+		provider.GetAudio(buff, start, 512);
+		for (size_t i = 0; i < 512; ++i)
+			ASSERT_EQ(static_cast<uint16_t>(start + i), buff[i]);
+	}
+}
+}
+
+namespace {
+/// Shared state for GatedAudioProvider
+struct DecodeGate {
+	/// Bit n is set if segment n may be decoded
+	std::atomic<uint64_t> open{0};
+	std::mutex mutex;
+	/// Segments in the order they were first asked for
+	std::vector<int64_t> requested;
+	/// Number of instances of the provider which have been made
+	std::atomic<int> instances{0};
+
+	void Open(uint64_t segments) { open |= segments; }
+
+	/// Wait until a decoder has started on the given segment
+	void WaitFor(int64_t segment) {
+		for (;;) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (std::find(begin(requested), end(requested), segment) != end(requested))
+					return;
+			}
+			agi::util::sleep_for(1);
+		}
+	}
+};
+
+/// Provider which holds up decoding of each segment until it's opened, and
+/// which can be cloned
+struct GatedAudioProvider : TestAudioProvider<> {
+	DecodeGate& gate;
+
+	GatedAudioProvider(DecodeGate& gate) : gate(gate) { ++gate.instances; }
+
+	void FillBuffer(void *buf, int64_t start, int64_t count) const override {
+		const int64_t segment = start / segment_size;
+		{
+			std::lock_guard<std::mutex> lock(gate.mutex);
+			if (std::find(begin(gate.requested), end(gate.requested), segment) == end(gate.requested))
+				gate.requested.push_back(segment);
+		}
+		while (!((gate.open >> segment) & 1)) agi::util::sleep_for(1);
+		TestAudioProvider::FillBuffer(buf, start, count);
+	}
+
+	std::unique_ptr<agi::AudioProvider> Clone() const override {
+		return agi::make_unique<GatedAudioProvider>(gate);
+	}
+};
+
+/// Single-threaded version for tests which care about the order
+struct SerialGatedAudioProvider : GatedAudioProvider {
+	using GatedAudioProvider::GatedAudioProvider;
+	std::unique_ptr<agi::AudioProvider> Clone() const override { return nullptr; }
+};
+
+void check_all_cached_audio(agi::AudioProvider const& provider) {
+	std::vector<uint16_t> buff(segment_size);
+	for (int64_t start = 0; start < provider.GetNumSamples(); start += segment_size) {
+		const int64_t count = std::min(segment_size, provider.GetNumSamples() - start);
+		provider.GetAudio(buff.data(), start, count);
+		for (int64_t i = 0; i < count; ++i)
+			ASSERT_EQ(static_cast<uint16_t>(start + i), buff[i]) << start + i;
+	}
+}
+}
+
+TEST(lagi_audio, ram_cache_prioritized) {
+	DecodeGate gate;
+	auto provider = agi::CreateRAMAudioProvider(agi::make_unique<SerialGatedAudioProvider>(gate));
+
+	// The first segment is already being decoded, so the prioritized one
+	// should come right after it
+	gate.WaitFor(0);
+	provider->Prioritize(10 * segment_size + 100, 1000);
+	gate.Open(1 | 1 << 10);
+	while (!provider->IsRangeDecoded(10 * segment_size, segment_size)) agi::util::sleep_for(0);
+
+	EXPECT_TRUE(provider->IsRangeDecoded(0, segment_size));
+	EXPECT_FALSE(provider->IsRangeDecoded(segment_size, 1));
+	EXPECT_FALSE(provider->IsRangeDecoded(0, 2 * segment_size));
+	EXPECT_EQ(2 * segment_size, provider->GetDecodedSamples());
+
+	// Decoded parts are returned while the rest is silent
+	uint16_t buff[512];
+	provider->GetAudio(buff, 11 * segment_size - 256, 512);
+	for (size_t i = 0; i < 256; ++i)
+		ASSERT_EQ(static_cast<uint16_t>(11 * segment_size - 256 + i), buff[i]);
+	for (size_t i = 256; i < 512; ++i)
+		ASSERT_EQ(0, buff[i]);
+
+	gate.Open(~uint64_t(0));
+	while (provider->GetDecodedSamples() != provider->GetNumSamples()) agi::util::sleep_for(0);
+	check_all_cached_audio(*provider);
+
+	// After the prioritized segment it carries on from there rather than
+	// seeking back
+	ASSERT_GE(gate.requested.size(), 3u);
+	EXPECT_EQ(0, gate.requested[0]);
+	EXPECT_EQ(10, gate.requested[1]);
+	EXPECT_EQ(11, gate.requested[2]);
+}
+
+TEST(lagi_audio, hd_cache_parallel_decoders) {
+	DecodeGate gate;
+	gate.Open(~uint64_t(0));
+	auto provider = agi::CreateHDAudioProvider(agi::make_unique<GatedAudioProvider>(gate), agi::Path().Decode("?temp"));
+	while (provider->GetDecodedSamples() != provider->GetNumSamples()) agi::util::sleep_for(0);
+
+	check_all_cached_audio(*provider);
+	EXPECT_LE(gate.instances, 4);
+	EXPECT_EQ(size_t((provider->GetNumSamples() + segment_size - 1) / segment_size), gate.requested.size());
+}
+
+TEST(lagi_audio, persistent_cache_keeps_prioritized_segments) {
+	auto path = agi::Path().Decode("?temp/persistent_cache_keeps_prioritized_segments.pcmcache");
+	if (agi::fs::FileExists(path)) agi::fs::Remove(path);
+
+	DecodeGate gate;
+	std::unique_ptr<agi::AudioProvider> src = agi::make_unique<SerialGatedAudioProvider>(gate);
+	auto provider = agi::CreatePersistentAudioProvider(src, path);
+	gate.WaitFor(0);
+	provider->Prioritize(10 * segment_size, segment_size);
+	gate.Open(1 | 1 << 10);
+
+	// Close it while the segment after the prioritized one is in progress
+	gate.WaitFor(11);
+	std::thread closer([&] { provider.reset(); });
+	agi::util::sleep_for(50);
+	gate.Open(~uint64_t(0));
+	closer.join();
+
+	DecodeGate second_gate;
+	second_gate.Open(~uint64_t(0));
+	src = agi::make_unique<SerialGatedAudioProvider>(second_gate);
+	provider = agi::CreatePersistentAudioProvider(src, path);
+	while (provider->GetDecodedSamples() != provider->GetNumSamples()) agi::util::sleep_for(0);
+	check_all_cached_audio(*provider);
+
+	// Only the segments which weren't finished before are decoded again
+	for (int64_t segment : second_gate.requested) {
+		EXPECT_NE(0, segment);
+		EXPECT_NE(10, segment);
+		EXPECT_NE(11, segment);
+	}
+	EXPECT_EQ(1, second_gate.requested.front());
+
+	provider.reset();
+	agi::fs::Remove(path);
+}
+
+namespace {
+/// Stereo provider which counts how many times it's been cloned
+struct StereoAudioProvider : TestAudioProvider<int16_t> {
+	std::atomic<int> *clones;
+
+	StereoAudioProvider(std::atomic<int> *clones) : TestAudioProvider(30), clones(clones) {
+		channels = 2;
+	}
+
+	void FillBuffer(void *buf, int64_t start, int64_t count) const override {
+		auto out = static_cast<int16_t *>(buf);
+		for (int64_t end = start + count; start < end; ++start) {
+			*out++ = (int16_t)(start & 0x3fff);
+			*out++ = (int16_t)(start & 0x3fff);
+		}
+	}
+
+	std::unique_ptr<agi::AudioProvider> Clone() const override {
+		if (!clones) return nullptr;
+		++*clones;
+		return agi::make_unique<StereoAudioProvider>(clones);
+	}
+};
+
+void check_stereo_audio(agi::AudioProvider const& provider) {
+	int16_t mono[512], stereo[1024];
+	for (int64_t start : {int64_t(0), segment_size - 256, provider.GetNumSamples() - 512}) {
+		provider.GetInt16MonoAudio(mono, start, 512);
+		provider.GetAudio(stereo, start, 512);
+		for (size_t i = 0; i < 512; ++i) {
+			ASSERT_EQ((int16_t)((start + i) & 0x3fff), mono[i]);
+			ASSERT_EQ((int16_t)((start + i) & 0x3fff), stereo[i * 2]);
+			ASSERT_EQ((int16_t)((start + i) & 0x3fff), stereo[i * 2 + 1]);
+		}
+	}
+}
+}
+
+TEST(lagi_audio, ram_cache_compact_display_stream) {
+	std::atomic<int> clones{0};
+	auto provider = agi::CreateRAMAudioProvider(agi::make_unique<StereoAudioProvider>(&clones));
+	EXPECT_EQ(2, provider->GetChannels());
+	while (provider->GetDecodedSamples() != provider->GetNumSamples()) agi::util::sleep_for(0);
+
+	// Only the 16-bit mono stream is cached, and playback is decoded from a
+	// clone of the source
+	auto usage = provider->GetCacheUsage();
+	EXPECT_EQ(provider->GetNumSamples() * 2, usage.display);
+	EXPECT_EQ(0, usage.playback);
+	EXPECT_TRUE(usage.in_memory);
+	EXPECT_GE(clones, 1);
+	check_stereo_audio(*provider);
+}
+
+TEST(lagi_audio, hd_cache_full_format_without_clone) {
+	auto provider = agi::CreateHDAudioProvider(agi::make_unique<StereoAudioProvider>(nullptr), agi::Path().Decode("?temp"));
+	while (provider->GetDecodedSamples() != provider->GetNumSamples()) agi::util::sleep_for(0);
+
+	// Without a second instance of the source everything has to be cached
+	auto usage = provider->GetCacheUsage();
+	EXPECT_EQ(0, usage.display);
+	EXPECT_EQ(provider->GetNumSamples() * 4, usage.playback);
+	EXPECT_FALSE(usage.in_memory);
+	check_stereo_audio(*provider);
+}
+
+TEST(lagi_audio, persistent_cache_compact_reused) {
+	auto path = agi::Path().Decode("?temp/persistent_cache_compact_reused.pcmcache");
+	if (agi::fs::FileExists(path)) agi::fs::Remove(path);
+
+	std::atomic<int> clones{0};
+	std::unique_ptr<agi::AudioProvider> src = agi::make_unique<StereoAudioProvider>(&clones);
+	auto provider = agi::CreatePersistentAudioProvider(src, path);
+	while (provider->GetDecodedSamples() != provider->GetNumSamples()) agi::util::sleep_for(0);
+	// Header, samples and a byte of bitmap
+	EXPECT_EQ(64 + provider->GetNumSamples() * 2 + 1, (int64_t)agi::fs::Size(path));
+	check_stereo_audio(*provider);
+	provider.reset();
+
+	// The complete display stream is reused, and the source itself is kept
+	// for playback rather than being cloned
+	clones = 0;
+	src = agi::make_unique<StereoAudioProvider>(&clones);
+	provider = agi::CreatePersistentAudioProvider(src, path);
+	EXPECT_FALSE(src);
+	EXPECT_EQ(provider->GetNumSamples(), provider->GetDecodedSamples());
+	EXPECT_EQ(provider->GetNumSamples() * 2, provider->GetCacheUsage().display);
+	EXPECT_EQ(0, clones);
+	check_stereo_audio(*provider);
+
+	provider.reset();
+	agi::fs::Remove(path);
+}
+
+TEST(lagi_audio, persistent_cache_reused) {
+	auto path = agi::Path().Decode("?temp/persistent_cache_reused.pcmcache");
+	if (agi::fs::FileExists(path)) agi::fs::Remove(path);
+
+	std::atomic<int64_t> first_request{-1};
+	std::unique_ptr<agi::AudioProvider> src = agi::make_unique<RecordingAudioProvider>(first_request);
+	auto provider = agi::CreatePersistentAudioProvider(src, path);
+	EXPECT_FALSE(src);
+	while (provider->GetDecodedSamples() != provider->GetNumSamples()) agi::util::sleep_for(0);
+	check_cached_audio(*provider);
+	EXPECT_EQ(0, first_request);
+	provider.reset();
+
+	// A complete cache shouldn't touch the source at all
+	first_request = -1;
+	src = agi::make_unique<RecordingAudioProvider>(first_request);
+	provider = agi::CreatePersistentAudioProvider(src, path);
+	EXPECT_FALSE(src);
+	EXPECT_EQ(provider->GetNumSamples(), provider->GetDecodedSamples());
+	check_cached_audio(*provider);
+	EXPECT_EQ(-1, first_request);
+
+	provider.reset();
+	agi::fs::Remove(path);
+}
+
+TEST(lagi_audio, persistent_cache_resumes) {
+	auto path = agi::Path().Decode("?temp/persistent_cache_resumes.pcmcache");
+	if (agi::fs::FileExists(path)) agi::fs::Remove(path);
+
+	std::atomic<int64_t> first_request{-1};
+	std::atomic<bool> gate{false};
+	std::unique_ptr<agi::AudioProvider> src = agi::make_unique<RecordingAudioProvider>(first_request, &gate);
+	auto provider = agi::CreatePersistentAudioProvider(src, path);
+	while (provider->GetDecodedSamples() < segment_size) agi::util::sleep_for(0);
+
+	// Close it while the second segment is still being decoded
+	std::thread closer([&] { provider.reset(); });
+	agi::util::sleep_for(50);
+	gate = true;
+	closer.join();
+
+	// Resuming counts as using the cache, so that cleaning up the cache
+	// directory afterwards won't delete it
+	auto old_time = time(nullptr) - 3600;
+	boost::filesystem::last_write_time(path, old_time);
+
+	first_request = -1;
+	src = agi::make_unique<RecordingAudioProvider>(first_request);
+	provider = agi::CreatePersistentAudioProvider(src, path);
+	EXPECT_GT(agi::fs::ModifiedTime(path), old_time);
+	while (provider->GetDecodedSamples() != provider->GetNumSamples()) agi::util::sleep_for(0);
+	EXPECT_GE(first_request, segment_size);
+	check_cached_audio(*provider);
+
+	provider.reset();
+	agi::fs::Remove(path);
+}
+
+TEST(lagi_audio, persistent_cache_format_change) {
+	auto path = agi::Path().Decode("?temp/persistent_cache_format_change.pcmcache");
+	if (agi::fs::FileExists(path)) agi::fs::Remove(path);
+
+	std::atomic<int64_t> first_request{-1};
+	std::unique_ptr<agi::AudioProvider> src = agi::make_unique<RecordingAudioProvider>(first_request);
+	auto provider = agi::CreatePersistentAudioProvider(src, path);
+	while (provider->GetDecodedSamples() != provider->GetNumSamples()) agi::util::sleep_for(0);
+	provider.reset();
+
+	first_request = -1;
+	src = agi::make_unique<RecordingAudioProvider>(first_request, nullptr, 44100);
+	provider = agi::CreatePersistentAudioProvider(src, path);
+	while (provider->GetDecodedSamples() != provider->GetNumSamples()) agi::util::sleep_for(0);
+	EXPECT_EQ(44100, provider->GetSampleRate());
+	EXPECT_EQ(0, first_request);
+	check_cached_audio(*provider);
+
+	provider.reset();
+	agi::fs::Remove(path);
+}
+
 TEST(lagi_audio, convert_8bit) {
 	auto provider = agi::CreateConvertAudioProvider(agi::make_unique<TestAudioProvider<uint8_t>>());
 
@@ -551,4 +916,524 @@ TEST(lagi_audio, wave64_truncated) {
 	}
 
 	agi::fs::Remove(path);
-}
\ No newline at end of file
+}
+namespace {
+agi::AudioPeak brute_force_peak(agi::AudioProvider const& provider, int64_t start, int64_t count) {
+	std::vector<int16_t> buff(count);
+	provider.GetInt16MonoAudio(buff.data(), start, count);
+
+	agi::AudioPeak ret;
+	int64_t sum_min = 0, sum_max = 0;
+	for (auto sample : buff) {
+		ret.min = std::min(ret.min, sample);
+		ret.max = std::max(ret.max, sample);
+		(sample > 0 ? sum_max : sum_min) += sample;
+	}
+	ret.avg_min = sum_min / count;
+	ret.avg_max = sum_max / count;
+	return ret;
+}
+}
+
+TEST(lagi_audio, peak_pyramid_matches_samples) {
+	TestAudioProvider<> provider(10);
+	provider.bias = 12345;
+	agi::AudioPeakPyramid pyramid(&provider);
+
+	// Bucket-aligned ranges at every level, including ones which span chunks
+	for (int64_t count : {256, 512, 4096, 65536, 65536 * 3}) {
+		for (int64_t start : {int64_t(0), count, 3 * count, 200000 / count * count}) {
+			auto expected = brute_force_peak(provider, start, count);
+			auto actual = pyramid.Get(start, count);
+			ASSERT_EQ(expected.min, actual.min) << start << " " << count;
+			ASSERT_EQ(expected.max, actual.max) << start << " " << count;
+			ASSERT_NEAR(expected.avg_min, actual.avg_min, 16) << start << " " << count;
+			ASSERT_NEAR(expected.avg_max, actual.avg_max, 16) << start << " " << count;
+		}
+	}
+}
+
+TEST(lagi_audio, peak_pyramid_out_of_range) {
+	TestAudioProvider<> provider(1);
+	provider.bias = 1000;
+	agi::AudioPeakPyramid pyramid(&provider);
+
+	auto peak = pyramid.Get(provider.GetNumSamples() + 65536, 1024);
+	EXPECT_EQ(0, peak.min);
+	EXPECT_EQ(0, peak.max);
+
+	peak = pyramid.Get(-512, 1024);
+	EXPECT_EQ(brute_force_peak(provider, 0, 512).max, peak.max);
+}
+
+TEST(lagi_audio, peak_pyramid_waits_for_decoding) {
+	struct PartialProvider : TestAudioProvider<> {
+		PartialProvider() : TestAudioProvider(1) { bias = 1000; decoded_samples = 0; }
+		void Decode(int64_t count) { decoded_samples = count; }
+		void FillBuffer(void *buf, int64_t start, int64_t count) const override {
+			TestAudioProvider::FillBuffer(buf, start, count);
+			auto out = static_cast<uint16_t *>(buf);
+			for (int64_t i = std::max<int64_t>(0, decoded_samples - start); i < count; ++i)
+				out[i] = 0;
+		}
+	} provider;
+	agi::AudioPeakPyramid pyramid(&provider);
+
+	EXPECT_EQ(0, pyramid.Get(0, 65536).max);
+
+	provider.Decode(1024);
+	EXPECT_EQ(1000 + 1023, pyramid.Get(0, 65536).max);
+
+	provider.Decode(provider.GetNumSamples());
+	EXPECT_EQ(SHRT_MAX, pyramid.Get(0, 65536).max);
+}
+
+TEST(lagi_audio, peak_pyramid_built_as_decoded) {
+	struct ListeningProvider : TestAudioProvider<> {
+		DecodedFunc listener;
+		mutable int reads = 0;
+		ListeningProvider() : TestAudioProvider(10) { bias = 1000; }
+		void SetDecodedListener(DecodedFunc func) override { listener = std::move(func); }
+		void FillBuffer(void *buf, int64_t start, int64_t count) const override {
+			++reads;
+			TestAudioProvider::FillBuffer(buf, start, count);
+		}
+	} provider;
+
+	{
+		agi::AudioPeakPyramid pyramid(&provider);
+		ASSERT_TRUE(!!provider.listener);
+
+		// Only the whole chunks within the range are built
+		provider.listener(65536, 65536 * 2 + 100);
+		EXPECT_EQ(2, provider.reads);
+
+		// Querying them doesn't read anything more
+		auto expected = brute_force_peak(provider, 65536, 65536 * 2);
+		provider.reads = 0;
+		EXPECT_EQ(expected.max, pyramid.Get(65536, 65536 * 2).max);
+		EXPECT_EQ(0, provider.reads);
+
+		// The partial chunk at the end is built once it's all decoded
+		const int64_t last_chunk = provider.GetNumSamples() / 65536 * 65536;
+		provider.listener(last_chunk - 65536, provider.GetNumSamples() - last_chunk + 65536);
+		EXPECT_EQ(2, provider.reads);
+	}
+	EXPECT_FALSE(provider.listener);
+}
+
+namespace {
+template<typename Float>
+int16_t reference_float_to_int16(Float sample) {
+	Float expanded = sample * 32768;
+	return expanded < -32768 ? -32768 : expanded > 32767 ? 32767 : static_cast<int16_t>(expanded);
+}
+
+template<typename Float>
+void test_float_kernel() {
+	// Odd length so that both the vector loop and the tail are used
+	std::vector<Float> src(1001);
+	for (size_t i = 0; i < src.size(); ++i)
+		src[i] = (Float)((int)(i * 7919 % 1001) - 500) / 400;
+	src[0] = -1;
+	src[1] = (Float)32767 / 32768;
+	src[2] = (Float)-32767.5 / 32768;
+
+	std::vector<int16_t> dst(src.size());
+	agi::ConvertSamplesToInt16(src.data(), dst.data(), src.size(), sizeof(Float), true);
+	for (size_t i = 0; i < src.size(); ++i)
+		ASSERT_EQ(reference_float_to_int16(src[i]), dst[i]) << i;
+	EXPECT_EQ(SHRT_MIN, dst[0]);
+	EXPECT_EQ(SHRT_MAX, dst[1]);
+	EXPECT_EQ(-32767, dst[2]);
+}
+}
+
+TEST(lagi_audio, convert_float_kernel) {
+	test_float_kernel<float>();
+}
+
+TEST(lagi_audio, convert_double_kernel) {
+	test_float_kernel<double>();
+}
+
+TEST(lagi_audio, convert_int_kernels) {
+	std::vector<uint8_t> u8(1001);
+	for (size_t i = 0; i < u8.size(); ++i)
+		u8[i] = (uint8_t)(i * 37);
+	std::vector<int16_t> dst(u8.size());
+	agi::ConvertSamplesToInt16(u8.data(), dst.data(), u8.size(), 1, false);
+	for (size_t i = 0; i < u8.size(); ++i)
+		ASSERT_EQ((u8[i] - 128) * 256, dst[i]) << i;
+
+	std::vector<int32_t> s32(1001);
+	for (size_t i = 0; i < s32.size(); ++i)
+		s32[i] = (int32_t)(i * 2654435761u);
+	agi::ConvertSamplesToInt16(s32.data(), dst.data(), s32.size(), 4, false);
+	for (size_t i = 0; i < s32.size(); ++i)
+		ASSERT_EQ((int16_t)(s32[i] >> 16), dst[i]) << i;
+
+	// 24-bit samples are packed, so check that each one is read from the right place
+	std::vector<uint8_t> s24(1001 * 3);
+	for (size_t i = 0; i < s24.size(); ++i)
+		s24[i] = (uint8_t)(i * 101);
+	agi::ConvertSamplesToInt16(s24.data(), dst.data(), 1001, 3, false);
+	for (size_t i = 0; i < 1001; ++i)
+		ASSERT_EQ((int16_t)(s24[i * 3 + 1] | s24[i * 3 + 2] << 8), dst[i]) << i;
+}
+
+TEST(lagi_audio, downmix_kernel) {
+	for (int channels = 1; channels <= 9; ++channels) {
+		SCOPED_TRACE(channels);
+		const size_t frames = 333;
+		std::vector<int16_t> src(frames * channels);
+		for (size_t i = 0; i < src.size(); ++i)
+			src[i] = (int16_t)(i * 40503);
+		src[0] = SHRT_MIN;
+		src[channels - 1] = SHRT_MIN;
+
+		std::vector<int16_t> dst(frames);
+		agi::DownmixInt16(src.data(), dst.data(), frames, channels);
+		for (size_t i = 0; i < frames; ++i) {
+			int sum = 0;
+			for (int c = 0; c < channels; ++c)
+				sum += src[i * channels + c];
+			ASSERT_EQ(sum / channels, dst[i]) << i;
+		}
+
+		agi::DownmixInt16(src.data(), src.data(), frames, channels);
+		for (size_t i = 0; i < frames; ++i)
+			ASSERT_EQ(dst[i], src[i]) << i;
+	}
+}
+
+TEST(lagi_audio, scale_kernel) {
+	std::vector<int16_t> src(1001);
+	for (size_t i = 0; i < src.size(); ++i)
+		src[i] = (int16_t)(i * 40503);
+
+	for (double volume : {0.0, 0.3, 1.7, 4.0}) {
+		SCOPED_TRACE(volume);
+		for (bool round : {false, true}) {
+			auto buf = src;
+			agi::ScaleInt16(buf.data(), buf.size(), volume, round);
+			for (size_t i = 0; i < src.size(); ++i) {
+				int expected = agi::util::mid(-0x8000, (int)(src[i] * volume + (round ? 0.5 : 0.0)), 0x7FFF);
+				ASSERT_EQ(expected, buf[i]) << i;
+			}
+		}
+	}
+}
+
+TEST(lagi_audio, multichannel_float_downmix) {
+	struct AudioProvider : agi::AudioProvider {
+		AudioProvider() {
+			channels = 6;
+			num_samples = 90 * 48000;
+			decoded_samples = num_samples;
+			sample_rate = 48000;
+			bytes_per_sample = sizeof(float);
+			float_samples = true;
+		}
+
+		void FillBuffer(void *buf, int64_t start, int64_t count) const override {
+			auto out = static_cast<float *>(buf);
+			for (int64_t end = start + count; start < end; ++start) {
+				for (int c = 0; c < channels; ++c)
+					*out++ = (float)((start * 6 + c) % 2001 - 1000) / 1000;
+			}
+		}
+	} provider;
+
+	// Long enough to be converted in more than one block
+	std::vector<int16_t> samples(10000);
+	provider.GetInt16MonoAudio(samples.data(), 12345, samples.size());
+	std::vector<float> frame(6);
+	for (size_t i = 0; i < samples.size(); ++i) {
+		provider.GetAudio(frame.data(), 12345 + i, 1);
+		int sum = 0;
+		for (float sample : frame)
+			sum += reference_float_to_int16(sample);
+		ASSERT_EQ(sum / 6, samples[i]) << i;
+	}
+}
+
+namespace {
+/// Read count frames from a decode-ahead buffer, waiting for the decoder
+/// whenever it runs dry
+template<typename Sample>
+std::vector<Sample> read_ahead(agi::DecodeAheadBuffer& buffer, int64_t count, int64_t piece = 333) {
+	std::vector<Sample> out(count * buffer.GetFrameSize() / sizeof(Sample));
+	int64_t done = 0;
+	while (done < count) {
+		const int64_t got = buffer.Read(&out[done * buffer.GetFrameSize() / sizeof(Sample)], std::min(piece, count - done));
+		if (!got) agi::util::sleep_for(1);
+		done += got;
+	}
+	return out;
+}
+}
+
+TEST(lagi_audio, decode_ahead_reads_in_order) {
+	TestAudioProvider<> provider;
+	// 20 ms of lead is less than the amount read, so the ring wraps
+	agi::DecodeAheadBuffer buffer(&provider, false, 20);
+	buffer.Start(1000, 1000 + 48000, 0);
+
+	auto samples = read_ahead<uint16_t>(buffer, 48000);
+	for (size_t i = 0; i < samples.size(); ++i)
+		ASSERT_EQ(static_cast<uint16_t>(1000 + i), samples[i]) << i;
+
+	// Nothing past the end, and reaching it isn't an underrun
+	uint16_t extra[10];
+	EXPECT_EQ(0, buffer.Read(extra, 10));
+	EXPECT_EQ(1000 + 48000, buffer.GetReadPosition());
+}
+
+TEST(lagi_audio, decode_ahead_prefill_and_underrun) {
+	std::atomic<int64_t> first_request{-1};
+	std::atomic<bool> gate{false};
+	RecordingAudioProvider provider(first_request, &gate);
+	agi::PlaybackStats stats(48000);
+	agi::DecodeAheadBuffer buffer(&provider, false, 100, &stats);
+
+	// The prefill is decoded before Start returns, but the decoder is then
+	// held up, so asking for more than that is an underrun
+	buffer.Start(segment_size - 100, segment_size + 1000, 100);
+	uint16_t buff[200];
+	EXPECT_EQ(100, buffer.Read(buff, 100));
+	EXPECT_EQ(0u, stats.Get().underruns);
+	for (size_t i = 0; i < 100; ++i)
+		ASSERT_EQ(static_cast<uint16_t>(segment_size - 100 + i), buff[i]);
+
+	EXPECT_EQ(0, buffer.Read(buff, 200));
+	EXPECT_EQ(1u, stats.Get().underruns);
+
+	gate = true;
+	auto rest = read_ahead<uint16_t>(buffer, 1000);
+	for (size_t i = 0; i < rest.size(); ++i)
+		ASSERT_EQ(static_cast<uint16_t>(segment_size + i), rest[i]) << i;
+}
+
+TEST(lagi_audio, decode_ahead_restart) {
+	TestAudioProvider<> provider;
+	agi::DecodeAheadBuffer buffer(&provider, false, 50);
+	buffer.Start(0, 48000, 1000);
+	read_ahead<uint16_t>(buffer, 500);
+
+	// Whatever was buffered for the old range is thrown away
+	buffer.Start(20000, 48000, 1000);
+	auto samples = read_ahead<uint16_t>(buffer, 5000);
+	for (size_t i = 0; i < samples.size(); ++i)
+		ASSERT_EQ(static_cast<uint16_t>(20000 + i), samples[i]) << i;
+
+	buffer.Stop();
+	uint16_t buff[10];
+	EXPECT_EQ(0, buffer.Read(buff, 10));
+}
+
+TEST(lagi_audio, decode_ahead_end_position) {
+	TestAudioProvider<> provider;
+	agi::DecodeAheadBuffer buffer(&provider, false, 100);
+	buffer.Start(0, 10000, 4000);
+
+	// Moving the end back cuts off audio which was already decoded
+	buffer.SetEndPosition(3000);
+	read_ahead<uint16_t>(buffer, 3000);
+	uint16_t buff[10];
+	EXPECT_EQ(0, buffer.Read(buff, 10));
+
+	// Moving it forward again lets decoding carry on
+	buffer.SetEndPosition(6000);
+	auto samples = read_ahead<uint16_t>(buffer, 3000);
+	for (size_t i = 0; i < samples.size(); ++i)
+		ASSERT_EQ(static_cast<uint16_t>(3000 + i), samples[i]) << i;
+}
+
+TEST(lagi_audio, decode_ahead_mono16_with_volume) {
+	StereoAudioProvider provider(nullptr);
+	agi::DecodeAheadBuffer buffer(&provider, true, 50);
+	EXPECT_EQ(sizeof(int16_t), buffer.GetFrameSize());
+	buffer.SetVolume(2.0);
+	buffer.Start(100, 10100, 0);
+
+	auto samples = read_ahead<int16_t>(buffer, 10000);
+	for (size_t i = 0; i < samples.size(); ++i)
+		ASSERT_EQ((int16_t)(((100 + i) & 0x3fff) * 2), samples[i]) << i;
+}
+
+TEST(lagi_audio, decode_ahead_records_player_stats) {
+	std::atomic<int64_t> first_request{-1};
+	std::atomic<bool> gate{false};
+	RecordingAudioProvider provider(first_request, &gate);
+	agi::PlaybackStats stats(48000);
+	agi::DecodeAheadBuffer buffer(&provider, false, 100, &stats);
+
+	buffer.Start(segment_size - 480, segment_size + 1000, 480);
+	EXPECT_LT(0u, stats.Get().provider_reads);
+
+	uint16_t buff[480];
+	EXPECT_EQ(240, buffer.Read(buff, 240));
+	EXPECT_EQ(240, buffer.Read(buff, 480));
+	auto s = stats.Get();
+	EXPECT_EQ(2u, s.reads);
+	EXPECT_EQ(1u, s.underruns);
+	EXPECT_EQ(0, s.min_fill_ms);
+	EXPECT_EQ(2, s.avg_fill_ms);
+	gate = true;
+}
+
+TEST(lagi_audio, playback_stats_counters) {
+	agi::PlaybackStats stats(1000);
+	auto s = stats.Get();
+	EXPECT_EQ(0u, s.reads);
+	EXPECT_EQ(0, s.min_fill_ms);
+	EXPECT_EQ(-1, s.latency_ms);
+	EXPECT_EQ(0u, s.drift_samples);
+
+	stats.RecordRead(50, false);
+	stats.RecordRead(10, true);
+	stats.RecordRead(30, false);
+	stats.RecordDeviceUnderrun();
+	stats.RecordLatency(80);
+	stats.RecordLatency(40);
+	stats.RecordDrift(-25);
+	stats.RecordDrift(10);
+
+	s = stats.Get();
+	EXPECT_EQ(3u, s.reads);
+	EXPECT_EQ(1u, s.underruns);
+	EXPECT_EQ(1u, s.device_underruns);
+	EXPECT_EQ(10, s.min_fill_ms);
+	EXPECT_EQ(30, s.avg_fill_ms);
+	EXPECT_EQ(40, s.latency_ms);
+	EXPECT_EQ(80, s.max_latency_ms);
+	EXPECT_EQ(2u, s.drift_samples);
+	EXPECT_EQ(10, s.drift_ms);
+	EXPECT_EQ(25, s.max_drift_ms);
+
+	stats.Reset();
+	s = stats.Get();
+	EXPECT_EQ(0u, s.reads);
+	EXPECT_EQ(0u, s.underruns);
+	EXPECT_EQ(-1, s.max_latency_ms);
+	EXPECT_EQ(0, s.max_drift_ms);
+}
+
+TEST(lagi_audio, playback_stats_read_time_histogram) {
+	using std::chrono::microseconds;
+	agi::PlaybackStats stats(48000);
+	stats.RecordProviderRead(microseconds(0));
+	stats.RecordProviderRead(microseconds(99));
+	stats.RecordProviderRead(microseconds(100));
+	stats.RecordProviderRead(microseconds(1500));
+	stats.RecordProviderRead(std::chrono::seconds(2));
+
+	auto s = stats.Get();
+	const int last = agi::PlaybackStats::ReadTimeBuckets - 1;
+	EXPECT_EQ(5u, s.provider_reads);
+	EXPECT_EQ(2u, s.read_time[0]);
+	EXPECT_EQ(1u, s.read_time[1]);
+	EXPECT_EQ(1u, s.read_time[4]);
+	EXPECT_EQ(1u, s.read_time[last]);
+	EXPECT_EQ(2000000, s.max_read_us);
+
+	auto line = agi::PlaybackStats::Format(s);
+	EXPECT_NE(std::string::npos, line.find("provider_reads=5 "));
+	EXPECT_NE(std::string::npos, line.find("read_hist_us=<100:2,<200:1,"));
+	EXPECT_NE(std::string::npos, line.find(",102400+:1"));
+}
+
+namespace {
+/// Quiet noise with bursts of a loud tone at the given times
+struct SpeechAudioProvider : agi::AudioProvider {
+	std::vector<std::pair<int, int>> bursts;
+
+	SpeechAudioProvider(std::vector<std::pair<int, int>> bursts) : bursts(std::move(bursts)) {
+		channels = 1;
+		sample_rate = 16000;
+		num_samples = sample_rate * 8;
+		decoded_samples = num_samples;
+		bytes_per_sample = sizeof(int16_t);
+		float_samples = false;
+	}
+
+	void Decode(int64_t count) { decoded_samples = count; }
+
+	void FillBuffer(void *buf, int64_t start, int64_t count) const override {
+		auto out = static_cast<int16_t *>(buf);
+		for (int64_t i = start; i < start + count; ++i) {
+			const int64_t ms = i * 1000 / sample_rate;
+			bool loud = false;
+			for (auto const& burst : bursts)
+				loud = loud || (ms >= burst.first && ms < burst.second);
+			const int noise = int((uint32_t(i) * 2654435761u) >> 26) - 32;
+			*out++ = int16_t(loud ? 8000 * std::sin(i * 0.3) + noise : noise);
+		}
+	}
+};
+
+void wait_for_envelope(agi::SpeechEnvelope const& envelope) {
+	for (int i = 0; i < 500 && !envelope.IsComplete(); ++i)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	ASSERT_TRUE(envelope.IsComplete());
+}
+}
+
+TEST(lagi_audio, speech_envelope_boundaries) {
+	// A short pause inside the first burst and a click which is too short to
+	// be speech are both smoothed over
+	SpeechAudioProvider provider({{1000, 1800}, {1880, 2500}, {4000, 4300}, {6000, 6030}});
+	agi::SpeechEnvelope envelope(&provider);
+	wait_for_envelope(envelope);
+
+	EXPECT_EQ(1000, envelope.NearestOnset(1050, 100));
+	EXPECT_EQ(2500, envelope.NearestOffset(2450, 100));
+	EXPECT_EQ(4000, envelope.NearestOnset(3900, 100));
+	EXPECT_EQ(4300, envelope.NearestOffset(4300, 0));
+
+	EXPECT_EQ(-1, envelope.NearestOffset(1800, 100));
+	EXPECT_EQ(-1, envelope.NearestOnset(1880, 100));
+	EXPECT_EQ(-1, envelope.NearestOnset(6000, 500));
+	EXPECT_EQ(-1, envelope.NearestOnset(1050, 49));
+
+	EXPECT_GT(envelope.GetLevel(1500), -20.f);
+	EXPECT_LT(envelope.GetLevel(3000), -50.f);
+	EXPECT_EQ(agi::SpeechEnvelope::MinLevel, envelope.GetLevel(100000));
+	EXPECT_EQ(8000, envelope.GetAnalyzedMs());
+}
+
+TEST(lagi_audio, speech_envelope_nearest) {
+	SpeechAudioProvider provider({{1000, 2000}, {4000, 5000}});
+	agi::SpeechEnvelope envelope(&provider);
+	wait_for_envelope(envelope);
+
+	EXPECT_EQ(4000, envelope.NearestOnset(2600, 2000));
+	EXPECT_EQ(1000, envelope.NearestOnset(2400, 2000));
+	EXPECT_EQ(2000, envelope.NearestOffset(0, 2000));
+	EXPECT_EQ(5000, envelope.NearestOffset(10000, 5000));
+	EXPECT_EQ(-1, envelope.NearestOffset(10000, 4999));
+}
+
+TEST(lagi_audio, speech_envelope_speech_at_end) {
+	SpeechAudioProvider provider({{7000, 8000}});
+	agi::SpeechEnvelope envelope(&provider);
+	wait_for_envelope(envelope);
+
+	EXPECT_EQ(7000, envelope.NearestOnset(7000, 0));
+	EXPECT_EQ(8000, envelope.NearestOffset(8000, 0));
+}
+
+TEST(lagi_audio, speech_envelope_waits_for_decoding) {
+	SpeechAudioProvider provider({{1000, 2000}});
+	provider.Decode(0);
+	agi::SpeechEnvelope envelope(&provider);
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	EXPECT_EQ(0, envelope.GetAnalyzedMs());
+	EXPECT_EQ(-1, envelope.NearestOnset(1000, 1000));
+
+	provider.Decode(provider.GetNumSamples());
+	wait_for_envelope(envelope);
+	EXPECT_EQ(1000, envelope.NearestOnset(1000, 0));
+}
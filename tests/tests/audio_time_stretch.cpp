@@ -0,0 +1,196 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include <main.h>
+
+#include "audio_time_stretch.h"
+
+#include <libaegisub/audio/provider.h>
+#include <libaegisub/util.h>
+
+#include <cmath>
+#include <vector>
+
+namespace {
+/// Stereo audio whose left channel is a ramp of the sample number and whose
+/// right channel is the negated ramp, so that resampling it is exact
+struct RampProvider : agi::AudioProvider {
+	RampProvider() {
+		channels = 2;
+		sample_rate = 48000;
+		num_samples = 20000;
+		decoded_samples = num_samples;
+		bytes_per_sample = sizeof(int16_t);
+		float_samples = false;
+	}
+
+	void FillBuffer(void *buf, int64_t start, int64_t count) const override {
+		auto out = static_cast<int16_t *>(buf);
+		for (int64_t i = start; i < start + count; ++i) {
+			*out++ = int16_t(i);
+			*out++ = int16_t(-i);
+		}
+	}
+};
+
+/// Read frames up to a period at a time until the end, waiting for the
+/// stretcher rather than reading more than it has ready
+std::vector<float> read_all(TimeStretchBuffer& stretch, int64_t period = 300) {
+	std::vector<float> out;
+	std::vector<float> buf(period * 2);
+	while (true) {
+		const int64_t available = stretch.GetAvailable();
+		if (!available) {
+			if (stretch.IsFinished() && !stretch.GetAvailable()) break;
+			agi::util::sleep_for(1);
+			continue;
+		}
+		const int64_t got = stretch.Read(buf.data(), std::min(available, period));
+		out.insert(out.end(), buf.begin(), buf.begin() + got * 2);
+	}
+	return out;
+}
+
+/// Check that each output frame is the source frame its position maps to
+void check_positions(TimeStretchBuffer const& stretch, std::vector<float> const& out, int64_t first_output = 0) {
+	for (size_t i = 0; i < out.size() / 2; ++i) {
+		const double pos = stretch.GetSourcePosition(first_output + int64_t(i));
+		ASSERT_NEAR(pos, out[i * 2] * 32768.0, 0.01) << "frame " << i;
+		ASSERT_NEAR(-pos, out[i * 2 + 1] * 32768.0, 0.01) << "frame " << i;
+	}
+}
+}
+
+TEST(TimeStretchBuffer, normal_speed_is_unchanged) {
+	RampProvider provider;
+	TimeStretchBuffer stretch(&provider, 50);
+	stretch.Start(0, 1000, 5000, 1.0, false);
+	EXPECT_EQ(4000, stretch.GetOutputEnd());
+
+	auto out = read_all(stretch);
+	ASSERT_EQ(4000u * 2, out.size());
+	for (size_t i = 0; i < 4000; ++i) {
+		ASSERT_EQ(float(int(i) + 1000) / 32768.f, out[i * 2]);
+		ASSERT_EQ(float(-int(i) - 1000) / 32768.f, out[i * 2 + 1]);
+	}
+}
+
+TEST(TimeStretchBuffer, fixed_speeds) {
+	RampProvider provider;
+	TimeStretchBuffer stretch(&provider, 50);
+	for (double speed : {2.0, 0.5, 0.75, 1.25}) {
+		stretch.Start(0, 2000, 6000, speed, false);
+		const int64_t expected = int64_t(std::ceil(4000 / speed));
+		EXPECT_EQ(expected, stretch.GetOutputEnd());
+
+		auto out = read_all(stretch);
+		ASSERT_EQ(size_t(expected * 2), out.size()) << speed;
+		check_positions(stretch, out);
+	}
+}
+
+TEST(TimeStretchBuffer, speed_change_during_playback) {
+	RampProvider provider;
+	TimeStretchBuffer stretch(&provider, 50);
+	stretch.Start(0, 0, 16000, 0.5, false);
+	EXPECT_EQ(32000, stretch.GetOutputEnd());
+
+	// Less than the lead, which is stretched before Start returns
+	std::vector<float> buf(2000 * 2);
+	ASSERT_EQ(2000, stretch.Read(buf.data(), 2000));
+	stretch.SetSpeed(2.0);
+
+	auto out = read_all(stretch);
+	out.insert(out.begin(), buf.begin(), buf.end());
+	check_positions(stretch, out);
+
+	// The change is heard once the audio already stretched has been played,
+	// and the rest plays at the new speed
+	const int64_t frames = int64_t(out.size() / 2);
+	EXPECT_LT(frames, 12000);
+	EXPECT_EQ(frames, stretch.GetOutputEnd());
+	EXPECT_DOUBLE_EQ(16000 - 2 * 100, stretch.GetSourcePosition(frames - 100));
+	EXPECT_DOUBLE_EQ(1000, stretch.GetSourcePosition(2000));
+}
+
+TEST(TimeStretchBuffer, output_offset) {
+	RampProvider provider;
+	TimeStretchBuffer stretch(&provider, 50);
+	stretch.Start(5000, 100, 1100, 2.0, false);
+	EXPECT_EQ(5000, stretch.GetReadPosition());
+	EXPECT_EQ(5500, stretch.GetOutputEnd());
+	EXPECT_DOUBLE_EQ(100, stretch.GetSourcePosition(5000));
+
+	auto out = read_all(stretch);
+	ASSERT_EQ(500u * 2, out.size());
+	EXPECT_EQ(5500, stretch.GetReadPosition());
+	check_positions(stretch, out, 5000);
+	EXPECT_DOUBLE_EQ(1100, stretch.GetSourcePosition(6000));
+}
+
+TEST(TimeStretchBuffer, stop) {
+	RampProvider provider;
+	TimeStretchBuffer stretch(&provider, 50);
+	stretch.Start(0, 0, 10000, 1.5, false);
+	stretch.Stop();
+
+	std::vector<float> buf(100 * 2);
+	EXPECT_EQ(0, stretch.Read(buf.data(), 100));
+
+	stretch.Start(0, 0, 100, 1.0, false);
+	EXPECT_EQ(100, stretch.Read(buf.data(), 100));
+}
+
+TEST(TimeStretchBuffer, underrun_keeps_positions) {
+	RampProvider provider;
+	TimeStretchBuffer stretch(&provider, 50);
+	stretch.Start(0, 0, 16000, 0.5, false);
+
+	// Asking for more than has been stretched plays the rest as silence,
+	// and the audio it stood in for is skipped rather than played late
+	std::vector<float> buf(10000 * 2);
+	const int64_t got = stretch.Read(buf.data(), 10000);
+	EXPECT_LT(got, 10000);
+	EXPECT_EQ(10000, stretch.GetReadPosition());
+
+	auto out = read_all(stretch);
+	EXPECT_EQ(32000 - 10000, int64_t(out.size() / 2));
+	check_positions(stretch, out, 10000);
+}
+
+TEST(TimeStretchBuffer, seek) {
+	RampProvider provider;
+	TimeStretchBuffer stretch(&provider, 50);
+	stretch.Start(0, 0, 16000, 2.0, false);
+	std::vector<float> buf(1000 * 2);
+	ASSERT_EQ(1000, stretch.Read(buf.data(), 1000));
+
+	// Until the stretcher has caught up with the seek, reads are silence
+	// which still moves the position on
+	stretch.Seek(4000);
+	EXPECT_EQ(4000, stretch.GetReadPosition());
+	while (!stretch.GetAvailable()) {
+		EXPECT_EQ(0, stretch.Read(buf.data(), 10));
+		agi::util::sleep_for(1);
+	}
+	const int64_t resumed = stretch.GetReadPosition();
+	EXPECT_LE(4000, resumed);
+
+	auto out = read_all(stretch);
+	EXPECT_EQ(8000 - resumed, int64_t(out.size() / 2));
+	check_positions(stretch, out, resumed);
+	EXPECT_DOUBLE_EQ(2000, stretch.GetSourcePosition(1000));
+}
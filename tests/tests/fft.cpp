@@ -0,0 +1,124 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <main.h>
+
+#include "fft.h"
+
+#include <libaegisub/exception.h>
+
+#include <cmath>
+#include <numeric>
+#include <random>
+
+namespace {
+const double pi = 3.1415926535897932384626433832795;
+
+/// Direct evaluation of the DFT, in double precision
+void reference_dft(std::vector<float> const& input, std::vector<double>& out_r, std::vector<double>& out_i) {
+	const size_t n = input.size();
+	out_r.assign(n / 2 + 1, 0);
+	out_i.assign(n / 2 + 1, 0);
+	for (size_t k = 0; k <= n / 2; ++k) {
+		for (size_t t = 0; t < n; ++t) {
+			const double angle = -2 * pi * double(k * t % n) / n;
+			out_r[k] += input[t] * cos(angle);
+			out_i[k] += input[t] * sin(angle);
+		}
+	}
+}
+}
+
+TEST(FFT, matches_dft) {
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> dist(-1.f, 1.f);
+
+	for (size_t size : {4, 8, 16, 32, 512, 2048}) {
+		std::vector<float> input(size);
+		for (auto& sample : input) sample = dist(rng);
+
+		std::vector<float> out_r(size / 2 + 1), out_i(size / 2 + 1);
+		FFT fft(size);
+		fft.Transform(input.data(), out_r.data(), out_i.data());
+
+		std::vector<double> ref_r, ref_i;
+		reference_dft(input, ref_r, ref_i);
+		for (size_t k = 0; k <= size / 2; ++k) {
+			ASSERT_NEAR(ref_r[k], out_r[k], 1e-5 * size) << size << " " << k;
+			ASSERT_NEAR(ref_i[k], out_i[k], 1e-5 * size) << size << " " << k;
+		}
+	}
+}
+
+TEST(FFT, reusable) {
+	FFT fft(64);
+	std::vector<float> input(64, 0.f), out_r(33), out_i(33);
+	input[1] = 1.f;
+	fft.Transform(input.data(), out_r.data(), out_i.data());
+	auto first_r = out_r, first_i = out_i;
+
+	std::fill(input.begin(), input.end(), 0.5f);
+	fft.Transform(input.data(), out_r.data(), out_i.data());
+	EXPECT_FLOAT_EQ(32.f, out_r[0]);
+
+	input.assign(64, 0.f);
+	input[1] = 1.f;
+	fft.Transform(input.data(), out_r.data(), out_i.data());
+	EXPECT_EQ(first_r, out_r);
+	EXPECT_EQ(first_i, out_i);
+}
+
+TEST(FFT, rejects_bad_sizes) {
+	EXPECT_THROW(FFT(0), agi::InternalError);
+	EXPECT_THROW(FFT(2), agi::InternalError);
+	EXPECT_THROW(FFT(96), agi::InternalError);
+}
+
+TEST(FFT, window_mean_is_one) {
+	EXPECT_TRUE(MakeFFTWindow(FFTWindow::Rectangular, 1024).empty());
+	for (auto window : {FFTWindow::Hann, FFTWindow::Blackman}) {
+		auto coefficients = MakeFFTWindow(window, 1024);
+		ASSERT_EQ(1024u, coefficients.size());
+		EXPECT_NEAR(1.0, std::accumulate(coefficients.begin(), coefficients.end(), 0.0) / 1024, 1e-5);
+		EXPECT_NEAR(0.0, coefficients[0], 1e-6);
+	}
+}
+
+TEST(FFT, window_reduces_leakage) {
+	// A tone between two bins leaks into the whole spectrum without a window
+	const size_t size = 1024;
+	std::vector<float> input(size);
+	for (size_t i = 0; i < size; ++i)
+		input[i] = float(sin(2 * pi * 100.5 * i / size));
+
+	auto far_leakage = [&](FFTWindow window) {
+		auto coefficients = MakeFFTWindow(window, size);
+		std::vector<float> windowed(input);
+		for (size_t i = 0; i < coefficients.size(); ++i)
+			windowed[i] *= coefficients[i];
+
+		std::vector<float> out_r(size / 2 + 1), out_i(size / 2 + 1);
+		FFT fft(size);
+		fft.Transform(windowed.data(), out_r.data(), out_i.data());
+		const double peak = std::hypot(out_r[100], out_i[100]);
+		return std::hypot(out_r[300], out_i[300]) / peak;
+	};
+
+	const double rectangular = far_leakage(FFTWindow::Rectangular);
+	const double hann = far_leakage(FFTWindow::Hann);
+	const double blackman = far_leakage(FFTWindow::Blackman);
+	EXPECT_GT(rectangular, 1e-3);
+	EXPECT_LT(hann, rectangular / 100);
+	EXPECT_LT(blackman, hann);
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include <main.h>
+
+#include <libaegisub/ass/field_scanner.h>
+#include <libaegisub/split.h>
+
+#include <string>
+#include <vector>
+
+using agi::ass::CharRange;
+
+namespace {
+std::vector<std::string> scan(std::string const& str) {
+	std::vector<std::string> ret;
+	agi::ass::FieldScanner scanner(str.data(), str.data() + str.size());
+	CharRange field;
+	while (scanner.Next(field))
+		ret.emplace_back(field.begin(), field.end());
+	return ret;
+}
+
+std::vector<std::string> split(std::string const& str) {
+	std::vector<std::string> ret;
+	for (auto tok : agi::Split(str, ','))
+		ret.push_back(agi::str(tok));
+	return ret;
+}
+
+std::string trim(std::string const& str) {
+	auto r = agi::ass::Trim(CharRange(str.data(), str.data() + str.size()));
+	return std::string(r.begin(), r.end());
+}
+
+bool parse_int(std::string const& str, int &out) {
+	return agi::ass::ParseInt(CharRange(str.data(), str.data() + str.size()), out);
+}
+}
+
+TEST(lagi_field_scanner, matches_split) {
+	const char *inputs[] = {
+		"", ",", "a", "a,", ",a", "a,,b",
+		"0,0:00:00.00,0:00:01.00,Default,,0,0,0,,Text, with, commas",
+		// Long enough to go through the vectorized paths
+		"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa,bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb,c",
+		"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa",
+	};
+	for (auto input : inputs)
+		EXPECT_EQ(split(input), scan(input)) << input;
+}
+
+TEST(lagi_field_scanner, find_char_every_offset) {
+	for (size_t len = 0; len < 80; ++len) {
+		for (size_t pos = 0; pos <= len; ++pos) {
+			std::string str(len, 'x');
+			if (pos < len) str[pos] = ',';
+			auto found = agi::ass::FindChar(str.data(), str.data() + len, ',');
+			EXPECT_EQ(str.data() + pos, found);
+		}
+	}
+}
+
+TEST(lagi_field_scanner, does_not_copy_input) {
+	std::string str("a,b");
+	agi::ass::FieldScanner scanner(str.data(), str.data() + str.size());
+	CharRange field;
+	ASSERT_TRUE(scanner.Next(field));
+	EXPECT_EQ(str.data(), field.begin());
+	ASSERT_TRUE(scanner.Next(field));
+	EXPECT_EQ(str.data() + 2, field.begin());
+	EXPECT_TRUE(scanner.AtEnd());
+	EXPECT_FALSE(scanner.Next(field));
+}
+
+TEST(lagi_field_scanner, trim) {
+	EXPECT_EQ("", trim(""));
+	EXPECT_EQ("", trim(" \t "));
+	EXPECT_EQ("a b", trim(" a b\t"));
+	EXPECT_EQ("abc", trim("abc"));
+}
+
+TEST(lagi_field_scanner, parse_int) {
+	int value = 0;
+	EXPECT_TRUE(parse_int("0", value));
+	EXPECT_EQ(0, value);
+	EXPECT_TRUE(parse_int("123", value));
+	EXPECT_EQ(123, value);
+	EXPECT_TRUE(parse_int("-45", value));
+	EXPECT_EQ(-45, value);
+	EXPECT_TRUE(parse_int("+7", value));
+	EXPECT_EQ(7, value);
+	EXPECT_TRUE(parse_int("999999999", value));
+	EXPECT_EQ(999999999, value);
+
+	EXPECT_FALSE(parse_int("", value));
+	EXPECT_FALSE(parse_int("-", value));
+	EXPECT_FALSE(parse_int(" 1", value));
+	EXPECT_FALSE(parse_int("1a", value));
+	EXPECT_FALSE(parse_int("1000000000", value));
+}
@@ -0,0 +1,141 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include <main.h>
+
+#include "spectrum_rows.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+/// Row values as the spectrum renderer computed them for each pixel before
+/// the mapping was precomputed
+std::vector<float> reference_column(SpectrumRowParams const& p, const float *power) {
+	auto floor_int = [] (float val) { return int(floorf(val)); };
+	auto round_int = [] (float val) { return int(floorf(val + 0.5f)); };
+
+	const int nbr_bins = 1 << p.derivation_size;
+	const int minband = 1;
+	const int maxband = std::min(round_int(nbr_bins * p.max_freq / (p.sample_rate * 0.5f)), nbr_bins);
+	const float scale_log = logf(maxband / minband);
+	float b_fref = nbr_bins * p.freq_ref / (p.sample_rate * 0.5f);
+	b_fref = std::min(std::max(b_fref, 1.f), float(maxband - 1));
+	const float clin = minband + (maxband - minband) * p.pos_fref;
+	const float clog = minband * expf(p.pos_fref * scale_log);
+	const float log_ratio_calc = std::min(std::max((b_fref - clin) / (clog - clin), 0.f), 1.f);
+
+	std::vector<float> out;
+	float bin_prv = minband, bin_cur = minband;
+	for (int y = 0; y < p.height; ++y) {
+		float bin_nxt = maxband;
+		if (y + 1 < p.height) {
+			const float pos_rel = float(y + 1) / float(p.height);
+			const float b_lin = minband + pos_rel * (maxband - minband);
+			const float b_log = minband * expf(pos_rel * scale_log);
+			bin_nxt = b_lin + log_ratio_calc * (b_log - b_lin);
+		}
+
+		if (bin_nxt - bin_prv < 2) {
+			const int bin_0 = floor_int(bin_cur);
+			const int bin_1 = std::min(bin_0 + 1, nbr_bins - 1);
+			const float frac = bin_cur - float(bin_0);
+			out.push_back(power[bin_0] + frac * (power[bin_1] - power[bin_0]));
+		}
+		else {
+			const int bin_inf = std::min(floor_int((bin_prv + bin_cur) * 0.5f), nbr_bins - 2);
+			const int bin_sup = std::min(floor_int((bin_cur + bin_nxt) * 0.5f), nbr_bins - 1);
+			out.push_back(*std::max_element(&power[bin_inf], &power[bin_sup]));
+		}
+
+		bin_prv = bin_cur;
+		bin_cur = bin_nxt;
+	}
+	return out;
+}
+
+SpectrumRowParams make_params(int height, size_t derivation_size, float pos_fref) {
+	SpectrumRowParams p;
+	p.height = height;
+	p.derivation_size = derivation_size;
+	p.sample_rate = 48000;
+	p.max_freq = 20000;
+	p.freq_ref = 1000;
+	p.pos_fref = pos_fref;
+	return p;
+}
+}
+
+TEST(SpectrumRows, matches_per_pixel_mapping) {
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> dist(0.f, 1.f);
+
+	for (size_t derivation_size : {8, 10, 12}) {
+		std::vector<float> power(size_t(1) << derivation_size);
+		std::generate(power.begin(), power.end(), [&] { return dist(rng); });
+
+		for (int height : {1, 7, 100, 400, 1500}) {
+			for (float pos_fref : {0.1f, 1.f / 3, 0.9f}) {
+				const auto params = make_params(height, derivation_size, pos_fref);
+				SpectrumRowMap map(params);
+				std::vector<float> column(height);
+				map.MapColumn(power.data(), column.data());
+				EXPECT_EQ(reference_column(params, power.data()), column)
+					<< "derivation_size " << derivation_size << " height " << height << " pos_fref " << pos_fref;
+			}
+		}
+	}
+}
+
+TEST(SpectrumRows, params_compare) {
+	const auto params = make_params(400, 10, 1.f / 3);
+	SpectrumRowMap map(params);
+	EXPECT_TRUE(map.GetParams() == params);
+
+	auto other = params;
+	other.height = 401;
+	EXPECT_TRUE(map.GetParams() != other);
+	other = params;
+	other.max_freq = 16000;
+	EXPECT_TRUE(map.GetParams() != other);
+}
+
+TEST(SpectrumRows, palette_mapping) {
+	const size_t factor = 16;
+	std::vector<unsigned char> palette((factor + 1) * 3);
+	for (size_t i = 0; i < palette.size(); ++i)
+		palette[i] = (unsigned char)i;
+
+	const std::vector<float> values{-1.f, 0.f, 0.03f, 0.25f, 0.5f, 0.999f, 1.f, 1.5f, 100.f, 0.7f, 0.125f};
+	const float scale = 1.5f;
+
+	// Written bottom-up with a stride, as the renderer does
+	const ptrdiff_t stride = 3 * 5;
+	std::vector<unsigned char> image(values.size() * stride, 0xFF);
+	MapSpectrumColumn(values.data(), values.size(), scale, palette.data(), factor,
+		image.data() + (values.size() - 1) * stride, -stride);
+
+	for (size_t i = 0; i < values.size(); ++i) {
+		const float v = values[i] * scale * factor;
+		const size_t index = v < 0 ? 0 : std::min<size_t>(size_t(v), factor);
+		const unsigned char *px = &image[(values.size() - 1 - i) * stride];
+		EXPECT_EQ(palette[index * 3 + 0], px[0]) << values[i];
+		EXPECT_EQ(palette[index * 3 + 1], px[1]) << values[i];
+		EXPECT_EQ(palette[index * 3 + 2], px[2]) << values[i];
+		EXPECT_EQ(0xFF, px[3]);
+	}
+}
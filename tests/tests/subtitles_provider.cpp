@@ -0,0 +1,240 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <main.h>
+
+#include "ass_dialogue.h"
+#include "ass_file.h"
+#include "include/aegisub/subtitles_provider.h"
+
+#include <libaegisub/format.h>
+
+#include <random>
+
+namespace {
+/// Provider which keeps the track as a list of Dialogue lines
+class TrackProvider final : public SubtitlesProvider {
+	static std::vector<std::string> Split(const char *data, size_t len) {
+		std::vector<std::string> lines;
+		const char *end = data + len;
+		while (data < end) {
+			auto eol = std::find(data, end, '\n');
+			std::string line(data, eol);
+			if (line.compare(0, 10, "Dialogue: ") == 0)
+				lines.push_back(std::move(line));
+			data = eol + 1;
+		}
+		return lines;
+	}
+
+	void LoadSubtitles(const char *data, size_t len) override {
+		events = Split(data, len);
+	}
+
+	bool ReplaceEvents(size_t index, size_t count, const char *data, size_t len) override {
+		if (fail || index + count > events.size()) return false;
+		auto added = Split(data, len);
+		events.erase(events.begin() + index, events.begin() + index + count);
+		events.insert(events.begin() + index, added.begin(), added.end());
+		return true;
+	}
+
+public:
+	using SubtitlesProvider::LoadSubtitles;
+
+	std::vector<std::string> events;
+	/// Make ReplaceEvents fail as if the renderer couldn't patch its track
+	bool fail = false;
+
+	void DrawSubtitles(VideoFrame &, double) override { }
+};
+
+void add_lines(AssFile &file, int count) {
+	for (int i = 0; i < count; ++i) {
+		auto line = new AssDialogue;
+		line->Start = i * 1000;
+		line->End = i * 1000 + 1000;
+		line->Text = agi::format("line %d", i);
+		line->Row = i;
+		file.Events.push_back(*line);
+	}
+}
+
+AssDialogue &line_at(AssFile &file, int row) {
+	auto it = file.Events.begin();
+	std::advance(it, row);
+	return *it;
+}
+
+/// The events the renderer should have for the file
+std::vector<std::string> visible_events(AssFile const& file) {
+	std::vector<std::string> events;
+	for (auto const& line : file.Events) {
+		if (!line.Comment)
+			events.push_back(line.GetEntryData());
+	}
+	return events;
+}
+}
+
+TEST(SubtitlesProvider, replace_changed_line) {
+	AssFile file;
+	add_lines(file, 5);
+	TrackProvider provider;
+	provider.LoadSubtitles(&file);
+	ASSERT_EQ(visible_events(file), provider.events);
+	EXPECT_EQ(5u, provider.GetEventsParsed());
+
+	line_at(file, 2).Text = "changed";
+	ASSERT_TRUE(provider.UpdateSubtitles(line_at(file, 2)));
+	EXPECT_EQ(visible_events(file), provider.events);
+	EXPECT_EQ(1u, provider.GetEventsParsed());
+}
+
+TEST(SubtitlesProvider, commenting_line_deletes_event) {
+	AssFile file;
+	add_lines(file, 5);
+	TrackProvider provider;
+	provider.LoadSubtitles(&file);
+
+	line_at(file, 1).Comment = true;
+	ASSERT_TRUE(provider.UpdateSubtitles(line_at(file, 1)));
+	EXPECT_EQ(visible_events(file), provider.events);
+	EXPECT_EQ(0u, provider.GetEventsParsed());
+
+	// Lines after the deleted one are now one event earlier in the track
+	line_at(file, 3).Text = "changed";
+	ASSERT_TRUE(provider.UpdateSubtitles(line_at(file, 3)));
+	EXPECT_EQ(visible_events(file), provider.events);
+
+	line_at(file, 4).Comment = true;
+	ASSERT_TRUE(provider.UpdateSubtitles(line_at(file, 4)));
+	EXPECT_EQ(visible_events(file), provider.events);
+}
+
+TEST(SubtitlesProvider, uncommenting_line_inserts_event) {
+	AssFile file;
+	add_lines(file, 5);
+	line_at(file, 0).Comment = true;
+	line_at(file, 2).Comment = true;
+	line_at(file, 4).Comment = true;
+	TrackProvider provider;
+	provider.LoadSubtitles(&file);
+	ASSERT_EQ(2u, provider.events.size());
+
+	line_at(file, 2).Comment = false;
+	ASSERT_TRUE(provider.UpdateSubtitles(line_at(file, 2)));
+	EXPECT_EQ(visible_events(file), provider.events);
+	EXPECT_EQ(1u, provider.GetEventsParsed());
+
+	line_at(file, 0).Comment = false;
+	ASSERT_TRUE(provider.UpdateSubtitles(line_at(file, 0)));
+	EXPECT_EQ(visible_events(file), provider.events);
+
+	line_at(file, 4).Comment = false;
+	ASSERT_TRUE(provider.UpdateSubtitles(line_at(file, 4)));
+	EXPECT_EQ(visible_events(file), provider.events);
+
+	line_at(file, 3).Text = "changed";
+	ASSERT_TRUE(provider.UpdateSubtitles(line_at(file, 3)));
+	EXPECT_EQ(visible_events(file), provider.events);
+}
+
+TEST(SubtitlesProvider, delete_then_insert_at_same_position) {
+	AssFile file;
+	add_lines(file, 5);
+	TrackProvider provider;
+	provider.LoadSubtitles(&file);
+
+	line_at(file, 2).Comment = true;
+	ASSERT_TRUE(provider.UpdateSubtitles(line_at(file, 2)));
+	ASSERT_EQ(visible_events(file), provider.events);
+
+	line_at(file, 2).Comment = false;
+	line_at(file, 2).Text = "changed";
+	ASSERT_TRUE(provider.UpdateSubtitles(line_at(file, 2)));
+	EXPECT_EQ(visible_events(file), provider.events);
+
+	// The reinserted line must be patched in place rather than inserted again
+	line_at(file, 2).Text = "changed again";
+	ASSERT_TRUE(provider.UpdateSubtitles(line_at(file, 2)));
+	EXPECT_EQ(visible_events(file), provider.events);
+
+	line_at(file, 3).Text = "changed";
+	ASSERT_TRUE(provider.UpdateSubtitles(line_at(file, 3)));
+	EXPECT_EQ(visible_events(file), provider.events);
+}
+
+TEST(SubtitlesProvider, editing_commented_line_changes_nothing) {
+	AssFile file;
+	add_lines(file, 3);
+	line_at(file, 1).Comment = true;
+	TrackProvider provider;
+	provider.LoadSubtitles(&file);
+
+	line_at(file, 1).Text = "changed";
+	ASSERT_TRUE(provider.UpdateSubtitles(line_at(file, 1)));
+	EXPECT_EQ(visible_events(file), provider.events);
+	EXPECT_EQ(0u, provider.GetEventsParsed());
+}
+
+TEST(SubtitlesProvider, random_edits_stay_in_step) {
+	AssFile file;
+	add_lines(file, 50);
+	TrackProvider provider;
+	provider.LoadSubtitles(&file);
+
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<int> row_dist(0, 49);
+	for (int i = 0; i < 1000; ++i) {
+		auto& line = line_at(file, row_dist(rng));
+		if (rng() % 2)
+			line.Comment = !line.Comment;
+		else
+			line.Text = agi::format("edit %d", i);
+		ASSERT_TRUE(provider.UpdateSubtitles(line));
+		ASSERT_EQ(visible_events(file), provider.events) << "after edit " << i;
+	}
+}
+
+TEST(SubtitlesProvider, single_frame_load_needs_reload) {
+	AssFile file;
+	add_lines(file, 3);
+	TrackProvider provider;
+	provider.LoadSubtitles(&file, 1500);
+	ASSERT_EQ(1u, provider.events.size());
+
+	line_at(file, 1).Text = "changed";
+	EXPECT_FALSE(provider.UpdateSubtitles(line_at(file, 1)));
+}
+
+TEST(SubtitlesProvider, failed_replace_needs_reload) {
+	AssFile file;
+	add_lines(file, 3);
+	TrackProvider provider;
+	provider.LoadSubtitles(&file);
+
+	provider.fail = true;
+	line_at(file, 1).Text = "changed";
+	EXPECT_FALSE(provider.UpdateSubtitles(line_at(file, 1)));
+
+	// The track may be out of step now, so later updates also need a reload
+	provider.fail = false;
+	EXPECT_FALSE(provider.UpdateSubtitles(line_at(file, 1)));
+
+	provider.LoadSubtitles(&file);
+	line_at(file, 2).Text = "changed";
+	ASSERT_TRUE(provider.UpdateSubtitles(line_at(file, 2)));
+	EXPECT_EQ(visible_events(file), provider.events);
+}
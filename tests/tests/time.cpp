@@ -62,6 +62,20 @@ TEST(lagi_time, extra_garbage_is_ignored) {
 	EXPECT_STREQ("1:23:45.67", Time("1a:b2c3d:e4f5g.!6&7").GetAssFormatted().c_str());
 }
 
+TEST(lagi_time, append_ass_formatted) {
+	int times[] = {0, 5, 994, 995, 61000, 3599990, 3600000, 36000000, 596 * 60 * 60 * 1000};
+	for (int t : times) {
+		std::string str = "x";
+		Time(t).AppendAssFormatted(str);
+		EXPECT_EQ("x" + Time(t).GetAssFormatted(), str);
+	}
+}
+
+TEST(lagi_time, parse_range) {
+	std::string str("0,1:23:45.67,Default");
+	EXPECT_STREQ("1:23:45.67", Time(str.data() + 2, str.data() + 12).GetAssFormatted().c_str());
+}
+
 TEST(lagi_time, srt_time) {
 	EXPECT_STREQ("1:23:45.678", Time("1:23:45,678").GetAssFormatted(true).c_str());
 	EXPECT_STREQ("01:23:45,678", Time("1:23:45,678").GetSrtFormatted().c_str());
@@ -0,0 +1,153 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+#include <main.h>
+
+#include "video_frame.h"
+#include "video_frame_cache.h"
+
+namespace {
+/// A frame of the given number of bytes, each set to value
+VideoFrame make_frame(size_t size, unsigned char value) {
+	return VideoFrame{std::vector<unsigned char>(size, value), size, 1, size, false};
+}
+}
+
+TEST(VideoFrameCache, hits_and_misses) {
+	VideoFrameCache cache(1000);
+	VideoFrame out;
+	EXPECT_FALSE(cache.Get(1, out));
+
+	cache.Insert(1, make_frame(100, 1));
+	ASSERT_TRUE(cache.Get(1, out));
+	EXPECT_EQ(100u, out.data.size());
+	EXPECT_EQ(1, out.data[0]);
+	EXPECT_EQ(100u, out.width);
+	EXPECT_FALSE(cache.Get(2, out));
+
+	auto stats = cache.GetStats();
+	EXPECT_EQ(1u, stats.hits);
+	EXPECT_EQ(2u, stats.misses);
+	EXPECT_EQ(1u, stats.frames);
+	EXPECT_EQ(100u, stats.bytes);
+	EXPECT_EQ(1000u, stats.max_bytes);
+}
+
+TEST(VideoFrameCache, evicts_least_recently_used) {
+	VideoFrameCache cache(300);
+	cache.Insert(1, make_frame(100, 1));
+	cache.Insert(2, make_frame(100, 2));
+	cache.Insert(3, make_frame(100, 3));
+
+	VideoFrame out;
+	ASSERT_TRUE(cache.Get(1, out));
+	cache.Insert(4, make_frame(100, 4));
+
+	EXPECT_FALSE(cache.Get(2, out));
+	EXPECT_TRUE(cache.Get(1, out));
+	EXPECT_TRUE(cache.Get(3, out));
+	EXPECT_TRUE(cache.Get(4, out));
+	EXPECT_EQ(4, out.data[0]);
+	EXPECT_EQ(300u, cache.GetStats().bytes);
+}
+
+TEST(VideoFrameCache, mixed_sizes_stay_under_limit) {
+	VideoFrameCache cache(250);
+	cache.Insert(1, make_frame(100, 1));
+	cache.Insert(2, make_frame(50, 2));
+	cache.Insert(3, make_frame(100, 3));
+	EXPECT_EQ(250u, cache.GetStats().bytes);
+
+	cache.Insert(4, make_frame(120, 4));
+	auto stats = cache.GetStats();
+	EXPECT_EQ(220u, stats.bytes);
+	EXPECT_EQ(2u, stats.frames);
+
+	VideoFrame out;
+	EXPECT_FALSE(cache.Get(1, out));
+	EXPECT_FALSE(cache.Get(2, out));
+	EXPECT_TRUE(cache.Get(3, out));
+	EXPECT_TRUE(cache.Get(4, out));
+}
+
+TEST(VideoFrameCache, reinsert_replaces) {
+	VideoFrameCache cache(1000);
+	cache.Insert(1, make_frame(100, 1));
+	cache.Insert(1, make_frame(200, 5));
+
+	auto stats = cache.GetStats();
+	EXPECT_EQ(1u, stats.frames);
+	EXPECT_EQ(200u, stats.bytes);
+
+	VideoFrame out;
+	ASSERT_TRUE(cache.Get(1, out));
+	EXPECT_EQ(200u, out.data.size());
+	EXPECT_EQ(5, out.data[0]);
+}
+
+TEST(VideoFrameCache, shrinking_evicts) {
+	VideoFrameCache cache(500);
+	for (int i = 0; i < 5; ++i)
+		cache.Insert(i, make_frame(100, i));
+
+	cache.SetMaxSize(250);
+	auto stats = cache.GetStats();
+	EXPECT_EQ(2u, stats.frames);
+	EXPECT_EQ(200u, stats.bytes);
+	EXPECT_EQ(250u, stats.max_bytes);
+
+	VideoFrame out;
+	EXPECT_FALSE(cache.Get(2, out));
+	EXPECT_TRUE(cache.Get(3, out));
+	EXPECT_TRUE(cache.Get(4, out));
+}
+
+TEST(VideoFrameCache, oversized_frame_kept_alone) {
+	VideoFrameCache cache(150);
+	cache.Insert(1, make_frame(100, 1));
+	cache.Insert(2, make_frame(400, 2));
+
+	auto stats = cache.GetStats();
+	EXPECT_EQ(1u, stats.frames);
+	EXPECT_EQ(400u, stats.bytes);
+
+	VideoFrame out;
+	EXPECT_FALSE(cache.Get(1, out));
+	EXPECT_TRUE(cache.Get(2, out));
+
+	cache.SetMaxSize(0);
+	EXPECT_EQ(1u, cache.GetStats().frames);
+
+	cache.Insert(3, make_frame(100, 3));
+	EXPECT_FALSE(cache.Get(2, out));
+	EXPECT_TRUE(cache.Get(3, out));
+	EXPECT_EQ(100u, cache.GetStats().bytes);
+}
+
+TEST(VideoFrameCache, clear) {
+	VideoFrameCache cache(1000);
+	cache.Insert(1, make_frame(100, 1));
+	cache.Insert(2, make_frame(100, 2));
+	cache.Clear();
+
+	auto stats = cache.GetStats();
+	EXPECT_EQ(0u, stats.frames);
+	EXPECT_EQ(0u, stats.bytes);
+
+	VideoFrame out;
+	EXPECT_FALSE(cache.Get(1, out));
+}
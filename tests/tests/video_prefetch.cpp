@@ -0,0 +1,124 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include <main.h>
+
+#include "video_frame.h"
+#include "video_prefetch.h"
+
+namespace {
+/// Produce everything the queue asks for, with times of 10 ms per frame
+void fill(FramePrefetchQueue& queue) {
+	for (int frame; (frame = queue.NextToProduce()) >= 0; )
+		queue.Push(FramePrefetchQueue::Frame{frame, frame * 10., std::make_shared<VideoFrame>()});
+}
+}
+
+TEST(FramePrefetchQueue, inactive_until_started) {
+	FramePrefetchQueue queue;
+	EXPECT_FALSE(queue.IsActive());
+	EXPECT_EQ(-1, queue.NextToProduce());
+
+	FramePrefetchQueue::Frame frame;
+	EXPECT_FALSE(queue.Take(0, 0, frame));
+	EXPECT_EQ(0u, queue.GetMisses());
+}
+
+TEST(FramePrefetchQueue, fills_to_capacity) {
+	FramePrefetchQueue queue;
+	queue.Start(5, 100, 4);
+	EXPECT_TRUE(queue.IsActive());
+	EXPECT_EQ(5, queue.NextToProduce());
+	fill(queue);
+	EXPECT_EQ(4u, queue.Size());
+
+	FramePrefetchQueue::Frame frame;
+	ASSERT_TRUE(queue.Take(5, 50, frame));
+	EXPECT_EQ(5, frame.number);
+	EXPECT_TRUE(frame.image);
+	EXPECT_EQ(9, queue.NextToProduce());
+	EXPECT_EQ(1u, queue.GetHits());
+}
+
+TEST(FramePrefetchQueue, stops_at_end) {
+	FramePrefetchQueue queue;
+	queue.Start(8, 10, 4);
+	fill(queue);
+	EXPECT_EQ(2u, queue.Size());
+	EXPECT_EQ(-1, queue.NextToProduce());
+}
+
+TEST(FramePrefetchQueue, skipped_frames_are_discarded) {
+	FramePrefetchQueue queue;
+	queue.Start(0, 100, 4);
+	fill(queue);
+
+	FramePrefetchQueue::Frame frame;
+	ASSERT_TRUE(queue.Take(2, 20, frame));
+	EXPECT_EQ(2, frame.number);
+	EXPECT_EQ(2u, queue.GetDiscarded());
+	EXPECT_EQ(1u, queue.Size());
+}
+
+TEST(FramePrefetchQueue, miss_restarts_after_requested_frame) {
+	FramePrefetchQueue queue;
+	queue.Start(0, 100, 4);
+	fill(queue);
+
+	FramePrefetchQueue::Frame frame;
+	EXPECT_FALSE(queue.Take(20, 200, frame));
+	EXPECT_EQ(1u, queue.GetMisses());
+	EXPECT_EQ(4u, queue.GetDiscarded());
+	EXPECT_EQ(0u, queue.Size());
+	EXPECT_EQ(21, queue.NextToProduce());
+}
+
+TEST(FramePrefetchQueue, wrong_time_is_a_miss) {
+	FramePrefetchQueue queue;
+	queue.Start(0, 100, 4);
+	fill(queue);
+
+	FramePrefetchQueue::Frame frame;
+	EXPECT_FALSE(queue.Take(0, 5, frame));
+	EXPECT_EQ(1u, queue.GetMisses());
+	EXPECT_EQ(0u, queue.GetHits());
+}
+
+TEST(FramePrefetchQueue, invalidate) {
+	FramePrefetchQueue queue;
+	queue.Start(0, 100, 4);
+	fill(queue);
+
+	queue.Invalidate(3);
+	EXPECT_EQ(0u, queue.Size());
+	EXPECT_EQ(3, queue.NextToProduce());
+	EXPECT_TRUE(queue.IsActive());
+
+	queue.Stop();
+	queue.Invalidate(3);
+	EXPECT_FALSE(queue.IsActive());
+	EXPECT_EQ(-1, queue.NextToProduce());
+}
+
+TEST(FramePrefetchQueue, zero_capacity_counts_misses) {
+	FramePrefetchQueue queue;
+	queue.Start(0, 100, 0);
+	EXPECT_EQ(-1, queue.NextToProduce());
+
+	FramePrefetchQueue::Frame frame;
+	EXPECT_FALSE(queue.Take(1, 10, frame));
+	EXPECT_EQ(1u, queue.GetMisses());
+}
@@ -0,0 +1,109 @@
+// Copyright (c) 2025
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include <main.h>
+
+#include "waveform_raster.h"
+
+#include <array>
+#include <random>
+
+namespace {
+const unsigned char palette[4][3] = {
+	{0, 0, 0},
+	{10, 11, 12},
+	{20, 21, 22},
+	{30, 31, 32},
+};
+
+/// Colour index of a pixel drawn column by column, as with a line per span
+std::vector<int> reference(std::vector<std::array<int, 4>> const& spans, int height, int zero_line) {
+	const int width = int(spans.size());
+	std::vector<int> out(width * height, WaveformRaster::Background);
+	for (int x = 0; x < width; ++x) {
+		for (int y = std::max(spans[x][0], 0); y < std::min(spans[x][1], height); ++y)
+			out[y * width + x] = WaveformRaster::Peak;
+		for (int y = std::max(spans[x][2], 0); y < std::min(spans[x][3], height); ++y)
+			out[y * width + x] = WaveformRaster::Average;
+	}
+	if (zero_line >= 0) {
+		for (int x = 0; x < width; ++x)
+			out[zero_line * width + x] = WaveformRaster::ZeroLine;
+	}
+	return out;
+}
+
+void check(std::vector<std::array<int, 4>> const& spans, int height, int zero_line) {
+	const int width = int(spans.size());
+	WaveformRaster raster;
+	raster.Reset(width, height);
+	for (int x = 0; x < width; ++x)
+		raster.SetColumn(x, spans[x][0], spans[x][1], spans[x][2], spans[x][3]);
+
+	std::vector<unsigned char> rgb(width * height * 3, 0xFF);
+	raster.Rasterize(palette, zero_line, rgb.data());
+
+	auto expected = reference(spans, height, zero_line);
+	for (int i = 0; i < width * height; ++i) {
+		ASSERT_EQ(palette[expected[i]][0], rgb[i * 3 + 0]) << "pixel " << i % width << "," << i / width;
+		ASSERT_EQ(palette[expected[i]][1], rgb[i * 3 + 1]) << "pixel " << i % width << "," << i / width;
+		ASSERT_EQ(palette[expected[i]][2], rgb[i * 3 + 2]) << "pixel " << i % width << "," << i / width;
+	}
+}
+}
+
+TEST(WaveformRaster, spans) {
+	check({
+		{2, 8, 4, 6},
+		{0, 10, 0, 0},
+		{5, 5, 5, 5},
+		{3, 7, 2, 8},
+		{-5, 20, 4, 5},
+	}, 10, 5);
+}
+
+TEST(WaveformRaster, no_zero_line) {
+	check({{1, 3, 0, 0}, {0, 0, 0, 0}, {2, 4, 2, 3}}, 4, -1);
+}
+
+TEST(WaveformRaster, random_columns) {
+	std::mt19937 rng(3);
+	const int height = 101, midpoint = height / 2;
+	std::uniform_int_distribution<int> dist(0, midpoint);
+
+	std::vector<std::array<int, 4>> spans;
+	for (int x = 0; x < 300; ++x) {
+		const int peak_max = dist(rng), peak_min = -dist(rng);
+		const int avg_max = peak_max / 2, avg_min = peak_min / 2;
+		spans.push_back({midpoint - peak_max, midpoint - peak_min, midpoint - avg_max, midpoint - avg_min});
+	}
+	check(spans, height, midpoint);
+}
+
+TEST(WaveformRaster, reset_clears_spans) {
+	WaveformRaster raster;
+	raster.Reset(2, 3);
+	raster.SetColumn(0, 0, 3, 0, 3);
+	raster.SetColumn(1, 0, 3, 0, 3);
+	raster.Reset(2, 3);
+	EXPECT_EQ(2, raster.GetWidth());
+	EXPECT_EQ(3, raster.GetHeight());
+
+	std::vector<unsigned char> rgb(2 * 3 * 3, 0xFF);
+	raster.Rasterize(palette, -1, rgb.data());
+	for (auto c : rgb)
+		EXPECT_EQ(0, c);
+}